@@ -0,0 +1,10 @@
+#include "pch.h"
+
+#include <utils/MicroBenchmark.h>
+
+// Entry point of the standalone micro-benchmark build, takes the same arguments as --microbenchmark does in the engine
+int main(int argc, char **argv) {
+	PROFILE_THREAD_NAME("Main Thread");
+
+	return arcane::MicroBenchmark::run(argc, argv);
+}
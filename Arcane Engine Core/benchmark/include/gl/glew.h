@@ -0,0 +1,7 @@
+#pragma once
+
+// Stands in for GLEW in the standalone micro-benchmark build. The benchmarks never call GL, the engine files they link only need the
+// GL declarations, so the entry points are taken straight from the system's libGL instead of being loaded at runtime
+#define GL_GLEXT_PROTOTYPES 1
+#include <GL/gl.h>
+#include <GL/glext.h>
@@ -3,6 +3,48 @@
 // Debug Options
 #define DEBUG_ENABLED 1
 
+// Profiler Settings
+#define PROFILER_ENABLED 1 // CPU zones are recorded for captures, with this off every zone compiles to nothing
+#define PROFILER_EVENTS_PER_THREAD 65536 // Zones each thread's ring buffer holds before the oldest are overwritten
+#define PROFILER_CAPTURE_FRAMES 10 // Frames a requested capture covers
+#define PROFILER_SPIKE_THRESHOLD_MS 50.0 // Frames taking longer than this are captured automatically
+#define PROFILER_SPIKE_CONTEXT_FRAMES 5 // Frames before a spike that its capture includes
+#define PROFILER_SPIKE_COOLDOWN_FRAMES 300 // Frames after a capture before another spike is captured
+#define PROFILER_CAPTURE_DIRECTORY "logged_files/captures/" // Chrome trace JSON, open in chrome://tracing or ui.perfetto.dev
+#define GPU_PROFILER_ENABLED 1 // Render passes are timed with GPU timestamp queries, cheap enough to leave on in release builds
+#define GPU_PROFILER_FRAME_LATENCY 4 // Frames after which a frame's queries are read back, so reading them never stalls
+#define GPU_PROFILER_MAX_PASSES 64 // Passes timed per frame, later ones are skipped
+#define FRAME_STATISTICS_WINDOW 1024 // Frames the rolling frame time percentiles and per pass histograms cover
+#define FRAME_STATISTICS_PLOT_FRAMES 300 // Frame times kept for the runtime pane's graph
+#define FRAME_STATISTICS_STUTTER_FACTOR 2.0 // Frames taking this many times the median frame time count as stutters
+#define FRAME_STATISTICS_STUTTER_MIN_FRAMES 30 // Frames needed in the window before stutters are counted
+#define FRAME_STATISTICS_EXPORT_DIRECTORY "logged_files/statistics/"
+
+// Benchmark Settings
+#define BENCHMARK_DEFAULT_FRAMES 1000 // Frames measured when --frames isn't given
+#define BENCHMARK_WARMUP_FRAMES 60 // Frames rendered before measuring starts, so streaming and driver shader compiles settle
+#define BENCHMARK_DEFAULT_CAMERA_PATH "res/benchmark/default.campath" // Camera path replayed when --camera-path isn't given
+#define BENCHMARK_DEFAULT_OUTPUT_PATH "benchmark_results.json" // Results file written when --output isn't given
+#define BENCHMARK_RESOLUTION_X 1280 // Render resolution when --resolution isn't given
+#define BENCHMARK_RESOLUTION_Y 720
+#define BENCHMARK_EGL_CONTEXT 0 // Creates the offscreen context through EGL, for headless Linux machines without a display server
+#define CAMERA_PATH_RECORD_INTERVAL 0.25f // Seconds between keyframes when recording a camera path with F9
+#define CAMERA_PATH_RECORDING_PATH "res/benchmark/recorded.campath"
+#define MICROBENCHMARK_MIN_TIME_MS 100.0 // Each measurement repeats the operation for at least this long
+#define MICROBENCHMARK_REPETITIONS 5 // Measurements taken per micro-benchmark, the fastest is reported
+
+// Stress Scene Settings (defaults for the "stress" scene, each can be overridden in the scene name, see StressSceneGenerator)
+#define STRESS_SCENE_SEED 1
+#define STRESS_SCENE_RENDERABLES 1000
+#define STRESS_SCENE_MODELS 8 // Distinct meshes the renderables are drawn from, each with a different triangle count
+#define STRESS_SCENE_STATIC_FRACTION 0.75f // Renderables and lights that are static, the dynamic renderables spin
+#define STRESS_SCENE_TRANSPARENT_FRACTION 0.1f
+#define STRESS_SCENE_POINT_LIGHTS 32
+#define STRESS_SCENE_SPOT_LIGHTS 8
+#define STRESS_SCENE_PROBES 1
+#define STRESS_SCENE_HIERARCHY_DEPTH 1 // 1 means every renderable is a root, deeper hierarchies chain renderables under each other
+#define STRESS_SCENE_EXTENT 200.0f // Width and depth of the area the scene is spread over, centred on the default scene's model
+
 
 // Window Settings
 #define WINDOW_X_RESOLUTION 1920
@@ -12,6 +54,28 @@
 
 // Render Settings
 #define FORWARD_RENDER 0
+#define DEFERRED_LIGHT_VOLUMES 1 // Deferred lighting draws point and spot lights as instanced light volumes, instead of looking them up in the light clusters at every pixel
+
+// Clustered Lighting Settings (point and spot lights are culled into a view space froxel grid, see LightClusterPass)
+#define LIGHT_CLUSTER_GRID_X 16
+#define LIGHT_CLUSTER_GRID_Y 9
+#define LIGHT_CLUSTER_GRID_Z 24 // Depth slices, spaced logarithmically between the near and far plane
+#define LIGHT_CLUSTER_MAX_LIGHTS 256 // Lights a single cluster can hold, has to match MAX_LIGHTS_PER_CLUSTER in LightClustering.glsl
+#define LIGHT_CLUSTER_AVERAGE_LIGHTS 32 // Starting size of the light index list the GPU culling writes, it grows when clusters don't fit (they lose their lights until it does)
+#define LIGHT_CLUSTER_READBACK_LATENCY 3 // Dispatches after which the GPU culling's light index count is read back to grow the list, so reading it never stalls
+#define LIGHT_CLUSTER_GPU_CULLING 1 // Cull with a compute shader, otherwise lights are culled on worker threads and uploaded
+#define LIGHT_CLUSTER_CPU_THREADS 4 // Threads the CPU culling is split across, including the GL thread
+#define POINT_LIGHT_BUFFER_BINDING 0 // Shader storage binding points, have to match the lighting shaders
+#define SPOT_LIGHT_BUFFER_BINDING 1
+#define LIGHT_CLUSTER_BUFFER_BINDING 2
+#define LIGHT_INDEX_BUFFER_BINDING 3
+#define LIGHT_INDEX_COUNTER_BINDING 4
+#define DIRECTIONAL_LIGHT_BUFFER_BINDING 5 // Also holds the light counts
+#define OBJECT_LIGHT_INDEX_BUFFER_BINDING 6
+
+// Object Light List Settings (forward shaded models get their own list of the point and spot lights that reach them, see ObjectLightAssigner)
+#define OBJECT_LIGHT_GRID_CELL_SIZE 32.0f // Lights are bucketed into a uniform grid of this cell size for the assignment
+#define OBJECT_LIGHT_LIST_MAX_LIGHTS 64 // Objects reaching more lights than this (large level geometry) use the light clusters instead
 
 // AA Settings
 #define MSAA_SAMPLE_AMOUNT 4 // Only used in forward rendering
@@ -20,6 +84,38 @@
 // Texture Filtering Settings
 #define ANISOTROPIC_FILTERING_LEVEL 8.0f
 
+// Texture Loading Settings
+#define TEXTURE_LOADING_WORKER_COUNT 2 // Threads decoding textures requested with TextureLoader::load2DTextureAsync
+#define TEXTURE_UPLOAD_BUDGET_MS 2.0 // Time the GL thread may spend per frame finalizing asynchronously loaded textures
+#define TEXTURE_STAGING_SLOT_COUNT 3 // Pixel unpack buffer slots that uploads are staged through
+#define TEXTURE_STAGING_SLOT_SIZE (2048 * 2048 * 4) // Bytes per staging slot, larger textures are uploaded straight from client memory
+#define TEXTURE_COOKING_ENABLED 1 // 2D textures are block compressed with pregenerated mips and cached, instead of being uploaded uncompressed
+#define TEXTURE_CACHE_DIRECTORY "res/cache/textures/" // Where cooked textures are stored, keyed by a hash of the source image and its settings
+#define TEXTURE_STREAMING_ENABLED 1 // Cooked textures only keep the mips their on-screen size needs resident, the rest are streamed from the cache
+#define TEXTURE_STREAMING_BUDGET (256 * 1024 * 1024) // Bytes of VRAM streamed textures may use, mips are evicted from the least needed textures past this
+#define TEXTURE_STREAMING_RESIDENT_TAIL_SIZE 128 // Mips this size and smaller are always resident
+#define TEXTURE_STREAMING_UPLOADS_PER_FRAME 4 // Streamed in mip chains the GL thread may swap in per frame
+#define TEXTURE_STREAMING_EVICTION_FRAMES 120 // Frames a texture can go unseen before its streamed mips are released
+
+// Mesh Settings
+#define MESH_COMPACT_VERTEX_FORMAT 1 // Loaded models store quantized positions, octahedral normals + tangents and half float UVs (20 bytes a vertex instead of 56)
+#define MESH_OPTIMIZATION_ENABLED 1 // Loaded models have their triangles reordered for the vertex cache and overdraw, and their vertices for fetch locality
+#define MESH_VERTEX_CACHE_SIZE 16 // Post-transform cache entries the triangle reordering targets
+#define MODEL_COOKING_ENABLED 1 // Imported models are cooked to .amesh files that later runs map and upload without going through Assimp
+#define MODEL_CACHE_DIRECTORY "res/cache/models/" // Where cooked models are stored, keyed by a hash of the source path
+#define MODEL_COOKING_MAX_WORKERS 8 // Upper bound on the threads a model's meshes are converted on while cooking
+
+// File System Settings
+#define VFS_ARCHIVE_PATH "resources.apak" // Mounted at startup if it exists, anything it doesn't contain is read from the loose files
+#define VFS_BUILD_ARCHIVE 0 // Packs the files listed in VFS_ARCHIVE_MANIFEST_PATH into VFS_ARCHIVE_PATH at startup, before it is mounted
+#define VFS_ARCHIVE_MANIFEST_PATH "resources.manifest"
+#define VFS_READAHEAD_ARCHIVES 1 // Ask the OS to start reading mounted archives in the background as soon as they are mounted
+#define PACK_MIN_COMPRESSION_SAVING 0.05f // Packed files are only LZ4 compressed if it shrinks them by at least this fraction
+
+// Asset Settings
+#define ASSET_DESTRUCTION_DELAY_FRAMES 3 // Frames a released asset is kept around for, so assets that are dropped and requested again aren't reloaded
+#define ASSET_MODEL_UPLOADS_PER_FRAME 1 // Asynchronously loaded models the GL thread may upload per frame
+
 // IBL Settings
 #define LIGHT_PROBE_RESOLUTION 32
 #define REFLECTION_PROBE_MIP_COUNT 5
@@ -40,6 +136,18 @@
 // SSAO Options
 #define SSAO_KERNEL_SIZE 32 // Maximum amount is restricted by the shader. Only supports a maximum of 64
 
+// Terrain Options
+#define TERRAIN_TILE_SIZE 64 // Quads along the side of a streamed terrain tile
+#define TERRAIN_CACHE_DIRECTORY "res/cache/terrain/" // Where heightmaps cooked into tiled pyramids are stored, keyed by a hash of the source path
+#define TERRAIN_TILE_MEMORY_BUDGET (64 * 1024 * 1024) // Bytes of tile vertex data allowed to be resident, least recently used tiles are evicted past this
+#define TERRAIN_TILE_UPLOADS_PER_FRAME 2 // Caps the per frame upload cost of streamed tiles
+#define TERRAIN_LOD_DISTANCE_FACTOR 2.0f // A tile is replaced by its children when the camera is within this many tile widths of it
+#define TERRAIN_VIRTUAL_TEXTURE_LEVELS 4 // Clipmap levels, each covers twice the area of the previous one. Restricted by the terrain geometry shader to a maximum of 4
+#define TERRAIN_VIRTUAL_TEXTURE_RESOLUTION 1024 // Texels along the side of a clipmap level
+#define TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE 128 // Texels along the side of a page, the unit the clipmap is baked in
+#define TERRAIN_VIRTUAL_TEXTURE_TEXEL_SIZE 0.25f // World units covered by a texel of the finest clipmap level
+#define TERRAIN_VIRTUAL_TEXTURE_PAGES_PER_FRAME 8 // Caps the per frame baking cost
+
 // Parallax Options
 #define PARALLAX_MIN_STEPS 1
 #define PARALLAX_MAX_STEPS 20
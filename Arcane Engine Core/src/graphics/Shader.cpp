@@ -37,6 +37,10 @@ namespace arcane {
 		glUniform2i(getUniformLocation(name), vector.x, vector.y);
 	}
 
+	void Shader::setUniform(const char *name, const glm::uvec2& vector) {
+		glUniform2ui(getUniformLocation(name), vector.x, vector.y);
+	}
+
 	void Shader::setUniform(const char* name, const glm::vec3& vector) {
 		glUniform3f(getUniformLocation(name), vector.x, vector.y, vector.z);
 	}
@@ -121,7 +125,7 @@ namespace arcane {
 		return 0;
 	}
 
-	std::unordered_map<GLenum, std::string> Shader::preProcessShaderBinary(std::string &source) {
+	std::unordered_map<GLenum, std::string> Shader::preProcessShaderBinary(const std::string &source) {
 		std::unordered_map<GLenum, std::string> shaderSources;
 
 		const char *shaderTypeToken = "#shader-type";
@@ -16,6 +16,7 @@ namespace arcane {
 		void setUniform(const char *name, int value);
 		void setUniform(const char *name, const glm::vec2& vector);
 		void setUniform(const char *name, const glm::ivec2& vector);
+		void setUniform(const char *name, const glm::uvec2& vector);
 		void setUniform(const char *name, const glm::vec3& vector);
 		void setUniform(const char *name, const glm::ivec3& vector);
 		void setUniform(const char *name, const glm::vec4& vector);
@@ -33,11 +34,13 @@ namespace arcane {
 		void setUniformArray(const char *name, int arraySize, glm::ivec4 *value);
 
 		inline unsigned int getShaderID() { return m_ShaderID; }
+
+		// Splits a shader file into its stages on the #shader-type lines
+		static std::unordered_map<GLenum, std::string> preProcessShaderBinary(const std::string &source);
 	private:
 		int getUniformLocation(const char *name);
 
 		static GLenum shaderTypeFromString(const std::string &type);
-		std::unordered_map<GLenum, std::string> preProcessShaderBinary(std::string &source);
 		void compile(const std::unordered_map<GLenum, std::string> &shaderSources);
 	private:
 		unsigned int m_ShaderID;
@@ -3,15 +3,19 @@
 
 namespace arcane {
 
+	// Only the window's callbacks feed it, defining it here keeps every file including Window.h from constructing its own copy
+	static InputManager g_InputManager;
+
 	// Static declarations
 	bool Window::s_HideCursor;
 	int Window::s_Width; int Window::s_Height;
 
-	Window::Window(const char *title, int width, int height) {
+	Window::Window(const char *title, int width, int height, bool offscreen) {
 		m_Title = title;
+		m_Offscreen = offscreen;
 		s_Width = width;
 		s_Height = height;
-		s_HideCursor = true;
+		s_HideCursor = !offscreen;
 
 		if (!init()) {
 			Logger::getInstance().error("logged_files/window_creation.txt", "Window Initialization", "Could not initialize window class");
@@ -45,9 +49,15 @@ namespace arcane {
 
 		// Window hints
 		glfwWindowHint(GLFW_DOUBLEBUFFER, true);
+		if (m_Offscreen) {
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#if BENCHMARK_EGL_CONTEXT
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+		}
 
 		// Create the window and OpenGL context
-		if (FULLSCREEN_MODE) {
+		if (FULLSCREEN_MODE && !m_Offscreen) {
 			setFullscreenResolution();
 			m_Window = glfwCreateWindow(s_Width, s_Height, m_Title, glfwGetPrimaryMonitor(), NULL);
 		}
@@ -83,7 +93,7 @@ namespace arcane {
 		glfwSetJoystickCallback(joystick_callback);
 
 		// Check to see if v-sync was enabled and act accordingly
-		if (V_SYNC) {
+		if (V_SYNC && !m_Offscreen) {
 			glfwSwapInterval(1);
 		}
 		else {
@@ -155,11 +165,11 @@ namespace arcane {
 	}
 
 	/*              Callback Functions              */
-	static void error_callback(int error, const char* description) {
+	void error_callback(int error, const char* description) {
 		std::cout << "Error:" << std::endl << description << std::endl;
 	}
 
-	static void window_resize_callback(GLFWwindow *window, int width, int height) {
+	void window_resize_callback(GLFWwindow *window, int width, int height) {
 		Window* win = (Window*)glfwGetWindowUserPointer(window);
 		if (width == 0 || height == 0) {
 			win->s_Width = WINDOW_X_RESOLUTION;
@@ -172,11 +182,11 @@ namespace arcane {
 		glViewport(0, 0, win->s_Width, win->s_Height);
 	}
 
-	static void framebuffer_resize_callback(GLFWwindow *window, int width, int height) {
+	void framebuffer_resize_callback(GLFWwindow *window, int width, int height) {
 		Window* win = (Window*)glfwGetWindowUserPointer(window);
 	}
 
-	static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+	void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
 		Window* win = (Window*)glfwGetWindowUserPointer(window);
 		g_InputManager.keyCallback(key, scancode, action, mods);
 		ImGui_ImplGlfw_KeyCallback(window, key, scancode, action, mods);
@@ -189,29 +199,29 @@ namespace arcane {
 #endif
 	}
 
-	static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+	void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
 		g_InputManager.mouseButtonCallback(button, action, mods);
 		ImGui_ImplGlfw_MouseButtonCallback(window, button, action, mods);
 	}
 
-	static void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
+	void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
 		g_InputManager.cursorPositionCallback(xpos, ypos);
 	}
 	
-	static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+	void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 		g_InputManager.scrollCallback(xoffset, yoffset);
 		ImGui_ImplGlfw_ScrollCallback(window, xoffset, yoffset);
 	}
 
-	static void char_callback(GLFWwindow* window, unsigned int c) {
+	void char_callback(GLFWwindow* window, unsigned int c) {
 		ImGui_ImplGlfw_CharCallback(window, c);
 	}
 
-	static void joystick_callback(int joystick, int event) {
+	void joystick_callback(int joystick, int event) {
 		g_InputManager.joystickCallback(joystick, event);
 	}
 
-	static void GLAPIENTRY DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
+	void GLAPIENTRY DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
 		fprintf(stderr, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s\n",
 			(type == GL_DEBUG_TYPE_ERROR ? "** GL ERROR **" : ""),
 			type, severity, message);
@@ -6,11 +6,10 @@
 
 namespace arcane {
 
-	static InputManager g_InputManager;
-
 	class Window {
 	public:
-		Window(const char *title, int width, int height);
+		// Offscreen windows are hidden and never wait for v-sync, for running without a display (see Benchmark)
+		Window(const char *title, int width, int height, bool offscreen = false);
 		~Window();
 
 		/**
@@ -32,19 +31,20 @@ namespace arcane {
 		void setFullscreenResolution();
 
 		// Callback Functions
-		static friend void error_callback(int error, const char* description);
-		static friend void window_resize_callback(GLFWwindow *window, int width, int height);
-		static friend void framebuffer_resize_callback(GLFWwindow *window, int width, int height);
-		static friend void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
-		static friend void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
-		static friend void cursor_position_callback(GLFWwindow* window, double xpos, double ypos);
-		static friend void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-		static friend void char_callback(GLFWwindow* window, unsigned int c);
-		static friend void joystick_callback(int joystick, int event);
-		static friend void GLAPIENTRY DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+		friend void error_callback(int error, const char* description);
+		friend void window_resize_callback(GLFWwindow *window, int width, int height);
+		friend void framebuffer_resize_callback(GLFWwindow *window, int width, int height);
+		friend void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+		friend void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+		friend void cursor_position_callback(GLFWwindow* window, double xpos, double ypos);
+		friend void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+		friend void char_callback(GLFWwindow* window, unsigned int c);
+		friend void joystick_callback(int joystick, int event);
+		friend void GLAPIENTRY DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
 	private:
 		const char *m_Title;
 		GLFWwindow *m_Window;
+		bool m_Offscreen;
 
 		static bool s_HideCursor;
 		static int s_Width, s_Height;
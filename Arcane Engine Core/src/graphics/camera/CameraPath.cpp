@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "CameraPath.h"
+
+#include <utils/FileUtils.h>
+
+#include <sstream>
+
+namespace arcane {
+
+	template <typename T>
+	static T catmullRom(const T &p0, const T &p1, const T &p2, const T &p3, float t) {
+		float t2 = t * t;
+		float t3 = t2 * t;
+		return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+	}
+
+	CameraPath::CameraPath() {}
+
+	bool CameraPath::load(const std::string &path) {
+		m_Keyframes.clear();
+
+		std::string contents = FileUtils::readFile(path);
+		if (contents.empty()) {
+			Logger::getInstance().error("logged_files/camera_paths.txt", "camera path loading", "Couldn't read camera path: " + path);
+			return false;
+		}
+
+		std::istringstream input(contents);
+		std::string line;
+		while (std::getline(input, line)) {
+			if (line.empty() || line[0] == '#' || line[0] == '\r')
+				continue;
+
+			CameraKeyframe keyframe;
+			std::istringstream values(line);
+			if (!(values >> keyframe.Time >> keyframe.Position.x >> keyframe.Position.y >> keyframe.Position.z >> keyframe.Yaw >> keyframe.Pitch)) {
+				Logger::getInstance().error("logged_files/camera_paths.txt", "camera path loading", "Malformed keyframe in " + path + ": " + line);
+				m_Keyframes.clear();
+				return false;
+			}
+			if (!m_Keyframes.empty() && keyframe.Time <= m_Keyframes.back().Time) {
+				Logger::getInstance().error("logged_files/camera_paths.txt", "camera path loading", "Keyframe times have to increase in " + path + ": " + line);
+				m_Keyframes.clear();
+				return false;
+			}
+			m_Keyframes.push_back(keyframe);
+		}
+		return !m_Keyframes.empty();
+	}
+
+	bool CameraPath::save(const std::string &path) const {
+		std::ofstream output(path, std::ios::out | std::ios::trunc);
+		if (!output) {
+			Logger::getInstance().error("logged_files/camera_paths.txt", "camera path saving", "Couldn't create camera path: " + path);
+			return false;
+		}
+
+		output << "# time x y z yaw pitch\n";
+		for (const CameraKeyframe &keyframe : m_Keyframes) {
+			output << keyframe.Time << ' ' << keyframe.Position.x << ' ' << keyframe.Position.y << ' ' << keyframe.Position.z << ' ' << keyframe.Yaw << ' ' << keyframe.Pitch << '\n';
+		}
+		return (bool)output;
+	}
+
+	void CameraPath::clear() {
+		m_Keyframes.clear();
+	}
+
+	void CameraPath::record(const FPSCamera &camera, float time) {
+		if (!m_Keyframes.empty() && time - m_Keyframes.back().Time < CAMERA_PATH_RECORD_INTERVAL)
+			return;
+
+		CameraKeyframe keyframe;
+		keyframe.Time = time;
+		keyframe.Position = camera.getPosition();
+		keyframe.Yaw = camera.getYaw();
+		keyframe.Pitch = camera.getPitch();
+		m_Keyframes.push_back(keyframe);
+	}
+
+	void CameraPath::apply(FPSCamera &camera, float time) const {
+		if (m_Keyframes.empty())
+			return;
+
+		// Find the segment the time falls in, the keyframes either side of it shape the curve and are clamped at the ends
+		time = glm::clamp(time, m_Keyframes.front().Time, m_Keyframes.back().Time);
+		size_t next = std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), time, [](float time, const CameraKeyframe &keyframe) {
+			return time < keyframe.Time;
+		}) - m_Keyframes.begin();
+		if (next == m_Keyframes.size()) {
+			camera.setPosition(m_Keyframes.back().Position);
+			camera.setOrientation(m_Keyframes.back().Yaw, m_Keyframes.back().Pitch);
+			return;
+		}
+		size_t current = next - 1;
+
+		const CameraKeyframe &k0 = m_Keyframes[current > 0 ? current - 1 : current];
+		const CameraKeyframe &k1 = m_Keyframes[current];
+		const CameraKeyframe &k2 = m_Keyframes[next];
+		const CameraKeyframe &k3 = m_Keyframes[next + 1 < m_Keyframes.size() ? next + 1 : next];
+		float t = (time - k1.Time) / (k2.Time - k1.Time);
+
+		camera.setPosition(catmullRom(k0.Position, k1.Position, k2.Position, k3.Position, t));
+		camera.setOrientation(catmullRom(k0.Yaw, k1.Yaw, k2.Yaw, k3.Yaw, t), catmullRom(k0.Pitch, k1.Pitch, k2.Pitch, k3.Pitch, t));
+	}
+
+}
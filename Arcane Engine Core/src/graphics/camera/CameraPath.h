@@ -0,0 +1,34 @@
+#pragma once
+
+#include <graphics/camera/FPSCamera.h>
+
+namespace arcane {
+
+	struct CameraKeyframe {
+		float Time; // Seconds from the start of the path
+		glm::vec3 Position;
+		float Yaw, Pitch;
+	};
+
+	// Camera flythrough recorded from an FPSCamera and played back along a Catmull-Rom spline through its keyframes.
+	// Stored as text, one "time x y z yaw pitch" keyframe per line, lines starting with # are comments
+	class CameraPath {
+	public:
+		CameraPath();
+
+		bool load(const std::string &path);
+		bool save(const std::string &path) const;
+		void clear();
+
+		// Adds a keyframe if at least CAMERA_PATH_RECORD_INTERVAL seconds have passed since the last one
+		void record(const FPSCamera &camera, float time);
+		void apply(FPSCamera &camera, float time) const; // Time is clamped to the path's duration
+
+		inline float getDuration() const { return m_Keyframes.empty() ? 0.0f : m_Keyframes.back().Time; }
+		inline bool isEmpty() const { return m_Keyframes.empty(); }
+		inline size_t getKeyframeCount() const { return m_Keyframes.size(); }
+	private:
+		std::vector<CameraKeyframe> m_Keyframes; // Sorted by time
+	};
+
+}
@@ -74,6 +74,12 @@ namespace arcane {
 		processCameraRotation(mouseXDelta, mouseYDelta, true);
 	}
 
+	void FPSCamera::setOrientation(float yaw, float pitch) {
+		m_CurrentYaw = yaw;
+		m_CurrentPitch = glm::clamp(pitch, -89.0f, 89.0f);
+		updateCameraVectors();
+	}
+
 	void FPSCamera::processCameraMovement(glm::vec3 &direction, float deltaTime) {
 		float velocity = m_CurrentMovementSpeed * deltaTime;
 		m_Position += direction * velocity;
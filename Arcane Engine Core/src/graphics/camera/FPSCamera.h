@@ -39,6 +39,7 @@ namespace arcane {
 		inline virtual const glm::vec3& getFront() const { return m_Front; }
 		inline virtual const glm::vec3& getUp() const { return m_Up; }
 		inline virtual void setPosition(const glm::vec3 &position) { m_Position = position; };
+		void setOrientation(float yaw, float pitch);
 	private:
 		void updateCameraVectors();
 		void processCameraMovement(glm::vec3 &direction, float deltaTime);
@@ -34,12 +34,7 @@ namespace arcane {
 		if (m_ProbeBlendSetting == PROBES_SIMPLE) {
 			// Light Probes
 			if (m_LightProbes.size() > 0) {
-				unsigned int closestIndex = 0;
-				for (unsigned int i = 1; i < m_LightProbes.size(); i++) {
-					if (glm::length2(m_LightProbes[i]->getPosition() - renderPosition) < glm::length2(m_LightProbes[closestIndex]->getPosition() - renderPosition))
-						closestIndex = i;
-				}
-				m_LightProbes[closestIndex]->bind(shader);
+				findClosestProbe(m_LightProbes, renderPosition)->bind(shader);
 			}
 			// Light probe fallback
 			else {
@@ -48,12 +43,7 @@ namespace arcane {
 
 			// Reflection Probes
 			if (m_ReflectionProbes.size() > 0) {
-				unsigned int closestIndex = 0;
-				for (unsigned int i = 1; i < m_ReflectionProbes.size(); i++) {
-					if (glm::length2(m_ReflectionProbes[i]->getPosition() - renderPosition) < glm::length2(m_ReflectionProbes[closestIndex]->getPosition() - renderPosition))
-						closestIndex = i;
-				}
-				m_ReflectionProbes[closestIndex]->bind(shader);
+				findClosestProbe(m_ReflectionProbes, renderPosition)->bind(shader);
 			}
 			// Reflection probe fallback
 			else {
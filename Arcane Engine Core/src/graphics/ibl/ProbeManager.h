@@ -27,6 +27,10 @@ namespace arcane {
 
 		// Assumes shader is bound
 		void bindProbes(glm::vec3 &renderPosition, Shader *shader);
+
+		// Nearest probe to the position, nullptr if there are none
+		template<typename Probe>
+		static Probe* findClosestProbe(const std::vector<Probe*> &probes, const glm::vec3 &position);
 	private:
 		ProbeBlendSetting m_ProbeBlendSetting;
 		
@@ -39,4 +43,18 @@ namespace arcane {
 		ReflectionProbe *m_ReflectionProbeFallback;
 	};
 
+	template<typename Probe>
+	Probe* ProbeManager::findClosestProbe(const std::vector<Probe*> &probes, const glm::vec3 &position) {
+		Probe *closest = nullptr;
+		float closestDistance2 = std::numeric_limits<float>::max();
+		for (Probe *probe : probes) {
+			float distance2 = glm::length2(probe->getPosition() - position);
+			if (distance2 < closestDistance2) {
+				closest = probe;
+				closestDistance2 = distance2;
+			}
+		}
+		return closest;
+	}
+
 }
@@ -3,13 +3,7 @@
 
 namespace arcane {
 
-	DirectionalLight::DirectionalLight(float lightIntensity, glm::vec3 &lightColour, glm::vec3 &dir)
+	DirectionalLight::DirectionalLight(float lightIntensity, const glm::vec3 &lightColour, const glm::vec3 &dir)
 		: Light(lightIntensity, lightColour), m_Direction(dir) {}
 
-	void DirectionalLight::setupUniforms(Shader *shader, int currentLightIndex) {
-		shader->setUniform(("dirLights[" + std::to_string(currentLightIndex) + "].direction").c_str(), m_Direction);
-		shader->setUniform(("dirLights[" + std::to_string(currentLightIndex) + "].intensity").c_str(), m_Intensity);
-		shader->setUniform(("dirLights[" + std::to_string(currentLightIndex) + "].lightColour").c_str(), m_LightColour);
-	}
-
 }
@@ -9,9 +9,7 @@ namespace arcane {
 	class DirectionalLight : public Light {
 		friend DynamicLightManager;
 	public:
-		DirectionalLight(float lightIntensity, glm::vec3 &lightColour, glm::vec3 &dir);
-
-		virtual void setupUniforms(Shader *shader, int currentLightIndex) override;
+		DirectionalLight(float lightIntensity, const glm::vec3 &lightColour, const glm::vec3 &dir);
 	private:
 		glm::vec3 m_Direction;
 	};
@@ -3,10 +3,63 @@
 
 namespace arcane {
 
-	DynamicLightManager::DynamicLightManager() {
+	static const unsigned int s_MinimumLightCapacity = 8;
+
+	// Packs a range of slots into the scratch memory and uploads it over the same slots in the light buffer
+	template<typename T, typename PackFunction>
+	static void uploadLightRange(std::vector<unsigned char> &scratch, GLintptr regionOffset, unsigned int firstSlot, unsigned int lastSlot, PackFunction pack) {
+		scratch.resize((lastSlot - firstSlot) * sizeof(T));
+		T *lights = reinterpret_cast<T*>(scratch.data());
+		for (unsigned int slot = firstSlot; slot < lastSlot; ++slot) {
+			lights[slot - firstSlot] = pack(slot);
+		}
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, regionOffset + firstSlot * sizeof(T), scratch.size(), scratch.data());
+	}
+
+	unsigned int LightArrays::insert(bool isStatic, float intensity, const glm::vec3 &lightColour) {
+		unsigned int count = (unsigned int)Intensities.size();
+		unsigned int slot = isStatic ? StaticCount++ : count;
+		for (unsigned int &existingSlot : Slots) {
+			if (existingSlot >= slot)
+				++existingSlot;
+		}
+		Slots.push_back(slot);
+		Intensities.insert(Intensities.begin() + slot, intensity);
+		LightColours.insert(LightColours.begin() + slot, lightColour);
+
+		markDirty(slot, count + 1); // Every light after it has moved along a slot
+		return slot;
+	}
+
+	void LightArrays::markDirty(unsigned int firstSlot, unsigned int lastSlot) {
+		if (firstSlot >= lastSlot)
+			return;
+
+		if (DirtyBegin == DirtyEnd) {
+			DirtyBegin = firstSlot;
+			DirtyEnd = lastSlot;
+		}
+		else {
+			DirtyBegin = std::min(DirtyBegin, firstSlot);
+			DirtyEnd = std::max(DirtyEnd, lastSlot);
+		}
+	}
+
+
+	DynamicLightManager::DynamicLightManager() : m_DirectionalCapacity(s_MinimumLightCapacity), m_PointCapacity(s_MinimumLightCapacity), m_SpotCapacity(s_MinimumLightCapacity),
+		m_DirectionalRegionSize(0), m_BufferSize(0), m_LightCountsDirty(true)
+	{
+		static_assert(sizeof(DirectionalLightData) == 32 && sizeof(PointLightData) == 32 && sizeof(SpotLightData) == 64, "Light data has to match the std430 layout of the shaders' light structs");
+		glGenBuffers(1, &m_LightBuffer);
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_BufferOffsetAlignment);
+
 		init();
 	}
 
+	DynamicLightManager::~DynamicLightManager() {
+		glDeleteBuffers(1, &m_LightBuffer);
+	}
+
 	void DynamicLightManager::init() {
 		// Setup some lights for the scene
 		DirectionalLight directionalLight1(2.0f, glm::vec3(3.25f, 3.25f, 3.25f), glm::vec3(-0.25f, -1.0f, -0.25f));
@@ -26,97 +79,171 @@ namespace arcane {
 		addPointLight(pointLight2);
 	}
 
-	void DynamicLightManager::bindLightingUniforms(Shader *shader) {
-		shader->setUniform("numDirPointSpotLights", glm::ivec4(m_DirectionalLights.size(), m_PointLights.size(), m_SpotLights.size(), 0));
-
-		int i = 0;
-		for (auto iter = m_DirectionalLights.begin(); iter != m_DirectionalLights.end(); iter++) {
-			iter->setupUniforms(shader, i++);
+	void DynamicLightManager::updateLightBuffers(bool onlyStatic) {
+		PROFILE_FUNCTION();
+		reserveLightBuffer();
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightBuffer);
+
+		// Both directional regions hold the same lights, the static region's counts just stop at the static ones
+		if (m_LightCountsDirty) {
+			for (int i = 0; i < 2; ++i) {
+				bool staticRegion = i == 1;
+				glm::ivec4 lightCounts(m_DirectionalLights.getCount(staticRegion), m_PointLights.getCount(staticRegion), m_SpotLights.getCount(staticRegion), 0);
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, m_DirectionalOffsets[i], sizeof(lightCounts), &lightCounts);
+			}
+			m_LightCountsDirty = false;
 		}
 
-		i = 0;
-		for (auto iter = m_PointLights.begin(); iter != m_PointLights.end(); iter++) {
-			iter->setupUniforms(shader, i++);
+		const DirectionalLightArrays &dirLights = m_DirectionalLights;
+		if (dirLights.DirtyBegin != dirLights.DirtyEnd) {
+			for (int i = 0; i < 2; ++i) {
+				uploadLightRange<DirectionalLightData>(m_UploadScratch, m_DirectionalOffsets[i] + sizeof(glm::ivec4), dirLights.DirtyBegin, dirLights.DirtyEnd, [&dirLights](unsigned int slot) {
+					DirectionalLightData data = {};
+					data.Direction = dirLights.Directions[slot];
+					data.Intensity = dirLights.Intensities[slot];
+					data.LightColour = dirLights.LightColours[slot];
+					return data;
+				});
+			}
+			m_DirectionalLights.clearDirty();
 		}
 
-		i = 0;
-		for (auto iter = m_SpotLights.begin(); iter != m_SpotLights.end(); iter++) {
-			iter->setupUniforms(shader, i++);
-		}
-	}
-
-	void DynamicLightManager::bindStaticLightingUniforms(Shader *shader) {
-		int numStaticDirLights = 0;
-		for (auto iter = m_DirectionalLights.begin(); iter != m_DirectionalLights.end(); iter++) {
-			if (iter->m_IsStatic) 
-				iter->setupUniforms(shader, numStaticDirLights++);
+		const PointLightArrays &pointLights = m_PointLights;
+		if (pointLights.DirtyBegin != pointLights.DirtyEnd) {
+			uploadLightRange<PointLightData>(m_UploadScratch, m_PointOffset, pointLights.DirtyBegin, pointLights.DirtyEnd, [&pointLights](unsigned int slot) {
+				PointLightData data = { pointLights.Positions[slot], pointLights.Intensities[slot], pointLights.LightColours[slot], pointLights.AttenuationRadii[slot] };
+				return data;
+			});
+			m_PointLights.clearDirty();
 		}
 
-		int numStaticPointLights = 0;
-		for (auto iter = m_PointLights.begin(); iter != m_PointLights.end(); iter++) {
-			if (iter->m_IsStatic)
-				iter->setupUniforms(shader, numStaticPointLights++);
+		const SpotLightArrays &spotLights = m_SpotLights;
+		if (spotLights.DirtyBegin != spotLights.DirtyEnd) {
+			uploadLightRange<SpotLightData>(m_UploadScratch, m_SpotOffset, spotLights.DirtyBegin, spotLights.DirtyEnd, [&spotLights](unsigned int slot) {
+				SpotLightData data = {};
+				data.Position = spotLights.Positions[slot];
+				data.Intensity = spotLights.Intensities[slot];
+				data.Direction = spotLights.Directions[slot];
+				data.AttenuationRadius = spotLights.AttenuationRadii[slot];
+				data.LightColour = spotLights.LightColours[slot];
+				data.CutOff = spotLights.CutOffs[slot];
+				data.OuterCutOff = spotLights.OuterCutOffs[slot];
+				return data;
+			});
+			m_SpotLights.clearDirty();
 		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-		int numStaticSpotLights = 0;
-		for (auto iter = m_SpotLights.begin(); iter != m_SpotLights.end(); iter++) {
-			if (iter->m_IsStatic) 
-				iter->setupUniforms(shader, numStaticSpotLights++);
-		}
+		// Static lights are at the front of the point and spot regions, so only the counts have to change for a static view
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, DIRECTIONAL_LIGHT_BUFFER_BINDING, m_LightBuffer, m_DirectionalOffsets[onlyStatic ? 1 : 0], m_DirectionalRegionSize);
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_BUFFER_BINDING, m_LightBuffer, m_PointOffset, m_PointCapacity * sizeof(PointLightData));
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SPOT_LIGHT_BUFFER_BINDING, m_LightBuffer, m_SpotOffset, m_SpotCapacity * sizeof(SpotLightData));
+	}
 
-		shader->setUniform("numDirPointSpotLights", glm::ivec4(numStaticDirLights, numStaticPointLights, numStaticSpotLights, 0));
+	void DynamicLightManager::reserveLightBuffer() {
+		unsigned int dirLightCount = m_DirectionalLights.getCount(false), pointLightCount = m_PointLights.getCount(false), spotLightCount = m_SpotLights.getCount(false);
+		if (m_BufferSize != 0 && dirLightCount <= m_DirectionalCapacity && pointLightCount <= m_PointCapacity && spotLightCount <= m_SpotCapacity)
+			return;
+
+		auto grow = [](unsigned int capacity, unsigned int count) {
+			while (capacity < count)
+				capacity *= 2;
+			return capacity;
+		};
+		auto align = [this](GLsizeiptr offset) {
+			return (offset + m_BufferOffsetAlignment - 1) / m_BufferOffsetAlignment * m_BufferOffsetAlignment;
+		};
+		m_DirectionalCapacity = grow(m_DirectionalCapacity, dirLightCount);
+		m_PointCapacity = grow(m_PointCapacity, pointLightCount);
+		m_SpotCapacity = grow(m_SpotCapacity, spotLightCount);
+
+		m_DirectionalRegionSize = sizeof(glm::ivec4) + m_DirectionalCapacity * sizeof(DirectionalLightData);
+		m_DirectionalOffsets[0] = 0;
+		m_DirectionalOffsets[1] = align(m_DirectionalRegionSize);
+		m_PointOffset = align(m_DirectionalOffsets[1] + m_DirectionalRegionSize);
+		m_SpotOffset = align(m_PointOffset + m_PointCapacity * sizeof(PointLightData));
+		m_BufferSize = m_SpotOffset + m_SpotCapacity * sizeof(SpotLightData);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_BufferSize, nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		// The new storage starts out empty
+		m_DirectionalLights.markDirty(0, dirLightCount);
+		m_PointLights.markDirty(0, pointLightCount);
+		m_SpotLights.markDirty(0, spotLightCount);
+		m_LightCountsDirty = true;
 	}
 
 
 	void DynamicLightManager::addDirectionalLight(DirectionalLight &directionalLight) {
-		m_DirectionalLights.push_back(directionalLight);
+		unsigned int slot = m_DirectionalLights.insert(directionalLight.getStatic(), directionalLight.m_Intensity, directionalLight.m_LightColour);
+		m_DirectionalLights.Directions.insert(m_DirectionalLights.Directions.begin() + slot, directionalLight.m_Direction);
+		m_LightCountsDirty = true;
 	}
 
 	void DynamicLightManager::addPointLight(PointLight &pointLight) {
-		m_PointLights.push_back(pointLight);
+		unsigned int slot = m_PointLights.insert(pointLight.getStatic(), pointLight.m_Intensity, pointLight.m_LightColour);
+		m_PointLights.Positions.insert(m_PointLights.Positions.begin() + slot, pointLight.m_Position);
+		m_PointLights.AttenuationRadii.insert(m_PointLights.AttenuationRadii.begin() + slot, pointLight.m_AttenuationRadius);
+		m_LightCountsDirty = true;
 	}
 
 	void DynamicLightManager::addSpotLight(SpotLight &spotLight) {
-		m_SpotLights.push_back(spotLight);
+		unsigned int slot = m_SpotLights.insert(spotLight.getStatic(), spotLight.m_Intensity, spotLight.m_LightColour);
+		m_SpotLights.Positions.insert(m_SpotLights.Positions.begin() + slot, spotLight.m_Position);
+		m_SpotLights.Directions.insert(m_SpotLights.Directions.begin() + slot, spotLight.m_Direction);
+		m_SpotLights.AttenuationRadii.insert(m_SpotLights.AttenuationRadii.begin() + slot, spotLight.m_AttenuationRadius);
+		m_SpotLights.CutOffs.insert(m_SpotLights.CutOffs.begin() + slot, spotLight.m_CutOff);
+		m_SpotLights.OuterCutOffs.insert(m_SpotLights.OuterCutOffs.begin() + slot, spotLight.m_OuterCutOff);
+		m_LightCountsDirty = true;
 	}
 
 
 	// Setters
 	void DynamicLightManager::setDirectionalLightDirection(unsigned int index, const glm::vec3 &dir) {
 #if DEBUG_ENABLED
-		if (m_DirectionalLights[index].m_IsStatic)
+		if (m_DirectionalLights.isStatic(index))
 			Logger::getInstance().warning("logged_files/warnings.txt", "DynamicLightManager Static Light Warning", "modifying directional light's direction, even though it is a static light");
 #endif
-		m_DirectionalLights[index].m_Direction = dir;
+		unsigned int slot = m_DirectionalLights.Slots[index];
+		m_DirectionalLights.Directions[slot] = dir;
+		m_DirectionalLights.markDirty(slot, slot + 1);
 	}
 
 	void DynamicLightManager::setPointLightPosition(unsigned int index, const glm::vec3 &pos) {
 #if DEBUG_ENABLED
-		if (m_PointLights[index].m_IsStatic)
+		if (m_PointLights.isStatic(index))
 			Logger::getInstance().warning("logged_files/warnings.txt", "DynamicLightManager Static Light Warning", "modifying point light's position, even though it is a static light");
 #endif
-		m_PointLights[index].m_Position = pos;
+		unsigned int slot = m_PointLights.Slots[index];
+		m_PointLights.Positions[slot] = pos;
+		m_PointLights.markDirty(slot, slot + 1);
 	}
 
 	void DynamicLightManager::setSpotLightPosition(unsigned int index, const glm::vec3 &pos) {
 #if DEBUG_ENABLED
-		if (m_PointLights[index].m_IsStatic)
+		if (m_SpotLights.isStatic(index))
 			Logger::getInstance().warning("logged_files/warnings.txt", "DynamicLightManager Static Light Warning", "modifying spot light's position, even though it is a static light");
 #endif
-		m_SpotLights[index].m_Position = pos;
+		unsigned int slot = m_SpotLights.Slots[index];
+		m_SpotLights.Positions[slot] = pos;
+		m_SpotLights.markDirty(slot, slot + 1);
 	}
 	void DynamicLightManager::setSpotLightDirection(unsigned int index, const glm::vec3 &dir) {
 #if DEBUG_ENABLED
-		if (m_PointLights[index].m_IsStatic)
+		if (m_SpotLights.isStatic(index))
 			Logger::getInstance().warning("logged_files/warnings.txt", "DynamicLightManager Static Light Warning", "modifying spot light's direction, even though it is a static light");
 #endif
-		m_SpotLights[index].m_Direction = dir;
+		unsigned int slot = m_SpotLights.Slots[index];
+		m_SpotLights.Directions[slot] = dir;
+		m_SpotLights.markDirty(slot, slot + 1);
 	}
 
 
 	// Getters
 	const glm::vec3& DynamicLightManager::getDirectionalLightDirection(unsigned int index) {
-		return m_DirectionalLights[index].m_Direction;
+		return m_DirectionalLights.Directions[m_DirectionalLights.Slots[index]];
 	}
 
 }
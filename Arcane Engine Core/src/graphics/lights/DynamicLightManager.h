@@ -6,12 +6,75 @@
 
 namespace arcane {
 
+	// std430 layouts of the lights in the light buffer, have to match the structs in the lighting shaders
+	struct DirectionalLightData {
+		glm::vec3 Direction;
+		float Intensity;
+		glm::vec3 LightColour;
+		float Padding;
+	};
+
+	struct PointLightData {
+		glm::vec3 Position;
+		float Intensity;
+		glm::vec3 LightColour;
+		float AttenuationRadius;
+	};
+
+	struct SpotLightData {
+		glm::vec3 Position;
+		float Intensity;
+		glm::vec3 Direction;
+		float AttenuationRadius;
+		glm::vec3 LightColour;
+		float CutOff;
+		float OuterCutOff;
+		float Padding[3];
+	};
+
+	// Lights of one type stored as structures of arrays. Static lights always come first, so a probe capture can just use the front
+	// of each array. Lights keep the index they were added with, Slots maps it to where the light currently sits in the arrays
+	struct LightArrays {
+		std::vector<unsigned int> Slots;
+		std::vector<float> Intensities;
+		std::vector<glm::vec3> LightColours;
+		unsigned int StaticCount = 0;
+		unsigned int DirtyBegin = 0, DirtyEnd = 0; // Slots changed since the last upload
+
+		// Makes room for a light and returns its slot, the type's own arrays have to insert at the same slot
+		unsigned int insert(bool isStatic, float intensity, const glm::vec3 &lightColour);
+		void markDirty(unsigned int firstSlot, unsigned int lastSlot);
+		inline void clearDirty() { DirtyBegin = DirtyEnd = 0; }
+
+		inline unsigned int getCount(bool onlyStatic) const { return onlyStatic ? StaticCount : (unsigned int)Intensities.size(); }
+		inline bool isStatic(unsigned int index) const { return Slots[index] < StaticCount; }
+	};
+
+	struct DirectionalLightArrays : LightArrays {
+		std::vector<glm::vec3> Directions;
+	};
+
+	struct PointLightArrays : LightArrays {
+		std::vector<glm::vec3> Positions;
+		std::vector<float> AttenuationRadii;
+	};
+
+	struct SpotLightArrays : LightArrays {
+		std::vector<glm::vec3> Positions, Directions;
+		std::vector<float> AttenuationRadii, CutOffs, OuterCutOffs;
+	};
+
+	// Every light lives in a single buffer that all the lighting shaders read from their storage bindings, so binding lights costs the
+	// same no matter how many shaders and passes use them. It is laid out as
+	//   [light counts + directional lights] [static light counts + directional lights] [point lights] [spot lights]
+	// with each region's capacity growing as lights are added, and only the lights changed since the last update are re-uploaded
 	class DynamicLightManager {
 	public:
 		DynamicLightManager();
+		~DynamicLightManager();
 
-		void bindLightingUniforms(Shader *shader);
-		void bindStaticLightingUniforms(Shader *shader);
+		// Uploads the lights that changed and binds the light buffer, exposing only the static lights when rendering static geometry (probe captures)
+		void updateLightBuffers(bool onlyStatic);
 
 		void addDirectionalLight(DirectionalLight &directionalLight);
 		void addPointLight(PointLight &pointLight);
@@ -30,12 +93,25 @@ namespace arcane {
 
 		// Getters
 		const glm::vec3& getDirectionalLightDirection(unsigned int index);
+		inline const PointLightArrays& getPointLights() const { return m_PointLights; } // Indexed by slot, the order shaders see them in
+		inline const SpotLightArrays& getSpotLights() const { return m_SpotLights; }
 	private:
 		void init();
-		
-		std::vector<DirectionalLight> m_DirectionalLights;
-		std::vector<PointLight> m_PointLights;
-		std::vector<SpotLight> m_SpotLights;
+
+		void reserveLightBuffer();
+
+		DirectionalLightArrays m_DirectionalLights;
+		PointLightArrays m_PointLights;
+		SpotLightArrays m_SpotLights;
+
+		GLuint m_LightBuffer;
+		GLint m_BufferOffsetAlignment;
+		unsigned int m_DirectionalCapacity, m_PointCapacity, m_SpotCapacity;
+		GLintptr m_DirectionalOffsets[2], m_PointOffset, m_SpotOffset; // Directional regions for all lights and static lights
+		GLsizeiptr m_DirectionalRegionSize, m_BufferSize;
+		bool m_LightCountsDirty;
+
+		std::vector<unsigned char> m_UploadScratch; // Dirty lights are packed here before being uploaded
 	};
 
 }
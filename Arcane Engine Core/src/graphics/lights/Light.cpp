@@ -3,7 +3,7 @@
 
 namespace arcane {
 
-	Light::Light(float lightIntensity, glm::vec3 &lightColour) 
+	Light::Light(float lightIntensity, const glm::vec3 &lightColour) 
 		: m_Intensity(lightIntensity), m_LightColour(lightColour), m_IsStatic(false) {}
 
 }
@@ -6,9 +6,10 @@ namespace arcane {
 
 	class Light {
 	public:
-		Light(float lightIntensity, glm::vec3 &lightColour);
+		Light(float lightIntensity, const glm::vec3 &lightColour);
 
-		virtual void setupUniforms(Shader *shader, int currentLightIndex) = 0;
+		inline bool getStatic() const { return m_IsStatic; }
+		inline void setStatic(bool choice) { m_IsStatic = choice; }
 	protected:
 		float m_Intensity;
 		glm::vec3 m_LightColour;
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "ObjectLightAssigner.h"
+
+namespace arcane {
+
+	static const int s_MaxCellsPerLight = 512;
+	const unsigned int ObjectLightAssigner::ClusteredLightList;
+
+	ObjectLightAssigner::ObjectLightAssigner() : m_PointLightCount(0), m_VisitStamp(0), m_LightIndexBuffer(0) {}
+
+	ObjectLightAssigner::~ObjectLightAssigner() {
+		if (m_LightIndexBuffer)
+			glDeleteBuffers(1, &m_LightIndexBuffer);
+	}
+
+	void ObjectLightAssigner::buildLightGrid(const PointLightArrays &pointLights, const SpotLightArrays &spotLights, bool onlyStatic) {
+		PROFILE_FUNCTION();
+		m_Grid.clear();
+		m_LightSpheres.clear();
+		m_LargeLights.clear();
+
+		// Spot lights are bucketed with the sphere bounding their whole range, it is conservative for narrow cones
+		m_PointLightCount = pointLights.getCount(onlyStatic);
+		for (unsigned int i = 0; i < m_PointLightCount; ++i) {
+			addToGrid(glm::vec4(pointLights.Positions[i], pointLights.AttenuationRadii[i]), i);
+		}
+		unsigned int spotLightCount = spotLights.getCount(onlyStatic);
+		for (unsigned int i = 0; i < spotLightCount; ++i) {
+			addToGrid(glm::vec4(spotLights.Positions[i], spotLights.AttenuationRadii[i]), m_PointLightCount + i);
+		}
+
+		std::sort(m_Grid.begin(), m_Grid.end(), [](const GridEntry &a, const GridEntry &b) { return a.Cell < b.Cell; });
+
+		m_LightVisits.assign(m_LightSpheres.size(), 0);
+		m_VisitStamp = 0;
+	}
+
+	void ObjectLightAssigner::assignLights(const std::vector<glm::vec4> &boundingSpheres, std::vector<glm::uvec2> &outLightLists) {
+		PROFILE_FUNCTION();
+		m_LightIndices.clear();
+		outLightLists.resize(boundingSpheres.size());
+		for (size_t i = 0; i < boundingSpheres.size(); ++i) {
+			outLightLists[i] = findLights(boundingSpheres[i], m_LightIndices);
+		}
+
+		if (!m_LightIndexBuffer)
+			glGenBuffers(1, &m_LightIndexBuffer);
+
+		// Rewritten every flush, so the old storage is orphaned rather than waited on
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightIndexBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(m_LightIndices.size(), (size_t)1) * sizeof(unsigned int), nullptr, GL_STREAM_DRAW);
+		if (!m_LightIndices.empty())
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_LightIndices.size() * sizeof(unsigned int), m_LightIndices.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_LIGHT_INDEX_BUFFER_BINDING, m_LightIndexBuffer);
+	}
+
+	glm::uvec2 ObjectLightAssigner::findLights(const glm::vec4 &boundingSphere, std::vector<unsigned int> &outIndices) {
+		m_PointLightsFound.clear();
+		m_SpotLightsFound.clear();
+		if (++m_VisitStamp == 0) {
+			std::fill(m_LightVisits.begin(), m_LightVisits.end(), 0);
+			m_VisitStamp = 1;
+		}
+
+		auto testLight = [this, &boundingSphere](unsigned int light) {
+			if (m_LightVisits[light] == m_VisitStamp)
+				return;
+			m_LightVisits[light] = m_VisitStamp;
+
+			const glm::vec4 &lightSphere = m_LightSpheres[light];
+			float reach = lightSphere.w + boundingSphere.w;
+			if (glm::length2(glm::vec3(lightSphere) - glm::vec3(boundingSphere)) > reach * reach)
+				return;
+
+			if (light < m_PointLightCount)
+				m_PointLightsFound.push_back(light);
+			else
+				m_SpotLightsFound.push_back(light - m_PointLightCount);
+		};
+
+		// Objects covering more cells than there are grid entries are cheaper to test against every light
+		glm::ivec3 minCell(glm::floor((glm::vec3(boundingSphere) - boundingSphere.w) / OBJECT_LIGHT_GRID_CELL_SIZE));
+		glm::ivec3 maxCell(glm::floor((glm::vec3(boundingSphere) + boundingSphere.w) / OBJECT_LIGHT_GRID_CELL_SIZE));
+		glm::ivec3 cellRange = maxCell - minCell + 1;
+		if ((double)cellRange.x * cellRange.y * cellRange.z > (double)m_Grid.size()) {
+			for (unsigned int light = 0; light < m_LightSpheres.size(); ++light) {
+				testLight(light);
+			}
+		}
+		else {
+			for (int z = minCell.z; z <= maxCell.z; ++z) {
+				for (int y = minCell.y; y <= maxCell.y; ++y) {
+					for (int x = minCell.x; x <= maxCell.x; ++x) {
+						GridEntry key = { getCellKey(glm::ivec3(x, y, z)), 0 };
+						auto entry = std::lower_bound(m_Grid.begin(), m_Grid.end(), key, [](const GridEntry &a, const GridEntry &b) { return a.Cell < b.Cell; });
+						for (; entry != m_Grid.end() && entry->Cell == key.Cell; ++entry) {
+							testLight(entry->Light);
+						}
+					}
+				}
+			}
+			for (unsigned int light : m_LargeLights) {
+				testLight(light);
+			}
+		}
+
+		size_t lightCount = m_PointLightsFound.size() + m_SpotLightsFound.size();
+		if (lightCount > OBJECT_LIGHT_LIST_MAX_LIGHTS)
+			return glm::uvec2(0, ClusteredLightList);
+
+		// Cells are visited in no particular order, sorting keeps the shader's reads through the light buffers in order
+		std::sort(m_PointLightsFound.begin(), m_PointLightsFound.end());
+		std::sort(m_SpotLightsFound.begin(), m_SpotLightsFound.end());
+		unsigned int offset = (unsigned int)outIndices.size();
+		outIndices.insert(outIndices.end(), m_PointLightsFound.begin(), m_PointLightsFound.end());
+		outIndices.insert(outIndices.end(), m_SpotLightsFound.begin(), m_SpotLightsFound.end());
+		return glm::uvec2(offset, (unsigned int)m_PointLightsFound.size() | ((unsigned int)m_SpotLightsFound.size() << 16));
+	}
+
+	size_t ObjectLightAssigner::getLookupFootprint(const glm::vec4 &boundingSphere) const {
+		// Follows the same path as findLights, a light's sphere is only read the first time one of the cells brings it up
+		glm::ivec3 minCell(glm::floor((glm::vec3(boundingSphere) - boundingSphere.w) / OBJECT_LIGHT_GRID_CELL_SIZE));
+		glm::ivec3 maxCell(glm::floor((glm::vec3(boundingSphere) + boundingSphere.w) / OBJECT_LIGHT_GRID_CELL_SIZE));
+		glm::ivec3 cellRange = maxCell - minCell + 1;
+		if ((double)cellRange.x * cellRange.y * cellRange.z > (double)m_Grid.size())
+			return m_LightSpheres.size() * sizeof(glm::vec4);
+
+		std::vector<bool> lightsRead(m_LightSpheres.size(), false);
+		size_t entriesRead = 0;
+		for (int z = minCell.z; z <= maxCell.z; ++z) {
+			for (int y = minCell.y; y <= maxCell.y; ++y) {
+				for (int x = minCell.x; x <= maxCell.x; ++x) {
+					GridEntry key = { getCellKey(glm::ivec3(x, y, z)), 0 };
+					auto entry = std::lower_bound(m_Grid.begin(), m_Grid.end(), key, [](const GridEntry &a, const GridEntry &b) { return a.Cell < b.Cell; });
+					for (; entry != m_Grid.end() && entry->Cell == key.Cell; ++entry) {
+						entriesRead++;
+						lightsRead[entry->Light] = true;
+					}
+				}
+			}
+		}
+		for (unsigned int light : m_LargeLights) {
+			lightsRead[light] = true;
+		}
+		return entriesRead * sizeof(GridEntry) + (size_t)std::count(lightsRead.begin(), lightsRead.end(), true) * sizeof(glm::vec4);
+	}
+
+	void ObjectLightAssigner::addToGrid(const glm::vec4 &sphere, unsigned int light) {
+		m_LightSpheres.push_back(sphere);
+
+		glm::ivec3 minCell(glm::floor((glm::vec3(sphere) - sphere.w) / OBJECT_LIGHT_GRID_CELL_SIZE));
+		glm::ivec3 maxCell(glm::floor((glm::vec3(sphere) + sphere.w) / OBJECT_LIGHT_GRID_CELL_SIZE));
+		glm::ivec3 cellRange = maxCell - minCell + 1;
+		if ((double)cellRange.x * cellRange.y * cellRange.z > s_MaxCellsPerLight) {
+			m_LargeLights.push_back(light);
+			return;
+		}
+
+		for (int z = minCell.z; z <= maxCell.z; ++z) {
+			for (int y = minCell.y; y <= maxCell.y; ++y) {
+				for (int x = minCell.x; x <= maxCell.x; ++x) {
+					GridEntry entry = { getCellKey(glm::ivec3(x, y, z)), light };
+					m_Grid.push_back(entry);
+				}
+			}
+		}
+	}
+
+	// 21 bits per axis, cells far enough apart to wrap onto each other only cost an extra sphere test
+	uint64_t ObjectLightAssigner::getCellKey(const glm::ivec3 &cell) {
+		const uint64_t mask = (1 << 21) - 1;
+		return (((uint64_t)cell.x & mask) << 42) | (((uint64_t)cell.y & mask) << 21) | ((uint64_t)cell.z & mask);
+	}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "DynamicLightManager.h"
+
+namespace arcane {
+
+	// Gives each forward shaded object a compact list of the point and spot lights its bounding sphere reaches, so its fragments only loop
+	// over those. Lights are bucketed into a uniform grid, kept as a list of (cell, light) pairs sorted by cell, and an object only tests
+	// the lights in the cells it overlaps
+	class ObjectLightAssigner {
+	public:
+		static const unsigned int ClusteredLightList = 0xFFFFFFFF; // Counts of an object that reaches too many lights and uses the light clusters instead
+
+		ObjectLightAssigner();
+		~ObjectLightAssigner();
+
+		// Buckets the lights the light buffer exposes, only the static ones when rendering static geometry (probe captures)
+		void buildLightGrid(const PointLightArrays &pointLights, const SpotLightArrays &spotLights, bool onlyStatic);
+
+		// Finds the lights reaching each bounding sphere (world space position, radius in w) and uploads the index lists for the lighting shaders.
+		// Each object gets (offset, point light count | spot light count << 16) into them
+		void assignLights(const std::vector<glm::vec4> &boundingSpheres, std::vector<glm::uvec2> &outLightLists);
+
+		// The CPU side of the assignment, kept free of GL so it can be measured without a context (see MicroBenchmark). Appends the point
+		// light indices then the spot light indices to outIndices
+		glm::uvec2 findLights(const glm::vec4 &boundingSphere, std::vector<unsigned int> &outIndices);
+
+		// Bytes of grid entries and light spheres findLights reads for the bounding sphere, for the micro-benchmark's bandwidth figures
+		size_t getLookupFootprint(const glm::vec4 &boundingSphere) const;
+	private:
+		struct GridEntry {
+			uint64_t Cell;
+			unsigned int Light; // Spot lights come after the point lights
+		};
+
+		void addToGrid(const glm::vec4 &sphere, unsigned int light);
+		static uint64_t getCellKey(const glm::ivec3 &cell);
+	private:
+		std::vector<GridEntry> m_Grid;
+		std::vector<glm::vec4> m_LightSpheres; // World space position, radius in w
+		std::vector<unsigned int> m_LargeLights; // Lights covering too many cells to bucket, every object tests them
+		unsigned int m_PointLightCount;
+
+		// Lights overlapping several of an object's cells are only tested once
+		std::vector<unsigned int> m_LightVisits;
+		unsigned int m_VisitStamp;
+		std::vector<unsigned int> m_PointLightsFound, m_SpotLightsFound;
+
+		std::vector<unsigned int> m_LightIndices;
+		GLuint m_LightIndexBuffer; // Created on first use
+	};
+
+}
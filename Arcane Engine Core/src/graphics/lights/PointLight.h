@@ -9,9 +9,7 @@ namespace arcane {
 	class PointLight : public Light {
 		friend DynamicLightManager;
 	public:
-		PointLight(float lightIntensity, glm::vec3 &lightColour, float attenuationRadius, glm::vec3 &pos);
-
-		virtual void setupUniforms(Shader *shader, int currentLightIndex) override;
+		PointLight(float lightIntensity, const glm::vec3 &lightColour, float attenuationRadius, const glm::vec3 &pos);
 	private:
 		float m_AttenuationRadius;
 		glm::vec3 m_Position;
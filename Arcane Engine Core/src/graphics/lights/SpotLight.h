@@ -9,9 +9,7 @@ namespace arcane {
 	class SpotLight : public Light {
 		friend DynamicLightManager;
 	public:
-		SpotLight(float lightIntensity, glm::vec3 &lightColour, float attenuationRadius, glm::vec3 &pos, glm::vec3 &dir, float cutOffAngle, float outerCutOffAngle);
-	
-		virtual void setupUniforms(Shader *shader, int currentLightIndex) override;
+		SpotLight(float lightIntensity, const glm::vec3 &lightColour, float attenuationRadius, const glm::vec3 &pos, const glm::vec3 &dir, float cutOffAngle, float outerCutOffAngle);
 	private:
 		float m_AttenuationRadius;
 		glm::vec3 m_Position, m_Direction;
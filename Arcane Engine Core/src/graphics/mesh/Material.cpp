@@ -2,6 +2,7 @@
 #include "Material.h"
 
 #include <graphics/Window.h>
+#include <graphics/texture/TextureStreamer.h>
 #include <ui/DebugPane.h>
 
 namespace arcane {
@@ -72,4 +73,13 @@ namespace arcane {
 		}
 	}
 
+	void Material::requestTextureDetail(float screenSpaceSize) const {
+		Texture *textures[] = { m_AlbedoMap, m_NormalMap, m_MetallicMap, m_RoughnessMap, m_AmbientOcclusionMap, m_DisplacementMap };
+		for (Texture *texture : textures) {
+			if (texture) {
+				TextureStreamer::requestDetail(texture, screenSpaceSize);
+			}
+		}
+	}
+
 }
@@ -14,6 +14,9 @@ namespace arcane {
 		// Assumes the shader is already bound
 		void BindMaterialInformation(Shader *shader) const;
 
+		// Texture streaming feedback, screenSpaceSize is how many pixels the surface covers on screen
+		void requestTextureDetail(float screenSpaceSize) const;
+
 		inline void setAlbedoMap(Texture *texture) { m_AlbedoMap = texture; }
 		inline void setNormalMap(Texture *texture) { m_NormalMap = texture; }
 		inline void setMetallicMap(Texture *texture) { m_MetallicMap = texture; }
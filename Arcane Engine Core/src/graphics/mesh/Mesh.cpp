@@ -1,194 +1,231 @@
 #include "pch.h"
 #include "Mesh.h"
 
+#include <graphics/renderer/RenderStatistics.h>
+
 namespace arcane {
 
-	Mesh::Mesh() : m_VAO(0), m_VBO(0), m_IBO(0) {}
+	Mesh::Mesh() : m_VAO(0), m_VBO(0), m_IBO(0), m_VertexCount(0), m_IndexCount(0), m_IndexType(GL_UNSIGNED_INT), m_IsCompact(false), m_PositionScale(1.0f), m_PositionOffset(0.0f), m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_BoundingRadius(0.0f) {}
+
+	Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<unsigned int> indices)
+		: m_Positions(std::move(positions)), m_Indices(std::move(indices)), m_VAO(0), m_VBO(0), m_IBO(0), m_VertexCount(0), m_IndexCount(0), m_IndexType(GL_UNSIGNED_INT), m_IsCompact(false), m_PositionScale(1.0f), m_PositionOffset(0.0f), m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_BoundingRadius(0.0f) {}
 
-	Mesh::Mesh(std::vector<glm::vec3> &positions, std::vector<unsigned int> &indices)
-		: m_Positions(positions), m_Indices(indices), m_VAO(0), m_VBO(0), m_IBO(0) {}
+	Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uvs, std::vector<unsigned int> indices)
+		: m_Positions(std::move(positions)), m_UVs(std::move(uvs)), m_Indices(std::move(indices)), m_VAO(0), m_VBO(0), m_IBO(0), m_VertexCount(0), m_IndexCount(0), m_IndexType(GL_UNSIGNED_INT), m_IsCompact(false), m_PositionScale(1.0f), m_PositionOffset(0.0f), m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_BoundingRadius(0.0f) {}
 
-	Mesh::Mesh(std::vector<glm::vec3> &positions, std::vector<glm::vec2> &uvs, std::vector<unsigned int> &indices)
-		: m_Positions(positions), m_UVs(uvs), m_Indices(indices), m_VAO(0), m_VBO(0), m_IBO(0) {}
+	Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uvs, std::vector<glm::vec3> normals, std::vector<unsigned int> indices)
+		: m_Positions(std::move(positions)), m_UVs(std::move(uvs)), m_Normals(std::move(normals)), m_Indices(std::move(indices)), m_VAO(0), m_VBO(0), m_IBO(0), m_VertexCount(0), m_IndexCount(0), m_IndexType(GL_UNSIGNED_INT), m_IsCompact(false), m_PositionScale(1.0f), m_PositionOffset(0.0f), m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_BoundingRadius(0.0f) {}
 
-	Mesh::Mesh(std::vector<glm::vec3> &positions, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals, std::vector<unsigned int> &indices)
-		: m_Positions(positions), m_UVs(uvs), m_Normals(normals), m_Indices(indices), m_VAO(0), m_VBO(0), m_IBO(0) {}
+	Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uvs, std::vector<glm::vec3> normals, std::vector<glm::vec3> tangents, std::vector<glm::vec3> bitangents, std::vector<unsigned int> indices)
+		: m_Positions(std::move(positions)), m_UVs(std::move(uvs)), m_Normals(std::move(normals)), m_Tangents(std::move(tangents)), m_Bitangents(std::move(bitangents)), m_Indices(std::move(indices)), m_VAO(0), m_VBO(0), m_IBO(0), m_VertexCount(0), m_IndexCount(0), m_IndexType(GL_UNSIGNED_INT), m_IsCompact(false), m_PositionScale(1.0f), m_PositionOffset(0.0f), m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_BoundingRadius(0.0f) {}
 
-	Mesh::Mesh(std::vector<glm::vec3> &positions, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals, std::vector<glm::vec3> &tangents, std::vector<glm::vec3> &bitangents, std::vector<unsigned int> &indices)
-		: m_Positions(positions), m_UVs(uvs), m_Normals(normals), m_Tangents(tangents), m_Bitangents(bitangents), m_Indices(indices), m_VAO(0), m_VBO(0), m_IBO(0) {}
- 
+	Mesh::~Mesh() {
+		releaseGPUData();
+	}
+
+	Mesh::Mesh(Mesh &&other) noexcept : m_VAO(0), m_VBO(0), m_IBO(0), m_VertexCount(0), m_IndexCount(0), m_IndexType(GL_UNSIGNED_INT), m_IsCompact(false), m_PositionScale(1.0f), m_PositionOffset(0.0f), m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_BoundingRadius(0.0f) {
+		*this = std::move(other);
+	}
+
+	Mesh& Mesh::operator=(Mesh &&other) noexcept {
+		if (this != &other) {
+			releaseGPUData();
+
+			m_VAO = other.m_VAO; m_VBO = other.m_VBO; m_IBO = other.m_IBO;
+			m_VertexCount = other.m_VertexCount; m_IndexCount = other.m_IndexCount; m_IndexType = other.m_IndexType;
+			m_Material = other.m_Material;
+			m_IsCompact = other.m_IsCompact; m_PositionScale = other.m_PositionScale; m_PositionOffset = other.m_PositionOffset;
+			m_BoundsMin = other.m_BoundsMin; m_BoundsMax = other.m_BoundsMax; m_BoundingRadius = other.m_BoundingRadius;
+			m_Positions = std::move(other.m_Positions);
+			m_UVs = std::move(other.m_UVs);
+			m_Normals = std::move(other.m_Normals);
+			m_Tangents = std::move(other.m_Tangents);
+			m_Bitangents = std::move(other.m_Bitangents);
+			m_Indices = std::move(other.m_Indices);
+
+			// The moved from mesh no longer owns the buffers
+			other.m_VAO = other.m_VBO = other.m_IBO = 0;
+			other.m_VertexCount = other.m_IndexCount = 0;
+		}
+		return *this;
+	}
 
 	void Mesh::Draw() const {
 		glBindVertexArray(m_VAO);
-		if (m_Indices.size() > 0) {
+		if (m_IndexCount > 0) {
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
-			glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, 0);
+			glDrawElements(GL_TRIANGLES, m_IndexCount, m_IndexType, 0);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+			RenderStatistics::addDrawCall(m_IndexCount / 3);
 		}
 		else {
-			glDrawArrays(GL_TRIANGLES, 0, m_Positions.size());
+			glDrawArrays(GL_TRIANGLES, 0, m_VertexCount);
+			RenderStatistics::addDrawCall(m_VertexCount / 3);
 		}
 		glBindVertexArray(0);
 	}
 
-	void Mesh::LoadData(bool interleaved) {
+	void Mesh::DrawInstanced(unsigned int instanceCount) const {
+		if (instanceCount == 0)
+			return;
+
+		glBindVertexArray(m_VAO);
+		if (m_IndexCount > 0) {
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
+			glDrawElementsInstanced(GL_TRIANGLES, m_IndexCount, m_IndexType, 0, instanceCount);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+			RenderStatistics::addDrawCall((uint64_t)(m_IndexCount / 3) * instanceCount);
+		}
+		else {
+			glDrawArraysInstanced(GL_TRIANGLES, 0, m_VertexCount, instanceCount);
+			RenderStatistics::addDrawCall((uint64_t)(m_VertexCount / 3) * instanceCount);
+		}
+		glBindVertexArray(0);
+	}
+
+	void Mesh::LoadData(bool keepCPUData) {
 		// Check for possible mesh initialization errors
+		unsigned int vertexCount = m_Positions.size();
 		{
-			unsigned int vertexCount = m_Positions.size();
-
-			if (vertexCount == 0)
+			bool valid = true;
+			if (vertexCount == 0) {
 				Logger::getInstance().error("logged_files/mesh_creation.txt", "Mesh Creation", "Mesh doesn't contain any vertices");
+				valid = false;
+			}
 
-			if (m_UVs.size() != 0 && m_UVs.size() != vertexCount)
+			if (m_UVs.size() != 0 && m_UVs.size() != vertexCount) {
 				Logger::getInstance().error("logged_files/mesh_creation.txt", "Mesh Creation", "Mesh UV count doesn't match the vertex count");
-			if (m_Normals.size() != 0 && m_Normals.size() != vertexCount)
+				valid = false;
+			}
+			if (m_Normals.size() != 0 && m_Normals.size() != vertexCount) {
 				Logger::getInstance().error("logged_files/mesh_creation.txt", "Mesh Creation", "Mesh Normal count doesn't match the vertex count");
-			if (m_Tangents.size() != 0 && m_Tangents.size() != vertexCount)
+				valid = false;
+			}
+			if (m_Tangents.size() != 0 && m_Tangents.size() != vertexCount) {
 				Logger::getInstance().error("logged_files/mesh_creation.txt", "Mesh Creation", "Mesh Tangent count doesn't match the vertex count");
-			if (m_Bitangents.size() != 0 && m_Bitangents.size() != vertexCount)
+				valid = false;
+			}
+			if (m_Bitangents.size() != 0 && m_Bitangents.size() != vertexCount) {
 				Logger::getInstance().error("logged_files/mesh_creation.txt", "Mesh Creation", "Mesh Bitangent count doesn't match the vertex count");
+				valid = false;
+			}
+
+			if (!valid)
+				return;
 		}
 
-		// Preprocess the mesh data in the format that was specified
-		std::vector<float> data;
-		if (interleaved) {
-			for (unsigned int i = 0; i < m_Positions.size(); i++) {
-				data.push_back(m_Positions[i].x);
-				data.push_back(m_Positions[i].y);
-				data.push_back(m_Positions[i].z);
-				if (m_Normals.size() > 0) {
-					data.push_back(m_Normals[i].x);
-					data.push_back(m_Normals[i].y);
-					data.push_back(m_Normals[i].z);
-				}
-				if (m_UVs.size() > 0) {
-					data.push_back(m_UVs[i].x);
-					data.push_back(m_UVs[i].y);
-				}
-				if (m_Tangents.size() > 0) {
-					data.push_back(m_Tangents[i].x);
-					data.push_back(m_Tangents[i].y);
-					data.push_back(m_Tangents[i].z);
-				}
-				if (m_Bitangents.size() > 0) {
-					data.push_back(m_Bitangents[i].x);
-					data.push_back(m_Bitangents[i].y);
-					data.push_back(m_Bitangents[i].z);
-				}
-			}
+		if (m_Tangents.size() > 0 || m_Bitangents.size() > 0) {
+			loadVertices<FullPrecisionVertexLayout>(vertexCount, [this](FullPrecisionVertex *vertices) { writeVertices(vertices); });
 		}
 		else {
-			for (unsigned int i = 0; i < m_Positions.size(); i++) {
-				data.push_back(m_Positions[i].x);
-				data.push_back(m_Positions[i].y);
-				data.push_back(m_Positions[i].z);
-			}
-			for (unsigned int i = 0; i < m_Normals.size(); i++) {
-				data.push_back(m_Normals[i].x);
-				data.push_back(m_Normals[i].y);
-				data.push_back(m_Normals[i].z);
-			}
-			for (unsigned int i = 0; i < m_UVs.size(); i++) {
-				data.push_back(m_UVs[i].x);
-				data.push_back(m_UVs[i].y);
-			}
-			for (unsigned int i = 0; i < m_Tangents.size(); i++) {
-				data.push_back(m_Tangents[i].x);
-				data.push_back(m_Tangents[i].y);
-				data.push_back(m_Tangents[i].z);
+			loadVertices<StandardVertexLayout>(vertexCount, [this](StandardVertex *vertices) { writeVertices(vertices); });
+		}
+
+		if (m_Indices.size() > 0) {
+			if (vertexCount <= 65536) {
+				loadIndices<unsigned short>(m_Indices.size(), [this](unsigned short *indices) { writeIndices(indices); });
 			}
-			for (unsigned int i = 0; i < m_Bitangents.size(); i++) {
-				data.push_back(m_Bitangents[i].x);
-				data.push_back(m_Bitangents[i].y);
-				data.push_back(m_Bitangents[i].z);
+			else {
+				loadIndices<unsigned int>(m_Indices.size(), [this](unsigned int *indices) { writeIndices(indices); });
 			}
 		}
 
-		// Compute the component count
-		unsigned int bufferComponentCount = 0;
-		if (m_Positions.size() > 0)
-			bufferComponentCount += 3;
-		if (m_Normals.size() > 0)
-			bufferComponentCount += 3;
-		if (m_UVs.size() > 0)
-			bufferComponentCount += 2;
-		if (m_Tangents.size() > 0)
-			bufferComponentCount += 3;
-		if (m_Bitangents.size() > 0)
-			bufferComponentCount += 3;
-
-		glGenVertexArrays(1, &m_VAO);
-		glGenBuffers(1, &m_VBO);
-		glGenBuffers(1, &m_IBO);
-
-		// Load data into the index buffer and vertex buffer
-		glBindVertexArray(m_VAO);
-		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
-		if (m_Indices.size() > 0)
-		{
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(unsigned int), &m_Indices[0], GL_STATIC_DRAW);
+		calculateBounds();
+		if (!keepCPUData) {
+			releaseCPUData();
 		}
+	}
 
-		// Setup the format for the VAO
-		if (interleaved) {
-			size_t stride = bufferComponentCount * sizeof(float);
-			size_t offset = 0;
-
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
-			offset += 3 * sizeof(float);
-			if (m_Normals.size() > 0) {
-				glEnableVertexAttribArray(1);
-				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
-				offset += 3 * sizeof(float);
-			}
-			if (m_UVs.size() > 0) {
-				glEnableVertexAttribArray(2);
-				glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offset);
-				offset += 2 * sizeof(float);
-			}
-			if (m_Tangents.size() > 0) {
-				glEnableVertexAttribArray(3);
-				glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
-				offset += 3 * sizeof(float);
-			}
-			if (m_Bitangents.size() > 0) {
-				glEnableVertexAttribArray(4);
-				glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
-				offset += 3 * sizeof(float);
-			}
+	void Mesh::writeVertices(FullPrecisionVertex *vertices) const {
+		// Attributes the mesh doesn't have are zeroed
+		bool hasNormals = m_Normals.size() > 0, hasUVs = m_UVs.size() > 0, hasTangents = m_Tangents.size() > 0, hasBitangents = m_Bitangents.size() > 0;
+		for (size_t i = 0; i < m_Positions.size(); ++i) {
+			vertices[i].Position = m_Positions[i];
+			vertices[i].Normal = hasNormals ? m_Normals[i] : glm::vec3(0.0f);
+			vertices[i].UV = hasUVs ? m_UVs[i] : glm::vec2(0.0f);
+			vertices[i].Tangent = hasTangents ? m_Tangents[i] : glm::vec3(0.0f);
+			vertices[i].Bitangent = hasBitangents ? m_Bitangents[i] : glm::vec3(0.0f);
 		}
-		else {
-			size_t offset = 0;
-
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)offset);
-			offset += m_Positions.size() * 3 * sizeof(float);
-			if (m_Normals.size() > 0) {
-				glEnableVertexAttribArray(1);
-				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)offset);
-				offset += m_Normals.size() * 3 * sizeof(float);
-			}
-			if (m_UVs.size() > 0) {
-				glEnableVertexAttribArray(2);
-				glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void*)offset);
-				offset += m_UVs.size() * 2 * sizeof(float);
-			}
-			if (m_Tangents.size() > 0) {
-				glEnableVertexAttribArray(3);
-				glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (void*)offset);
-				offset += m_Tangents.size() * 3 * sizeof(float);
-			}
-			if (m_Bitangents.size() > 0) {
-				glEnableVertexAttribArray(4);
-				glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, (void*)offset);
-				offset += m_Bitangents.size() * 3 * sizeof(float);
-			}
+	}
+
+	void Mesh::writeVertices(StandardVertex *vertices) const {
+		bool hasNormals = m_Normals.size() > 0, hasUVs = m_UVs.size() > 0;
+		for (size_t i = 0; i < m_Positions.size(); ++i) {
+			vertices[i].Position = m_Positions[i];
+			vertices[i].Normal = hasNormals ? m_Normals[i] : glm::vec3(0.0f);
+			vertices[i].UV = hasUVs ? m_UVs[i] : glm::vec2(0.0f);
 		}
+	}
 
-		glBindVertexArray(0);
+	void Mesh::writeIndices(unsigned short *indices) const {
+		std::copy(m_Indices.begin(), m_Indices.end(), indices);
+	}
+
+	void Mesh::writeIndices(unsigned int *indices) const {
+		if (!m_Indices.empty())
+			memcpy(indices, &m_Indices[0], m_Indices.size() * sizeof(unsigned int));
+	}
+
+	void Mesh::calculateBounds() {
+		m_BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+		m_BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+		m_BoundingRadius = 0.0f;
+		for (const glm::vec3 &position : m_Positions) {
+			m_BoundsMin = glm::min(m_BoundsMin, position);
+			m_BoundsMax = glm::max(m_BoundsMax, position);
+			m_BoundingRadius = std::max(m_BoundingRadius, glm::length(position));
+		}
+	}
+
+	void Mesh::releaseCPUData() {
+		// Swap with empty vectors, clear() alone keeps the capacity allocated
+		std::vector<glm::vec3>().swap(m_Positions);
+		std::vector<glm::vec2>().swap(m_UVs);
+		std::vector<glm::vec3>().swap(m_Normals);
+		std::vector<glm::vec3>().swap(m_Tangents);
+		std::vector<glm::vec3>().swap(m_Bitangents);
+		std::vector<unsigned int>().swap(m_Indices);
+	}
+
+	void Mesh::releaseGPUData() {
+		if (m_VAO)
+			glDeleteVertexArrays(1, &m_VAO);
+		if (m_VBO)
+			glDeleteBuffers(1, &m_VBO);
+		if (m_IBO)
+			glDeleteBuffers(1, &m_IBO);
+		m_VAO = m_VBO = m_IBO = 0;
+	}
+
+	void* Mesh::mapNewBuffer(GLenum target, unsigned int &buffer, size_t size) {
+		glGenBuffers(1, &buffer);
+		glBindBuffer(target, buffer);
+		glBufferData(target, size, nullptr, GL_STATIC_DRAW);
+		if (size == 0)
+			return nullptr;
+
+		return glMapBufferRange(target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+
+	void Mesh::unmapBuffer(GLenum target) {
+		GLint mapped = GL_FALSE;
+		glGetBufferParameteriv(target, GL_BUFFER_MAPPED, &mapped);
+		if (mapped && glUnmapBuffer(target) == GL_FALSE) {
+			// The data store was lost while mapped (e.g. a display mode change), contents are undefined until the mesh is reloaded
+			Logger::getInstance().error("logged_files/mesh_creation.txt", "Mesh Creation", "Mesh buffer contents were corrupted while mapped");
+		}
+	}
+
+	void Mesh::bindVertexFormat(Shader *shader) const {
+		shader->setUniform("compactVertexFormat", m_IsCompact ? 1 : 0);
+		shader->setUniform("positionScale", m_PositionScale);
+		shader->setUniform("positionOffset", m_PositionOffset);
+	}
+
+	void Mesh::bindFullPrecisionVertexFormat(Shader *shader) {
+		shader->setUniform("compactVertexFormat", 0);
+		shader->setUniform("positionScale", glm::vec3(1.0f));
+		shader->setUniform("positionOffset", glm::vec3(0.0f));
 	}
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Material.h"
+#include "VertexLayout.h"
 
 #include <platform/OpenGL/IndexBuffer.h>
 #include <platform/OpenGL/VertexArray.h>
@@ -13,28 +14,78 @@ namespace arcane {
 		friend Model;
 	public:
 		Mesh();
-		Mesh(std::vector<glm::vec3> &positions, std::vector<unsigned int> &indices);
-		Mesh(std::vector<glm::vec3> &positions, std::vector<glm::vec2> &uvs, std::vector<unsigned int> &indices);
-		Mesh(std::vector<glm::vec3> &positions, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals, std::vector<unsigned int> &indices);
-		Mesh(std::vector<glm::vec3> &positions, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals, std::vector<glm::vec3> &tangents, std::vector<glm::vec3> &bitangents, std::vector<unsigned int> &indices);
+		Mesh(std::vector<glm::vec3> positions, std::vector<unsigned int> indices);
+		Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uvs, std::vector<unsigned int> indices);
+		Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uvs, std::vector<glm::vec3> normals, std::vector<unsigned int> indices);
+		Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uvs, std::vector<glm::vec3> normals, std::vector<glm::vec3> tangents, std::vector<glm::vec3> bitangents, std::vector<unsigned int> indices);
+		~Mesh();
 
-		// Commits all of the buffers their attributes to the GPU driver
-		void LoadData(bool interleaved = true);
+		// A mesh owns its GL buffers, so it can only be moved
+		Mesh(const Mesh &other) = delete;
+		Mesh& operator=(const Mesh &other) = delete;
+		Mesh(Mesh &&other) noexcept;
+		Mesh& operator=(Mesh &&other) noexcept;
+
+		// Commits all of the buffers their attributes to the GPU driver, using the smallest full precision layout that holds them. The CPU side
+		// copies are released afterwards unless keepCPUData is set, only keep them if something like collision or picking needs to read them
+		void LoadData(bool keepCPUData = false);
+
+		// Allocates the vertex buffer for a layout and hands the writer the mapped memory to fill in place, so the vertices are written
+		// once, straight from wherever they come from, with no staging copy
+		// Indices are attached to the vertex array, so they have to be loaded after the vertices
+		template<typename Layout, typename VertexWriter>
+		void loadVertices(unsigned int vertexCount, VertexWriter writeVertices);
+		// Index is unsigned short or unsigned int, meshes with fewer than 65536 vertices should use 16 bit indices to halve their index fetches
+		template<typename Index, typename IndexWriter>
+		void loadIndices(unsigned int indexCount, IndexWriter writeIndices);
+
+		// The CPU side of LoadData, interleaves the attribute arrays into vertices / narrows the indices. Don't touch GL, so they can be
+		// measured without a context (see MicroBenchmark)
+		void writeVertices(FullPrecisionVertex *vertices) const;
+		void writeVertices(StandardVertex *vertices) const;
+		void writeIndices(unsigned short *indices) const;
+		void writeIndices(unsigned int *indices) const;
+
+		// Quantized layouts are decoded with position * scale + offset
+		inline void setPositionDequantization(const glm::vec3 &scale, const glm::vec3 &offset) { m_PositionScale = scale; m_PositionOffset = offset; }
+
+		// Sets the uniforms the mesh vertex shaders need to decode this mesh's vertex format
+		void bindVertexFormat(Shader *shader) const;
+		static void bindFullPrecisionVertexFormat(Shader *shader);
 
 		void Draw() const;
+		void DrawInstanced(unsigned int instanceCount) const; // The vertex shader tells instances apart with gl_InstanceID
 
-		inline void setPositions(std::vector<glm::vec3> &positions) { m_Positions = positions; }
-		inline void setUVs(std::vector<glm::vec2> &uvs) { m_UVs = uvs; }
-		inline void setNormals(std::vector<glm::vec3> &normals) { m_Normals = normals; }
-		inline void setTangents(std::vector<glm::vec3> &tangents) { m_Tangents = tangents; }
-		inline void setBitangents(std::vector<glm::vec3> &bitangents) { m_Bitangents = bitangents; }
-		inline void setIndices(std::vector<unsigned int> &indices) { m_Indices = indices; }
+		inline void setPositions(std::vector<glm::vec3> positions) { m_Positions = std::move(positions); }
+		inline void setUVs(std::vector<glm::vec2> uvs) { m_UVs = std::move(uvs); }
+		inline void setNormals(std::vector<glm::vec3> normals) { m_Normals = std::move(normals); }
+		inline void setTangents(std::vector<glm::vec3> tangents) { m_Tangents = std::move(tangents); }
+		inline void setBitangents(std::vector<glm::vec3> bitangents) { m_Bitangents = std::move(bitangents); }
+		inline void setIndices(std::vector<unsigned int> indices) { m_Indices = std::move(indices); }
+
+		// Only filled once loaded if the mesh was asked to keep its CPU data
+		inline const std::vector<glm::vec3>& getPositions() const { return m_Positions; }
+		inline const std::vector<unsigned int>& getIndices() const { return m_Indices; }
+		inline bool hasCPUData() const { return !m_Positions.empty(); }
 
 		inline Material& getMaterial() { return m_Material; }
+		inline bool isCompact() const { return m_IsCompact; }
+		inline const glm::vec3& getBoundsMin() const { return m_BoundsMin; }
+		inline const glm::vec3& getBoundsMax() const { return m_BoundsMax; }
+		inline float getBoundingRadius() const { return m_BoundingRadius; }
 	protected:
 		unsigned int m_VAO, m_VBO, m_IBO;
+		unsigned int m_VertexCount, m_IndexCount;
+		GLenum m_IndexType;
 		Material m_Material;
 
+		bool m_IsCompact;
+		glm::vec3 m_PositionScale, m_PositionOffset;
+
+		// Model space, kept so the vertices don't have to be
+		glm::vec3 m_BoundsMin, m_BoundsMax;
+		float m_BoundingRadius; // Around the mesh's origin
+
 		std::vector<glm::vec3> m_Positions;
 		std::vector<glm::vec2> m_UVs;
 		std::vector<glm::vec3> m_Normals;
@@ -42,6 +93,49 @@ namespace arcane {
 		std::vector<glm::vec3> m_Bitangents;
 
 		std::vector<unsigned int> m_Indices;
+
+		void calculateBounds();
+		void releaseCPUData();
+		void releaseGPUData();
+
+		void* mapNewBuffer(GLenum target, unsigned int &buffer, size_t size);
+		void unmapBuffer(GLenum target);
 	};
 
+	template<typename Layout, typename VertexWriter>
+	void Mesh::loadVertices(unsigned int vertexCount, VertexWriter writeVertices) {
+		typedef typename Layout::VertexType Vertex;
+
+		releaseGPUData();
+		glGenVertexArrays(1, &m_VAO);
+		glBindVertexArray(m_VAO);
+
+		Vertex *vertices = static_cast<Vertex*>(mapNewBuffer(GL_ARRAY_BUFFER, m_VBO, vertexCount * sizeof(Vertex)));
+		if (vertices) {
+			writeVertices(vertices);
+		}
+		unmapBuffer(GL_ARRAY_BUFFER);
+		Layout::enableAttributes();
+
+		glBindVertexArray(0);
+		m_VertexCount = vertexCount;
+		m_IsCompact = Layout::IsQuantized;
+	}
+
+	template<typename Index, typename IndexWriter>
+	void Mesh::loadIndices(unsigned int indexCount, IndexWriter writeIndices) {
+		static_assert(std::is_same<Index, unsigned short>::value || std::is_same<Index, unsigned int>::value, "Mesh indices have to be unsigned short or unsigned int");
+		glBindVertexArray(m_VAO);
+
+		Index *indices = static_cast<Index*>(mapNewBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO, indexCount * sizeof(Index)));
+		if (indices) {
+			writeIndices(indices);
+		}
+		unmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+
+		glBindVertexArray(0);
+		m_IndexCount = indexCount;
+		m_IndexType = sizeof(Index) == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
+
 }
@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+namespace arcane {
+
+	std::vector<unsigned int> MeshOptimizer::optimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount, unsigned int cacheSize) {
+		std::vector<unsigned int> clusters;
+		unsigned int triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertexCount == 0)
+			return clusters;
+
+		// Vertex -> triangle adjacency, packed so each vertex's triangles are contiguous
+		std::vector<unsigned int> liveTriangles(vertexCount, 0);
+		for (unsigned int i = 0; i < triangleCount * 3; ++i) {
+			++liveTriangles[indices[i]];
+		}
+		std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+		for (unsigned int v = 0; v < vertexCount; ++v) {
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+		}
+		std::vector<unsigned int> adjacency(adjacencyOffsets[vertexCount]);
+		{
+			std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (unsigned int t = 0; t < triangleCount; ++t) {
+				for (unsigned int j = 0; j < 3; ++j) {
+					adjacency[fill[indices[t * 3 + j]]++] = t;
+				}
+			}
+		}
+
+		std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<unsigned int> deadEndStack;
+		std::vector<unsigned int> candidates;
+		std::vector<unsigned int> output;
+		output.reserve(triangleCount * 3);
+
+		int fanningVertex = 0;
+		unsigned int timestamp = cacheSize + 1;
+		unsigned int cursor = 1;
+		clusters.push_back(0);
+		while (fanningVertex >= 0) {
+			// Emit every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (unsigned int a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a) {
+				unsigned int triangle = adjacency[a];
+				if (emitted[triangle])
+					continue;
+
+				for (unsigned int j = 0; j < 3; ++j) {
+					unsigned int vertex = indices[triangle * 3 + j];
+					output.push_back(vertex);
+					deadEndStack.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangles[vertex];
+					if (timestamp - cacheTimestamps[vertex] > cacheSize) {
+						cacheTimestamps[vertex] = timestamp++;
+					}
+				}
+				emitted[triangle] = true;
+			}
+
+			// Prefer the candidate that will still be in the cache once its remaining triangles are emitted, oldest first
+			int nextVertex = -1;
+			int bestPriority = -1;
+			for (unsigned int vertex : candidates) {
+				if (liveTriangles[vertex] == 0)
+					continue;
+
+				int priority = 0;
+				if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+					priority = timestamp - cacheTimestamps[vertex];
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					nextVertex = vertex;
+				}
+			}
+
+			// Dead end, fall back to a recently used vertex with triangles left, then to the next unfinished vertex in input order
+			if (nextVertex == -1) {
+				while (!deadEndStack.empty()) {
+					unsigned int vertex = deadEndStack.back();
+					deadEndStack.pop_back();
+					if (liveTriangles[vertex] > 0) {
+						nextVertex = vertex;
+						break;
+					}
+				}
+				while (nextVertex == -1 && cursor < vertexCount) {
+					if (liveTriangles[cursor] > 0) {
+						nextVertex = cursor;
+					}
+					++cursor;
+				}
+
+				if (nextVertex != -1 && output.size() / 3 > clusters.back()) {
+					clusters.push_back(output.size() / 3);
+				}
+			}
+			fanningVertex = nextVertex;
+		}
+
+		std::copy(output.begin(), output.end(), indices.begin());
+
+		return clusters;
+	}
+
+	void MeshOptimizer::optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<unsigned int> &clusters, const glm::vec3 *positions, unsigned int vertexCount) {
+		unsigned int triangleCount = indices.size() / 3;
+		if (clusters.size() < 2 || vertexCount == 0)
+			return;
+
+		glm::vec3 meshCentroid(0.0f);
+		for (unsigned int v = 0; v < vertexCount; ++v) {
+			meshCentroid += positions[v];
+		}
+		meshCentroid /= (float)vertexCount;
+
+		// Clusters facing away from the centre are likely on the outside of the mesh, so drawing them first lets them occlude the inner ones
+		struct ClusterSortKey {
+			unsigned int Cluster;
+			float Occlusion;
+		};
+		std::vector<ClusterSortKey> sortKeys(clusters.size());
+		for (unsigned int c = 0; c < clusters.size(); ++c) {
+			unsigned int begin = clusters[c];
+			unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+			glm::vec3 centroid(0.0f), areaWeightedNormal(0.0f);
+			for (unsigned int t = begin; t < end; ++t) {
+				const glm::vec3 &p0 = positions[indices[t * 3]], &p1 = positions[indices[t * 3 + 1]], &p2 = positions[indices[t * 3 + 2]];
+				centroid += (p0 + p1 + p2) / 3.0f;
+				areaWeightedNormal += glm::cross(p1 - p0, p2 - p0);
+			}
+			centroid /= (float)(end - begin);
+
+			float normalLength = glm::length(areaWeightedNormal);
+			sortKeys[c].Cluster = c;
+			sortKeys[c].Occlusion = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, areaWeightedNormal / normalLength) : 0.0f;
+		}
+		std::stable_sort(sortKeys.begin(), sortKeys.end(), [](const ClusterSortKey &a, const ClusterSortKey &b) -> bool {
+			return a.Occlusion > b.Occlusion;
+		});
+
+		std::vector<unsigned int> output;
+		output.reserve(indices.size());
+		for (const ClusterSortKey &key : sortKeys) {
+			unsigned int begin = clusters[key.Cluster];
+			unsigned int end = key.Cluster + 1 < clusters.size() ? clusters[key.Cluster + 1] : triangleCount;
+			output.insert(output.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+		}
+		std::copy(output.begin(), output.end(), indices.begin());
+	}
+
+	unsigned int MeshOptimizer::optimizeVertexFetch(std::vector<unsigned int> &indices, unsigned int vertexCount, std::vector<unsigned int> &outRemap) {
+		outRemap.assign(vertexCount, ~0u);
+
+		unsigned int nextVertex = 0;
+		for (unsigned int &index : indices) {
+			if (outRemap[index] == ~0u) {
+				outRemap[index] = nextVertex++;
+			}
+			index = outRemap[index];
+		}
+		return nextVertex;
+	}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace arcane {
+
+	// Import time reordering of triangle lists so the GPU does less vertex work and shades fewer hidden pixels
+	class MeshOptimizer {
+	public:
+		// Reorders triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007). Returns the index of the first triangle of
+		// every cluster, a cluster starts wherever the reordering had to jump to an unrelated part of the mesh
+		static std::vector<unsigned int> optimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount, unsigned int cacheSize = MESH_VERTEX_CACHE_SIZE);
+
+		// Sorts the clusters so outward facing ones near the mesh's silhouette are drawn first and occlude the rest, triangle order within a cluster is kept
+		static void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<unsigned int> &clusters, const glm::vec3 *positions, unsigned int vertexCount);
+
+		// Renumbers vertices in the order the indices first reference them so vertex fetches walk the buffer linearly. Fills outRemap with the new
+		// index of every old vertex (~0u for vertices no triangle uses) and returns how many vertices are left
+		static unsigned int optimizeVertexFetch(std::vector<unsigned int> &indices, unsigned int vertexCount, std::vector<unsigned int> &outRemap);
+	};
+
+}
@@ -5,16 +5,19 @@
 
 namespace arcane {
 
-	Model::Model(const char *path) {
-		loadModel(path);
+	Model::Model() : m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_BoundingRadius(0.0f) {}
+
+	Model::Model(const char *path, bool keepCPUData) {
+		loadModel(path, keepCPUData);
 	}
 
-	Model::Model(const Mesh &mesh) {
-		m_Meshes.push_back(mesh);
+	Model::Model(Mesh &&mesh) {
+		m_Meshes.push_back(std::move(mesh));
+		calculateBounds();
 	}
 
-	Model::Model(const std::vector<Mesh> &meshes) {
-		m_Meshes = meshes;
+	Model::Model(std::vector<Mesh> &&meshes) : m_Meshes(std::move(meshes)) {
+		calculateBounds();
 	}
 
 	void Model::Draw(Shader *shader, RenderPassType pass) const {
@@ -23,119 +26,140 @@ namespace arcane {
 			if (pass == MaterialRequired) {
 				m_Meshes[i].m_Material.BindMaterialInformation(shader);
 			}
+			m_Meshes[i].bindVertexFormat(shader);
 			m_Meshes[i].Draw();
 		}
 	}
 
-	void Model::loadModel(const std::string &path) {
-		Assimp::Importer import;
-		const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+	void Model::requestTextureDetail(float screenSpaceSize) const {
+		for (unsigned int i = 0; i < m_Meshes.size(); ++i) {
+			m_Meshes[i].m_Material.requestTextureDetail(screenSpaceSize);
+		}
+	}
 
-		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-			Logger::getInstance().error("logged_files/model_loading.txt", "model initialization", import.GetErrorString());
-			return;
+	void Model::calculateBounds() {
+		m_BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+		m_BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+		m_BoundingRadius = 0.0f;
+		for (unsigned int i = 0; i < m_Meshes.size(); ++i) {
+			m_BoundsMin = glm::min(m_BoundsMin, m_Meshes[i].getBoundsMin());
+			m_BoundsMax = glm::max(m_BoundsMax, m_Meshes[i].getBoundsMax());
+			m_BoundingRadius = std::max(m_BoundingRadius, m_Meshes[i].getBoundingRadius());
 		}
+	}
 
-		m_Directory = path.substr(0, path.find_last_of('/'));
+	void Model::loadModel(const std::string &path, bool keepCPUData) {
+		m_BoundsMin = m_BoundsMax = glm::vec3(0.0f);
+		m_BoundingRadius = 0.0f;
 
-		processNode(scene->mRootNode, scene);
+		// Assimp only runs if the source changed since it was last cooked, otherwise the cooked model is mapped straight in
+		CookedModel cooked;
+		if (!ModelCooker::loadOrCookModel(path, cooked))
+			return;
+
+		loadCooked(cooked, keepCPUData);
 	}
 
-	void Model::processNode(aiNode *node, const aiScene *scene) {
-		// Process all of the node's meshes (if any)
-		for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
-			// Each node has an array of mesh indices, use these indices to get the meshes from the scene
-			aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-			m_Meshes.push_back(processMesh(mesh, scene));
+	void Model::loadCooked(const CookedModel &cooked, bool keepCPUData) {
+		const CookedModelHeader &header = cooked.getHeader();
+		m_BoundsMin = glm::make_vec3(header.BoundsMin);
+		m_BoundsMax = glm::make_vec3(header.BoundsMax);
+		m_BoundingRadius = header.BoundingRadius;
+
+		// Request every material texture first so they decode on the texture loader's workers while the meshes upload, then do all of the
+		// GL uploads back to back on this thread
+		m_Meshes.resize(header.MeshCount);
+		for (unsigned int i = 0; i < header.MeshCount; ++i) {
+			loadCookedMaterial(cooked, i, m_Meshes[i].m_Material);
 		}
-		// Process all of the node's children
-		for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-			processNode(node->mChildren[i], scene);
+		for (unsigned int i = 0; i < header.MeshCount; ++i) {
+			uploadCookedMesh(cooked, i, m_Meshes[i], keepCPUData);
 		}
 	}
 
-	Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
-		std::vector<glm::vec3> positions;
-		std::vector<glm::vec2> uvs;
-		std::vector<glm::vec3> normals;
-		std::vector<glm::vec3> tangents;
-		std::vector<glm::vec3> bitangents;
-		std::vector<unsigned int> indices;
-
-		positions.reserve(mesh->mNumVertices);
-		uvs.reserve(mesh->mNumVertices);
-		normals.reserve(mesh->mNumVertices);
-		tangents.reserve(mesh->mNumVertices);
-		bitangents.reserve(mesh->mNumVertices);
-		indices.reserve(mesh->mNumFaces * 3);
-
-		// Process vertices
-		for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-			glm::vec2 uvCoord;
-			// Texture Coordinates (check if there is texture coordinates)
-			if (mesh->mTextureCoords[0]) {
-				// A vertex can contain up to 8 different texture coordinates. We are just going to use one set of TexCoords per vertex so grab the first one
-				uvCoord.x = mesh->mTextureCoords[0][i].x;
-				uvCoord.y = mesh->mTextureCoords[0][i].y;
-			}
-			else {
-				uvCoord.x = 0.0f;
-				uvCoord.y = 0.0f;
-			}
-
-			positions.push_back(glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z));
-			uvs.push_back(glm::vec2(uvCoord.x, uvCoord.y));
-			normals.push_back(glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z));
-			tangents.push_back(glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z));
-			bitangents.push_back(glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z));
+	void Model::uploadCookedMesh(const CookedModel &cooked, unsigned int index, Mesh &newMesh, bool keepCPUData) {
+		const CookedMeshRecord &record = cooked.getMesh(index);
+		const unsigned char *vertexData = cooked.getVertexData(index);
+		const unsigned char *indexData = cooked.getIndexData(index);
+		bool isCompact = cooked.getHeader().VertexFormat == CookedCompactVertices;
+
+		// The blobs are already in GPU layout, so uploading is a copy from the mapped file into the mapped buffers
+		if (isCompact) {
+			newMesh.loadVertices<CompactVertexLayout>(record.VertexCount, [&](CompactVertex *vertices) {
+				memcpy(vertices, vertexData, record.VertexCount * sizeof(CompactVertex));
+			});
+			newMesh.setPositionDequantization(glm::make_vec3(record.PositionScale), glm::make_vec3(record.PositionOffset));
 		}
-
-		// Process Indices
-		// Loop through every face (triangle thanks to aiProcess_Triangulate) and stores its indices in our meshes indices. This will ensure they are in the right order.
-		for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-			aiFace face = mesh->mFaces[i];
-			for (unsigned int j = 0; j < face.mNumIndices; ++j) {
-				indices.push_back(face.mIndices[j]);
-			}
+		else {
+			newMesh.loadVertices<FullPrecisionVertexLayout>(record.VertexCount, [&](FullPrecisionVertex *vertices) {
+				memcpy(vertices, vertexData, record.VertexCount * sizeof(FullPrecisionVertex));
+			});
+		}
+		if (record.IndexSize == sizeof(unsigned short)) {
+			newMesh.loadIndices<unsigned short>(record.IndexCount, [&](unsigned short *indices) {
+				memcpy(indices, indexData, record.IndexCount * sizeof(unsigned short));
+			});
+		}
+		else {
+			newMesh.loadIndices<unsigned int>(record.IndexCount, [&](unsigned int *indices) {
+				memcpy(indices, indexData, record.IndexCount * sizeof(unsigned int));
+			});
 		}
 
-		Mesh newMesh(positions, uvs, normals, tangents, bitangents, indices);
-		newMesh.LoadData();
+		newMesh.m_BoundsMin = glm::make_vec3(record.BoundsMin);
+		newMesh.m_BoundsMax = glm::make_vec3(record.BoundsMax);
+		newMesh.m_BoundingRadius = record.BoundingRadius;
+
+		// Positions (dequantized for compact meshes) and indices for the caller's collision or picking
+		if (keepCPUData) {
+			newMesh.m_Positions.resize(record.VertexCount);
+			for (unsigned int i = 0; i < record.VertexCount; ++i) {
+				if (isCompact) {
+					const CompactVertex *vertex = reinterpret_cast<const CompactVertex*>(vertexData) + i;
+					glm::vec3 normalizedPosition(vertex->Position[0], vertex->Position[1], vertex->Position[2]);
+					newMesh.m_Positions[i] = normalizedPosition / 65535.0f * glm::make_vec3(record.PositionScale) + glm::make_vec3(record.PositionOffset);
+				}
+				else {
+					newMesh.m_Positions[i] = (reinterpret_cast<const FullPrecisionVertex*>(vertexData) + i)->Position;
+				}
+			}
 
-		// Process Materials (textures in this case)
-		if (mesh->mMaterialIndex >= 0) {
-			aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
-
-			// Attempt to load the materials if they can be found. However PBR materials will need to be manually configured since Assimp doesn't support them
-			// Only colour data for the renderer is considered sRGB, all other type of non-colour texture data shouldn't be corrected by the hardware
-			newMesh.m_Material.setAlbedoMap(loadMaterialTexture(material, aiTextureType_DIFFUSE, true));
-			newMesh.m_Material.setNormalMap(loadMaterialTexture(material, aiTextureType_NORMALS, false));
-			newMesh.m_Material.setAmbientOcclusionMap(loadMaterialTexture(material, aiTextureType_AMBIENT, false));
-			newMesh.m_Material.setDisplacementMap(loadMaterialTexture(material, aiTextureType_DISPLACEMENT, true));
+			newMesh.m_Indices.resize(record.IndexCount);
+			for (unsigned int i = 0; i < record.IndexCount; ++i) {
+				newMesh.m_Indices[i] = record.IndexSize == sizeof(unsigned short) ? reinterpret_cast<const unsigned short*>(indexData)[i] : reinterpret_cast<const unsigned int*>(indexData)[i];
+			}
 		}
-
-		return newMesh;
 	}
 
-	Texture* Model::loadMaterialTexture(aiMaterial *mat, aiTextureType type, bool isSRGB) {
-		// Log material constraints are being violated (1 texture per type for the standard shader)
-		if (mat->GetTextureCount(type) > 1)
-			Logger::getInstance().error("logged_files/material_creation.txt", "Mesh Loading", "Mesh's default material contains more than 1 texture for the same type, which currently isn't supported by the standard shader");
+	void Model::loadCookedMaterial(const CookedModel &cooked, unsigned int index, Material &material) {
+		// Process Materials (textures in this case)
+		// Attempt to load the materials if they can be found. However PBR materials will need to be manually configured since Assimp doesn't support them
+		// Only colour data for the renderer is considered sRGB, all other type of non-colour texture data shouldn't be corrected by the hardware
+		material.setAlbedoMap(loadMaterialTexture(cooked.getTexturePath(index, CookedAlbedoTexture), CookedAlbedoTexture, true));
+		material.setNormalMap(loadMaterialTexture(cooked.getTexturePath(index, CookedNormalTexture), CookedNormalTexture, false));
+		material.setAmbientOcclusionMap(loadMaterialTexture(cooked.getTexturePath(index, CookedAmbientOcclusionTexture), CookedAmbientOcclusionTexture, false));
+		material.setDisplacementMap(loadMaterialTexture(cooked.getTexturePath(index, CookedDisplacementTexture), CookedDisplacementTexture, true));
+	}
 
+	Texture* Model::loadMaterialTexture(const std::string &path, CookedTextureSlot slot, bool isSRGB) {
 		// Load the texture of a certain type, assuming there is one
-		if (mat->GetTextureCount(type) > 0) {
-			aiString str;
-			mat->GetTexture(type, 0, &str); // Grab only the first texture (standard shader only supports one texture of each type, it doesn't know how you want to do special blending)
-
-			// Assumption made: material stuff is located in the same directory as the model object
-			std::string fileToSearch = (m_Directory + "/" + std::string(str.C_Str())).c_str();
-
-			TextureSettings textureSettings;
-			textureSettings.IsSRGB = isSRGB;
-			return TextureLoader::load2DTexture(fileToSearch, &textureSettings);
+		if (path.empty())
+			return nullptr;
+
+		TextureSettings textureSettings;
+		textureSettings.IsSRGB = isSRGB;
+		textureSettings.IsNormalMap = slot == CookedNormalTexture;
+
+		// Placeholder shown while the texture streams in, picked so the surface is neutral for that map type
+		glm::vec4 placeholderColour(0.5f, 0.5f, 0.5f, 1.0f);
+		switch (slot) {
+		case CookedNormalTexture: placeholderColour = glm::vec4(0.5f, 0.5f, 1.0f, 1.0f); break;
+		case CookedAmbientOcclusionTexture: placeholderColour = glm::vec4(1.0f); break;
+		case CookedDisplacementTexture: placeholderColour = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); break;
+		default: break;
 		}
-
-		return nullptr;
+		m_Textures.push_back(AssetManager::load2DTextureAsync(path, textureSettings, placeholderColour));
+		return m_Textures.back().get();
 	}
 
 }
@@ -3,31 +3,44 @@
 #include <graphics/Shader.h>
 #include <graphics/mesh/Mesh.h>
 #include <graphics/renderer/renderpass/RenderPassType.h>
+#include <utils/loaders/AssetManager.h>
+#include <utils/loaders/ModelCooker.h>
 #include <utils/loaders/TextureLoader.h>
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
 namespace arcane {
 
 	class Model {
 	public:
-		Model(const char *path);
-		Model(const Mesh &mesh);
-		Model(const std::vector<Mesh> &meshes);
+		Model(); // Empty, for models the AssetManager fills in once they are loaded
+		// keepCPUData keeps each mesh's positions and indices around after upload, for collision or picking
+		Model(const char *path, bool keepCPUData = false);
+		Model(Mesh &&mesh);
+		Model(std::vector<Mesh> &&meshes);
 		
 		void Draw(Shader *shader, RenderPassType pass) const;
 
+		// Texture streaming feedback for every mesh's material
+		void requestTextureDetail(float screenSpaceSize) const;
+
 		inline std::vector<Mesh>& getMeshes() { return m_Meshes; }
+		inline float getBoundingRadius() const { return m_BoundingRadius; }
+		inline const glm::vec3& getBoundsMin() const { return m_BoundsMin; }
+		inline const glm::vec3& getBoundsMax() const { return m_BoundsMax; }
 	private:
+		friend class AssetManager;
+
 		std::vector<Mesh> m_Meshes;
-		std::string m_Directory;
+		std::vector<AssetHandle<Texture>> m_Textures; // Material textures, released along with the model
+		glm::vec3 m_BoundsMin, m_BoundsMax; // Model space
+		float m_BoundingRadius; // Around the model's origin, in model space
+
+		void calculateBounds();
 
-		void loadModel(const std::string &path);
-		void processNode(aiNode *node, const aiScene *scene);
-		Mesh processMesh(aiMesh *mesh, const aiScene *scene);
-		Texture* loadMaterialTexture(aiMaterial *mat, aiTextureType type, bool isSRGB);
+		void loadModel(const std::string &path, bool keepCPUData);
+		void loadCooked(const CookedModel &cooked, bool keepCPUData);
+		void loadCookedMaterial(const CookedModel &cooked, unsigned int index, Material &material);
+		void uploadCookedMesh(const CookedModel &cooked, unsigned int index, Mesh &newMesh, bool keepCPUData);
+		Texture* loadMaterialTexture(const std::string &path, CookedTextureSlot slot, bool isSRGB);
 	};
 
 }
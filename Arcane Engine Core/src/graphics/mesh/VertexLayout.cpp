@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "VertexLayout.h"
+
+#include <glm/gtc/packing.hpp>
+
+namespace arcane {
+
+	// Maps a unit vector onto the octahedron, then folds the lower half over so it fits in a 2D [-1, 1] square
+	static glm::vec2 octahedralEncode(const glm::vec3 &vector) {
+		float length = std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z);
+		if (length <= 0.0f)
+			return glm::vec2(0.0f);
+
+		glm::vec3 n = vector / length;
+		glm::vec2 encoded(n.x, n.y);
+		if (n.z < 0.0f) {
+			encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+			encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return encoded;
+	}
+
+	static int16_t packSnorm16(float value) {
+		return static_cast<int16_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	static uint16_t packUnorm16(float value) {
+		return static_cast<uint16_t>(std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	CompactVertex CompactVertex::encode(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &uv, const glm::vec3 &tangent, const glm::vec3 &bitangent,
+		const glm::vec3 &boundsMin, const glm::vec3 &boundsExtent)
+	{
+		CompactVertex vertex;
+
+		glm::vec3 normalizedPosition = (position - boundsMin) / boundsExtent;
+		vertex.Position[0] = packUnorm16(normalizedPosition.x);
+		vertex.Position[1] = packUnorm16(normalizedPosition.y);
+		vertex.Position[2] = packUnorm16(normalizedPosition.z);
+		vertex.Position[3] = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? 0 : 65535;
+
+		glm::vec2 encodedNormal = octahedralEncode(normal);
+		vertex.Normal[0] = packSnorm16(encodedNormal.x);
+		vertex.Normal[1] = packSnorm16(encodedNormal.y);
+
+		vertex.UV[0] = glm::packHalf1x16(uv.x);
+		vertex.UV[1] = glm::packHalf1x16(uv.y);
+
+		glm::vec2 encodedTangent = octahedralEncode(tangent);
+		vertex.Tangent[0] = packSnorm16(encodedTangent.x);
+		vertex.Tangent[1] = packSnorm16(encodedTangent.y);
+
+		return vertex;
+	}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+namespace arcane {
+
+	// Describes one attribute of an interleaved vertex. Everything is a template argument so a layout's attribute setup compiles down to
+	// a fixed sequence of glVertexAttribPointer calls
+	template<GLuint Location, GLint ComponentCount, GLenum ComponentType, GLboolean Normalized, size_t Offset>
+	struct VertexAttribute {
+		static void enable(GLsizei stride) {
+			glEnableVertexAttribArray(Location);
+			glVertexAttribPointer(Location, ComponentCount, ComponentType, Normalized, stride, (void*)Offset);
+		}
+	};
+
+	// Ties a vertex struct to the attributes it is read with. IsQuantized marks layouts the mesh shaders have to decode (see Mesh::bindVertexFormat)
+	template<typename Vertex, bool Quantized, typename... Attributes>
+	struct VertexLayout {
+		typedef Vertex VertexType;
+		static const bool IsQuantized = Quantized;
+
+		static void enableAttributes() {
+			int expand[] = { 0, (Attributes::enable(sizeof(Vertex)), 0)... };
+			(void)expand;
+		}
+	};
+
+	// Full precision vertex, matching the attribute locations every mesh shader reads
+	struct FullPrecisionVertex {
+		glm::vec3 Position;
+		glm::vec3 Normal;
+		glm::vec2 UV;
+		glm::vec3 Tangent;
+		glm::vec3 Bitangent;
+	};
+	typedef VertexLayout<FullPrecisionVertex, false,
+		VertexAttribute<0, 3, GL_FLOAT, GL_FALSE, offsetof(FullPrecisionVertex, Position)>,
+		VertexAttribute<1, 3, GL_FLOAT, GL_FALSE, offsetof(FullPrecisionVertex, Normal)>,
+		VertexAttribute<2, 2, GL_FLOAT, GL_FALSE, offsetof(FullPrecisionVertex, UV)>,
+		VertexAttribute<3, 3, GL_FLOAT, GL_FALSE, offsetof(FullPrecisionVertex, Tangent)>,
+		VertexAttribute<4, 3, GL_FLOAT, GL_FALSE, offsetof(FullPrecisionVertex, Bitangent)>> FullPrecisionVertexLayout;
+
+	// Full precision vertex without a tangent frame, for meshes that are never normal mapped
+	struct StandardVertex {
+		glm::vec3 Position;
+		glm::vec3 Normal;
+		glm::vec2 UV;
+	};
+	typedef VertexLayout<StandardVertex, false,
+		VertexAttribute<0, 3, GL_FLOAT, GL_FALSE, offsetof(StandardVertex, Position)>,
+		VertexAttribute<1, 3, GL_FLOAT, GL_FALSE, offsetof(StandardVertex, Normal)>,
+		VertexAttribute<2, 2, GL_FLOAT, GL_FALSE, offsetof(StandardVertex, UV)>> StandardVertexLayout;
+
+	// 20 byte vertex, the bitangent is rebuilt in the shader from cross(normal, tangent) so only its handedness is stored
+	struct CompactVertex {
+		uint16_t Position[4]; // Normalized against the mesh bounds, w holds the bitangent's handedness (0 = -1, max = +1)
+		int16_t Normal[2]; // Octahedral encoded
+		uint16_t UV[2]; // Half floats
+		int16_t Tangent[2]; // Octahedral encoded
+
+		// Quantizes a vertex, the position is remapped from [boundsMin, boundsMin + boundsExtent] to [0, 1]
+		static CompactVertex encode(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &uv, const glm::vec3 &tangent, const glm::vec3 &bitangent,
+			const glm::vec3 &boundsMin, const glm::vec3 &boundsExtent);
+	};
+	typedef VertexLayout<CompactVertex, true,
+		VertexAttribute<0, 4, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(CompactVertex, Position)>,
+		VertexAttribute<1, 2, GL_SHORT, GL_TRUE, offsetof(CompactVertex, Normal)>,
+		VertexAttribute<2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactVertex, UV)>,
+		VertexAttribute<3, 2, GL_SHORT, GL_TRUE, offsetof(CompactVertex, Tangent)>> CompactVertexLayout;
+
+}
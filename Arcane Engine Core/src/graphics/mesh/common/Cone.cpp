@@ -0,0 +1,34 @@
+#include "pch.h"
+#include "Cone.h"
+
+namespace arcane {
+
+	Cone::Cone(int segments) {
+		m_Positions.push_back(glm::vec3(0.0f, 0.0f, 0.0f)); // Apex
+		m_Positions.push_back(glm::vec3(0.0f, 0.0f, 1.0f)); // Base centre
+		for (int i = 0; i < segments; ++i)
+		{
+			float angle = (float)i / (float)segments * glm::pi<float>() * 2.0f;
+			m_Positions.push_back(glm::vec3(std::cos(angle), std::sin(angle), 1.0f));
+		}
+
+		for (int i = 0; i < segments; ++i)
+		{
+			unsigned int current = 2 + i;
+			unsigned int next = 2 + (i + 1) % segments;
+
+			// Side
+			m_Indices.push_back(0);
+			m_Indices.push_back(next);
+			m_Indices.push_back(current);
+
+			// Base
+			m_Indices.push_back(1);
+			m_Indices.push_back(current);
+			m_Indices.push_back(next);
+		}
+
+		LoadData();
+	}
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <graphics/mesh/Mesh.h>
+
+namespace arcane {
+
+	// Apex at the origin, opening along +z to a capped base of radius 1 at z = 1
+	class Cone : public Mesh {
+	public:
+		Cone(int segments = 16);
+	};
+
+}
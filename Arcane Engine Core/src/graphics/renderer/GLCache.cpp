@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "GLCache.h"
 
+#include <graphics/renderer/RenderStatistics.h>
+
 namespace arcane {
 
 	GLCache::GLCache() : m_ActiveShaderID(0) {
@@ -11,6 +13,8 @@ namespace arcane {
 		m_Cull = false;
 		m_FaceToCull = GL_BACK;
 		m_Multisample = false;;
+		m_DepthClamp = false;
+		m_DepthMask = true;
 		setDepthTest(true);
 		setFaceCull(true);
 	}
@@ -26,6 +30,7 @@ namespace arcane {
 
 	void GLCache::setDepthTest(bool choice) {
 		if (m_DepthTest != choice) {
+			RenderStatistics::addStateChange();
 			m_DepthTest = choice;
 			if (m_DepthTest)
 				glEnable(GL_DEPTH_TEST);
@@ -36,6 +41,7 @@ namespace arcane {
 
 	void GLCache::setStencilTest(bool choice) {
 		if (m_StencilTest != choice) {
+			RenderStatistics::addStateChange();
 			m_StencilTest = choice;
 			if (m_StencilTest)
 				glEnable(GL_STENCIL_TEST);
@@ -46,6 +52,7 @@ namespace arcane {
 
 	void GLCache::setBlend(bool choice) {
 		if (m_Blend != choice) {
+			RenderStatistics::addStateChange();
 			m_Blend = choice;
 			if (m_Blend)
 				glEnable(GL_BLEND);
@@ -56,6 +63,7 @@ namespace arcane {
 
 	void GLCache::setFaceCull(bool choice) {
 		if (m_Cull != choice) {
+			RenderStatistics::addStateChange();
 			m_Cull = choice;
 			if (m_Cull)
 				glEnable(GL_CULL_FACE);
@@ -66,6 +74,7 @@ namespace arcane {
 
 	void GLCache::setMultisample(bool choice) {
 		if (m_Multisample != choice) {
+			RenderStatistics::addStateChange();
 			m_Multisample = choice;
 			if (m_Multisample)
 				glEnable(GL_MULTISAMPLE);
@@ -74,15 +83,36 @@ namespace arcane {
 		}
 	}
 
+	void GLCache::setDepthClamp(bool choice) {
+		if (m_DepthClamp != choice) {
+			RenderStatistics::addStateChange();
+			m_DepthClamp = choice;
+			if (m_DepthClamp)
+				glEnable(GL_DEPTH_CLAMP);
+			else
+				glDisable(GL_DEPTH_CLAMP);
+		}
+	}
+
 	void GLCache::setDepthFunc(GLenum depthFunc) {
 		if (m_DepthFunc != depthFunc) {
+			RenderStatistics::addStateChange();
 			m_DepthFunc = depthFunc;
 			glDepthFunc(m_DepthFunc);
 		}
 	}
 
+	void GLCache::setDepthMask(bool writeDepth) {
+		if (m_DepthMask != writeDepth) {
+			RenderStatistics::addStateChange();
+			m_DepthMask = writeDepth;
+			glDepthMask(m_DepthMask ? GL_TRUE : GL_FALSE);
+		}
+	}
+
 	void GLCache::setStencilFunc(GLenum testFunc, int stencilFragValue, unsigned int stencilBitmask) {
 		if (m_StencilTestFunc != testFunc || m_StencilFragValue != stencilFragValue || m_StencilFuncBitmask != stencilBitmask) {
+			RenderStatistics::addStateChange();
 			m_StencilTestFunc = testFunc; 
 			m_StencilFragValue = stencilFragValue; 
 			m_StencilFuncBitmask = stencilBitmask;
@@ -93,6 +123,7 @@ namespace arcane {
 
 	void GLCache::setStencilOp(GLenum stencilFailOperation, GLenum depthFailOperation, GLenum depthPassOperation) {
 		if (m_StencilFailOperation != stencilFailOperation || m_DepthFailOperation != depthFailOperation || m_DepthPassOperation != depthPassOperation) {
+			RenderStatistics::addStateChange();
 			m_StencilFailOperation = stencilFailOperation;
 			m_DepthFailOperation = depthFailOperation;
 			m_DepthPassOperation = depthPassOperation;
@@ -103,6 +134,7 @@ namespace arcane {
 
 	void GLCache::setStencilWriteMask(unsigned int bitmask) {
 		if (m_StencilWriteBitmask != bitmask) {
+			RenderStatistics::addStateChange();
 			m_StencilWriteBitmask = bitmask;
 			glStencilMaskSeparate(GL_FRONT_AND_BACK, m_StencilWriteBitmask);
 		}
@@ -110,6 +142,7 @@ namespace arcane {
 
 	void GLCache::setBlendFunc(GLenum src, GLenum dst) {
 		if (m_BlendSrc != src || m_BlendDst != dst) {
+			RenderStatistics::addStateChange();
 			m_BlendSrc = src;
 			m_BlendDst = dst;
 			glBlendFunc(m_BlendSrc, m_BlendDst);
@@ -118,6 +151,7 @@ namespace arcane {
 
 	void GLCache::setCullFace(GLenum faceToCull) {
 		if (m_FaceToCull != faceToCull) {
+			RenderStatistics::addStateChange();
 			m_FaceToCull = faceToCull;
 			glCullFace(m_FaceToCull);
 		}
@@ -125,6 +159,7 @@ namespace arcane {
 
 	void GLCache::switchShader(Shader *shader) {
 		if (m_ActiveShaderID != shader->getShaderID()) {
+			RenderStatistics::addShaderSwitch();
 			m_ActiveShaderID = shader->getShaderID();
 			shader->enable();
 		}
@@ -132,6 +167,7 @@ namespace arcane {
 
 	void GLCache::switchShader(unsigned int shaderID) {
 		if (m_ActiveShaderID != shaderID) {
+			RenderStatistics::addShaderSwitch();
 			m_ActiveShaderID = shaderID;
 			glUseProgram(shaderID);
 		}
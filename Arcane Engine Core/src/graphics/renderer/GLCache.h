@@ -17,8 +17,10 @@ namespace arcane {
 		void setBlend(bool choice);
 		void setFaceCull(bool choice);
 		void setMultisample(bool choice);
+		void setDepthClamp(bool choice);
 
 		void setDepthFunc(GLenum depthFunc);
+		void setDepthMask(bool writeDepth);
 		void setStencilFunc(GLenum testFunc, int stencilFragValue, unsigned int stencilBitmask);
 		void setStencilOp(GLenum stencilFailOperation, GLenum depthFailOperation, GLenum depthPassOperation);
 		void setStencilWriteMask(unsigned int bitmask);
@@ -34,9 +36,11 @@ namespace arcane {
 		bool m_Blend;
 		bool m_Cull;
 		bool m_Multisample;
+		bool m_DepthClamp;
 
 		// Depth State
 		GLenum m_DepthFunc;
+		bool m_DepthMask;
 
 		// Stencil State
 		GLenum m_StencilTestFunc;
@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "GPUProfiler.h"
+
+namespace arcane {
+
+	// Static declarations
+	std::array<GPUProfiler::FrameQueries, GPU_PROFILER_FRAME_LATENCY> GPUProfiler::s_Frames;
+	uint64_t GPUProfiler::s_FrameIndex = 0;
+	unsigned int GPUProfiler::s_PassDepth = 0;
+	bool GPUProfiler::s_Initialized = false;
+	bool GPUProfiler::s_FrameActive = false;
+	bool GPUProfiler::s_WaitForResults = false;
+	GPUProfiler::ResolveCallback GPUProfiler::s_ResolveCallback;
+	std::vector<GPUPassTiming> GPUProfiler::s_PassTimings;
+	double GPUProfiler::s_FrameTime = 0.0;
+	uint64_t GPUProfiler::s_ResolvedFrameIndex = 0;
+
+	void GPUProfiler::init() {
+		if (s_Initialized)
+			return;
+
+		for (FrameQueries &frame : s_Frames) {
+			glGenQueries(2, frame.FrameQueries);
+			glGenQueries(GPU_PROFILER_MAX_PASSES * 2, frame.PassQueries);
+			frame.PassCount = 0;
+			frame.FrameIndex = 0;
+			frame.Pending = false;
+		}
+		s_PassTimings.reserve(GPU_PROFILER_MAX_PASSES);
+		s_Initialized = true;
+	}
+
+	void GPUProfiler::shutdown() {
+		if (!s_Initialized)
+			return;
+
+		for (FrameQueries &frame : s_Frames) {
+			glDeleteQueries(2, frame.FrameQueries);
+			glDeleteQueries(GPU_PROFILER_MAX_PASSES * 2, frame.PassQueries);
+		}
+		s_Initialized = false;
+		s_FrameActive = false;
+	}
+
+	void GPUProfiler::beginFrame() {
+		if (!s_Initialized || s_FrameActive)
+			return;
+
+		// The queries this frame reuses were issued GPU_PROFILER_FRAME_LATENCY frames ago
+		FrameQueries &frame = s_Frames[s_FrameIndex % GPU_PROFILER_FRAME_LATENCY];
+		if (frame.Pending) {
+			resolveFrame(frame);
+		}
+
+		frame.PassCount = 0;
+		frame.FrameIndex = s_FrameIndex;
+		glQueryCounter(frame.FrameQueries[0], GL_TIMESTAMP);
+		s_PassDepth = 0;
+		s_FrameActive = true;
+	}
+
+	void GPUProfiler::endFrame() {
+		if (!s_FrameActive)
+			return;
+
+		FrameQueries &frame = s_Frames[s_FrameIndex % GPU_PROFILER_FRAME_LATENCY];
+		glQueryCounter(frame.FrameQueries[1], GL_TIMESTAMP);
+		frame.Pending = true;
+		++s_FrameIndex;
+		s_FrameActive = false;
+	}
+
+	int GPUProfiler::beginPass(const char *name) {
+		if (!s_FrameActive)
+			return -1;
+
+		FrameQueries &frame = s_Frames[s_FrameIndex % GPU_PROFILER_FRAME_LATENCY];
+		if (frame.PassCount == GPU_PROFILER_MAX_PASSES)
+			return -1;
+
+		unsigned int pass = frame.PassCount++;
+		frame.PassNames[pass] = name;
+		frame.PassDepths[pass] = s_PassDepth++;
+		glQueryCounter(frame.PassQueries[pass * 2], GL_TIMESTAMP);
+		return (int)pass;
+	}
+
+	void GPUProfiler::endPass(int pass) {
+		if (pass < 0 || !s_FrameActive)
+			return;
+
+		FrameQueries &frame = s_Frames[s_FrameIndex % GPU_PROFILER_FRAME_LATENCY];
+		glQueryCounter(frame.PassQueries[pass * 2 + 1], GL_TIMESTAMP);
+		--s_PassDepth;
+	}
+
+	void GPUProfiler::flush() {
+		if (!s_Initialized)
+			return;
+
+		// Oldest first, the frame after the one being recorded is the oldest in the ring
+		for (unsigned int i = 1; i <= GPU_PROFILER_FRAME_LATENCY; ++i) {
+			FrameQueries &frame = s_Frames[(s_FrameIndex + i) % GPU_PROFILER_FRAME_LATENCY];
+			if (frame.Pending) {
+				bool wait = s_WaitForResults;
+				s_WaitForResults = true;
+				resolveFrame(frame);
+				s_WaitForResults = wait;
+			}
+		}
+	}
+
+	double GPUProfiler::getPassTime(const std::string &name) {
+		double milliseconds = 0.0;
+		for (const GPUPassTiming &timing : s_PassTimings) {
+			if (name == timing.Name)
+				milliseconds += timing.Milliseconds;
+		}
+		return milliseconds;
+	}
+
+	void GPUProfiler::resolveFrame(FrameQueries &frame) {
+		frame.Pending = false;
+
+		// Timestamps complete in submission order, so if the frame's last one has landed they all have. If the GPU is still that far
+		// behind the frame is dropped rather than waited on, unless waiting was asked for
+		if (!s_WaitForResults) {
+			GLint available = 0;
+			glGetQueryObjectiv(frame.FrameQueries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				return;
+		}
+
+		GLuint64 frameStart, frameEnd;
+		glGetQueryObjectui64v(frame.FrameQueries[0], GL_QUERY_RESULT, &frameStart);
+		glGetQueryObjectui64v(frame.FrameQueries[1], GL_QUERY_RESULT, &frameEnd);
+		s_FrameTime = (frameEnd - frameStart) / 1000000.0;
+
+		s_PassTimings.clear();
+		for (unsigned int i = 0; i < frame.PassCount; ++i) {
+			GLuint64 passStart, passEnd;
+			glGetQueryObjectui64v(frame.PassQueries[i * 2], GL_QUERY_RESULT, &passStart);
+			glGetQueryObjectui64v(frame.PassQueries[i * 2 + 1], GL_QUERY_RESULT, &passEnd);
+
+			GPUPassTiming timing;
+			timing.Name = frame.PassNames[i];
+			timing.Milliseconds = passEnd > passStart ? (passEnd - passStart) / 1000000.0 : 0.0;
+			timing.Depth = frame.PassDepths[i];
+			s_PassTimings.push_back(timing);
+		}
+		s_ResolvedFrameIndex = frame.FrameIndex;
+		if (s_ResolveCallback) {
+			s_ResolveCallback(frame.FrameIndex, s_FrameTime, s_PassTimings);
+		}
+	}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+namespace arcane {
+
+	struct GPUPassTiming {
+		const char *Name;
+		double Milliseconds;
+		unsigned int Depth; // Passes nested inside another pass are one deeper than it
+	};
+
+	// Times render passes with GL_TIMESTAMP queries. Each frame records into its own set of queries, which are only read back
+	// GPU_PROFILER_FRAME_LATENCY frames later when they have long finished, so nothing ever waits on the GPU
+	class GPUProfiler {
+	public:
+		typedef std::function<void(uint64_t frameIndex, double frameMilliseconds, const std::vector<GPUPassTiming> &passTimings)> ResolveCallback;
+
+		static void init(); // Needs the GL context
+		static void shutdown();
+
+		static void beginFrame();
+		static void endFrame();
+
+		// Returns -1 (and records nothing) outside of a frame or once the frame has GPU_PROFILER_MAX_PASSES passes
+		static int beginPass(const char *name);
+		static void endPass(int pass);
+
+		// Passes of the most recent frame that has been read back, in the order they were submitted
+		inline static const std::vector<GPUPassTiming>& getPassTimings() { return s_PassTimings; }
+		static double getPassTime(const std::string &name); // Summed over every pass with the name, 0 if it didn't run
+		inline static double getFrameTime() { return s_FrameTime; }
+		inline static uint64_t getResolvedFrameIndex() { return s_ResolvedFrameIndex; }
+		inline static uint64_t getFrameIndex() { return s_FrameIndex; } // Of the frame being recorded
+
+		// For benchmarking, where every frame's timings are needed. Waiting makes read back block instead of dropping frames the GPU
+		// hasn't finished, flush reads back every frame still pending, and the callback sees each frame as it is read back
+		inline static void setWaitForResults(bool wait) { s_WaitForResults = wait; }
+		inline static void setResolveCallback(const ResolveCallback &callback) { s_ResolveCallback = callback; }
+		static void flush();
+	private:
+		struct FrameQueries {
+			GLuint FrameQueries[2];
+			GLuint PassQueries[GPU_PROFILER_MAX_PASSES * 2];
+			const char *PassNames[GPU_PROFILER_MAX_PASSES];
+			unsigned int PassDepths[GPU_PROFILER_MAX_PASSES];
+			unsigned int PassCount;
+			uint64_t FrameIndex;
+			bool Pending;
+		};
+
+		static void resolveFrame(FrameQueries &frame);
+	private:
+		static std::array<FrameQueries, GPU_PROFILER_FRAME_LATENCY> s_Frames;
+		static uint64_t s_FrameIndex;
+		static unsigned int s_PassDepth;
+		static bool s_Initialized, s_FrameActive, s_WaitForResults;
+		static ResolveCallback s_ResolveCallback;
+
+		static std::vector<GPUPassTiming> s_PassTimings;
+		static double s_FrameTime;
+		static uint64_t s_ResolvedFrameIndex;
+	};
+
+	class GPUProfilerScope {
+	public:
+		GPUProfilerScope(const char *name) : m_Pass(GPUProfiler::beginPass(name)) {}
+		~GPUProfilerScope() { GPUProfiler::endPass(m_Pass); }
+
+		GPUProfilerScope(const GPUProfilerScope &scope) = delete;
+		GPUProfilerScope& operator=(const GPUProfilerScope &scope) = delete;
+	private:
+		int m_Pass;
+	};
+
+}
+
+#if GPU_PROFILER_ENABLED
+#define PROFILE_GPU_PASS(name) ::arcane::GPUProfilerScope PROFILER_CONCAT(gpuProfilerScope, __LINE__)(name)
+#else
+#define PROFILE_GPU_PASS(name)
+#endif
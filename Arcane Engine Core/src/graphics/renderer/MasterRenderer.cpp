@@ -1,19 +1,18 @@
 #include "pch.h"
 #include "MasterRenderer.h"
 
-#include <ui/RuntimePane.h>
-
 namespace arcane
 {
 
 	MasterRenderer::MasterRenderer(Scene3D *scene) : m_ActiveScene(scene),
-		m_ShadowmapPass(scene), m_PostProcessPass(scene), m_ForwardLightingPass(scene, true), m_EnvironmentProbePass(scene),
+		m_ShadowmapPass(scene), m_LightClusterPass(scene), m_PostProcessPass(scene), m_ForwardLightingPass(scene, true), m_EnvironmentProbePass(scene),
 		m_DeferredGeometryPass(scene), m_DeferredLightingPass(scene), m_PostGBufferForwardPass(scene)
 	{
 		m_GLCache = GLCache::getInstance();
 	}
 
 	void MasterRenderer::init() {
+		PROFILE_FUNCTION();
 		// State that should never change
 		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
@@ -22,38 +21,25 @@ namespace arcane
 	}
 
 	void MasterRenderer::render() {
+		PROFILE_FUNCTION();
 		/* Forward Rendering */
 #if FORWARD_RENDER
-#if DEBUG_ENABLED
-		glFinish();
-		m_ProfilingTimer.reset();
-#endif
 		ShadowmapPassOutput shadowmapOutput = m_ShadowmapPass.generateShadowmaps(m_ActiveScene->getCamera(), false);
-#if DEBUG_ENABLED
-		glFinish();
-		RuntimePane::setShadowmapTimer((float)m_ProfilingTimer.elapsed());
-#endif
+		LightClusterPassOutput clusterOutput = m_LightClusterPass.executeLightClusterPass(m_ActiveScene->getCamera(), Window::getRenderResolutionWidth(), Window::getRenderResolutionHeight(), false);
 
-		LightingPassOutput lightingOutput = m_ForwardLightingPass.executeLightingPass(shadowmapOutput, m_ActiveScene->getCamera(), false, true);
+		LightingPassOutput lightingOutput = m_ForwardLightingPass.executeLightingPass(shadowmapOutput, clusterOutput, m_ActiveScene->getCamera(), false, true);
 		m_PostProcessPass.executePostProcessPass(lightingOutput.outputFramebuffer);
 
 
 		/* Deferred Rendering */
 #else
-#if DEBUG_ENABLED
-		glFinish();
-		m_ProfilingTimer.reset();
-#endif
 		ShadowmapPassOutput shadowmapOutput = m_ShadowmapPass.generateShadowmaps(m_ActiveScene->getCamera(), false);
-#if DEBUG_ENABLED
-		glFinish();
-		RuntimePane::setShadowmapTimer((float)m_ProfilingTimer.elapsed());
-#endif
+		LightClusterPassOutput clusterOutput = m_LightClusterPass.executeLightClusterPass(m_ActiveScene->getCamera(), Window::getRenderResolutionWidth(), Window::getRenderResolutionHeight(), false);
 
 		GeometryPassOutput geometryOutput = m_DeferredGeometryPass.executeGeometryPass(m_ActiveScene->getCamera(), false);
 		PreLightingPassOutput preLightingOutput = m_PostProcessPass.executePreLightingPass(geometryOutput, m_ActiveScene->getCamera());
-		LightingPassOutput deferredLightingOutput = m_DeferredLightingPass.executeLightingPass(shadowmapOutput, geometryOutput, preLightingOutput, m_ActiveScene->getCamera(), true);
-		LightingPassOutput postGBufferForward = m_PostGBufferForwardPass.executeLightingPass(shadowmapOutput, deferredLightingOutput, m_ActiveScene->getCamera(), false, true);
+		LightingPassOutput deferredLightingOutput = m_DeferredLightingPass.executeLightingPass(shadowmapOutput, clusterOutput, geometryOutput, preLightingOutput, m_ActiveScene->getCamera(), true);
+		LightingPassOutput postGBufferForward = m_PostGBufferForwardPass.executeLightingPass(shadowmapOutput, clusterOutput, deferredLightingOutput, m_ActiveScene->getCamera(), false, true);
 		m_PostProcessPass.executePostProcessPass(postGBufferForward.outputFramebuffer);
 
 #endif
@@ -5,10 +5,10 @@
 #include <graphics/renderer/renderpass/deferred/PostGBufferForwardPass.h>
 #include <graphics/renderer/renderpass/forward/ForwardProbePass.h>
 #include <graphics/renderer/renderpass/forward/ForwardLightingPass.h>
+#include <graphics/renderer/renderpass/LightClusterPass.h>
 #include <graphics/renderer/renderpass/PostProcessPass.h>
 #include <graphics/renderer/renderpass/ShadowmapPass.h>
 #include <scene/Scene3D.h>
-#include <utils/Timer.h>
 
 namespace arcane
 {
@@ -26,6 +26,7 @@ namespace arcane
 
 		// Other passes
 		ShadowmapPass m_ShadowmapPass;
+		LightClusterPass m_LightClusterPass;
 		PostProcessPass m_PostProcessPass;
 
 		// Forward passes
@@ -36,8 +37,6 @@ namespace arcane
 		DeferredGeometryPass m_DeferredGeometryPass;
 		DeferredLightingPass m_DeferredLightingPass;
 		PostGBufferForward m_PostGBufferForwardPass;
-
-		Timer m_ProfilingTimer;
 	};
 
 }
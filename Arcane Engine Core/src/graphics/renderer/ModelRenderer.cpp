@@ -34,63 +34,88 @@ namespace arcane {
 		m_GLCache->setFaceCull(false);
 	}
 
-	void ModelRenderer::flushOpaque(Shader *shader, RenderPassType pass) {
+	void ModelRenderer::flushOpaque(Shader *shader, RenderPassType pass, ObjectLightAssigner *lightAssigner) {
 		m_GLCache->switchShader(shader);
+		if (lightAssigner)
+			assignObjectLights(m_OpaqueRenderQueue, lightAssigner);
 
 		// Render opaque objects
-		while (!m_OpaqueRenderQueue.empty()) {
+		for (size_t drawIndex = 0; !m_OpaqueRenderQueue.empty(); ++drawIndex) {
 			RenderableModel *current = m_OpaqueRenderQueue.front();
 
 			setupModelMatrix(current, shader, pass);
+			if (lightAssigner)
+				shader->setUniform("objectLightList", m_ObjectLightLists[drawIndex]);
 			current->draw(shader, pass);
 
 			m_OpaqueRenderQueue.pop_front();
 		}
 	}
 
-	void ModelRenderer::flushTransparent(Shader *shader, RenderPassType pass) {
+	void ModelRenderer::flushTransparent(Shader *shader, RenderPassType pass, ObjectLightAssigner *lightAssigner) {
 		m_GLCache->switchShader(shader);
 
-		// Sort then render transparent objects (from back to front, does not account for rotations or scaling)
-		std::sort(m_TransparentRenderQueue.begin(), m_TransparentRenderQueue.end(),
-			[this](RenderableModel *a, RenderableModel *b) -> bool
-		{
-			return glm::length2(m_Camera->getPosition() - a->getPosition()) > glm::length2(m_Camera->getPosition() - b->getPosition());
-		});
-		while (!m_TransparentRenderQueue.empty()) {
+		// Sort then render transparent objects
+		sortBackToFront(m_TransparentRenderQueue, m_Camera->getPosition());
+		if (lightAssigner)
+			assignObjectLights(m_TransparentRenderQueue, lightAssigner);
+		for (size_t drawIndex = 0; !m_TransparentRenderQueue.empty(); ++drawIndex) {
 			RenderableModel *current = m_TransparentRenderQueue.front();
 
 			m_GLCache->setBlend(true);
 			m_GLCache->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 			setupModelMatrix(current, shader, pass);
+			if (lightAssigner)
+				shader->setUniform("objectLightList", m_ObjectLightLists[drawIndex]);
 			current->draw(shader, pass);
 
 			m_TransparentRenderQueue.pop_front();
 		}
 	}
 
-	// TODO: Currently only supports two levels for hierarchical transformations
-	// Make it work with any number of levels
-	void ModelRenderer::setupModelMatrix(RenderableModel *renderable, Shader *shader, RenderPassType pass) {
-		glm::mat4 model(1);
+	void ModelRenderer::sortBackToFront(std::deque<RenderableModel*> &renderQueue, const glm::vec3 &viewPosition) {
+		// Does not account for rotations or scaling
+		std::sort(renderQueue.begin(), renderQueue.end(),
+			[&viewPosition](RenderableModel *a, RenderableModel *b) -> bool
+		{
+			return glm::length2(viewPosition - a->getPosition()) > glm::length2(viewPosition - b->getPosition());
+		});
+	}
+
+	glm::mat4 ModelRenderer::calculateModelMatrix(const RenderableModel *renderable) {
 		glm::mat4 translate = glm::translate(glm::mat4(1.0f), renderable->getPosition());
 		glm::mat4 rotate = glm::toMat4(renderable->getOrientation());
 		glm::mat4 scale = glm::scale(glm::mat4(1.0f), renderable->getScale());
+		glm::mat4 model = translate * rotate * scale;
 
-		if (renderable->getParent()) {
-			// Only apply scale locally
-			model = glm::translate(glm::mat4(1.0f), renderable->getParent()->getPosition()) * glm::toMat4(renderable->getParent()->getOrientation()) * translate * rotate * scale;
+		// Every ancestor's translation and rotation apply, scale is only applied locally
+		for (const RenderableModel *parent = renderable->getParent(); parent; parent = parent->getParent()) {
+			model = glm::translate(glm::mat4(1.0f), parent->getPosition()) * glm::toMat4(parent->getOrientation()) * model;
 		}
-		else {
-			model = translate * rotate * scale;
+		return model;
+	}
+
+	void ModelRenderer::assignObjectLights(const std::deque<RenderableModel*> &renderQueue, ObjectLightAssigner *lightAssigner) {
+		PROFILE_FUNCTION();
+		// The model's bounding radius is around its origin, and only the renderable's own scale applies to it
+		m_BoundingSpheres.resize(renderQueue.size());
+		for (size_t i = 0; i < renderQueue.size(); ++i) {
+			const RenderableModel *renderable = renderQueue[i];
+			const glm::vec3 &scale = renderable->getScale();
+			glm::vec3 centre = glm::vec3(calculateModelMatrix(renderable)[3]);
+			m_BoundingSpheres[i] = glm::vec4(centre, renderable->getModel()->getBoundingRadius() * std::max(scale.x, std::max(scale.y, scale.z)));
 		}
 
+		lightAssigner->assignLights(m_BoundingSpheres, m_ObjectLightLists);
+	}
+
+	void ModelRenderer::setupModelMatrix(RenderableModel *renderable, Shader *shader, RenderPassType pass) {
+		glm::mat4 model = calculateModelMatrix(renderable);
 		shader->setUniform("model", model);
 
 		if (pass == MaterialRequired) {
-			glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
-			shader->setUniform("normalMatrix", normalMatrix);
+			shader->setUniform("normalMatrix", calculateNormalMatrix(model));
 		}
 	}
 
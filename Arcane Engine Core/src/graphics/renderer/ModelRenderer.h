@@ -4,6 +4,7 @@
 
 #include <scene/RenderableModel.h>
 #include <graphics/camera/FPSCamera.h>
+#include <graphics/lights/ObjectLightAssigner.h>
 #include <graphics/mesh/Model.h>
 #include <graphics/mesh/common/Quad.h>
 #include <graphics/mesh/common/Cube.h>
@@ -21,16 +22,25 @@ namespace arcane {
 		void setupOpaqueRenderState();
 		void setupTransparentRenderState();
 
-		void flushOpaque(Shader *shader, RenderPassType pass);
-		void flushTransparent(Shader *shader, RenderPassType pass);
+		// Forward shading passes a light assigner, so every draw gets its own list of the lights that reach it
+		void flushOpaque(Shader *shader, RenderPassType pass, ObjectLightAssigner *lightAssigner = nullptr);
+		void flushTransparent(Shader *shader, RenderPassType pass, ObjectLightAssigner *lightAssigner = nullptr);
+
+		// The CPU side of flushing, kept free of GL so it can be measured without a context (see MicroBenchmark)
+		static void sortBackToFront(std::deque<RenderableModel*> &renderQueue, const glm::vec3 &viewPosition);
+		static glm::mat4 calculateModelMatrix(const RenderableModel *renderable);
+		inline static glm::mat3 calculateNormalMatrix(const glm::mat4 &model) { return glm::mat3(glm::transpose(glm::inverse(model))); }
 	public:
 		Quad NDC_Plane;
 		Cube NDC_Cube;
 	private:
-		void ModelRenderer::setupModelMatrix(RenderableModel *renderable, Shader *shader, RenderPassType pass);
+		void setupModelMatrix(RenderableModel *renderable, Shader *shader, RenderPassType pass);
+		void assignObjectLights(const std::deque<RenderableModel*> &renderQueue, ObjectLightAssigner *lightAssigner);
 
 		std::deque<RenderableModel*> m_OpaqueRenderQueue;
 		std::deque<RenderableModel*> m_TransparentRenderQueue;
+		std::vector<glm::vec4> m_BoundingSpheres;
+		std::vector<glm::uvec2> m_ObjectLightLists; // In the same order as the queue being flushed
 
 		FPSCamera *m_Camera;
 		GLCache *m_GLCache;
@@ -0,0 +1,13 @@
+#include "pch.h"
+#include "RenderStatistics.h"
+
+namespace arcane {
+
+	// Static declarations
+	RenderCounters RenderStatistics::s_Counters = {};
+
+	void RenderStatistics::reset() {
+		s_Counters = RenderCounters();
+	}
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace arcane {
+
+	struct RenderCounters {
+		uint64_t DrawCalls, Triangles;
+		uint64_t ShaderSwitches, StateChanges; // Only what reaches GL through the GLCache
+	};
+
+	// Counts the GL work submitted since the last reset, main loop resets it every frame
+	class RenderStatistics {
+	public:
+		inline static void addDrawCall(uint64_t triangles) { ++s_Counters.DrawCalls; s_Counters.Triangles += triangles; }
+		inline static void addShaderSwitch() { ++s_Counters.ShaderSwitches; }
+		inline static void addStateChange() { ++s_Counters.StateChanges; }
+
+		inline static const RenderCounters& getCounters() { return s_Counters; }
+		static void reset();
+	private:
+		static RenderCounters s_Counters;
+	};
+
+}
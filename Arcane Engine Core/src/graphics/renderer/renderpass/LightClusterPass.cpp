@@ -0,0 +1,393 @@
+#include "pch.h"
+#include "LightClusterPass.h"
+
+#include <graphics/renderer/GPUProfiler.h>
+#include <utils/loaders/ShaderLoader.h>
+
+namespace arcane {
+
+	static const size_t s_ClusterCount = LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y * LIGHT_CLUSTER_GRID_Z;
+	static const unsigned int s_ClusteringGroupSize = 64; // Has to match local_size_x in LightClustering.glsl
+
+	static bool sphereIntersectsBounds(const glm::vec4 &sphere, const LightClusterBounds &bounds) {
+		glm::vec3 closestPoint = glm::clamp(glm::vec3(sphere), bounds.Min, bounds.Max);
+		return glm::length2(closestPoint - glm::vec3(sphere)) <= sphere.w * sphere.w;
+	}
+
+	// Only the lights binned to the cluster's row are tested, the ones whose tile range misses the cluster are skipped before the sphere test
+	static unsigned int appendClusterLights(const LightClusterBounds &clusterBounds, int tileX, size_t row, const std::vector<glm::vec4> &lightSpheres, const LightClusterBins &bins,
+		unsigned int maxLights, std::vector<unsigned int> &outIndices)
+	{
+		unsigned int lightCount = 0;
+		for (unsigned int i = bins.RowOffsets[row]; i < bins.RowOffsets[row + 1] && lightCount < maxLights; ++i) {
+			unsigned int light = bins.RowLights[i];
+			const LightClusterRange &range = bins.Ranges[light];
+			if (tileX >= range.Min.x && tileX <= range.Max.x && sphereIntersectsBounds(lightSpheres[light], clusterBounds)) {
+				outIndices.push_back(light);
+				lightCount++;
+			}
+		}
+		return lightCount;
+	}
+
+	LightClusterPass::LightClusterPass(Scene3D *scene) : RenderPass(scene), m_LightIndexCapacity(s_ClusterCount * LIGHT_CLUSTER_AVERAGE_LIGHTS),
+		m_GPULightIndexCapacity(s_ClusterCount * LIGHT_CLUSTER_AVERAGE_LIGHTS), m_CullOnGPU(LIGHT_CLUSTER_GPU_CULLING != 0), m_NextCounterSlot(0),
+		m_BoundsProjection(0.0f), m_ThreadLightIndices(std::max(LIGHT_CLUSTER_CPU_THREADS, 1)), m_CullingGeneration(0), m_BusyCullingWorkers(0), m_ShutdownCullingWorkers(false)
+	{
+		m_ClusteringShader = ShaderLoader::loadShader("src/shaders/compute/LightClustering.glsl");
+
+		glGenBuffers(1, &m_ClusterBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ClusterBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, s_ClusterCount * sizeof(glm::uvec2), nullptr, GL_DYNAMIC_DRAW);
+
+		glGenBuffers(1, &m_LightIndexBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightIndexBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_LightIndexCapacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+
+		glGenBuffers(LIGHT_CLUSTER_READBACK_LATENCY, m_LightIndexCounterBuffers.data());
+		for (GLuint counterBuffer : m_LightIndexCounterBuffers) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int), nullptr, GL_DYNAMIC_READ);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		m_LightIndexCounterFences.fill(nullptr);
+	}
+
+	LightClusterPass::~LightClusterPass() {
+		{
+			std::lock_guard<std::mutex> lock(m_CullingMutex);
+			m_ShutdownCullingWorkers = true;
+		}
+		m_CullingStartCondition.notify_all();
+		for (std::thread &worker : m_CullingWorkers) {
+			worker.join();
+		}
+
+		glDeleteBuffers(1, &m_ClusterBuffer);
+		glDeleteBuffers(1, &m_LightIndexBuffer);
+		glDeleteBuffers(LIGHT_CLUSTER_READBACK_LATENCY, m_LightIndexCounterBuffers.data());
+		for (GLsync fence : m_LightIndexCounterFences) {
+			if (fence)
+				glDeleteSync(fence);
+		}
+	}
+
+	LightClusterPassOutput LightClusterPass::executeLightClusterPass(ICamera *camera, unsigned int width, unsigned int height, bool renderOnlyStatic) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Light Clustering");
+		m_ActiveScene->getDynamicLightManager()->updateLightBuffers(renderOnlyStatic);
+
+		if (m_CullOnGPU) {
+			cullOnGPU(camera, renderOnlyStatic);
+		}
+		else {
+			cullOnCPU(camera, renderOnlyStatic);
+		}
+
+		// Every pass that shades with the clusters reads the same buffers
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTER_BUFFER_BINDING, m_ClusterBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BUFFER_BINDING, m_LightIndexBuffer);
+
+		// Render pass output
+		float logDepthRange = std::log(FAR_PLANE / NEAR_PLANE);
+		LightClusterPassOutput passOutput;
+		passOutput.clusterGridSize = glm::ivec3(LIGHT_CLUSTER_GRID_X, LIGHT_CLUSTER_GRID_Y, LIGHT_CLUSTER_GRID_Z);
+		passOutput.clusterTileSize = glm::vec2((float)width / LIGHT_CLUSTER_GRID_X, (float)height / LIGHT_CLUSTER_GRID_Y);
+		passOutput.clusterSliceScaleBias = glm::vec2(LIGHT_CLUSTER_GRID_Z / logDepthRange, -LIGHT_CLUSTER_GRID_Z * std::log(NEAR_PLANE) / logDepthRange);
+		return passOutput;
+	}
+
+	void LightClusterPass::bindLightClusters(Shader *shader, const LightClusterPassOutput &clusterData) {
+		shader->setUniform("clusterGridSize", clusterData.clusterGridSize);
+		shader->setUniform("clusterTileSize", clusterData.clusterTileSize);
+		shader->setUniform("clusterSliceScaleBias", clusterData.clusterSliceScaleBias);
+	}
+
+	void LightClusterPass::cullOnGPU(ICamera *camera, bool renderOnlyStatic) {
+		DynamicLightManager *lightManager = m_ActiveScene->getDynamicLightManager();
+
+		unsigned int counterSlot = m_NextCounterSlot;
+		m_NextCounterSlot = (m_NextCounterSlot + 1) % LIGHT_CLUSTER_READBACK_LATENCY;
+		readBackLightIndexCount(counterSlot);
+
+		// The CPU path grows the index list to what it uploads, and an overflow read back may have grown what the GPU needs
+		if (m_LightIndexCapacity != m_GPULightIndexCapacity) {
+			m_LightIndexCapacity = m_GPULightIndexCapacity;
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightIndexBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, m_LightIndexCapacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+		}
+
+		unsigned int zero = 0;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightIndexCounterBuffers[counterSlot]);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTER_BUFFER_BINDING, m_ClusterBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BUFFER_BINDING, m_LightIndexBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_COUNTER_BINDING, m_LightIndexCounterBuffers[counterSlot]);
+
+		m_GLCache->switchShader(m_ClusteringShader);
+		m_ClusteringShader->setUniform("view", camera->getViewMatrix());
+		m_ClusteringShader->setUniform("projectionInverse", glm::inverse(camera->getProjectionMatrix()));
+		m_ClusteringShader->setUniform("clusterGridSize", glm::ivec3(LIGHT_CLUSTER_GRID_X, LIGHT_CLUSTER_GRID_Y, LIGHT_CLUSTER_GRID_Z));
+		m_ClusteringShader->setUniform("nearPlane", NEAR_PLANE);
+		m_ClusteringShader->setUniform("farPlane", FAR_PLANE);
+		m_ClusteringShader->setUniform("numPointLights", (int)lightManager->getPointLights().getCount(renderOnlyStatic));
+		m_ClusteringShader->setUniform("numSpotLights", (int)lightManager->getSpotLights().getCount(renderOnlyStatic));
+		m_ClusteringShader->setUniform("maxLightIndices", (int)m_LightIndexCapacity);
+
+		glDispatchCompute((GLuint)((s_ClusterCount + s_ClusteringGroupSize - 1) / s_ClusteringGroupSize), 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+		m_LightIndexCounterFences[counterSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	void LightClusterPass::readBackLightIndexCount(unsigned int counterSlot) {
+		GLsync &fence = m_LightIndexCounterFences[counterSlot];
+		if (!fence)
+			return;
+
+		// A dispatch the GPU still hasn't finished is skipped rather than waited on, a later one will report the same overflow
+		GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		glDeleteSync(fence);
+		fence = nullptr;
+		if (waitResult != GL_ALREADY_SIGNALED && waitResult != GL_CONDITION_SATISFIED)
+			return;
+
+		unsigned int requiredIndices = 0;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightIndexCounterBuffers[counterSlot]);
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(requiredIndices), &requiredIndices);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		if (requiredIndices <= m_GPULightIndexCapacity)
+			return;
+
+		// Leave some headroom so a few more lights coming into view don't overflow it again straight away
+		Logger::getInstance().warning("logged_files/warnings.txt", "Light Clustering", "Light index list overflowed (" + std::to_string(requiredIndices) + " of " + std::to_string(m_GPULightIndexCapacity) + " indices), clusters lost their lights until it grows");
+		m_GPULightIndexCapacity = (size_t)requiredIndices + requiredIndices / 2;
+	}
+
+	void LightClusterPass::cullOnCPU(ICamera *camera, bool renderOnlyStatic) {
+		DynamicLightManager *lightManager = m_ActiveScene->getDynamicLightManager();
+
+		// Cluster bounds only depend on the projection
+		glm::mat4 projection = camera->getProjectionMatrix();
+		if (projection != m_BoundsProjection) {
+			calculateClusterBounds(projection, m_ClusterBounds);
+			m_BoundsProjection = projection;
+		}
+
+		// Spot lights are culled with the sphere bounding their whole range, it is conservative for narrow cones
+		glm::mat4 view = camera->getViewMatrix();
+		const PointLightArrays &pointLights = lightManager->getPointLights();
+		m_PointLightSpheres.resize(pointLights.getCount(renderOnlyStatic));
+		for (size_t i = 0; i < m_PointLightSpheres.size(); ++i) {
+			m_PointLightSpheres[i] = glm::vec4(glm::vec3(view * glm::vec4(pointLights.Positions[i], 1.0f)), pointLights.AttenuationRadii[i]);
+		}
+		const SpotLightArrays &spotLights = lightManager->getSpotLights();
+		m_SpotLightSpheres.resize(spotLights.getCount(renderOnlyStatic));
+		for (size_t i = 0; i < m_SpotLightSpheres.size(); ++i) {
+			m_SpotLightSpheres[i] = glm::vec4(glm::vec3(view * glm::vec4(spotLights.Positions[i], 1.0f)), spotLights.AttenuationRadii[i]);
+		}
+
+		// Binning is cheap next to the cluster tests, so it is done up front and shared by every thread
+		binLights(projection, m_PointLightSpheres, m_PointLightBins);
+		binLights(projection, m_SpotLightSpheres, m_SpotLightBins);
+
+		// Split the clusters between the worker threads and this one, each builds its own index list
+		m_Clusters.resize(s_ClusterCount);
+		size_t threadCount = m_ThreadLightIndices.size();
+		if (m_CullingWorkers.empty()) {
+			for (size_t i = 1; i < threadCount; ++i) {
+				m_CullingWorkers.push_back(std::thread(&LightClusterPass::cullingWorkerLoop, this, i));
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_CullingMutex);
+			m_BusyCullingWorkers = m_CullingWorkers.size();
+			m_CullingGeneration++;
+		}
+		m_CullingStartCondition.notify_all();
+		cullClusterRange(0);
+		{
+			std::unique_lock<std::mutex> lock(m_CullingMutex);
+			m_CullingDoneCondition.wait(lock, [this]() { return m_BusyCullingWorkers == 0; });
+		}
+
+		// Stitch the index lists together, the offsets move by the size of the lists before them
+		size_t clustersPerThread = (s_ClusterCount + threadCount - 1) / threadCount;
+		size_t indexCount = 0;
+		for (size_t i = 0; i < threadCount; ++i) {
+			size_t first = std::min(i * clustersPerThread, s_ClusterCount);
+			size_t last = std::min(first + clustersPerThread, s_ClusterCount);
+			for (size_t cluster = first; cluster < last; ++cluster) {
+				m_Clusters[cluster].x += (unsigned int)indexCount;
+			}
+			indexCount += m_ThreadLightIndices[i].size();
+		}
+
+		// Both buffers keep their storage, the index list is only reallocated when it has to grow
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ClusterBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, s_ClusterCount * sizeof(glm::uvec2), m_Clusters.data());
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightIndexBuffer);
+		if (indexCount > m_LightIndexCapacity) {
+			m_LightIndexCapacity = indexCount + indexCount / 2;
+			glBufferData(GL_SHADER_STORAGE_BUFFER, m_LightIndexCapacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+		}
+		size_t offset = 0;
+		for (const std::vector<unsigned int> &indices : m_ThreadLightIndices) {
+			if (!indices.empty())
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset * sizeof(unsigned int), indices.size() * sizeof(unsigned int), indices.data());
+			offset += indices.size();
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	void LightClusterPass::cullingWorkerLoop(size_t threadIndex) {
+		uint64_t culledGeneration = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(m_CullingMutex);
+				m_CullingStartCondition.wait(lock, [this, culledGeneration]() { return m_ShutdownCullingWorkers || m_CullingGeneration != culledGeneration; });
+				if (m_ShutdownCullingWorkers)
+					return;
+				culledGeneration = m_CullingGeneration;
+			}
+
+			{
+				PROFILE_ZONE("Light Culling Worker");
+				cullClusterRange(threadIndex);
+			}
+
+			bool lastToFinish;
+			{
+				std::lock_guard<std::mutex> lock(m_CullingMutex);
+				lastToFinish = --m_BusyCullingWorkers == 0;
+			}
+			if (lastToFinish)
+				m_CullingDoneCondition.notify_one();
+		}
+	}
+
+	void LightClusterPass::cullClusterRange(size_t threadIndex) {
+		size_t clustersPerThread = (s_ClusterCount + m_ThreadLightIndices.size() - 1) / m_ThreadLightIndices.size();
+		size_t first = std::min(threadIndex * clustersPerThread, s_ClusterCount);
+		cullLights(m_ClusterBounds, m_PointLightSpheres, m_PointLightBins, m_SpotLightSpheres, m_SpotLightBins, first, std::min(first + clustersPerThread, s_ClusterCount), m_Clusters, m_ThreadLightIndices[threadIndex]);
+	}
+
+	void LightClusterPass::calculateClusterBounds(const glm::mat4 &projection, std::vector<LightClusterBounds> &outBounds) {
+		glm::mat4 projectionInverse = glm::inverse(projection);
+		outBounds.resize(s_ClusterCount);
+
+		size_t cluster = 0;
+		for (int z = 0; z < LIGHT_CLUSTER_GRID_Z; ++z) {
+			// Slices are spaced logarithmically so clusters stay roughly cubic along the whole depth range
+			float sliceNear = NEAR_PLANE * std::pow(FAR_PLANE / NEAR_PLANE, (float)z / LIGHT_CLUSTER_GRID_Z);
+			float sliceFar = NEAR_PLANE * std::pow(FAR_PLANE / NEAR_PLANE, (float)(z + 1) / LIGHT_CLUSTER_GRID_Z);
+
+			for (int y = 0; y < LIGHT_CLUSTER_GRID_Y; ++y) {
+				for (int x = 0; x < LIGHT_CLUSTER_GRID_X; ++x) {
+					LightClusterBounds &bounds = outBounds[cluster++];
+					bounds.Min = glm::vec3(std::numeric_limits<float>::max());
+					bounds.Max = glm::vec3(-std::numeric_limits<float>::max());
+
+					// Push the rays through the tile's corners out to the slice's near and far depth
+					for (int corner = 0; corner < 4; ++corner) {
+						glm::vec2 ndc(((x + (corner & 1)) * 2.0f / LIGHT_CLUSTER_GRID_X) - 1.0f, ((y + (corner >> 1)) * 2.0f / LIGHT_CLUSTER_GRID_Y) - 1.0f);
+						glm::vec4 nearPoint = projectionInverse * glm::vec4(ndc, -1.0f, 1.0f);
+						glm::vec3 ray = glm::vec3(nearPoint) / nearPoint.w;
+						ray /= -ray.z;
+
+						bounds.Min = glm::min(bounds.Min, glm::min(ray * sliceNear, ray * sliceFar));
+						bounds.Max = glm::max(bounds.Max, glm::max(ray * sliceNear, ray * sliceFar));
+					}
+				}
+			}
+		}
+	}
+
+	void LightClusterPass::binLights(const glm::mat4 &projection, const std::vector<glm::vec4> &lightSpheres, LightClusterBins &outBins) {
+		const size_t rowCount = LIGHT_CLUSTER_GRID_Y * LIGHT_CLUSTER_GRID_Z;
+		const glm::ivec2 tileGridSize(LIGHT_CLUSTER_GRID_X, LIGHT_CLUSTER_GRID_Y);
+		const float sliceScale = LIGHT_CLUSTER_GRID_Z / std::log(FAR_PLANE / NEAR_PLANE);
+
+		outBins.Ranges.resize(lightSpheres.size());
+		outBins.RowOffsets.assign(rowCount + 1, 0);
+		for (size_t i = 0; i < lightSpheres.size(); ++i) {
+			const glm::vec4 &sphere = lightSpheres[i];
+			LightClusterRange &range = outBins.Ranges[i];
+			range.Min = glm::ivec3(0);
+			range.Max = glm::ivec3(-1);
+
+			float nearDepth = -sphere.z - sphere.w, farDepth = -sphere.z + sphere.w;
+			if (farDepth < NEAR_PLANE || nearDepth > FAR_PLANE)
+				continue;
+
+			// The screen tiles are found by projecting the sphere's bounding box, a box reaching behind the camera could cover any tile
+			glm::vec2 minNDC(std::numeric_limits<float>::max()), maxNDC(std::numeric_limits<float>::lowest());
+			bool reachesBehindCamera = false;
+			for (int corner = 0; corner < 8 && !reachesBehindCamera; ++corner) {
+				glm::vec3 offset((corner & 1) ? sphere.w : -sphere.w, (corner & 2) ? sphere.w : -sphere.w, (corner & 4) ? sphere.w : -sphere.w);
+				glm::vec4 clipPosition = projection * glm::vec4(glm::vec3(sphere) + offset, 1.0f);
+				reachesBehindCamera = clipPosition.w <= 0.0f;
+				minNDC = glm::min(minNDC, glm::vec2(clipPosition) / clipPosition.w);
+				maxNDC = glm::max(maxNDC, glm::vec2(clipPosition) / clipPosition.w);
+			}
+
+			glm::ivec2 minTile(0), maxTile = tileGridSize - 1;
+			if (!reachesBehindCamera) {
+				if (maxNDC.x < -1.0f || maxNDC.y < -1.0f || minNDC.x > 1.0f || minNDC.y > 1.0f)
+					continue;
+				minTile = glm::clamp(glm::ivec2(glm::floor((minNDC * 0.5f + 0.5f) * glm::vec2(tileGridSize))), glm::ivec2(0), tileGridSize - 1);
+				maxTile = glm::clamp(glm::ivec2(glm::floor((maxNDC * 0.5f + 0.5f) * glm::vec2(tileGridSize))), glm::ivec2(0), tileGridSize - 1);
+			}
+
+			// Inverse of the logarithmic slice spacing used for the cluster bounds
+			int minSlice = (int)std::floor(std::log(std::max(nearDepth, NEAR_PLANE) / NEAR_PLANE) * sliceScale);
+			int maxSlice = (int)std::floor(std::log(std::min(farDepth, FAR_PLANE) / NEAR_PLANE) * sliceScale);
+			range.Min = glm::ivec3(minTile, glm::clamp(minSlice, 0, LIGHT_CLUSTER_GRID_Z - 1));
+			range.Max = glm::ivec3(maxTile, glm::clamp(maxSlice, 0, LIGHT_CLUSTER_GRID_Z - 1));
+
+			for (int z = range.Min.z; z <= range.Max.z; ++z) {
+				for (int y = range.Min.y; y <= range.Max.y; ++y) {
+					outBins.RowOffsets[y + z * LIGHT_CLUSTER_GRID_Y + 1]++;
+				}
+			}
+		}
+
+		// Counts to offsets, then each row's offset is used as its write cursor and shifted back afterwards
+		for (size_t row = 1; row <= rowCount; ++row) {
+			outBins.RowOffsets[row] += outBins.RowOffsets[row - 1];
+		}
+		outBins.RowLights.resize(outBins.RowOffsets[rowCount]);
+		for (size_t i = 0; i < lightSpheres.size(); ++i) {
+			const LightClusterRange &range = outBins.Ranges[i];
+			for (int z = range.Min.z; z <= range.Max.z; ++z) {
+				for (int y = range.Min.y; y <= range.Max.y; ++y) {
+					outBins.RowLights[outBins.RowOffsets[y + z * LIGHT_CLUSTER_GRID_Y]++] = (unsigned int)i;
+				}
+			}
+		}
+		for (size_t row = rowCount; row > 0; --row) {
+			outBins.RowOffsets[row] = outBins.RowOffsets[row - 1];
+		}
+		outBins.RowOffsets[0] = 0;
+	}
+
+	void LightClusterPass::cullLights(const std::vector<LightClusterBounds> &bounds, const std::vector<glm::vec4> &pointLightSpheres, const LightClusterBins &pointLightBins,
+		const std::vector<glm::vec4> &spotLightSpheres, const LightClusterBins &spotLightBins, size_t firstCluster, size_t lastCluster, std::vector<glm::uvec2> &outClusters, std::vector<unsigned int> &outIndices)
+	{
+		outIndices.clear();
+		for (size_t cluster = firstCluster; cluster < lastCluster; ++cluster) {
+			const LightClusterBounds &clusterBounds = bounds[cluster];
+			int tileX = (int)(cluster % LIGHT_CLUSTER_GRID_X);
+			size_t row = cluster / LIGHT_CLUSTER_GRID_X;
+			size_t offset = outIndices.size();
+
+			unsigned int pointLightCount = appendClusterLights(clusterBounds, tileX, row, pointLightSpheres, pointLightBins, LIGHT_CLUSTER_MAX_LIGHTS, outIndices);
+			unsigned int spotLightCount = appendClusterLights(clusterBounds, tileX, row, spotLightSpheres, spotLightBins, LIGHT_CLUSTER_MAX_LIGHTS - pointLightCount, outIndices);
+
+			outClusters[cluster] = glm::uvec2((unsigned int)offset, pointLightCount | (spotLightCount << 16));
+		}
+	}
+
+}
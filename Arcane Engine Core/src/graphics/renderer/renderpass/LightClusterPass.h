@@ -0,0 +1,82 @@
+#pragma once
+
+#include <graphics/camera/ICamera.h>
+#include <graphics/renderer/renderpass/RenderPass.h>
+#include <graphics/Shader.h>
+#include <scene/Scene3D.h>
+
+namespace arcane {
+
+	struct LightClusterBounds {
+		glm::vec3 Min, Max; // View space
+	};
+
+	struct LightClusterRange {
+		glm::ivec3 Min, Max; // Inclusive cluster coordinates a light's sphere can touch, Min > Max if it is outside the view
+	};
+
+	// Lights binned by the cluster rows (a row of screen tiles in one depth slice) they overlap, so a cluster only tests the lights near it
+	struct LightClusterBins {
+		std::vector<LightClusterRange> Ranges; // Per light
+		std::vector<unsigned int> RowOffsets; // Where each row's lights start in RowLights, with an extra entry for the end of the last row
+		std::vector<unsigned int> RowLights; // Light indices, in light order within each row
+	};
+
+	// Assigns the point and spot lights to a view space froxel grid, so the lighting shaders only evaluate the lights near each fragment.
+	// Each cluster stores an offset into a shared light index list and its light counts, its point light indices are followed by its spot light indices
+	class LightClusterPass : public RenderPass {
+	public:
+		LightClusterPass(Scene3D *scene);
+		virtual ~LightClusterPass() override;
+
+		// Width and height are the size of the framebuffer the clusters will be shaded into
+		LightClusterPassOutput executeLightClusterPass(ICamera *camera, unsigned int width, unsigned int height, bool renderOnlyStatic);
+
+		// Sets the uniforms a lighting shader needs to find a fragment's cluster
+		static void bindLightClusters(Shader *shader, const LightClusterPassOutput &clusterData);
+
+		// The CPU culling, kept free of GL so it can be benchmarked. Light spheres are view space positions with their radius in w.
+		// Culls clusters [firstCluster, lastCluster), their offsets are relative to the start of outIndices
+		static void calculateClusterBounds(const glm::mat4 &projection, std::vector<LightClusterBounds> &outBounds);
+		static void binLights(const glm::mat4 &projection, const std::vector<glm::vec4> &lightSpheres, LightClusterBins &outBins);
+		static void cullLights(const std::vector<LightClusterBounds> &bounds, const std::vector<glm::vec4> &pointLightSpheres, const LightClusterBins &pointLightBins,
+			const std::vector<glm::vec4> &spotLightSpheres, const LightClusterBins &spotLightBins, size_t firstCluster, size_t lastCluster, std::vector<glm::uvec2> &outClusters, std::vector<unsigned int> &outIndices);
+	private:
+		void cullOnGPU(ICamera *camera, bool renderOnlyStatic);
+		void cullOnCPU(ICamera *camera, bool renderOnlyStatic);
+
+		void cullingWorkerLoop(size_t threadIndex);
+		void cullClusterRange(size_t threadIndex); // Culls the share of the clusters that belongs to the thread
+
+		// Reads back the index count of the dispatch that last used the counter slot and grows the GPU index list if it didn't fit
+		void readBackLightIndexCount(unsigned int counterSlot);
+	private:
+		Shader *m_ClusteringShader;
+		GLuint m_ClusterBuffer, m_LightIndexBuffer;
+		size_t m_LightIndexCapacity; // In indices
+		size_t m_GPULightIndexCapacity; // What the GPU culling needs, only grows
+		bool m_CullOnGPU;
+
+		// Each dispatch counts into the next slot, the count is read back once the slot comes around again
+		std::array<GLuint, LIGHT_CLUSTER_READBACK_LATENCY> m_LightIndexCounterBuffers;
+		std::array<GLsync, LIGHT_CLUSTER_READBACK_LATENCY> m_LightIndexCounterFences;
+		unsigned int m_NextCounterSlot;
+
+		// CPU culling state, kept around so its allocations are reused
+		glm::mat4 m_BoundsProjection;
+		std::vector<LightClusterBounds> m_ClusterBounds;
+		std::vector<glm::vec4> m_PointLightSpheres, m_SpotLightSpheres;
+		LightClusterBins m_PointLightBins, m_SpotLightBins;
+		std::vector<glm::uvec2> m_Clusters;
+		std::vector<std::vector<unsigned int>> m_ThreadLightIndices;
+
+		// CPU culling workers, started the first time the CPU culling runs and woken once a frame
+		std::vector<std::thread> m_CullingWorkers;
+		std::mutex m_CullingMutex;
+		std::condition_variable m_CullingStartCondition, m_CullingDoneCondition;
+		uint64_t m_CullingGeneration; // Bumped to start the workers on the next frame's clusters
+		size_t m_BusyCullingWorkers;
+		bool m_ShutdownCullingWorkers;
+	};
+
+}
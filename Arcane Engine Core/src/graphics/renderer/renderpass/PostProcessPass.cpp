@@ -1,7 +1,7 @@
 #include "pch.h"
 #include "PostProcessPass.h"
 
-#include <ui/RuntimePane.h>
+#include <graphics/renderer/GPUProfiler.h>
 #include <utils/loaders/ShaderLoader.h>
 
 namespace arcane {
@@ -10,7 +10,7 @@ namespace arcane {
 		m_TonemappedNonLinearTarget(Window::getWidth(), Window::getHeight(), false), m_ScreenRenderTarget(Window::getWidth(), Window::getHeight(), false), m_ResolveRenderTarget(Window::getRenderResolutionWidth(), Window::getRenderResolutionHeight(), false), m_BrightPassRenderTarget(Window::getWidth(), Window::getHeight(), false),
 		m_BloomFullRenderTarget(Window::getWidth(), Window::getHeight(), false), m_BloomHalfRenderTarget((unsigned int)(Window::getWidth() * 0.5f), (unsigned int)(Window::getHeight() * 0.5f), false), m_BloomQuarterRenderTarget((unsigned int)(Window::getWidth() * 0.25f), (unsigned int)(Window::getHeight() * 0.25f), false), m_BloomEightRenderTarget((unsigned int)(Window::getWidth() * 0.125f), (unsigned int)(Window::getHeight() * 0.125f), false),
 		m_FullRenderTarget(Window::getWidth(), Window::getHeight(), false), m_HalfRenderTarget((unsigned int)(Window::getWidth() * 0.5f), (unsigned int)(Window::getHeight() * 0.5f), false), m_QuarterRenderTarget((unsigned int)(Window::getWidth() * 0.25f), (unsigned int)(Window::getWidth() * 0.25f), false), m_EightRenderTarget((unsigned int)(Window::getWidth() * 0.125f), (unsigned int)(Window::getHeight() * 0.125f), false),
-		m_SsaoNoiseTexture(), m_ProfilingTimer(), m_EffectsTimer()
+		m_SsaoNoiseTexture(), m_EffectsTimer()
 	{
 		// Shader setup
 		m_PassthroughShader = ShaderLoader::loadShader("src/shaders/post_process/Copy.glsl");
@@ -96,10 +96,8 @@ namespace arcane {
 
 	// Generates the AO of the scene using SSAO and stores it in a single channel texture
 	PreLightingPassOutput PostProcessPass::executePreLightingPass(GeometryPassOutput &geometryData, ICamera *camera) {
-#if DEBUG_ENABLED
-		glFinish();
-		m_ProfilingTimer.reset();
-#endif
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("SSAO");
 		PreLightingPassOutput passOutput;
 		if (!m_SsaoEnabled) {
 			passOutput.ssaoTexture = TextureLoader::getWhiteTexture();
@@ -158,17 +156,14 @@ namespace arcane {
 		// Reset unusual state
 		m_GLCache->setDepthTest(true);
 
-#if DEBUG_ENABLED
-		glFinish();
-		RuntimePane::setSsaoTimer((float)m_ProfilingTimer.elapsed());
-#endif
-
 		// Render pass output
 		passOutput.ssaoTexture = m_SsaoBlurRenderTarget.getColourTexture();
 		return passOutput;
 	}
 
 	void PostProcessPass::executePostProcessPass(Framebuffer *framebufferToProcess) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Post Process");
 		ModelRenderer *modelRenderer = m_ActiveScene->getModelRenderer();
 		GLCache *glCache = GLCache::getInstance();
 
@@ -226,10 +221,6 @@ namespace arcane {
 			inputFramebuffer = framebufferToRenderTo;
 		}
 
-#if DEBUG_ENABLED
-		glFinish();
-		m_ProfilingTimer.reset();
-#endif
 		if (m_FxaaEnabled) {
 			if (framebufferToRenderTo == &m_FullRenderTarget) framebufferToRenderTo = &m_TonemappedNonLinearTarget;
 			else framebufferToRenderTo = &m_FullRenderTarget;
@@ -237,10 +228,6 @@ namespace arcane {
 			fxaa(framebufferToRenderTo, inputFramebuffer->getColourTexture());
 			inputFramebuffer = framebufferToRenderTo;
 		}
-#if DEBUG_ENABLED
-		glFinish();
-		RuntimePane::setFxaaTimer((float)m_ProfilingTimer.elapsed());
-#endif
 
 		// Finally render the scene to the window's framebuffer
 		Window::bind();
@@ -252,6 +239,8 @@ namespace arcane {
 	}
 
 	void PostProcessPass::tonemapGammaCorrect(Framebuffer *target, Texture *hdrTexture) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Tonemap");
 		glViewport(0, 0, target->getWidth(), target->getHeight());
 		m_GLCache->switchShader(m_TonemapGammaCorrectShader);
 		m_GLCache->setDepthTest(false);
@@ -270,6 +259,8 @@ namespace arcane {
 	}
 
 	void PostProcessPass::fxaa(Framebuffer *target, Texture *texture) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("FXAA");
 		glViewport(0, 0, target->getWidth(), target->getHeight());
 		m_GLCache->switchShader(m_FxaaShader);
 		m_GLCache->setDepthTest(false);
@@ -287,6 +278,8 @@ namespace arcane {
 	}
 
 	void PostProcessPass::vignette(Framebuffer *target, Texture *texture, Texture *optionalVignetteMask) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Vignette");
 		glViewport(0, 0, target->getWidth(), target->getHeight());
 		m_GLCache->switchShader(m_VignetteShader);
 		m_GLCache->setDepthTest(false);
@@ -310,6 +303,8 @@ namespace arcane {
 	}
 
 	void PostProcessPass::chromaticAberration(Framebuffer *target, Texture *texture) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Chromatic Aberration");
 		glViewport(0, 0, target->getWidth(), target->getHeight());
 		m_GLCache->switchShader(m_ChromaticAberrationShader);
 		m_GLCache->setDepthTest(false);
@@ -328,6 +323,8 @@ namespace arcane {
 	}
 
 	void PostProcessPass::filmGrain(Framebuffer *target, Texture *texture) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Film Grain");
 		glViewport(0, 0, target->getWidth(), target->getHeight());
 		m_GLCache->switchShader(m_FilmGrainShader);
 		m_GLCache->setDepthTest(false);
@@ -346,6 +343,8 @@ namespace arcane {
 	}
 
 	Texture* PostProcessPass::bloom(Texture *hdrSceneTexture) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Bloom");
 		m_GLCache->setDepthTest(false);
 		m_GLCache->setBlend(false);
 		m_GLCache->setFaceCull(true);
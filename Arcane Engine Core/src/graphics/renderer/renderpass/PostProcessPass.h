@@ -73,7 +73,6 @@ namespace arcane {
 		std::array<glm::vec3, SSAO_KERNEL_SIZE> m_SsaoKernel;
 		Texture m_SsaoNoiseTexture;
 
-		Timer m_ProfilingTimer;
 		Timer m_EffectsTimer;
 	};
 
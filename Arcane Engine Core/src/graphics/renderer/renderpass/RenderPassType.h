@@ -27,4 +27,10 @@ namespace arcane {
 		Texture *ssaoTexture;
 	};
 
+	struct LightClusterPassOutput {
+		glm::ivec3 clusterGridSize;
+		glm::vec2 clusterTileSize; // Pixels covered by a cluster
+		glm::vec2 clusterSliceScaleBias; // Maps log(view depth) to a depth slice
+	};
+
 }
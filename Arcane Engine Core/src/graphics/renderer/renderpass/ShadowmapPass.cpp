@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "ShadowmapPass.h"
 
+#include <graphics/renderer/GPUProfiler.h>
 #include <utils/loaders/ShaderLoader.h>
 
 namespace arcane {
@@ -24,6 +25,8 @@ namespace arcane {
 	}
 
 	ShadowmapPassOutput ShadowmapPass::generateShadowmaps(ICamera *camera, bool renderOnlyStatic) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Shadowmap");
 		glViewport(0, 0, m_ShadowmapFramebuffer->getWidth(), m_ShadowmapFramebuffer->getHeight());
 		m_ShadowmapFramebuffer->bind();
 		m_ShadowmapFramebuffer->clear();
@@ -57,7 +60,8 @@ namespace arcane {
 		modelRenderer->flushOpaque(m_ShadowmapShader, NoMaterialRequired);
 		modelRenderer->flushTransparent(m_ShadowmapShader, NoMaterialRequired);
 
-		// Render terrain
+		// Render terrain (its vertices aren't quantized, so reset the decoding the model meshes left behind)
+		Mesh::bindFullPrecisionVertexFormat(m_ShadowmapShader);
 		terrain->Draw(m_ShadowmapShader, NoMaterialRequired);
 
 		// Render pass output
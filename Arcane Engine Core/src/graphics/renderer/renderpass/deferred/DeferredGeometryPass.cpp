@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "DeferredGeometryPass.h"
 
+#include <graphics/renderer/GPUProfiler.h>
 #include <utils/loaders/ShaderLoader.h>
 
 namespace arcane {
@@ -24,6 +25,8 @@ namespace arcane {
 	}
 
 	GeometryPassOutput DeferredGeometryPass::executeGeometryPass(ICamera *camera, bool renderOnlyStatic) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Geometry");
 		glViewport(0, 0, m_GBuffer->getWidth(), m_GBuffer->getHeight());
 		m_GBuffer->bind();
 		m_GBuffer->clear();
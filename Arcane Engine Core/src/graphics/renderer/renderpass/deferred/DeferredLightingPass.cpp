@@ -1,22 +1,31 @@
 #include "pch.h"
 #include "DeferredLightingPass.h"
 
+#include <graphics/renderer/GPUProfiler.h>
 #include <graphics/renderer/renderpass/deferred/DeferredGeometryPass.h>
 #include <utils/loaders/ShaderLoader.h>
 
 namespace arcane {
 
-	DeferredLightingPass::DeferredLightingPass(Scene3D *scene) : RenderPass(scene), m_AllocatedFramebuffer(true)
+	// Tessellation of the light volumes, coarse since they only have to bound the light
+	static const int s_PointLightVolumeSegments = 16, s_PointLightVolumeRings = 12;
+	static const int s_SpotLightVolumeSegments = 16;
+
+	DeferredLightingPass::DeferredLightingPass(Scene3D *scene) : RenderPass(scene), m_AllocatedFramebuffer(true),
+		m_PointLightVolume(s_PointLightVolumeSegments, s_PointLightVolumeRings), m_SpotLightVolume(s_SpotLightVolumeSegments)
 	{
 		m_LightingShader = ShaderLoader::loadShader("src/shaders/deferred/PBR_LightingPass.glsl");
+		m_LightVolumeShader = ShaderLoader::loadShader("src/shaders/deferred/PBR_LightVolumePass.glsl");
 
 		m_Framebuffer = new Framebuffer(Window::getRenderResolutionWidth(), Window::getRenderResolutionHeight(), false);
 		m_Framebuffer->addColorTexture(FloatingPoint16).addDepthStencilTexture(NormalizedDepthStencil).createFramebuffer();
 	}
 
-	DeferredLightingPass::DeferredLightingPass(Scene3D *scene, Framebuffer *customFramebuffer) : RenderPass(scene), m_AllocatedFramebuffer(false), m_Framebuffer(customFramebuffer)
+	DeferredLightingPass::DeferredLightingPass(Scene3D *scene, Framebuffer *customFramebuffer) : RenderPass(scene), m_AllocatedFramebuffer(false), m_Framebuffer(customFramebuffer),
+		m_PointLightVolume(s_PointLightVolumeSegments, s_PointLightVolumeRings), m_SpotLightVolume(s_SpotLightVolumeSegments)
 	{
 		m_LightingShader = ShaderLoader::loadShader("src/shaders/deferred/PBR_LightingPass.glsl");
+		m_LightVolumeShader = ShaderLoader::loadShader("src/shaders/deferred/PBR_LightVolumePass.glsl");
 	}
 
 	DeferredLightingPass::~DeferredLightingPass() {
@@ -25,7 +34,9 @@ namespace arcane {
 		}
 	}
 
-	LightingPassOutput DeferredLightingPass::executeLightingPass(ShadowmapPassOutput &shadowmapData, GeometryPassOutput &geometryData, PreLightingPassOutput &preLightingOutput, ICamera *camera, bool useIBL) {
+	LightingPassOutput DeferredLightingPass::executeLightingPass(ShadowmapPassOutput &shadowmapData, LightClusterPassOutput &clusterData, GeometryPassOutput &geometryData, PreLightingPassOutput &preLightingOutput, ICamera *camera, bool useIBL) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Deferred Lighting");
 		// Framebuffer setup
 		glViewport(0, 0, m_Framebuffer->getWidth(), m_Framebuffer->getHeight());
 		m_Framebuffer->bind();
@@ -43,12 +54,13 @@ namespace arcane {
 		m_GLCache->setStencilTest(true);
 		m_GLCache->setStencilWriteMask(0x00); // Do not update stencil values
 
-		DynamicLightManager *lightManager = m_ActiveScene->getDynamicLightManager();
 		ProbeManager *probeManager = m_ActiveScene->getProbeManager();
 
 		m_GLCache->switchShader(m_LightingShader);
-		lightManager->bindLightingUniforms(m_LightingShader);
+		LightClusterPass::bindLightClusters(m_LightingShader, clusterData);
 		m_LightingShader->setUniform("viewPos", camera->getPosition());
+		m_LightingShader->setUniform("view", camera->getViewMatrix());
+		m_LightingShader->setUniform("computeLocalLights", DEFERRED_LIGHT_VOLUMES ? 0 : 1);
 		m_LightingShader->setUniform("viewInverse", glm::inverse(camera->getViewMatrix()));
 		m_LightingShader->setUniform("projectionInverse", glm::inverse(camera->getProjectionMatrix()));
 
@@ -95,6 +107,9 @@ namespace arcane {
 		m_GLCache->setStencilFunc(GL_EQUAL, DeferredStencilValue::ModelStencilValue, 0xFF);
 		modelRenderer->NDC_Plane.Draw();
 
+#if DEFERRED_LIGHT_VOLUMES
+		renderLightVolumes(camera);
+#endif
 
 		// Reset state
 		m_GLCache->setDepthTest(true);
@@ -106,6 +121,58 @@ namespace arcane {
 		return passOutput;
 	}
 
+	// Only the pixels a light's volume covers are shaded for it. Back faces are drawn with an inverted depth test so surfaces behind the
+	// volume are rejected, and the shader discards surfaces in front of it. Depth clamping keeps back faces past the far plane from being
+	// clipped away, which would drop the light from distant surfaces. The stencil keeps the sky out. The volumes are instanced from the
+	// light buffers, so the whole pass is two draw calls no matter how many lights there are
+	void DeferredLightingPass::renderLightVolumes(ICamera *camera) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Deferred Light Volumes");
+		DynamicLightManager *lightManager = m_ActiveScene->getDynamicLightManager();
+
+		m_GLCache->switchShader(m_LightVolumeShader);
+		m_LightVolumeShader->setUniform("viewProjection", camera->getProjectionMatrix() * camera->getViewMatrix());
+		m_LightVolumeShader->setUniform("viewPos", camera->getPosition());
+		m_LightVolumeShader->setUniform("viewInverse", glm::inverse(camera->getViewMatrix()));
+		m_LightVolumeShader->setUniform("projectionInverse", glm::inverse(camera->getProjectionMatrix()));
+		m_LightVolumeShader->setUniform("screenSize", glm::vec2((float)m_Framebuffer->getWidth(), (float)m_Framebuffer->getHeight()));
+
+		// GBuffer data is still bound from the full screen passes
+		m_LightVolumeShader->setUniform("albedoTexture", 4);
+		m_LightVolumeShader->setUniform("normalTexture", 5);
+		m_LightVolumeShader->setUniform("materialInfoTexture", 6);
+		m_LightVolumeShader->setUniform("depthTexture", 8);
+
+		m_GLCache->setStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+		m_GLCache->setDepthTest(true);
+		m_GLCache->setDepthFunc(GL_GEQUAL);
+		m_GLCache->setDepthMask(false);
+		m_GLCache->setDepthClamp(true);
+		m_GLCache->setBlend(true);
+		m_GLCache->setBlendFunc(GL_ONE, GL_ONE);
+		m_GLCache->setFaceCull(true);
+		m_GLCache->setCullFace(GL_FRONT);
+
+		// Tessellated volumes sit inside the true shape, so they are scaled out until their flat faces clear it
+		float pointVolumeScale = 1.0f / (std::cos(glm::pi<float>() / s_PointLightVolumeSegments) * std::cos(glm::pi<float>() / (2.0f * s_PointLightVolumeRings)));
+		m_LightVolumeShader->setUniform("spotLightVolumes", 0);
+		m_LightVolumeShader->setUniform("volumeScale", pointVolumeScale);
+		m_PointLightVolume.DrawInstanced(lightManager->getPointLights().getCount(false));
+
+		float spotVolumeScale = 1.0f / std::cos(glm::pi<float>() / s_SpotLightVolumeSegments);
+		m_LightVolumeShader->setUniform("spotLightVolumes", 1);
+		m_LightVolumeShader->setUniform("volumeScale", spotVolumeScale);
+		m_SpotLightVolume.DrawInstanced(lightManager->getSpotLights().getCount(false));
+
+		// Reset state
+		m_GLCache->setCullFace(GL_BACK);
+		m_GLCache->setBlend(false);
+		m_GLCache->setDepthClamp(false);
+		m_GLCache->setDepthMask(true);
+		m_GLCache->setDepthFunc(GL_LESS);
+		m_GLCache->setDepthTest(false);
+	}
+
 	void DeferredLightingPass::bindShadowmap(Shader *shader, ShadowmapPassOutput &shadowmapData) {
 		shadowmapData.shadowmapFramebuffer->getDepthStencilTexture()->bind();
 		shader->setUniform("shadowmap", 0);
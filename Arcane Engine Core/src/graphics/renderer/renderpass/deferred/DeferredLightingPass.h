@@ -1,5 +1,8 @@
 #pragma once
 
+#include <graphics/mesh/common/Cone.h>
+#include <graphics/mesh/common/Sphere.h>
+#include <graphics/renderer/renderpass/LightClusterPass.h>
 #include <graphics/renderer/renderpass/RenderPass.h>
 #include <graphics/Shader.h>
 #include <scene/Scene3D.h>
@@ -12,12 +15,17 @@ namespace arcane {
 		DeferredLightingPass(Scene3D *scene, Framebuffer *framebuffer);
 		virtual ~DeferredLightingPass() override;
 
-		LightingPassOutput executeLightingPass(ShadowmapPassOutput &shadowmapData, GeometryPassOutput &geometryData, PreLightingPassOutput &preLightingOutput, ICamera *camera, bool useIBL);
+		LightingPassOutput executeLightingPass(ShadowmapPassOutput &shadowmapData, LightClusterPassOutput &clusterData, GeometryPassOutput &geometryData, PreLightingPassOutput &preLightingOutput, ICamera *camera, bool useIBL);
 	private:
 		void bindShadowmap(Shader *shader, ShadowmapPassOutput &shadowmapData);
+		void renderLightVolumes(ICamera *camera);
 	private:
 		bool m_AllocatedFramebuffer;
 		Framebuffer *m_Framebuffer;
-		Shader *m_LightingShader;
+		Shader *m_LightingShader, *m_LightVolumeShader;
+
+		// Unit volumes, instanced once per light
+		Sphere m_PointLightVolume;
+		Cone m_SpotLightVolume;
 	};
 }
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "PostGBufferForwardPass.h"
 
+#include <graphics/renderer/GPUProfiler.h>
 #include <utils/loaders/ShaderLoader.h>
 
 namespace arcane {
@@ -12,7 +13,9 @@ namespace arcane {
 
 	PostGBufferForward::~PostGBufferForward() {}
 
-	LightingPassOutput PostGBufferForward::executeLightingPass(ShadowmapPassOutput &shadowmapData, LightingPassOutput &lightingPassData, ICamera *camera, bool renderOnlyStatic, bool useIBL) {
+	LightingPassOutput PostGBufferForward::executeLightingPass(ShadowmapPassOutput &shadowmapData, LightClusterPassOutput &clusterData, LightingPassOutput &lightingPassData, ICamera *camera, bool renderOnlyStatic, bool useIBL) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Post GBuffer Forward");
 		glViewport(0, 0, lightingPassData.outputFramebuffer->getWidth(), lightingPassData.outputFramebuffer->getHeight());
 		lightingPassData.outputFramebuffer->bind();
 		m_GLCache->setMultisample(false);
@@ -28,12 +31,8 @@ namespace arcane {
 		skybox->Draw(camera);
 
 		// View setup + lighting setup
-		auto lightBindFunction = &DynamicLightManager::bindLightingUniforms;
-		if (renderOnlyStatic)
-			lightBindFunction = &DynamicLightManager::bindStaticLightingUniforms;
-
 		m_GLCache->switchShader(m_ModelShader);
-		(lightManager->*lightBindFunction) (m_ModelShader);
+		LightClusterPass::bindLightClusters(m_ModelShader, clusterData);
 		m_ModelShader->setUniform("viewPos", camera->getPosition());
 		m_ModelShader->setUniform("view", camera->getViewMatrix());
 		m_ModelShader->setUniform("projection", camera->getProjectionMatrix());
@@ -58,9 +57,12 @@ namespace arcane {
 			m_ActiveScene->addTransparentModelsToRenderer();
 		}
 
+		// Each model only shades with the lights that reach it
+		m_ObjectLightAssigner.buildLightGrid(lightManager->getPointLights(), lightManager->getSpotLights(), renderOnlyStatic);
+
 		// Render transparent objects
 		modelRenderer->setupTransparentRenderState();
-		modelRenderer->flushTransparent(m_ModelShader, MaterialRequired);
+		modelRenderer->flushTransparent(m_ModelShader, MaterialRequired, &m_ObjectLightAssigner);
 
 		// Render pass output
 		LightingPassOutput passOutput;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <graphics/lights/ObjectLightAssigner.h>
+#include <graphics/renderer/renderpass/LightClusterPass.h>
 #include <graphics/renderer/renderpass/RenderPass.h>
 #include <graphics/Shader.h>
 #include <scene/Scene3D.h>
@@ -11,11 +13,12 @@ namespace arcane {
 		PostGBufferForward(Scene3D *scene);
 		virtual ~PostGBufferForward() override;
 
-		LightingPassOutput executeLightingPass(ShadowmapPassOutput &shadowmapData, LightingPassOutput &lightingPassData, ICamera *camera, bool renderOnlyStatic, bool useIBL);
+		LightingPassOutput executeLightingPass(ShadowmapPassOutput &shadowmapData, LightClusterPassOutput &clusterData, LightingPassOutput &lightingPassData, ICamera *camera, bool renderOnlyStatic, bool useIBL);
 	private:
 		void bindShadowmap(Shader *shader, ShadowmapPassOutput &shadowmapData);
 	private:
 		Shader *m_ModelShader;
+		ObjectLightAssigner m_ObjectLightAssigner;
 	};
 
 }
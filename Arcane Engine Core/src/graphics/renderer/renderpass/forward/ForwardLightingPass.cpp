@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "ForwardLightingPass.h"
 
+#include <graphics/renderer/GPUProfiler.h>
 #include <utils/loaders/ShaderLoader.h>
 
 namespace arcane {
@@ -26,7 +27,9 @@ namespace arcane {
 		}
 	}
 
-	LightingPassOutput ForwardLightingPass::executeLightingPass(ShadowmapPassOutput &shadowmapData, ICamera *camera, bool renderOnlyStatic, bool useIBL) {
+	LightingPassOutput ForwardLightingPass::executeLightingPass(ShadowmapPassOutput &shadowmapData, LightClusterPassOutput &clusterData, ICamera *camera, bool renderOnlyStatic, bool useIBL) {
+		PROFILE_FUNCTION();
+		PROFILE_GPU_PASS("Forward Lighting");
 		glViewport(0, 0, m_Framebuffer->getWidth(), m_Framebuffer->getHeight());
 		m_Framebuffer->bind();
 		m_Framebuffer->clear();
@@ -45,12 +48,8 @@ namespace arcane {
 		ProbeManager *probeManager = m_ActiveScene->getProbeManager();
 
 		// View setup + lighting setup
-		auto lightBindFunction = &DynamicLightManager::bindLightingUniforms;
-		if (renderOnlyStatic)
-			lightBindFunction = &DynamicLightManager::bindStaticLightingUniforms;
-
 		m_GLCache->switchShader(m_ModelShader);
-		(lightManager->*lightBindFunction) (m_ModelShader);
+		LightClusterPass::bindLightClusters(m_ModelShader, clusterData);
 		m_ModelShader->setUniform("viewPos", camera->getPosition());
 		m_ModelShader->setUniform("view", camera->getViewMatrix());
 		m_ModelShader->setUniform("projection", camera->getProjectionMatrix());
@@ -69,6 +68,9 @@ namespace arcane {
 			m_ActiveScene->addModelsToRenderer();
 		}
 
+		// Each model only shades with the lights that reach it
+		m_ObjectLightAssigner.buildLightGrid(lightManager->getPointLights(), lightManager->getSpotLights(), renderOnlyStatic);
+
 		// Render opaque objects
 		if (useIBL) {
 			m_ModelShader->setUniform("computeIBL", 1);
@@ -77,11 +79,11 @@ namespace arcane {
 			m_ModelShader->setUniform("computeIBL", 0);
 		}
 		modelRenderer->setupOpaqueRenderState();
-		modelRenderer->flushOpaque(m_ModelShader, MaterialRequired);
+		modelRenderer->flushOpaque(m_ModelShader, MaterialRequired, &m_ObjectLightAssigner);
 
 		// Render terrain
 		m_GLCache->switchShader(m_TerrainShader);
-		(lightManager->*lightBindFunction) (m_TerrainShader);
+		LightClusterPass::bindLightClusters(m_TerrainShader, clusterData);
 		m_TerrainShader->setUniform("viewPos", camera->getPosition());
 		m_TerrainShader->setUniform("view", camera->getViewMatrix());
 		m_TerrainShader->setUniform("projection", camera->getProjectionMatrix());
@@ -97,7 +99,7 @@ namespace arcane {
 			probeManager->bindProbes(glm::vec3(0.0f, 0.0f, 0.0f), m_ModelShader);
 		}
 		modelRenderer->setupTransparentRenderState();
-		modelRenderer->flushTransparent(m_ModelShader, MaterialRequired);
+		modelRenderer->flushTransparent(m_ModelShader, MaterialRequired, &m_ObjectLightAssigner);
 
 		// Render pass output
 		LightingPassOutput passOutput;
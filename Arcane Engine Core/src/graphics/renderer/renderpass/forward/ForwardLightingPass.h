@@ -1,5 +1,7 @@
 #pragma once
 
+#include <graphics/lights/ObjectLightAssigner.h>
+#include <graphics/renderer/renderpass/LightClusterPass.h>
 #include <graphics/renderer/renderpass/RenderPass.h>
 #include <graphics/Shader.h>
 #include <scene/Scene3D.h>
@@ -12,13 +14,14 @@ namespace arcane {
 		ForwardLightingPass(Scene3D *scene, Framebuffer *customFramebuffer);
 		virtual ~ForwardLightingPass() override;
 
-		LightingPassOutput executeLightingPass(ShadowmapPassOutput &shadowmapData, ICamera *camera, bool renderOnlyStatic, bool useIBL);
+		LightingPassOutput executeLightingPass(ShadowmapPassOutput &shadowmapData, LightClusterPassOutput &clusterData, ICamera *camera, bool renderOnlyStatic, bool useIBL);
 	private:
 		void bindShadowmap(Shader *shader, ShadowmapPassOutput &shadowmapData);
 	private:
 		bool m_AllocatedFramebuffer;
 		Framebuffer *m_Framebuffer;
 		Shader *m_ModelShader, *m_TerrainShader;
+		ObjectLightAssigner m_ObjectLightAssigner;
 	};
 
 }
@@ -32,17 +32,21 @@ namespace arcane {
 	ForwardProbePass::~ForwardProbePass() {}
 
 	void ForwardProbePass::pregenerateIBL() {
+		PROFILE_FUNCTION();
 		generateBRDFLUT();
 		generateFallbackProbes();
 	}
 
 	void ForwardProbePass::pregenerateProbes() {
-		glm::vec3 probePosition = glm::vec3(67.0f, 92.0f, 133.0f);
-		generateLightProbe(probePosition);
-		generateReflectionProbe(probePosition);
+		PROFILE_FUNCTION();
+		for (glm::vec3 probePosition : m_ActiveScene->getProbePositions()) {
+			generateLightProbe(probePosition);
+			generateReflectionProbe(probePosition);
+		}
 	}
 
 	void ForwardProbePass::generateBRDFLUT() {
+		PROFILE_FUNCTION();
 		Shader *brdfIntegrationShader = ShaderLoader::loadShader("src/shaders/BRDF_Integration.glsl");
 		ModelRenderer *modelRenderer = m_ActiveScene->getModelRenderer();
 		
@@ -82,6 +86,7 @@ namespace arcane {
 	}
 
 	void ForwardProbePass::generateFallbackProbes() {
+		PROFILE_FUNCTION();
 		ProbeManager *probeManager = m_ActiveScene->getProbeManager();
 		glm::vec3 origin(0.0f, 0.0f, 0.0f);
 		m_CubemapCamera.setCenterPosition(origin);
@@ -158,12 +163,14 @@ namespace arcane {
 	}
 
 	void ForwardProbePass::generateLightProbe(glm::vec3 &probePosition) {
+		PROFILE_FUNCTION();
 		LightProbe *lightProbe = new LightProbe(probePosition, glm::vec2(LIGHT_PROBE_RESOLUTION, LIGHT_PROBE_RESOLUTION));
 		lightProbe->generate();
 
 		// Initialize step before rendering to the probe's cubemap
 		m_CubemapCamera.setCenterPosition(probePosition);
 		ShadowmapPass shadowPass(m_ActiveScene, &m_SceneCaptureShadowFramebuffer);
+		LightClusterPass lightClusterPass(m_ActiveScene);
 		ForwardLightingPass lightingPass(m_ActiveScene, &m_SceneCaptureLightingFramebuffer);
 
 		// Render the scene to the probe's cubemap
@@ -175,9 +182,10 @@ namespace arcane {
 			ShadowmapPassOutput shadowpassOutput = shadowPass.generateShadowmaps(&m_CubemapCamera, true);
 
 			// Light pass
+			LightClusterPassOutput clusterOutput = lightClusterPass.executeLightClusterPass(&m_CubemapCamera, m_SceneCaptureLightingFramebuffer.getWidth(), m_SceneCaptureLightingFramebuffer.getHeight(), true);
 			m_SceneCaptureLightingFramebuffer.bind();
 			m_SceneCaptureLightingFramebuffer.setColorAttachment(m_SceneCaptureCubemap.getCubemapID(), GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
-			lightingPass.executeLightingPass(shadowpassOutput, &m_CubemapCamera, true, false);
+			lightingPass.executeLightingPass(shadowpassOutput, clusterOutput, &m_CubemapCamera, true, false);
 			m_SceneCaptureLightingFramebuffer.setColorAttachment(0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
 		}
 
@@ -210,12 +218,14 @@ namespace arcane {
 	}
 
 	void ForwardProbePass::generateReflectionProbe(glm::vec3 &probePosition) {
+		PROFILE_FUNCTION();
 		ReflectionProbe *reflectionProbe = new ReflectionProbe(probePosition, glm::vec2(REFLECTION_PROBE_RESOLUTION, REFLECTION_PROBE_RESOLUTION));
 		reflectionProbe->generate();
 
 		// Initialize step before rendering to the probe's cubemap
 		m_CubemapCamera.setCenterPosition(probePosition);
 		ShadowmapPass shadowPass(m_ActiveScene, &m_SceneCaptureShadowFramebuffer);
+		LightClusterPass lightClusterPass(m_ActiveScene);
 		ForwardLightingPass lightingPass(m_ActiveScene, &m_SceneCaptureLightingFramebuffer);
 
 		// Render the scene to the probe's cubemap
@@ -227,9 +237,10 @@ namespace arcane {
 			ShadowmapPassOutput shadowpassOutput = shadowPass.generateShadowmaps(&m_CubemapCamera, true);
 
 			// Light pass
+			LightClusterPassOutput clusterOutput = lightClusterPass.executeLightClusterPass(&m_CubemapCamera, m_SceneCaptureLightingFramebuffer.getWidth(), m_SceneCaptureLightingFramebuffer.getHeight(), true);
 			m_SceneCaptureLightingFramebuffer.bind();
 			m_SceneCaptureLightingFramebuffer.setColorAttachment(m_SceneCaptureCubemap.getCubemapID(), GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
-			lightingPass.executeLightingPass(shadowpassOutput, &m_CubemapCamera, true, false);
+			lightingPass.executeLightingPass(shadowpassOutput, clusterOutput, &m_CubemapCamera, true, false);
 			m_SceneCaptureLightingFramebuffer.setColorAttachment(0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
 		}
 
@@ -1,35 +1,25 @@
 #include "pch.h"
 #include "Cubemap.h"
 
+#include <graphics/texture/SamplerCache.h>
+#include <graphics/texture/Texture.h>
+
 namespace arcane {
 
-	Cubemap::Cubemap(CubemapSettings &settings) : m_CubemapID(0), m_FaceWidth(0), m_FaceHeight(0), m_FacesGenerated(0), m_CubemapSettings(settings) {}
+	Cubemap::Cubemap(const CubemapSettings &settings) : m_CubemapID(0), m_FaceWidth(0), m_FaceHeight(0), m_FacesGenerated(0), m_SamplerId(0), m_CubemapSettings(settings) {}
 
 	Cubemap::~Cubemap() {
 		glDeleteTextures(1, &m_CubemapID);
 	}
 
 	void Cubemap::applyCubemapSettings() {
-		// Texture wrapping
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, m_CubemapSettings.TextureWrapSMode);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, m_CubemapSettings.TextureWrapTMode);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, m_CubemapSettings.TextureWrapRMode);
-
-		// Texture filtering
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, m_CubemapSettings.TextureMagnificationFilterMode);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, m_CubemapSettings.TextureMinificationFilterMode);
+		// Wrapping, filtering and anisotropy live in a shared sampler object that is bound alongside the cubemap
+		m_SamplerId = SamplerCache::getSampler(m_CubemapSettings);
 
 		// Mipmapping
 		if (m_CubemapSettings.HasMips) {
 			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_LOD_BIAS, m_CubemapSettings.MipBias);
 		}
-
-		// Anisotropic filtering (TODO: Move the anistropyAmount calculation to Defs.h to avoid querying the OpenGL driver everytime)
-		float maxAnisotropy;
-		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
-		float anistropyAmount = glm::min(maxAnisotropy, m_CubemapSettings.TextureAnisotropyLevel);
-		glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_ANISOTROPY_EXT, anistropyAmount);
 	}
 
 	void Cubemap::generateCubemapFace(GLenum face, unsigned int faceWidth, unsigned int faceHeight, GLenum dataFormat, const unsigned char *data)
@@ -52,11 +42,19 @@ namespace arcane {
 				case GL_RGBA: m_CubemapSettings.TextureFormat = GL_SRGB_ALPHA; break;
 				}
 			}
+			m_CubemapSettings.TextureFormat = Texture::getSizedTextureFormat(m_CubemapSettings.TextureFormat);
+
+			// Immutable storage for all six faces (and their mips) is allocated up front
+			bind();
+			glTexStorage2D(GL_TEXTURE_CUBE_MAP, m_CubemapSettings.HasMips ? Texture::getMipLevelCount(m_FaceWidth, m_FaceHeight) : 1, m_CubemapSettings.TextureFormat, m_FaceWidth, m_FaceHeight);
 		}
 
 		bind();
 
-		glTexImage2D(face, 0, m_CubemapSettings.TextureFormat, m_FaceWidth, m_FaceHeight, 0, dataFormat, GL_UNSIGNED_BYTE, data);
+		// Faces without data are render targets that get drawn into later
+		if (data) {
+			glTexSubImage2D(face, 0, 0, 0, m_FaceWidth, m_FaceHeight, dataFormat, GL_UNSIGNED_BYTE, data);
+		}
 		++m_FacesGenerated;
 
 		if (m_FacesGenerated >= 6) {
@@ -69,6 +67,7 @@ namespace arcane {
 	void Cubemap::bind(int unit) {
 		glActiveTexture(GL_TEXTURE0 + unit);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, m_CubemapID);
+		glBindSampler(unit, m_SamplerId);
 	}
 
 	void Cubemap::unbind() {
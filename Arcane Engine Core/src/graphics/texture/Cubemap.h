@@ -28,7 +28,7 @@ namespace arcane {
 
 	class Cubemap {
 	public:
-		Cubemap(CubemapSettings &settings = CubemapSettings());
+		Cubemap(const CubemapSettings &settings = CubemapSettings());
 		~Cubemap();
 
 		void generateCubemapFace(GLenum face, unsigned int faceWidth, unsigned int faceHeight, GLenum dataFormat, const unsigned char *data);
@@ -50,6 +50,7 @@ namespace arcane {
 
 		unsigned int m_FaceWidth, m_FaceHeight;
 		unsigned int m_FacesGenerated;
+		unsigned int m_SamplerId; // Shared with every cubemap using the same sampling settings (see SamplerCache)
 
 		CubemapSettings m_CubemapSettings;
 	};
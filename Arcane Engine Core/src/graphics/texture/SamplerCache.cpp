@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "SamplerCache.h"
+
+namespace arcane {
+
+	// Static declarations
+	std::map<SamplerDescription, unsigned int> SamplerCache::s_Samplers;
+	float SamplerCache::s_MaxAnisotropy = 0.0f;
+
+	unsigned int SamplerCache::getSampler(const TextureSettings &settings) {
+		SamplerDescription description = {};
+		description.WrapSMode = settings.TextureWrapSMode;
+		description.WrapTMode = settings.TextureWrapTMode;
+		description.WrapRMode = GL_REPEAT;
+		description.MinificationFilterMode = settings.TextureMinificationFilterMode;
+		description.MagnificationFilterMode = settings.TextureMagnificationFilterMode;
+		description.AnisotropyLevel = glm::min(getMaxAnisotropy(), settings.TextureAnisotropyLevel);
+		description.MipBias = settings.HasMips ? (float)settings.MipBias : 0.0f;
+		description.HasBorder = settings.HasBorder;
+		description.BorderColour = settings.HasBorder ? settings.BorderColour : glm::vec4(0.0f);
+
+		return getSampler(description);
+	}
+
+	unsigned int SamplerCache::getSampler(const CubemapSettings &settings) {
+		SamplerDescription description = {};
+		description.WrapSMode = settings.TextureWrapSMode;
+		description.WrapTMode = settings.TextureWrapTMode;
+		description.WrapRMode = settings.TextureWrapRMode;
+		description.MinificationFilterMode = settings.TextureMinificationFilterMode;
+		description.MagnificationFilterMode = settings.TextureMagnificationFilterMode;
+		description.AnisotropyLevel = glm::min(getMaxAnisotropy(), settings.TextureAnisotropyLevel);
+		description.MipBias = settings.HasMips ? (float)settings.MipBias : 0.0f;
+
+		return getSampler(description);
+	}
+
+	float SamplerCache::getMaxAnisotropy() {
+		if (s_MaxAnisotropy == 0.0f) {
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &s_MaxAnisotropy);
+		}
+		return s_MaxAnisotropy;
+	}
+
+	unsigned int SamplerCache::getSampler(const SamplerDescription &description) {
+		auto iter = s_Samplers.find(description);
+		if (iter != s_Samplers.end()) {
+			return iter->second;
+		}
+
+		unsigned int sampler;
+		glGenSamplers(1, &sampler);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, description.WrapSMode);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, description.WrapTMode);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, description.WrapRMode);
+		if (description.HasBorder) {
+			glSamplerParameterfv(sampler, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(description.BorderColour));
+		}
+		glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, description.MinificationFilterMode);
+		glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, description.MagnificationFilterMode);
+		glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, description.MipBias);
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, description.AnisotropyLevel);
+
+		s_Samplers.insert(std::make_pair(description, sampler));
+		return sampler;
+	}
+
+}
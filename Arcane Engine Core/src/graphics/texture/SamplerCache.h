@@ -0,0 +1,34 @@
+#pragma once
+
+#include <graphics/texture/Cubemap.h>
+#include <graphics/texture/Texture.h>
+
+namespace arcane {
+
+	// Everything a sampler object holds, laid out without padding so it can be compared bytewise
+	struct SamplerDescription {
+		GLenum WrapSMode, WrapTMode, WrapRMode;
+		GLenum MinificationFilterMode, MagnificationFilterMode;
+		float AnisotropyLevel;
+		float MipBias;
+		uint32_t HasBorder;
+		glm::vec4 BorderColour;
+
+		bool operator<(const SamplerDescription &other) const { return memcmp(this, &other, sizeof(SamplerDescription)) < 0; }
+	};
+
+	class SamplerCache {
+	public:
+		// Textures with identical sampling settings share one sampler object, which gets bound per unit alongside the texture
+		static unsigned int getSampler(const TextureSettings &settings);
+		static unsigned int getSampler(const CubemapSettings &settings);
+
+		static float getMaxAnisotropy(); // Queried from the driver once
+	private:
+		static unsigned int getSampler(const SamplerDescription &description);
+	private:
+		static std::map<SamplerDescription, unsigned int> s_Samplers;
+		static float s_MaxAnisotropy;
+	};
+
+}
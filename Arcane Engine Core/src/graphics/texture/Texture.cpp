@@ -1,58 +1,140 @@
 #include "pch.h"
 #include "Texture.h"
 
+#include <graphics/texture/SamplerCache.h>
+
 namespace arcane {
 
 	// TODO: Current Texture Copy implementation only copies the highest resolution mip (level 0)
 	// This implementation is fine when the hardware generates the mips because our newly created texture will do the same
 	// This only fails if the mip levels contain custom data that was generated by the hardware via glGenerateMipmap(...)
-	Texture::Texture(const Texture &texture) : m_TextureId(0), m_TextureTarget(texture.getTextureTarget()), m_Width(texture.getWidth()), m_Height(texture.getHeight()), m_TextureSettings(texture.getTextureSettings()) {
+	Texture::Texture(const Texture &texture) : m_TextureId(0), m_TextureTarget(texture.getTextureTarget()), m_Width(texture.getWidth()), m_Height(texture.getHeight()), m_MipsUploaded(false), m_MipCount(1), m_FirstResidentMip(0), m_SamplerId(0), m_TextureSettings(texture.getTextureSettings()) {
 		glGenTextures(1, &m_TextureId);
 		bind();
 
-		glTexImage2D(m_TextureTarget, 0, m_TextureSettings.TextureFormat, m_Width, m_Height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+		glTexStorage2D(m_TextureTarget, m_TextureSettings.HasMips ? getMipLevelCount(m_Width, m_Height) : 1, m_TextureSettings.TextureFormat, m_Width, m_Height);
 		applyTextureSettings();
 		glCopyImageSubData(texture.getTextureId(), texture.getTextureTarget(), 0, 0, 0, 0, m_TextureId, m_TextureTarget, 0, 0, 0, 0, m_Width, m_Height, 1);
 
 		unbind();
 	}
 
-	Texture::Texture(TextureSettings &settings) : m_TextureId(0), m_TextureTarget(0), m_Width(0), m_Height(0), m_TextureSettings(settings) {}
+	Texture::Texture(const TextureSettings &settings) : m_TextureId(0), m_TextureTarget(0), m_Width(0), m_Height(0), m_MipsUploaded(false), m_MipCount(1), m_FirstResidentMip(0), m_SamplerId(0), m_TextureSettings(settings) {}
 
 	Texture::~Texture() {
 		glDeleteTextures(1, &m_TextureId);
 	}
 
 	void Texture::applyTextureSettings() {
-		// Texture wrapping
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_TextureSettings.TextureWrapSMode);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_TextureSettings.TextureWrapTMode);
-		if (m_TextureSettings.HasBorder) {
-			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(m_TextureSettings.BorderColour));
+		// Wrapping, filtering and anisotropy live in a shared sampler object that is bound alongside the texture
+		m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
+
+		// Mipmapping
+		if (m_TextureSettings.HasMips && !m_MipsUploaded) {
+			glGenerateMipmap(m_TextureTarget);
 		}
+	}
+
+	void Texture::generate2DTexture(unsigned int width, unsigned int height, GLenum dataFormat, GLenum pixelDataType, const void *data, bool sourcedFromPixelBuffer) {
+		m_TextureTarget = GL_TEXTURE_2D;
+		m_Width = width;
+		m_Height = height;
+		m_MipsUploaded = false;
+		resolveTextureFormat(dataFormat);
+
+		// Regenerating releases the previous storage (ie. a placeholder being replaced once the real data has loaded)
+		glDeleteTextures(1, &m_TextureId);
+		glGenTextures(1, &m_TextureId);
+		bind();
 
-		// Texture filtering
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_TextureSettings.TextureMinificationFilterMode);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_TextureSettings.TextureMagnificationFilterMode);
+		glTexStorage2D(GL_TEXTURE_2D, m_TextureSettings.HasMips ? getMipLevelCount(width, height) : 1, m_TextureSettings.TextureFormat, width, height);
+		if (data || sourcedFromPixelBuffer) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, dataFormat, pixelDataType, data);
+		}
+		applyTextureSettings();
 
-		// Mipmapping
-		if (m_TextureSettings.HasMips) {
-			glGenerateMipmap(GL_TEXTURE_2D);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, m_TextureSettings.MipBias);
+		unbind();
+	}
+
+	void Texture::generate2DArrayTexture(unsigned int width, unsigned int height, unsigned int layerCount, GLenum dataFormat, GLenum pixelDataType, const void *data) {
+		m_TextureTarget = GL_TEXTURE_2D_ARRAY;
+		m_Width = width;
+		m_Height = height;
+		m_MipsUploaded = false;
+		resolveTextureFormat(dataFormat);
+
+		glDeleteTextures(1, &m_TextureId);
+		glGenTextures(1, &m_TextureId);
+		bind();
+
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_TextureSettings.HasMips ? getMipLevelCount(width, height) : 1, m_TextureSettings.TextureFormat, width, height, layerCount);
+		if (data) {
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, width, height, layerCount, dataFormat, pixelDataType, data);
 		}
+		applyTextureSettings();
 
-		// Anisotropic filtering (TODO: Move the anistropyAmount calculation to Defs.h to avoid querying the OpenGL driver everytime)
-		float maxAnisotropy;
-		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
-		float anistropyAmount = glm::min(maxAnisotropy, m_TextureSettings.TextureAnisotropyLevel);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anistropyAmount);
+		unbind();
 	}
 
-	void Texture::generate2DTexture(unsigned int width, unsigned int height, GLenum dataFormat, GLenum pixelDataType, const void *data) {
+	void Texture::generateCompressed2DTexture(unsigned int width, unsigned int height, GLenum compressedFormat, unsigned int mipCount, const void *data, unsigned int firstResidentMip) {
 		m_TextureTarget = GL_TEXTURE_2D;
 		m_Width = width;
 		m_Height = height;
+		m_MipsUploaded = true; // Compressed formats can't have their mips generated, so whatever was supplied is the whole chain
+		m_MipCount = mipCount;
+
+		m_TextureSettings.TextureFormat = compressedFormat;
+		if (m_TextureSettings.IsSRGB) {
+			switch (compressedFormat) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: m_TextureSettings.TextureFormat = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT; break;
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: m_TextureSettings.TextureFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; break;
+			}
+		}
 
+		glDeleteTextures(1, &m_TextureId);
+		m_TextureId = 0;
+		m_FirstResidentMip = mipCount;
+		changeResidentMips(firstResidentMip, data);
+	}
+
+	void Texture::changeResidentMips(unsigned int firstResidentMip, const void *mipData) {
+		unsigned int previousTextureId = m_TextureId, previousFirstResidentMip = m_FirstResidentMip;
+
+		// Immutable storage sized for just the resident mips, so evicting mips actually gives the memory back
+		glGenTextures(1, &m_TextureId);
+		bind();
+		glTexStorage2D(GL_TEXTURE_2D, m_MipCount - firstResidentMip, m_TextureSettings.TextureFormat, std::max(m_Width >> firstResidentMip, 1u), std::max(m_Height >> firstResidentMip, 1u));
+
+		const unsigned char *nextMipData = (const unsigned char*)mipData;
+		for (unsigned int mip = firstResidentMip; mip < m_MipCount; mip++) {
+			unsigned int mipWidth = std::max(m_Width >> mip, 1u), mipHeight = std::max(m_Height >> mip, 1u);
+			if (mip >= previousFirstResidentMip) {
+				glCopyImageSubData(previousTextureId, GL_TEXTURE_2D, mip - previousFirstResidentMip, 0, 0, 0, m_TextureId, GL_TEXTURE_2D, mip - firstResidentMip, 0, 0, 0, mipWidth, mipHeight, 1);
+			}
+			else {
+				unsigned int mipSize = getCompressedImageSize(m_TextureSettings.TextureFormat, mipWidth, mipHeight);
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, mip - firstResidentMip, 0, 0, mipWidth, mipHeight, m_TextureSettings.TextureFormat, mipSize, nextMipData);
+				nextMipData += mipSize;
+			}
+		}
+		applyTextureSettings();
+		unbind();
+
+		glDeleteTextures(1, &previousTextureId);
+		m_FirstResidentMip = firstResidentMip;
+	}
+
+	unsigned int Texture::getCompressedImageSize(GLenum compressedFormat, unsigned int width, unsigned int height) {
+		// Every BC format works on 4x4 blocks, the single channel and colour only formats use 8 bytes per block and the rest use 16
+		unsigned int blockSize;
+		switch (compressedFormat) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT: case GL_COMPRESSED_RED_RGTC1: blockSize = 8; break;
+		default: blockSize = 16; break;
+		}
+		return ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+	}
+
+	void Texture::resolveTextureFormat(GLenum dataFormat) {
 		// If GL_NONE is specified, set the texture format to the data format
 		if (m_TextureSettings.TextureFormat == GL_NONE) {
 			m_TextureSettings.TextureFormat = dataFormat;
@@ -64,14 +146,26 @@ namespace arcane {
 			case GL_RGBA: m_TextureSettings.TextureFormat = GL_SRGB_ALPHA; break;
 			}
 		}
+		m_TextureSettings.TextureFormat = getSizedTextureFormat(m_TextureSettings.TextureFormat);
+	}
 
-		glGenTextures(1, &m_TextureId);
-		bind();
-
-		glTexImage2D(GL_TEXTURE_2D, 0, m_TextureSettings.TextureFormat, width, height, 0, dataFormat, pixelDataType, data);
-		applyTextureSettings();
+	GLenum Texture::getSizedTextureFormat(GLenum textureFormat) {
+		// Immutable storage only accepts sized formats, unsized ones get the precision the driver used to pick for them
+		switch (textureFormat) {
+		case GL_RED: return GL_R8;
+		case GL_RG: return GL_RG8;
+		case GL_RGB: return GL_RGB8;
+		case GL_RGBA: return GL_RGBA8;
+		case GL_SRGB: return GL_SRGB8;
+		case GL_SRGB_ALPHA: return GL_SRGB8_ALPHA8;
+		case GL_DEPTH_COMPONENT: return GL_DEPTH_COMPONENT24;
+		case GL_DEPTH_STENCIL: return GL_DEPTH24_STENCIL8;
+		default: return textureFormat;
+		}
+	}
 
-		unbind();
+	unsigned int Texture::getMipLevelCount(unsigned int width, unsigned int height) {
+		return (unsigned int)std::floor(std::log2((float)std::max(width, height))) + 1;
 	}
 
 	void Texture::generate2DMultisampleTexture(unsigned int width, unsigned int height) {
@@ -80,9 +174,12 @@ namespace arcane {
 		m_Width = width;
 		m_Height = height;
 
+		m_TextureSettings.TextureFormat = getSizedTextureFormat(m_TextureSettings.TextureFormat);
+
+		glDeleteTextures(1, &m_TextureId);
 		glGenTextures(1, &m_TextureId);
 		bind();
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, MSAA_SAMPLE_AMOUNT, m_TextureSettings.TextureFormat, m_Width, m_Height, GL_TRUE);
+		glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, MSAA_SAMPLE_AMOUNT, m_TextureSettings.TextureFormat, m_Width, m_Height, GL_TRUE);
 		unbind();
 	}
 
@@ -97,6 +194,7 @@ namespace arcane {
 	void Texture::bind(int unit) {
 		glActiveTexture(GL_TEXTURE0 + unit);
 		glBindTexture(m_TextureTarget, m_TextureId);
+		glBindSampler(unit, m_SamplerId);
 	}
 
 	void Texture::unbind() {
@@ -111,7 +209,7 @@ namespace arcane {
 
 		m_TextureSettings.TextureWrapSMode = textureWrapMode;
 		if (isGenerated()) {
-			glTexParameteri(m_TextureTarget, GL_TEXTURE_WRAP_S, m_TextureSettings.TextureWrapSMode);
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -121,7 +219,7 @@ namespace arcane {
 
 		m_TextureSettings.TextureWrapTMode = textureWrapMode;
 		if (isGenerated()) {
-			glTexParameteri(m_TextureTarget, GL_TEXTURE_WRAP_T, m_TextureSettings.TextureWrapTMode);
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -131,7 +229,7 @@ namespace arcane {
 
 		m_TextureSettings.HasBorder = hasBorder;
 		if (isGenerated()) {
-			glTexParameterfv(m_TextureTarget, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(m_TextureSettings.BorderColour));
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -141,7 +239,7 @@ namespace arcane {
 
 		m_TextureSettings.BorderColour = borderColour;
 		if (isGenerated()) {
-			glTexParameterfv(m_TextureTarget, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(m_TextureSettings.BorderColour));
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -151,7 +249,7 @@ namespace arcane {
 
 		m_TextureSettings.TextureMinificationFilterMode = textureFilterMode;
 		if (isGenerated()) {
-			glTexParameteri(m_TextureTarget, GL_TEXTURE_MIN_FILTER, m_TextureSettings.TextureMinificationFilterMode);
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -165,7 +263,7 @@ namespace arcane {
 
 		m_TextureSettings.TextureMagnificationFilterMode = textureFilterMode;
 		if (isGenerated()) {
-			glTexParameteri(m_TextureTarget, GL_TEXTURE_MAG_FILTER, m_TextureSettings.TextureMagnificationFilterMode);
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -175,10 +273,7 @@ namespace arcane {
 
 		m_TextureSettings.TextureAnisotropyLevel = textureAnisotropyLevel;
 		if (isGenerated()) {
-			float maxAnisotropy;
-			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
-			float anistropyAmount = glm::min(maxAnisotropy, m_TextureSettings.TextureAnisotropyLevel);
-			glTexParameterf(m_TextureTarget, GL_TEXTURE_MAX_ANISOTROPY_EXT, anistropyAmount);
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -188,7 +283,7 @@ namespace arcane {
 
 		m_TextureSettings.MipBias = mipBias;
 		if (isGenerated()) {
-			glTexParameteri(m_TextureTarget, GL_TEXTURE_LOD_BIAS, m_TextureSettings.MipBias);
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -196,9 +291,14 @@ namespace arcane {
 		if (m_TextureSettings.HasMips == hasMips)
 			return;
 
+		// Only fills in levels the storage was allocated with, immutable storage can't grow a mip chain it was created without
 		m_TextureSettings.HasMips = hasMips;
-		if (isGenerated() && hasMips == true) {
-			glGenerateMipmap(m_TextureTarget);
+		if (isGenerated()) {
+			if (hasMips == true && !m_MipsUploaded) {
+				bind();
+				glGenerateMipmap(m_TextureTarget);
+			}
+			m_SamplerId = SamplerCache::getSampler(m_TextureSettings);
 		}
 	}
 
@@ -11,6 +11,9 @@ namespace arcane {
 		 * thus they are not in SRGB space. Note: If you generate your own data and it is already in linear space (like light probes), be careful */
 		bool IsSRGB = false;
 
+		// Normal maps get renormalized when their mips are filtered and are cooked to two channels (BC5), shaders reconstruct z
+		bool IsNormalMap = false;
+
 		// Texture wrapping options
 		GLenum TextureWrapSMode = GL_REPEAT;
 		GLenum TextureWrapTMode = GL_REPEAT;
@@ -30,14 +33,19 @@ namespace arcane {
 	class Texture {
 	public:
 		Texture(const Texture &texture); // Copies another texture and its settings
-		Texture(TextureSettings &settings = TextureSettings()); // If nothing is supplied, it will construct default settings
+		Texture(const TextureSettings &settings = TextureSettings()); // If nothing is supplied, it will construct default settings
 		~Texture();
 
 		// Generation functions
-		void generate2DTexture(unsigned int width, unsigned int height, GLenum dataFormat, GLenum pixelDataType = GL_UNSIGNED_BYTE, const void *data = nullptr);
+		void generate2DTexture(unsigned int width, unsigned int height, GLenum dataFormat, GLenum pixelDataType = GL_UNSIGNED_BYTE, const void *data = nullptr, bool sourcedFromPixelBuffer = false); // When sourced from a bound pixel unpack buffer, data is an offset into it (so null is still valid)
+		void generate2DArrayTexture(unsigned int width, unsigned int height, unsigned int layerCount, GLenum dataFormat, GLenum pixelDataType = GL_UNSIGNED_BYTE, const void *data = nullptr); // Layers are expected to be tightly packed one after another
+		void generateCompressed2DTexture(unsigned int width, unsigned int height, GLenum compressedFormat, unsigned int mipCount, const void *data, unsigned int firstResidentMip = 0); // Mips from firstResidentMip down are expected to be tightly packed, largest first
 		void generate2DMultisampleTexture(unsigned int width, unsigned int height);
 		void generateMips(); // Will attempt to generate mipmaps, only works if the texture has already been generated
 
+		// Reallocates a compressed texture so only mips from firstResidentMip down are on the GPU. Mips that stay resident are copied on the GPU, the newly resident ones come from mipData (tightly packed, largest first)
+		void changeResidentMips(unsigned int firstResidentMip, const void *mipData = nullptr);
+
 		void bind(int unit = 0);
 		void unbind();
 
@@ -62,14 +70,24 @@ namespace arcane {
 		inline bool isGenerated() const { return m_TextureId != 0; }
 		inline unsigned int getWidth() const { return m_Width; }
 		inline unsigned int getHeight() const { return m_Height; }
+		inline unsigned int getMipCount() const { return m_MipCount; }
+		inline unsigned int getFirstResidentMip() const { return m_FirstResidentMip; }
 		inline const TextureSettings& getTextureSettings() const { return m_TextureSettings; }
+
+		static unsigned int getCompressedImageSize(GLenum compressedFormat, unsigned int width, unsigned int height);
+		static GLenum getSizedTextureFormat(GLenum textureFormat);
+		static unsigned int getMipLevelCount(unsigned int width, unsigned int height);
 	private:
+		void resolveTextureFormat(GLenum dataFormat);
 		void applyTextureSettings();
 	private:
 		unsigned int m_TextureId;
 		GLenum m_TextureTarget;
 
 		unsigned int m_Width, m_Height;
+		bool m_MipsUploaded; // Mips came with the data (ie. cooked textures) so they shouldn't be generated by the driver
+		unsigned int m_MipCount, m_FirstResidentMip; // Only tracked for uploaded mip chains, width and height always refer to the full resolution mip
+		unsigned int m_SamplerId; // Shared with every texture using the same sampling settings (see SamplerCache)
 
 		TextureSettings m_TextureSettings;
 	};
@@ -0,0 +1,245 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+
+namespace arcane {
+
+	// Static declarations
+	std::unordered_map<Texture*, StreamedTexture> TextureStreamer::s_StreamedTextures;
+	uint64_t TextureStreamer::s_FrameIndex = 1;
+	size_t TextureStreamer::s_ResidentBytes = 0;
+	std::thread TextureStreamer::s_ReadWorker;
+	std::mutex TextureStreamer::s_RequestMutex, TextureStreamer::s_ResultMutex;
+	std::condition_variable TextureStreamer::s_RequestCondition;
+	std::deque<TextureMipRequest> TextureStreamer::s_Requests;
+	std::deque<TextureMipResult> TextureStreamer::s_Results;
+	bool TextureStreamer::s_ShutdownWorker = false;
+
+	bool TextureStreamer::trimToResidentTail(CookedTexture &cooked) {
+		if (cooked.CachePath.empty() || cooked.FirstMip != 0)
+			return false;
+
+		unsigned int tailMip = getTailMip(cooked.Width, cooked.Height, cooked.MipCount);
+		if (tailMip == 0)
+			return false;
+
+		size_t tailOffset = TextureCooker::getMipDataOffset(cooked.CompressedFormat, cooked.Width, cooked.Height, tailMip);
+		cooked.Data.erase(cooked.Data.begin(), cooked.Data.begin() + tailOffset);
+		cooked.FirstMip = tailMip;
+		return true;
+	}
+
+	void TextureStreamer::registerTexture(Texture *texture, const CookedTexture &cooked) {
+		if (!s_ReadWorker.joinable()) {
+			s_ShutdownWorker = false;
+			s_ReadWorker = std::thread(&TextureStreamer::readWorkerLoop);
+		}
+
+		StreamedTexture streamed;
+		streamed.CachePath = cooked.CachePath;
+		streamed.CacheDataOffset = cooked.CacheDataOffset;
+		streamed.CompressedFormat = cooked.CompressedFormat;
+		streamed.TailMip = cooked.FirstMip;
+		streamed.RequestedMip = cooked.FirstMip;
+		streamed.TargetMip = cooked.FirstMip;
+		streamed.LastRequestedFrame = 0;
+		streamed.ReadInFlight = false;
+		s_StreamedTextures[texture] = streamed;
+	}
+
+	void TextureStreamer::unregisterTexture(Texture *texture) {
+		s_StreamedTextures.erase(texture);
+	}
+
+	void TextureStreamer::requestDetail(Texture *texture, float screenSpaceSize) {
+		auto iter = s_StreamedTextures.find(texture);
+		if (iter == s_StreamedTextures.end())
+			return;
+
+		// Pick the mip whose resolution roughly matches the pixels it covers
+		StreamedTexture &streamed = iter->second;
+		float mip = std::floor(std::log2((float)std::max(texture->getWidth(), texture->getHeight()) / std::max(screenSpaceSize, 1.0f)));
+		unsigned int requestedMip = (unsigned int)glm::clamp(mip, 0.0f, (float)streamed.TailMip);
+
+		streamed.RequestedMip = std::min(streamed.RequestedMip, requestedMip);
+		streamed.LastRequestedFrame = s_FrameIndex;
+	}
+
+	void TextureStreamer::update() {
+		PROFILE_FUNCTION();
+		// Swap in the mips that finished reading, unless the texture's residency changed while they were being read
+		for (unsigned int i = 0; i < TEXTURE_STREAMING_UPLOADS_PER_FRAME; i++) {
+			TextureMipResult result;
+			{
+				std::lock_guard<std::mutex> lock(s_ResultMutex);
+				if (s_Results.empty())
+					break;
+				result = std::move(s_Results.front());
+				s_Results.pop_front();
+			}
+
+			auto iter = s_StreamedTextures.find(result.Target);
+			if (iter == s_StreamedTextures.end())
+				continue;
+
+			StreamedTexture &streamed = iter->second;
+			streamed.ReadInFlight = false;
+			if (result.Data.empty()) {
+				Logger::getInstance().error("logged_files/texture_loading.txt", "texture streaming", "Couldn't read mips from: " + streamed.CachePath);
+				streamed.TailMip = result.Target->getFirstResidentMip(); // Stop asking for mips that can't be read
+			}
+			else if (result.EndMip == result.Target->getFirstResidentMip()) {
+				result.Target->changeResidentMips(result.FirstMip, result.Data.data());
+			}
+		}
+
+		// What each texture needs: this frame's feedback if it was seen, its current mips if it was seen recently, otherwise only the tail
+		std::vector<std::pair<Texture*, StreamedTexture*>> textures;
+		textures.reserve(s_StreamedTextures.size());
+		size_t targetBytes = 0;
+		for (auto &iter : s_StreamedTextures) {
+			Texture *texture = iter.first;
+			StreamedTexture &streamed = iter.second;
+			unsigned int residentMip = texture->getFirstResidentMip();
+
+			if (streamed.LastRequestedFrame == s_FrameIndex)
+				streamed.TargetMip = streamed.RequestedMip;
+			else if (s_FrameIndex - streamed.LastRequestedFrame <= TEXTURE_STREAMING_EVICTION_FRAMES)
+				streamed.TargetMip = residentMip;
+			else
+				streamed.TargetMip = streamed.TailMip;
+			streamed.TargetMip = std::min(streamed.TargetMip, streamed.TailMip);
+
+			targetBytes += getResidentSize(texture, streamed, streamed.TargetMip);
+			textures.push_back(std::make_pair(texture, &streamed));
+		}
+
+		// Least needed first: textures that haven't been seen for the longest, then the ones using the most memory
+		std::sort(textures.begin(), textures.end(), [](const std::pair<Texture*, StreamedTexture*> &a, const std::pair<Texture*, StreamedTexture*> &b) {
+			if (a.second->LastRequestedFrame != b.second->LastRequestedFrame)
+				return a.second->LastRequestedFrame < b.second->LastRequestedFrame;
+			return getResidentSize(a.first, *a.second, a.second->TargetMip) > getResidentSize(b.first, *b.second, b.second->TargetMip);
+		});
+
+		if (targetBytes > TEXTURE_STREAMING_BUDGET) {
+			// Over budget, drop mips from the least needed textures until everything fits
+			for (auto &texture : textures) {
+				StreamedTexture &streamed = *texture.second;
+				while (targetBytes > TEXTURE_STREAMING_BUDGET && streamed.TargetMip < streamed.TailMip) {
+					targetBytes -= getResidentSize(texture.first, streamed, streamed.TargetMip) - getResidentSize(texture.first, streamed, streamed.TargetMip + 1);
+					streamed.TargetMip++;
+				}
+			}
+		}
+		else {
+			// Under budget, hold on to detail that is no longer needed (most needed first) so moving back and forth doesn't thrash the disk
+			for (auto iter = textures.rbegin(); iter != textures.rend(); iter++) {
+				StreamedTexture &streamed = *iter->second;
+				unsigned int residentMip = iter->first->getFirstResidentMip();
+				if (residentMip >= streamed.TargetMip)
+					continue;
+
+				size_t extraBytes = getResidentSize(iter->first, streamed, residentMip) - getResidentSize(iter->first, streamed, streamed.TargetMip);
+				if (targetBytes + extraBytes <= TEXTURE_STREAMING_BUDGET) {
+					targetBytes += extraBytes;
+					streamed.TargetMip = residentMip;
+				}
+			}
+		}
+
+		// Evict straight away (it only shrinks the storage), stream in missing mips from the cooked file
+		s_ResidentBytes = 0;
+		for (auto &texture : textures) {
+			StreamedTexture &streamed = *texture.second;
+			unsigned int residentMip = texture.first->getFirstResidentMip();
+
+			if (streamed.TargetMip > residentMip) {
+				texture.first->changeResidentMips(streamed.TargetMip);
+			}
+			else if (streamed.TargetMip < residentMip && !streamed.ReadInFlight) {
+				const Texture *target = texture.first;
+				size_t firstMipOffset = TextureCooker::getMipDataOffset(streamed.CompressedFormat, target->getWidth(), target->getHeight(), streamed.TargetMip);
+
+				TextureMipRequest request;
+				request.Target = texture.first;
+				request.CachePath = streamed.CachePath;
+				request.FileOffset = streamed.CacheDataOffset + firstMipOffset;
+				request.Size = TextureCooker::getMipDataOffset(streamed.CompressedFormat, target->getWidth(), target->getHeight(), residentMip) - firstMipOffset;
+				request.FirstMip = streamed.TargetMip;
+				request.EndMip = residentMip;
+				{
+					std::lock_guard<std::mutex> lock(s_RequestMutex);
+					s_Requests.push_back(request);
+				}
+				s_RequestCondition.notify_one();
+				streamed.ReadInFlight = true;
+			}
+
+			s_ResidentBytes += getResidentSize(texture.first, streamed, texture.first->getFirstResidentMip());
+			streamed.RequestedMip = streamed.TailMip;
+		}
+
+		s_FrameIndex++;
+	}
+
+	void TextureStreamer::shutdown() {
+		{
+			std::lock_guard<std::mutex> lock(s_RequestMutex);
+			s_ShutdownWorker = true;
+			s_Requests.clear();
+		}
+		s_RequestCondition.notify_all();
+		if (s_ReadWorker.joinable()) {
+			s_ReadWorker.join();
+		}
+		s_Results.clear();
+	}
+
+	void TextureStreamer::readWorkerLoop() {
+		PROFILE_THREAD_NAME("Texture Streaming Worker");
+		while (true) {
+			TextureMipRequest request;
+			{
+				std::unique_lock<std::mutex> lock(s_RequestMutex);
+				s_RequestCondition.wait(lock, []() { return s_ShutdownWorker || !s_Requests.empty(); });
+				if (s_ShutdownWorker)
+					return;
+
+				request = s_Requests.front();
+				s_Requests.pop_front();
+			}
+
+			PROFILE_ZONE("Read Streamed Mips");
+			TextureMipResult result;
+			result.Target = request.Target;
+			result.FirstMip = request.FirstMip;
+			result.EndMip = request.EndMip;
+
+			std::ifstream input(request.CachePath, std::ios::in | std::ios::binary);
+			if (input) {
+				result.Data.resize(request.Size);
+				input.seekg(request.FileOffset);
+				input.read((char*)result.Data.data(), request.Size);
+				if (!input) {
+					result.Data.clear();
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(s_ResultMutex);
+			s_Results.push_back(std::move(result));
+		}
+	}
+
+	size_t TextureStreamer::getResidentSize(const Texture *texture, const StreamedTexture &streamed, unsigned int firstMip) {
+		size_t chainSize = TextureCooker::getMipDataOffset(streamed.CompressedFormat, texture->getWidth(), texture->getHeight(), texture->getMipCount());
+		return chainSize - TextureCooker::getMipDataOffset(streamed.CompressedFormat, texture->getWidth(), texture->getHeight(), firstMip);
+	}
+
+	unsigned int TextureStreamer::getTailMip(unsigned int width, unsigned int height, unsigned int mipCount) {
+		unsigned int tailMip = 0;
+		while (tailMip + 1 < mipCount && std::max(width >> tailMip, height >> tailMip) > TEXTURE_STREAMING_RESIDENT_TAIL_SIZE) {
+			tailMip++;
+		}
+		return tailMip;
+	}
+
+}
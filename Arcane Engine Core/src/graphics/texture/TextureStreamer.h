@@ -0,0 +1,66 @@
+#pragma once
+
+#include <graphics/texture/Texture.h>
+#include <utils/loaders/TextureCooker.h>
+
+namespace arcane {
+
+	struct StreamedTexture {
+		std::string CachePath; // Cooked file the mips are read from
+		size_t CacheDataOffset;
+		GLenum CompressedFormat;
+
+		unsigned int TailMip; // Largest mip that is always resident
+		unsigned int RequestedMip; // Largest mip wanted by this frame's feedback
+		unsigned int TargetMip; // Largest mip that should be resident once the budget has been applied
+		uint64_t LastRequestedFrame;
+		bool ReadInFlight;
+	};
+
+	struct TextureMipRequest {
+		Texture *Target;
+		std::string CachePath;
+		size_t FileOffset, Size;
+		unsigned int FirstMip, EndMip; // Reads mips [FirstMip, EndMip)
+	};
+
+	struct TextureMipResult {
+		Texture *Target;
+		unsigned int FirstMip, EndMip;
+		std::vector<unsigned char> Data; // Empty if the read failed
+	};
+
+	class TextureStreamer {
+	public:
+		// Drops everything above the always resident tail from a cooked texture, returns false if the texture can't be streamed
+		static bool trimToResidentTail(CookedTexture &cooked);
+		static void registerTexture(Texture *texture, const CookedTexture &cooked);
+		static void unregisterTexture(Texture *texture); // Before the texture is destroyed, reads still in flight for it are dropped
+
+		// Feedback: how many pixels tall the texture covers on screen this frame
+		static void requestDetail(Texture *texture, float screenSpaceSize);
+
+		static void update(); // Call on the GL thread once a frame, after the frame's feedback has been requested
+		static void shutdown();
+
+		inline static size_t getResidentBytes() { return s_ResidentBytes; }
+		inline static size_t getStreamedTextureCount() { return s_StreamedTextures.size(); }
+	private:
+		static void readWorkerLoop();
+		static size_t getResidentSize(const Texture *texture, const StreamedTexture &streamed, unsigned int firstMip);
+		static unsigned int getTailMip(unsigned int width, unsigned int height, unsigned int mipCount);
+	private:
+		static std::unordered_map<Texture*, StreamedTexture> s_StreamedTextures;
+		static uint64_t s_FrameIndex;
+		static size_t s_ResidentBytes;
+
+		// Disk reads happen on a worker so the GL thread only ever does the upload
+		static std::thread s_ReadWorker;
+		static std::mutex s_RequestMutex, s_ResultMutex;
+		static std::condition_variable s_RequestCondition;
+		static std::deque<TextureMipRequest> s_Requests;
+		static std::deque<TextureMipResult> s_Results;
+		static bool s_ShutdownWorker;
+	};
+
+}
@@ -1,15 +1,45 @@
 #include "pch.h"
 
 #include <graphics/Window.h>
+#include <graphics/camera/CameraPath.h>
+#include <graphics/renderer/GPUProfiler.h>
 #include <graphics/renderer/MasterRenderer.h>
+#include <graphics/renderer/RenderStatistics.h>
+#include <graphics/texture/TextureStreamer.h>
 #include <scene/Scene3D.h>
 #include <ui/DebugPane.h>
 #include <ui/RuntimePane.h>
+#include <utils/Benchmark.h>
+#include <utils/FrameStatistics.h>
+#include <utils/MicroBenchmark.h>
 #include <utils/Time.h>
+#include <utils/VirtualFileSystem.h>
+#include <utils/loaders/AssetManager.h>
+
+int main(int argc, char **argv) {
+	PROFILE_THREAD_NAME("Main Thread");
+
+	// Runs before the window exists, it needs no GL context
+	if (arcane::MicroBenchmark::isRequested(argc, argv))
+		return arcane::MicroBenchmark::run(argc, argv);
+
+	// Mount the packed resources before anything is loaded
+#if VFS_BUILD_ARCHIVE
+	arcane::PackArchive::buildArchive(VFS_ARCHIVE_PATH, VFS_ARCHIVE_MANIFEST_PATH);
+#endif
+	arcane::VirtualFileSystem::mountArchive(VFS_ARCHIVE_PATH);
+
+	if (arcane::Benchmark::isRequested(argc, argv)) {
+		int exitCode = arcane::Benchmark::run(argc, argv);
+		arcane::VirtualFileSystem::unmountArchives();
+		return exitCode;
+	}
 
-int main() {
 	// Prepare the engine
 	arcane::Window window("Arcane Engine", WINDOW_X_RESOLUTION, WINDOW_Y_RESOLUTION);
+#if GPU_PROFILER_ENABLED
+	arcane::GPUProfiler::init();
+#endif
 	arcane::TextureLoader::initializeDefaultTextures();
 	arcane::Scene3D scene(&window);
 	arcane::MasterRenderer renderer(&scene);
@@ -19,12 +49,24 @@ int main() {
 	arcane::RuntimePane runtimePane(glm::vec2(270.0f, 175.0f));
 	arcane::DebugPane debugPane(glm::vec2(270.0f, 400.0f));
 
-	// Initialize the renderer
+	// Initialize the renderer (wait for models and textures to finish streaming in so the probes don't capture placeholders)
+	arcane::AssetManager::finishAsyncLoads();
+	arcane::TextureLoader::finishAsyncLoads();
 	renderer.init();
 
+	// F9 starts and stops recording a camera path for the benchmark
+	arcane::CameraPath recordedPath;
+	bool recordingPath = false, recordKeyWasPressed = false;
+	double recordingStart = 0.0;
+
 	arcane::Time deltaTime;
 	while (!window.closed()) {
 		deltaTime.update();
+		arcane::RenderStatistics::reset();
+		arcane::FrameStatistics::beginFrame();
+#if GPU_PROFILER_ENABLED
+		arcane::GPUProfiler::beginFrame();
+#endif
 
 #if DEBUG_ENABLED
 		if (debugPane.getWireframeMode())
@@ -37,19 +79,62 @@ int main() {
 		arcane::Window::clear();
 		ImGui_ImplGlfwGL3_NewFrame();
 
+		arcane::AssetManager::update();
+		arcane::TextureLoader::updateAsyncLoads();
 		scene.onUpdate((float)deltaTime.getDeltaTime());
+
+		bool recordKeyPressed = arcane::InputManager::isKeyPressed(GLFW_KEY_F9);
+		if (recordKeyPressed && !recordKeyWasPressed) {
+			recordingPath = !recordingPath;
+			if (recordingPath) {
+				recordedPath.clear();
+				recordingStart = glfwGetTime();
+			}
+			else {
+				recordedPath.save(CAMERA_PATH_RECORDING_PATH);
+			}
+		}
+		recordKeyWasPressed = recordKeyPressed;
+		if (recordingPath)
+			recordedPath.record(*scene.getCamera(), (float)(glfwGetTime() - recordingStart));
 		renderer.render();
 
 		// Display panes
-		arcane::Window::bind();
-		runtimePane.render();
-		debugPane.render();
+		{
+			PROFILE_ZONE("UI");
+			PROFILE_GPU_PASS("UI");
+			arcane::Window::bind();
+			runtimePane.render();
+			debugPane.render();
 
-		ImGui::Render();
-		ImGui_ImplGlfwGL3_RenderDrawData(ImGui::GetDrawData());
+			ImGui::Render();
+			ImGui_ImplGlfwGL3_RenderDrawData(ImGui::GetDrawData());
+		}
+
+#if GPU_PROFILER_ENABLED
+		arcane::GPUProfiler::endFrame();
+#endif
+		arcane::FrameStatistics::endFrame();
 
 		// Window and input updating
-		window.update();
+		{
+			PROFILE_ZONE("Window Update");
+			window.update();
+		}
+#if PROFILER_ENABLED
+		arcane::Profiler::endFrame();
+#endif
 	}
+
+#if GPU_PROFILER_ENABLED
+	arcane::GPUProfiler::shutdown();
+#endif
+	arcane::TextureLoader::shutdownAsyncLoading();
+	arcane::AssetManager::shutdown();
+	arcane::TextureStreamer::shutdown();
+	arcane::VirtualFileSystem::unmountArchives();
+#if PROFILER_ENABLED
+	arcane::Profiler::shutdown();
+#endif
 	return 0;
 }
@@ -8,11 +8,22 @@
 #include <string>
 #include <deque>
 #include <unordered_map>
+#include <map>
 #include <array>
 #include <set>
 #include <iterator>
 #include <fstream>
 #include <random>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <chrono>
+#include <functional>
+#include <algorithm>
 
 #include <gl/glew.h>
 
@@ -30,3 +41,4 @@
 
 #include "Defs.h"
 #include "utils/Logger.h"
+#include "utils/Profiler.h"
@@ -20,6 +20,7 @@ namespace arcane {
 		inline const glm::vec3& getScale() const { return m_Scale; }
 		inline const glm::quat& getOrientation() const { return m_Orientation; }
 		inline const RenderableModel* getParent() const { return m_Parent; }
+		inline Model* getModel() const { return m_Model; }
 		inline bool getTransparent() const { return m_IsTransparent; }
 		inline bool getStatic() const { return m_IsStatic; }
 
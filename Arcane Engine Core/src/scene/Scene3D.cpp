@@ -5,43 +5,76 @@
 #include <graphics/mesh/common/Cube.h>
 #include <graphics/mesh/common/Sphere.h>
 #include <graphics/mesh/common/Quad.h>
+#include <graphics/texture/TextureStreamer.h>
 
 namespace arcane {
 
-	Scene3D::Scene3D(Window *window)
+	Scene3D::Scene3D(Window *window, const std::string &sceneName)
 		: m_SceneCamera(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f), m_ModelRenderer(getCamera()), m_Terrain(glm::vec3(0.0f, -20.0f, 0.0f)), m_ProbeManager(m_SceneProbeBlendSetting)
 	{
 		m_GLCache = GLCache::getInstance();
 
-		init();
+		init(sceneName);
 	}
 
 	Scene3D::~Scene3D() {
 		
 	}
 
-	void Scene3D::init() {
+	void Scene3D::init(const std::string &sceneName) {
+		PROFILE_FUNCTION();
 		TextureSettings srgbTextureSettings;
 		srgbTextureSettings.IsSRGB = true;
 
-		Model *pbrGun = new arcane::Model("res/3D_Models/Cerberus_Gun/Cerberus_LP.FBX");
-		m_RenderableModels.push_back(new RenderableModel(glm::vec3(120.0f, 75.0f, 120.0f), glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(-90.0f), pbrGun, nullptr, true, false));
-		//pbrGun->getMeshes()[0].getMaterial().setAlbedoMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_A.tga"), &srgbTextureSettings));
-		//pbrGun->getMeshes()[0].getMaterial().setNormalMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_N.tga")));
-		//pbrGun->getMeshes()[0].getMaterial().setMetallicMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_M.tga")));
-		//pbrGun->getMeshes()[0].getMaterial().setRoughnessMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_R.tga")));
-		//pbrGun->getMeshes()[0].getMaterial().setAmbientOcclusionMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_AO.tga")));
-
-		//Model *hyruleShield = new arcane::Model("res/3D_Models/Hyrule_Shield/HShield.obj");
-		//m_RenderableModels.push_back(new RenderableModel(glm::vec3(67.0f, 92.0f, 133.0f), glm::vec3(5.0f, 5.0f, 5.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(180.0f), hyruleShield, nullptr, false, false));
-		//hyruleShield->getMeshes()[0].getMaterial().setAlbedoMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Albedo].tga"), &srgbTextureSettings));
-		//hyruleShield->getMeshes()[0].getMaterial().setNormalMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Normal].tga")));
-		//hyruleShield->getMeshes()[0].getMaterial().setMetallicMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Metallic].tga")));
-		//hyruleShield->getMeshes()[0].getMaterial().setRoughnessMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Roughness].tga")));
-		//hyruleShield->getMeshes()[0].getMaterial().setAmbientOcclusionMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Occlusion].tga")));
-
-		//Model *sponza = new arcane::Model("res/3D_Models/Sponza/sponza.obj");
-		//m_RenderableModels.push_back(new RenderableModel(glm::vec3(67.0f, 110.0f, 133.0f), glm::vec3(0.05f, 0.05f, 0.05f), glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(180.0f), sponza, nullptr, true, false));
+		// Models are read on worker threads and show up once they are uploaded, so building the scene doesn't wait on the disk
+		glm::vec3 cameraPosition(90.0f, 80.0f, 180.0f);
+		if (StressSceneGenerator::isStressScene(sceneName)) {
+			StressSceneSettings settings;
+			StressSceneGenerator::parseSettings(sceneName, settings);
+			StressScene stressScene;
+			StressSceneGenerator::generate(settings, stressScene);
+
+			m_Models = std::move(stressScene.Models);
+			m_RenderableModels = std::move(stressScene.Renderables);
+			m_Animations = std::move(stressScene.Animations);
+			m_ProbePositions = std::move(stressScene.ProbePositions);
+			for (PointLight &pointLight : stressScene.PointLights) {
+				m_DynamicLightManager.addPointLight(pointLight);
+			}
+			for (SpotLight &spotLight : stressScene.SpotLights) {
+				m_DynamicLightManager.addSpotLight(spotLight);
+			}
+			cameraPosition = stressScene.CameraPosition;
+		}
+		else if (sceneName == "sponza") {
+			AssetHandle<Model> sponza = AssetManager::loadModelAsync("res/3D_Models/Sponza/sponza.obj");
+			m_Models.push_back(sponza);
+			m_RenderableModels.push_back(new RenderableModel(glm::vec3(67.0f, 110.0f, 133.0f), glm::vec3(0.05f, 0.05f, 0.05f), glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(180.0f), sponza.get(), nullptr, true, false));
+			m_ProbePositions.push_back(glm::vec3(67.0f, 92.0f, 133.0f));
+		}
+		else {
+			if (sceneName != "default") {
+				Logger::getInstance().warning("logged_files/scene.txt", "scene loading", "Unknown scene \"" + sceneName + "\", loading the default scene");
+			}
+			AssetHandle<Model> pbrGun = AssetManager::loadModelAsync("res/3D_Models/Cerberus_Gun/Cerberus_LP.FBX");
+			m_Models.push_back(pbrGun);
+			m_RenderableModels.push_back(new RenderableModel(glm::vec3(120.0f, 75.0f, 120.0f), glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(-90.0f), pbrGun.get(), nullptr, true, false));
+			m_ProbePositions.push_back(glm::vec3(67.0f, 92.0f, 133.0f));
+			//pbrGun->getMeshes()[0].getMaterial().setAlbedoMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_A.tga"), &srgbTextureSettings));
+			//pbrGun->getMeshes()[0].getMaterial().setNormalMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_N.tga")));
+			//pbrGun->getMeshes()[0].getMaterial().setMetallicMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_M.tga")));
+			//pbrGun->getMeshes()[0].getMaterial().setRoughnessMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_R.tga")));
+			//pbrGun->getMeshes()[0].getMaterial().setAmbientOcclusionMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Cerberus_Gun/Textures/Cerberus_AO.tga")));
+
+			//AssetHandle<Model> hyruleShield = AssetManager::loadModel("res/3D_Models/Hyrule_Shield/HShield.obj"); // Synchronous, its meshes are needed right away
+			//m_Models.push_back(hyruleShield);
+			//m_RenderableModels.push_back(new RenderableModel(glm::vec3(67.0f, 92.0f, 133.0f), glm::vec3(5.0f, 5.0f, 5.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(180.0f), hyruleShield.get(), nullptr, false, false));
+			//hyruleShield->getMeshes()[0].getMaterial().setAlbedoMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Albedo].tga"), &srgbTextureSettings));
+			//hyruleShield->getMeshes()[0].getMaterial().setNormalMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Normal].tga")));
+			//hyruleShield->getMeshes()[0].getMaterial().setMetallicMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Metallic].tga")));
+			//hyruleShield->getMeshes()[0].getMaterial().setRoughnessMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Roughness].tga")));
+			//hyruleShield->getMeshes()[0].getMaterial().setAmbientOcclusionMap(TextureLoader::load2DTexture(std::string("res/3D_Models/Hyrule_Shield/HShield_[Occlusion].tga")));
+		}
 
 		// Skybox
 		std::vector<std::string> skyboxFilePaths;
@@ -53,15 +86,42 @@ namespace arcane {
 		skyboxFilePaths.push_back("res/skybox/front.png");
 		m_Skybox = new Skybox(skyboxFilePaths);
 
-		m_SceneCamera.setPosition(glm::vec3(90.0f, 80.0f, 180.0f));
+		m_SceneCamera.setPosition(cameraPosition);
 	}
 
 	void Scene3D::onUpdate(float deltaTime) {
+		PROFILE_FUNCTION();
 		// Camera Update
 		m_SceneCamera.processInput(deltaTime);
 
 		m_DynamicLightManager.setSpotLightDirection(0, m_SceneCamera.getFront());
 		m_DynamicLightManager.setSpotLightPosition(0, m_SceneCamera.getPosition());
+
+		// Animations
+		for (StressSceneAnimation &animation : m_Animations) {
+			animation.Angle += animation.Speed * deltaTime;
+			animation.Renderable->setOrientation(animation.Angle, animation.Axis);
+		}
+
+		// Terrain streaming
+		m_Terrain.onUpdate(m_SceneCamera.getPosition());
+
+		// Texture streaming
+		requestTextureDetail();
+		TextureStreamer::update();
+	}
+
+	void Scene3D::requestTextureDetail() {
+		PROFILE_FUNCTION();
+		// Estimate how many pixels each model covers on screen, assuming its textures span the model once
+		float pixelsPerUnitAtUnitDistance = Window::getRenderResolutionHeight() / (2.0f * std::tan(glm::radians(m_SceneCamera.getFOV()) * 0.5f));
+		for (RenderableModel *renderable : m_RenderableModels) {
+			const glm::vec3 &scale = renderable->getScale();
+			float radius = renderable->getModel()->getBoundingRadius() * std::max(scale.x, std::max(scale.y, scale.z));
+			float distance = std::max(glm::length(renderable->getPosition() - m_SceneCamera.getPosition()) - radius, NEAR_PLANE);
+
+			renderable->getModel()->requestTextureDetail(2.0f * radius * pixelsPerUnitAtUnitDistance / distance);
+		}
 	}
 
 	void Scene3D::addModelsToRenderer() {
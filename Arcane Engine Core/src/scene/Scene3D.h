@@ -8,14 +8,16 @@
 #include <graphics/renderer/GLCache.h>
 #include <graphics/renderer/ModelRenderer.h>
 #include <scene/RenderableModel.h>
+#include <scene/StressSceneGenerator.h>
 #include <terrain/Terrain.h>
+#include <utils/loaders/AssetManager.h>
 #include <utils/loaders/TextureLoader.h>
 
 namespace arcane {
 	
 	class Scene3D {
 	public:
-		Scene3D(Window *window);
+		Scene3D(Window *window, const std::string &sceneName = "default"); // Scenes are "default", "sponza" and generated "stress" scenes (see StressSceneGenerator)
 		~Scene3D();
 
 		void onUpdate(float deltaTime);
@@ -33,8 +35,10 @@ namespace arcane {
 		inline ProbeManager* getProbeManager() { return &m_ProbeManager; }
 		inline FPSCamera* getCamera() { return &m_SceneCamera; }
 		inline Skybox* getSkybox() { return m_Skybox; }
+		inline const std::vector<glm::vec3>& getProbePositions() const { return m_ProbePositions; }
 	private:
-		void init();
+		void init(const std::string &sceneName);
+		void requestTextureDetail();
 	private:
 		// Global Data
 		GLCache *m_GLCache;
@@ -49,7 +53,10 @@ namespace arcane {
 		Terrain m_Terrain;
 		DynamicLightManager m_DynamicLightManager;
 		ProbeManager m_ProbeManager;
+		std::vector<AssetHandle<Model>> m_Models; // Keeps the models the renderables point to loaded
 		std::vector<RenderableModel*> m_RenderableModels;
+		std::vector<StressSceneAnimation> m_Animations;
+		std::vector<glm::vec3> m_ProbePositions; // Where the renderer generates light and reflection probes
 	};
 
 }
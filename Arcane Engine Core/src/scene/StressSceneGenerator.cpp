@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "StressSceneGenerator.h"
+
+#include <graphics/mesh/common/Cube.h>
+#include <graphics/mesh/common/Sphere.h>
+
+namespace arcane {
+
+	// Where the default scene's model sits, so the benchmark's default camera path also works for stress scenes
+	static const glm::vec3 s_SceneCentre(120.0f, 75.0f, 120.0f);
+	static const float s_SceneHeight = 40.0f;
+
+	// The standard distributions are implementation defined, so floats are made from mt19937's output directly to keep layouts identical across
+	// compilers. Draws are always sequenced in separate statements, argument evaluation order isn't specified either
+	class StressSceneRandom {
+	public:
+		StressSceneRandom(unsigned int seed) : m_Engine(seed) {}
+
+		inline float next() { return (m_Engine() >> 8) * (1.0f / 16777216.0f); } // [0, 1)
+		inline float range(float min, float max) { return min + (max - min) * next(); }
+		inline unsigned int index(unsigned int count) { return std::min((unsigned int)(next() * count), count - 1); }
+		inline glm::vec3 vector(float min, float max) {
+			float x = range(min, max);
+			float y = range(min, max);
+			float z = range(min, max);
+			return glm::vec3(x, y, z);
+		}
+		inline glm::vec3 direction() { return glm::normalize(vector(-1.0f, 1.0f) + glm::vec3(0.0f, 0.001f, 0.0f)); }
+	private:
+		std::mt19937 m_Engine;
+	};
+
+	bool StressSceneGenerator::isStressScene(const std::string &sceneName) {
+		return sceneName == "stress" || sceneName.compare(0, 7, "stress:") == 0;
+	}
+
+	void StressSceneGenerator::parseSettings(const std::string &sceneName, StressSceneSettings &outSettings) {
+		size_t position = sceneName.find(':');
+		while (position != std::string::npos) {
+			size_t end = sceneName.find(',', position + 1);
+			std::string setting = sceneName.substr(position + 1, end == std::string::npos ? std::string::npos : end - position - 1);
+			position = end;
+
+			size_t separator = setting.find('=');
+			std::string key = setting.substr(0, separator);
+			const char *value = separator == std::string::npos ? "" : setting.c_str() + separator + 1;
+			char *valueEnd = nullptr;
+			double number = strtod(value, &valueEnd);
+			if (*value == '\0' || *valueEnd != '\0' || number < 0.0) {
+				Logger::getInstance().warning("logged_files/scene.txt", "stress scene", "Skipping malformed setting: " + setting);
+				continue;
+			}
+
+			if (key == "seed") outSettings.Seed = (unsigned int)number;
+			else if (key == "renderables") outSettings.RenderableCount = (unsigned int)number;
+			else if (key == "models") outSettings.ModelCount = std::max((unsigned int)number, 1u);
+			else if (key == "static") outSettings.StaticFraction = std::min((float)number, 1.0f);
+			else if (key == "transparent") outSettings.TransparentFraction = std::min((float)number, 1.0f);
+			else if (key == "pointlights") outSettings.PointLightCount = (unsigned int)number;
+			else if (key == "spotlights") outSettings.SpotLightCount = (unsigned int)number;
+			else if (key == "probes") outSettings.ProbeCount = (unsigned int)number;
+			else if (key == "depth") outSettings.HierarchyDepth = std::max((unsigned int)number, 1u);
+			else if (key == "extent") outSettings.Extent = std::max((float)number, 1.0f);
+			else Logger::getInstance().warning("logged_files/scene.txt", "stress scene", "Skipping unknown setting: " + setting);
+		}
+	}
+
+	void StressSceneGenerator::generate(const StressSceneSettings &settings, StressScene &outScene) {
+		PROFILE_FUNCTION();
+		StressSceneRandom random(settings.Seed);
+		const glm::vec3 halfExtent(settings.Extent * 0.5f, s_SceneHeight * 0.5f, settings.Extent * 0.5f);
+		auto randomPosition = [&]() { return s_SceneCentre + random.vector(-1.0f, 1.0f) * halfExtent; };
+
+		// Alternating cubes and spheres of increasing tessellation, so the models cover a range of triangle counts
+		for (unsigned int i = 0; i < settings.ModelCount; ++i) {
+			int segments = 8 << (i / 2 % 4);
+			std::string key = "stress:model" + std::to_string(i);
+			outScene.Models.push_back(AssetManager::loadWith<Model>(key, [i, segments]() {
+				return i % 2 == 0 ? new Model(Cube()) : new Model(Sphere(segments, segments));
+			}));
+		}
+
+		// Renderables are made in chains of HierarchyDepth, each child placed relative to the one before it
+		glm::vec3 one(1.0f);
+		RenderableModel *parent = nullptr;
+		for (unsigned int i = 0; i < settings.RenderableCount; ++i) {
+			bool isRoot = i % settings.HierarchyDepth == 0;
+			if (isRoot)
+				parent = nullptr;
+
+			glm::vec3 position = isRoot ? randomPosition() : random.direction();
+			if (!isRoot)
+				position *= random.range(2.0f, 6.0f);
+			glm::vec3 scale = one * random.range(0.5f, 2.5f);
+			glm::vec3 axis = random.direction();
+			float angle = random.range(0.0f, glm::two_pi<float>());
+			Model *model = outScene.Models[random.index(settings.ModelCount)].get();
+			bool isStatic = random.next() < settings.StaticFraction;
+			bool isTransparent = random.next() < settings.TransparentFraction;
+
+			RenderableModel *renderable = new RenderableModel(position, scale, axis, angle, model, parent, isStatic, isTransparent);
+			outScene.Renderables.push_back(renderable);
+			if (!isStatic) {
+				StressSceneAnimation animation = { renderable, axis, angle, random.range(-2.0f, 2.0f) };
+				outScene.Animations.push_back(animation);
+			}
+			parent = renderable;
+		}
+
+		for (unsigned int i = 0; i < settings.PointLightCount; ++i) {
+			glm::vec3 colour = random.vector(0.0f, 1.0f);
+			glm::vec3 position = randomPosition();
+			float intensity = random.range(5.0f, 20.0f);
+			float radius = random.range(15.0f, 40.0f);
+			PointLight pointLight(intensity, colour, radius, position);
+			pointLight.setStatic(random.next() < settings.StaticFraction);
+			outScene.PointLights.push_back(pointLight);
+		}
+		for (unsigned int i = 0; i < settings.SpotLightCount; ++i) {
+			glm::vec3 colour = random.vector(0.0f, 1.0f);
+			glm::vec3 position = randomPosition();
+			glm::vec3 direction = random.vector(-0.5f, 0.5f);
+			direction = glm::normalize(glm::vec3(direction.x, -1.0f, direction.z)); // Pointing down into the scene
+			float intensity = random.range(20.0f, 80.0f);
+			float radius = random.range(30.0f, 60.0f);
+			float innerAngle = random.range(10.0f, 30.0f);
+			SpotLight spotLight(intensity, colour, radius, position, direction, glm::cos(glm::radians(innerAngle)), glm::cos(glm::radians(innerAngle + 5.0f)));
+			spotLight.setStatic(random.next() < settings.StaticFraction);
+			outScene.SpotLights.push_back(spotLight);
+		}
+
+		for (unsigned int i = 0; i < settings.ProbeCount; ++i) {
+			outScene.ProbePositions.push_back(randomPosition());
+		}
+
+		// Looking down -z across the scene from its near edge
+		outScene.CameraPosition = s_SceneCentre + glm::vec3(0.0f, s_SceneHeight * 0.5f, halfExtent.z + 20.0f);
+	}
+
+}
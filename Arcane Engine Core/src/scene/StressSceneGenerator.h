@@ -0,0 +1,55 @@
+#pragma once
+
+#include <graphics/lights/PointLight.h>
+#include <graphics/lights/SpotLight.h>
+#include <graphics/mesh/Model.h>
+#include <scene/RenderableModel.h>
+#include <utils/loaders/AssetManager.h>
+
+namespace arcane {
+
+	struct StressSceneSettings {
+		unsigned int Seed = STRESS_SCENE_SEED;
+		unsigned int RenderableCount = STRESS_SCENE_RENDERABLES;
+		unsigned int ModelCount = STRESS_SCENE_MODELS;
+		float StaticFraction = STRESS_SCENE_STATIC_FRACTION;
+		float TransparentFraction = STRESS_SCENE_TRANSPARENT_FRACTION;
+		unsigned int PointLightCount = STRESS_SCENE_POINT_LIGHTS;
+		unsigned int SpotLightCount = STRESS_SCENE_SPOT_LIGHTS;
+		unsigned int ProbeCount = STRESS_SCENE_PROBES;
+		unsigned int HierarchyDepth = STRESS_SCENE_HIERARCHY_DEPTH;
+		float Extent = STRESS_SCENE_EXTENT;
+	};
+
+	// A dynamic renderable spinning about its own axis
+	struct StressSceneAnimation {
+		RenderableModel *Renderable;
+		glm::vec3 Axis;
+		float Angle, Speed; // Radians, radians per second
+	};
+
+	struct StressScene {
+		std::vector<AssetHandle<Model>> Models;
+		std::vector<RenderableModel*> Renderables; // Parents come before their children
+		std::vector<StressSceneAnimation> Animations;
+		std::vector<PointLight> PointLights;
+		std::vector<SpotLight> SpotLights;
+		std::vector<glm::vec3> ProbePositions;
+		glm::vec3 CameraPosition;
+	};
+
+	// Builds synthetic scenes for measuring how the renderer scales with renderables, models, lights and probes. The same settings
+	// always produce the same layout, on every platform. Selected with scene names like
+	//   stress:renderables=5000,models=16,static=0.5,transparent=0.2,pointlights=64,spotlights=16,probes=4,depth=3,seed=7,extent=300
+	// where every key is optional and falls back to the STRESS_SCENE_* defaults
+	class StressSceneGenerator {
+	public:
+		static bool isStressScene(const std::string &sceneName);
+		// Unknown keys and malformed values are logged and skipped
+		static void parseSettings(const std::string &sceneName, StressSceneSettings &outSettings);
+
+		// Creates the models (on the GL thread) and lays out everything else around the default scene's centre
+		static void generate(const StressSceneSettings &settings, StressScene &outScene);
+	};
+
+}
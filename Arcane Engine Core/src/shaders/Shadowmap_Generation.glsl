@@ -1,13 +1,15 @@
 #shader-type vertex
 #version 430 core
 
-layout (location = 0) in vec3 position;
+layout (location = 0) in vec3 position; // Compact meshes store it normalized against the mesh bounds
 
 uniform mat4 lightSpaceViewProjectionMatrix;
 uniform mat4 model;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
 
 void main() {
-	gl_Position = lightSpaceViewProjectionMatrix * model * vec4(position, 1.0f);
+	gl_Position = lightSpaceViewProjectionMatrix * model * vec4(position * positionScale + positionOffset, 1.0f);
 }
 
 
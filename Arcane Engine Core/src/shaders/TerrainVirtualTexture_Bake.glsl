@@ -0,0 +1,83 @@
+/*
+	Bakes the terrain's splatted material for one page of a clipmap level, the geometry pass then samples the result instead of splatting per pixel
+*/
+
+#shader-type vertex
+#version 430 core
+
+layout (location = 0) in vec3 position;
+layout (location = 2) in vec2 texCoord;
+
+out vec2 TexCoords;
+
+void main() {
+	gl_Position = vec4(position, 1.0);
+	TexCoords = texCoord;
+}
+
+
+
+
+#shader-type fragment
+#version 430 core
+
+layout (location = 0) out vec4 vt_Albedo;
+layout (location = 1) out vec4 vt_Normal;
+layout (location = 2) out vec4 vt_MaterialInfo;
+
+struct Material {
+	sampler2DArray albedoArray; // layer 0 is the background texture, layers 1-3 are driven by the blend map's rgb
+	sampler2DArray normalArray;
+	sampler2DArray materialInfoArray; // roughness (r), metallic (g), AO (b)
+
+	sampler2D blendmap;
+	float tilingAmount;
+};
+
+#define TERRAIN_LAYER_COUNT 4
+
+in vec2 TexCoords;
+
+uniform Material material;
+uniform vec2 terrainSize;
+uniform vec2 pageWorldOrigin;
+uniform float pageWorldSize;
+uniform float texelWorldSize;
+
+// Functions
+vec3 UnpackNormal(vec3 textureNormal);
+
+void main() {
+	vec2 terrainCoords = (pageWorldOrigin + TexCoords * pageWorldSize) / terrainSize;
+
+	vec4 blendMapColour = texture(material.blendmap, terrainCoords);
+	vec4 layerWeights = vec4(1 - (blendMapColour.r + blendMapColour.g + blendMapColour.b), blendMapColour.rgb);
+	vec2 tiledCoords = terrainCoords * material.tilingAmount;
+
+	// Filter for the footprint of a clipmap texel, not the footprint of a pixel in this bake
+	vec2 tiledCoordsDx = vec2(texelWorldSize / terrainSize.x * material.tilingAmount, 0.0);
+	vec2 tiledCoordsDy = vec2(0.0, texelWorldSize / terrainSize.y * material.tilingAmount);
+
+	vec3 albedo = vec3(0.0);
+	vec3 normal = vec3(0.0);
+	vec3 materialInfo = vec3(0.0);
+	for (int layer = 0; layer < TERRAIN_LAYER_COUNT; ++layer) {
+		float layerWeight = layerWeights[layer];
+		if (layerWeight <= 0.0)
+			continue;
+
+		vec3 layerCoords = vec3(tiledCoords, layer);
+		albedo += textureGrad(material.albedoArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb * layerWeight;
+		normal += UnpackNormal(textureGrad(material.normalArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb) * layerWeight;
+		materialInfo = max(materialInfo, textureGrad(material.materialInfoArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb * layerWeight);
+	}
+
+	vt_Albedo = vec4(albedo, 1.0);
+	vt_Normal = vec4(normalize(normal) * 0.5 + 0.5, 1.0);
+	vt_MaterialInfo = vec4(materialInfo, 1.0);
+}
+
+// Unpacks the normal from the texture and returns the normal in tangent space
+vec3 UnpackNormal(vec3 textureNormal) {
+	return normalize(textureNormal * 2.0 - 1.0);
+}
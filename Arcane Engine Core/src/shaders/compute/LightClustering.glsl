@@ -0,0 +1,145 @@
+#shader-type compute
+#version 430 core
+
+// One invocation per cluster. Lights are brought into shared memory a batch at a time, each invocation loading one of them. The lights are
+// gone through twice, first counting the ones reaching the cluster so it can reserve its space in the index list, then writing them into it
+layout (local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+struct PointLight {
+	vec3 position;
+	float intensity;
+	vec3 lightColour;
+	float attenuationRadius;
+};
+
+struct SpotLight {
+	vec3 position;
+	float intensity;
+	vec3 direction;
+	float attenuationRadius;
+	vec3 lightColour;
+	float cutOff;
+	float outerCutOff;
+};
+
+#define MAX_LIGHTS_PER_CLUSTER 256
+#define BATCH_SIZE 64
+
+layout (std430, binding = 0) readonly buffer PointLightBuffer { PointLight pointLights[]; };
+layout (std430, binding = 1) readonly buffer SpotLightBuffer { SpotLight spotLights[]; };
+layout (std430, binding = 2) writeonly buffer LightClusterBuffer { uvec2 lightClusters[]; }; // Index list offset, point light count | spot light count << 16
+layout (std430, binding = 3) writeonly buffer LightIndexBuffer { uint lightIndices[]; };
+layout (std430, binding = 4) buffer LightIndexCounter { uint lightIndexCount; };
+
+uniform mat4 view;
+uniform mat4 projectionInverse;
+uniform ivec3 clusterGridSize;
+uniform float nearPlane;
+uniform float farPlane;
+uniform int numPointLights;
+uniform int numSpotLights;
+uniform int maxLightIndices;
+
+shared vec4 batchSpheres[BATCH_SIZE]; // View space position, radius in w
+
+bool SphereIntersectsBounds(vec4 sphere, vec3 boundsMin, vec3 boundsMax) {
+	vec3 closestPoint = clamp(sphere.xyz, boundsMin, boundsMax);
+	vec3 offset = closestPoint - sphere.xyz;
+	return dot(offset, offset) <= sphere.w * sphere.w;
+}
+
+void main() {
+	int clusterCount = clusterGridSize.x * clusterGridSize.y * clusterGridSize.z;
+	int clusterIndex = int(gl_GlobalInvocationID.x);
+	bool validCluster = clusterIndex < clusterCount; // Invocations past the grid still help load the batches
+
+	// View space bounds of the cluster, the rays through the tile's corners pushed out to the slice's near and far depth
+	ivec3 cluster = ivec3(clusterIndex % clusterGridSize.x, (clusterIndex / clusterGridSize.x) % clusterGridSize.y, clusterIndex / (clusterGridSize.x * clusterGridSize.y));
+	float sliceNear = nearPlane * pow(farPlane / nearPlane, float(cluster.z) / clusterGridSize.z);
+	float sliceFar = nearPlane * pow(farPlane / nearPlane, float(cluster.z + 1) / clusterGridSize.z);
+	vec3 boundsMin = vec3(1e30);
+	vec3 boundsMax = vec3(-1e30);
+	for (int corner = 0; corner < 4; ++corner) {
+		vec2 ndc = vec2(cluster.xy + ivec2(corner & 1, corner >> 1)) * 2.0 / vec2(clusterGridSize.xy) - 1.0;
+		vec4 nearPoint = projectionInverse * vec4(ndc, -1.0, 1.0);
+		vec3 ray = nearPoint.xyz / nearPoint.w;
+		ray /= -ray.z;
+
+		boundsMin = min(boundsMin, min(ray * sliceNear, ray * sliceFar));
+		boundsMax = max(boundsMax, max(ray * sliceNear, ray * sliceFar));
+	}
+
+	uint pointLightCount = 0;
+	for (int batch = 0; batch < numPointLights; batch += BATCH_SIZE) {
+		int lightIndex = batch + int(gl_LocalInvocationIndex);
+		if (lightIndex < numPointLights)
+			batchSpheres[gl_LocalInvocationIndex] = vec4((view * vec4(pointLights[lightIndex].position, 1.0)).xyz, pointLights[lightIndex].attenuationRadius);
+		barrier();
+
+		int batchSize = min(BATCH_SIZE, numPointLights - batch);
+		for (int i = 0; i < batchSize && validCluster && pointLightCount < MAX_LIGHTS_PER_CLUSTER; ++i) {
+			if (SphereIntersectsBounds(batchSpheres[i], boundsMin, boundsMax))
+				pointLightCount++;
+		}
+		barrier();
+	}
+
+	// Spot lights are culled with the sphere bounding their whole range, it is conservative for narrow cones
+	uint spotLightCount = 0;
+	for (int batch = 0; batch < numSpotLights; batch += BATCH_SIZE) {
+		int lightIndex = batch + int(gl_LocalInvocationIndex);
+		if (lightIndex < numSpotLights)
+			batchSpheres[gl_LocalInvocationIndex] = vec4((view * vec4(spotLights[lightIndex].position, 1.0)).xyz, spotLights[lightIndex].attenuationRadius);
+		barrier();
+
+		int batchSize = min(BATCH_SIZE, numSpotLights - batch);
+		for (int i = 0; i < batchSize && validCluster && pointLightCount + spotLightCount < MAX_LIGHTS_PER_CLUSTER; ++i) {
+			if (SphereIntersectsBounds(batchSpheres[i], boundsMin, boundsMax))
+				spotLightCount++;
+		}
+		barrier();
+	}
+
+	// Reserve space in the shared index list. The count keeps growing past the end so the CPU can size the list to fit, a cluster that
+	// doesn't fit loses its lights rather than overwriting another's
+	uint lightCount = pointLightCount + spotLightCount;
+	uint offset = 0;
+	bool fits = false;
+	if (validCluster) {
+		offset = atomicAdd(lightIndexCount, lightCount);
+		fits = offset + lightCount <= uint(maxLightIndices);
+		lightClusters[clusterIndex] = fits ? uvec2(offset, pointLightCount | (spotLightCount << 16)) : uvec2(0, 0);
+	}
+
+	// Same walk through the lights, this time writing the ones found straight into the reserved space. Every invocation keeps loading
+	// the batches, the barriers have to be reached by the whole group
+	uint pointLightsWritten = 0;
+	for (int batch = 0; batch < numPointLights; batch += BATCH_SIZE) {
+		int lightIndex = batch + int(gl_LocalInvocationIndex);
+		if (lightIndex < numPointLights)
+			batchSpheres[gl_LocalInvocationIndex] = vec4((view * vec4(pointLights[lightIndex].position, 1.0)).xyz, pointLights[lightIndex].attenuationRadius);
+		barrier();
+
+		int batchSize = min(BATCH_SIZE, numPointLights - batch);
+		for (int i = 0; i < batchSize && fits && pointLightsWritten < pointLightCount; ++i) {
+			if (SphereIntersectsBounds(batchSpheres[i], boundsMin, boundsMax))
+				lightIndices[offset + pointLightsWritten++] = uint(batch + i);
+		}
+		barrier();
+	}
+
+	uint spotLightsWritten = 0;
+	for (int batch = 0; batch < numSpotLights; batch += BATCH_SIZE) {
+		int lightIndex = batch + int(gl_LocalInvocationIndex);
+		if (lightIndex < numSpotLights)
+			batchSpheres[gl_LocalInvocationIndex] = vec4((view * vec4(spotLights[lightIndex].position, 1.0)).xyz, spotLights[lightIndex].attenuationRadius);
+		barrier();
+
+		int batchSize = min(BATCH_SIZE, numSpotLights - batch);
+		for (int i = 0; i < batchSize && fits && spotLightsWritten < spotLightCount; ++i) {
+			if (SphereIntersectsBounds(batchSpheres[i], boundsMin, boundsMax))
+				lightIndices[offset + pointLightCount + spotLightsWritten++] = uint(batch + i);
+		}
+		barrier();
+	}
+}
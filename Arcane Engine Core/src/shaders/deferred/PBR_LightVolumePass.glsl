@@ -0,0 +1,237 @@
+#shader-type vertex
+#version 430 core
+
+// Point and spot lights are read from shader storage, laid out std430 to match PointLightData and SpotLightData
+struct PointLight {
+	vec3 position;
+	float intensity;
+	vec3 lightColour;
+	float attenuationRadius;
+};
+
+struct SpotLight {
+	vec3 position;
+	float intensity;
+	vec3 direction;
+	float attenuationRadius;
+	vec3 lightColour;
+	float cutOff;
+	float outerCutOff;
+};
+
+layout (location = 0) in vec3 position;
+
+layout (std430, binding = 0) readonly buffer PointLightBuffer { PointLight pointLights[]; };
+layout (std430, binding = 1) readonly buffer SpotLightBuffer { SpotLight spotLights[]; };
+
+flat out int LightIndex;
+
+uniform bool spotLightVolumes; // Cones for spot lights, otherwise spheres for point lights
+uniform float volumeScale; // Pushes the tessellated volume out so it fully contains the light's range
+uniform mat4 viewProjection;
+
+void main() {
+	LightIndex = gl_InstanceID;
+
+	vec3 worldPos;
+	if (spotLightVolumes) {
+		// The cone reaches the attenuation radius along the light's direction, and opens up to its outer cutoff
+		SpotLight light = spotLights[gl_InstanceID];
+		float outerCutOff = max(light.outerCutOff, 0.01); // Cones can only bound spot lights narrower than 180 degrees
+		float baseRadius = light.attenuationRadius * sqrt(1.0 - outerCutOff * outerCutOff) / outerCutOff;
+
+		vec3 forward = normalize(light.direction);
+		vec3 up = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+		vec3 right = normalize(cross(up, forward));
+		up = cross(forward, right);
+		worldPos = light.position + (right * position.x + up * position.y) * baseRadius * volumeScale + forward * position.z * light.attenuationRadius;
+	}
+	else {
+		PointLight light = pointLights[gl_InstanceID];
+		worldPos = light.position + position * light.attenuationRadius * volumeScale;
+	}
+
+	gl_Position = viewProjection * vec4(worldPos, 1.0);
+}
+
+
+
+
+#shader-type fragment
+#version 430 core
+
+// Point and spot lights are read from shader storage, laid out std430 to match PointLightData and SpotLightData
+struct PointLight {
+	vec3 position;
+	float intensity;
+	vec3 lightColour;
+	float attenuationRadius;
+};
+
+struct SpotLight {
+	vec3 position;
+	float intensity;
+	vec3 direction;
+	float attenuationRadius;
+	vec3 lightColour;
+	float cutOff;
+	float outerCutOff;
+};
+
+const float PI = 3.14159265359;
+
+flat in int LightIndex;
+
+out vec4 color;
+
+// GBuffer
+uniform sampler2D albedoTexture;
+uniform sampler2D normalTexture;
+uniform sampler2D materialInfoTexture;
+uniform sampler2D depthTexture;
+
+// Lighting
+layout (std430, binding = 0) readonly buffer PointLightBuffer { PointLight pointLights[]; };
+layout (std430, binding = 1) readonly buffer SpotLightBuffer { SpotLight spotLights[]; };
+uniform bool spotLightVolumes;
+
+uniform vec2 screenSize;
+uniform vec3 viewPos;
+uniform mat4 viewInverse;
+uniform mat4 projectionInverse;
+
+// Cook-Torrance BRDF functions adopted by Epic for UE4
+float NormalDistributionGGX(vec3 normal, vec3 halfway, float roughness);
+float GeometrySmith(vec3 normal, vec3 viewDir, vec3 lightDir, float roughness);
+float GeometrySchlickGGX(float cosTheta, float roughness);
+vec3 FresnelSchlick(float cosTheta, vec3 baseReflectivity);
+
+// Other function prototypes
+vec3 WorldPosFromDepth(vec2 texCoords);
+
+void main() {
+	vec2 texCoords = gl_FragCoord.xy / screenSize;
+
+	// Light setup, both light types fall off to nothing at their attenuation radius
+	vec3 lightPosition, lightColour;
+	float lightIntensity, attenuationRadius;
+	if (spotLightVolumes) {
+		lightPosition = spotLights[LightIndex].position;
+		lightColour = spotLights[LightIndex].lightColour;
+		lightIntensity = spotLights[LightIndex].intensity;
+		attenuationRadius = spotLights[LightIndex].attenuationRadius;
+	}
+	else {
+		lightPosition = pointLights[LightIndex].position;
+		lightColour = pointLights[LightIndex].lightColour;
+		lightIntensity = pointLights[LightIndex].intensity;
+		attenuationRadius = pointLights[LightIndex].attenuationRadius;
+	}
+
+	// The depth test only rejects surfaces behind the volume, surfaces in front of it are rejected here before any shading
+	vec3 fragPos = WorldPosFromDepth(texCoords);
+	float fragToLightDistance = length(lightPosition - fragPos);
+	if (fragToLightDistance >= attenuationRadius)
+		discard;
+
+	// Sample textures
+	vec3 albedo = texture(albedoTexture, texCoords).rgb;
+	vec3 normal = texture(normalTexture, texCoords).rgb;
+	float metallic = texture(materialInfoTexture, texCoords).r;
+	float roughness = max(texture(materialInfoTexture, texCoords).g, 0.04); // Specular highlights will be too fine otherwise, and will cause flicker
+
+	vec3 fragToView = normalize(viewPos - fragPos);
+	vec3 fragToLight = normalize(lightPosition - fragPos);
+	vec3 halfway = normalize(fragToView + fragToLight);
+
+	// Dielectrics have an average base specular reflectivity around 0.04, and metals absorb all of their diffuse (refraction) lighting so their albedo is used instead for their specular lighting (reflection)
+	vec3 baseReflectivity = vec3(0.04);
+	baseReflectivity = mix(baseReflectivity, albedo, metallic);
+
+	// Attenuation calculation (based on Epic's UE4 falloff model)
+	float d = fragToLightDistance / attenuationRadius;
+	float d2 = d * d;
+	float d4 = d2 * d2;
+	float falloffNumerator = clamp(1.0 - d4, 0.0, 1.0);
+	float attenuation = (falloffNumerator * falloffNumerator) / ((fragToLightDistance * fragToLightDistance) + 1.0);
+
+	// Check if it is in the spotlight's circle
+	if (spotLightVolumes) {
+		float theta = dot(normalize(spotLights[LightIndex].direction), -fragToLight);
+		float difference = spotLights[LightIndex].cutOff - spotLights[LightIndex].outerCutOff;
+		attenuation *= clamp((theta - spotLights[LightIndex].outerCutOff) / difference, 0.0, 1.0);
+	}
+	vec3 radiance = lightIntensity * lightColour * attenuation;
+
+	// Cook-Torrance Specular BRDF calculations
+	float normalDistribution = NormalDistributionGGX(normal, halfway, roughness);
+	vec3 fresnel = FresnelSchlick(max(dot(halfway, fragToView), 0.0), baseReflectivity);
+	float geometry = GeometrySmith(normal, fragToView, fragToLight, roughness);
+
+	// Calculate reflected and refracted light respectively, and since metals absorb all refracted light, we nullify the diffuse lighting based on the metallic parameter
+	vec3 specularRatio = fresnel;
+	vec3 diffuseRatio = vec3(1.0) - specularRatio;
+	diffuseRatio *= 1.0 - metallic;
+
+	// Finally calculate the specular part of the Cook-Torrance BRDF (max 0.1 stops any visual artifacts)
+	vec3 numerator = specularRatio * normalDistribution * geometry;
+	float denominator = 4 * max(dot(fragToView, normal), 0.1) * max(dot(fragToLight, normal), 0.0) + 0.001; // Prevents any division by zero
+	vec3 specular = numerator / denominator;
+
+	// Also calculate the diffuse, a lambertian calculation will be added onto the final radiance calculation
+	vec3 diffuse = diffuseRatio * albedo / PI;
+
+	// Added onto the lighting pass' output by blending, alpha is left alone
+	color = vec4((diffuse + specular) * radiance * max(dot(normal, fragToLight), 0.0), 0.0);
+}
+
+
+// Approximates the amount of microfacets that are properly aligned with the halfway vector, thus determines the strength and area for specular light
+float NormalDistributionGGX(vec3 normal, vec3 halfway, float roughness) {
+	float a = roughness * roughness;
+	float a2 = a * a;
+	float normDotHalf = dot(normal, halfway);
+	float normDotHalf2 = normDotHalf * normDotHalf;
+
+	float numerator = a2;
+	float denominator = normDotHalf2 * (a2 - 1.0) + 1.0;
+	denominator = PI * denominator * denominator;
+
+	return numerator / denominator;
+}
+
+
+// Approximates the geometry obstruction and geometry shadowing respectively, on the microfacet level
+float GeometrySmith(vec3 normal, vec3 viewDir, vec3 lightDir, float roughness) {
+	return GeometrySchlickGGX(max(dot(normal, viewDir), 0.0), roughness) * GeometrySchlickGGX(max(dot(normal, lightDir), 0.0), roughness);
+}
+float GeometrySchlickGGX(float cosTheta, float roughness) {
+	float r = (roughness + 1.0);
+	float k = (roughness * roughness) / 8.0;
+
+	float numerator = cosTheta;
+	float denominator = cosTheta * (1.0 - k) + k;
+
+	return numerator / max(denominator, 0.001);
+}
+
+
+// Calculates the amount of specular light. Since diffuse(refraction) and specular(reflection) are mutually exclusive,
+// we can also use this to determine the amount of diffuse light
+// Taken from UE4's implementation which is faster and basically identical to the usual Fresnel calculations: https://blog.selfshadow.com/publications/s2013-shading-course/karis/s2013_pbs_epic_notes_v2.pdf
+vec3 FresnelSchlick(float cosTheta, vec3 baseReflectivity) {
+	return max(baseReflectivity + (1.0 - baseReflectivity) * pow(2, (-5.55473 * cosTheta - 6.98316) * cosTheta), 0.0);
+}
+
+
+vec3 WorldPosFromDepth(vec2 texCoords) {
+	float z = 2.0 * texture(depthTexture, texCoords).r - 1.0; // [-1, 1]
+	vec4 clipSpacePos = vec4(texCoords * 2.0 - 1.0 , z, 1.0);
+	vec4 viewSpacePos = projectionInverse * clipSpacePos;
+
+	viewSpacePos /= viewSpacePos.w; // Perspective division
+
+	vec4 worldSpacePos = viewInverse * viewSpacePos;
+
+	return worldSpacePos.xyz;
+}
@@ -17,6 +17,7 @@ void main() {
 #shader-type fragment
 #version 430 core
 
+// Lights are read from shader storage, laid out std430 to match DirectionalLightData, PointLightData and SpotLightData
 struct DirLight {
 	vec3 direction;
 
@@ -26,7 +27,6 @@ struct DirLight {
 
 struct PointLight {
 	vec3 position;
-
 	float intensity;
 	vec3 lightColour;
 	float attenuationRadius;
@@ -34,19 +34,14 @@ struct PointLight {
 
 struct SpotLight {
 	vec3 position;
-	vec3 direction;
-
 	float intensity;
-	vec3 lightColour;
+	vec3 direction;
 	float attenuationRadius;
-
+	vec3 lightColour;
 	float cutOff;
 	float outerCutOff;
 };
 
-#define MAX_DIR_LIGHTS 5
-#define MAX_POINT_LIGHTS 5
-#define MAX_SPOT_LIGHTS 5
 const float PI = 3.14159265359;
 
 in vec2 TexCoords;
@@ -69,20 +64,28 @@ uniform sampler2D brdfLUT;
 
 // Lighting
 uniform sampler2D shadowmap;
-uniform ivec4 numDirPointSpotLights;
-uniform DirLight dirLights[MAX_DIR_LIGHTS];
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
+layout (std430, binding = 5) readonly buffer DirectionalLightBuffer { ivec4 numDirPointSpotLights; DirLight dirLights[]; };
+layout (std430, binding = 0) readonly buffer PointLightBuffer { PointLight pointLights[]; };
+layout (std430, binding = 1) readonly buffer SpotLightBuffer { SpotLight spotLights[]; };
+
+// Clustered lighting, each view space cluster lists the point and spot lights that reach it
+layout (std430, binding = 2) readonly buffer LightClusterBuffer { uvec2 lightClusters[]; }; // Index list offset, point light count | spot light count << 16
+layout (std430, binding = 3) readonly buffer LightIndexBuffer { uint lightIndices[]; };
+uniform ivec3 clusterGridSize;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterSliceScaleBias;
+uniform bool computeLocalLights; // Point and spot lights, off when they are drawn as light volumes instead
 
 uniform vec3 viewPos;
+uniform mat4 view;
 uniform mat4 viewInverse;
 uniform mat4 projectionInverse;
 uniform mat4 lightSpaceViewProjectionMatrix;
 
 // Light radiance calculations
 vec3 CalculateDirectionalLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragPos, vec3 fragToView, vec3 baseReflectivity);
-vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragPos, vec3 fragToView, vec3 baseReflectivity);
-vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragPos, vec3 fragToView, vec3 baseReflectivity);
+vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragPos, vec3 fragToView, vec3 baseReflectivity, uvec3 lightCluster);
+vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragPos, vec3 fragToView, vec3 baseReflectivity, uvec3 lightCluster);
 
 // Cook-Torrance BRDF functions adopted by Epic for UE4
 float NormalDistributionGGX(vec3 normal, vec3 halfway, float roughness);
@@ -91,6 +94,7 @@ float GeometrySchlickGGX(float cosTheta, float roughness);
 vec3 FresnelSchlick(float cosTheta, vec3 baseReflectivity);
 
 // Other function prototypes
+uvec3 FindLightCluster(float viewDepth);
 float CalculateShadow(vec3 fragPos, vec3 normal, vec3 fragToLight);
 vec3 WorldPosFromDepth();
 
@@ -119,8 +123,11 @@ void main() {
 	// Calculate per light radiance for all of the direct lighting
 	vec3 directLightIrradiance = vec3(0.0);
 	directLightIrradiance += CalculateDirectionalLightRadiance(albedo, normal, metallic, roughness, fragPos, fragToView, baseReflectivity);
-	directLightIrradiance += CalculatePointLightRadiance(albedo, normal, metallic, roughness, fragPos, fragToView, baseReflectivity);
-	directLightIrradiance += CalculateSpotLightRadiance(albedo, normal, metallic, roughness, fragPos, fragToView, baseReflectivity);
+	if (computeLocalLights) {
+		uvec3 lightCluster = FindLightCluster(-(view * vec4(fragPos, 1.0)).z);
+		directLightIrradiance += CalculatePointLightRadiance(albedo, normal, metallic, roughness, fragPos, fragToView, baseReflectivity, lightCluster);
+		directLightIrradiance += CalculateSpotLightRadiance(albedo, normal, metallic, roughness, fragPos, fragToView, baseReflectivity, lightCluster);
+	}
 
 	// Calcualte ambient IBL for both diffuse and specular
 	vec3 ambient = vec3(0.05) * albedo * ao;
@@ -176,10 +183,11 @@ vec3 CalculateDirectionalLightRadiance(vec3 albedo, vec3 normal, float metallic,
 }
 
 
-vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragPos, vec3 fragToView, vec3 baseReflectivity) {
+vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragPos, vec3 fragToView, vec3 baseReflectivity, uvec3 lightCluster) {
 	vec3 pointLightIrradiance = vec3(0.0);
 
-	for (int i = 0; i < numDirPointSpotLights.y; ++i) {
+	for (uint j = 0u; j < lightCluster.y; ++j) {
+		uint i = lightIndices[lightCluster.x + j];
 		vec3 fragToLight = normalize(pointLights[i].position - fragPos);
 		vec3 halfway = normalize(fragToView + fragToLight);
 		float fragToLightDistance = length(pointLights[i].position - fragPos);
@@ -218,10 +226,11 @@ vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float
 }
 
 
-vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness,  vec3 fragPos, vec3 fragToView, vec3 baseReflectivity) {
+vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness,  vec3 fragPos, vec3 fragToView, vec3 baseReflectivity, uvec3 lightCluster) {
 	vec3 spotLightIrradiance = vec3(0.0);
 
-	for (int i = 0; i < numDirPointSpotLights.z; ++i) {
+	for (uint j = 0u; j < lightCluster.z; ++j) {
+		uint i = lightIndices[lightCluster.x + lightCluster.y + j];
 		vec3 fragToLight = normalize(spotLights[i].position - fragPos);
 		vec3 halfway = normalize(fragToView + fragToLight);
 		float fragToLightDistance = length(spotLights[i].position - fragPos);
@@ -340,3 +349,11 @@ vec3 WorldPosFromDepth() {
 
 	return worldSpacePos.xyz;
 }
+
+// Returns the cluster's offset into the light index list, and its point and spot light counts
+uvec3 FindLightCluster(float viewDepth) {
+	int slice = clamp(int(log(viewDepth) * clusterSliceScaleBias.x + clusterSliceScaleBias.y), 0, clusterGridSize.z - 1);
+	ivec2 tile = min(ivec2(gl_FragCoord.xy / clusterTileSize), clusterGridSize.xy - 1);
+	uvec2 cluster = lightClusters[(slice * clusterGridSize.y + tile.y) * clusterGridSize.x + tile.x];
+	return uvec3(cluster.x, cluster.y & 0xFFFFu, cluster.y >> 16u);
+}
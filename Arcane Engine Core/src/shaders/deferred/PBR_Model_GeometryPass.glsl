@@ -1,7 +1,9 @@
 #shader-type vertex
 #version 430 core
 
-layout (location = 0) in vec3 position;
+// Full precision meshes leave position.w at its default of 1. Compact meshes store positions normalized against the mesh bounds
+// with the bitangent's handedness in w, and store normals + tangents octahedral encoded in xy (no bitangent attribute)
+layout (location = 0) in vec4 position;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 texCoords;
 layout (location = 3) in vec3 tangent;
@@ -15,20 +17,43 @@ out vec3 ViewPosTangentSpace;
 uniform bool hasDisplacement;
 uniform vec3 viewPos;
 
+uniform bool compactVertexFormat;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
 uniform mat3 normalMatrix;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+vec3 OctahedralDecode(vec2 encoded) {
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
 void main() {
+	// Decode the mesh's vertex format
+	vec3 localPosition = position.xyz * positionScale + positionOffset;
+	vec3 localNormal = normal;
+	vec3 localTangent = tangent;
+	vec3 localBitangent = bitangent;
+	if (compactVertexFormat) {
+		localNormal = OctahedralDecode(normal.xy);
+		localTangent = OctahedralDecode(tangent.xy);
+		localBitangent = cross(localNormal, localTangent) * (position.w * 2.0 - 1.0);
+	}
+
 	// Use the normal matrix to maintain the orthogonal property of a vector when it is scaled non-uniformly
-	vec3 T = normalize(normalMatrix * tangent);
-	vec3 B = normalize(normalMatrix * bitangent);
-	vec3 N = normalize(normalMatrix * normal);
+	vec3 T = normalize(normalMatrix * localTangent);
+	vec3 B = normalize(normalMatrix * localBitangent);
+	vec3 N = normalize(normalMatrix * localNormal);
 	TBN = mat3(T, B, N);
 
 	TexCoords = texCoords;
-	vec3 fragPos = vec3(model * vec4(position, 1.0f));
+	vec3 fragPos = vec3(model * vec4(localPosition, 1.0f));
 	if (hasDisplacement) {
 		mat3 inverseTBN = transpose(TBN); // Calculate matrix to go from world -> tangent (orthogonal matrix's transpose = inverse)
 		FragPosTangentSpace = inverseTBN * fragPos;
@@ -96,8 +121,10 @@ void main() {
 }
 
 // Unpacks the normal from the texture and returns the normal in tangent space
+// Only x and y are read since cooked normal maps are two channel (BC5), z is always positive in tangent space so it can be reconstructed
 vec3 UnpackNormal(vec3 textureNormal) {
-	return normalize(textureNormal * 2.0 - 1.0);
+	vec2 normalXY = textureNormal.xy * 2.0 - 1.0;
+	return vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
 }
 
 vec2 ParallaxMapping(vec2 texCoords, vec3 viewDirTangentSpace) {
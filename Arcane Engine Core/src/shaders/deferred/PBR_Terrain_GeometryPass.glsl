@@ -39,78 +39,76 @@ layout (location = 2) out vec4 gb_MaterialInfo;
 
 // Does AMD support sampler2D in a struct?
 struct Material {
-	sampler2D texture_albedo1; // background texture
-	sampler2D texture_albedo2; // r texture
-	sampler2D texture_albedo3; // g texture
-	sampler2D texture_albedo4; // b texture
-
-	sampler2D texture_normal1; // background texture
-	sampler2D texture_normal2; // r texture
-	sampler2D texture_normal3; // g texture
-	sampler2D texture_normal4; // b texture
-
-	sampler2D texture_roughness1; // background texture
-	sampler2D texture_roughness2; // r texture
-	sampler2D texture_roughness3; // g texture
-	sampler2D texture_roughness4; // b texture
-
-	sampler2D texture_metallic1; // background texture
-	sampler2D texture_metallic2; // r texture
-	sampler2D texture_metallic3; // g texture
-	sampler2D texture_metallic4; // b texture
-
-	sampler2D texture_AO1; // background texture
-	sampler2D texture_AO2; // r texture
-	sampler2D texture_AO3; // g texture
-	sampler2D texture_AO4; // b texture
+	sampler2DArray albedoArray; // layer 0 is the background texture, layers 1-3 are driven by the blend map's rgb
+	sampler2DArray normalArray;
+	sampler2DArray materialInfoArray; // roughness (r), metallic (g), AO (b)
 
 	sampler2D blendmap;
 	float tilingAmount;
 };
 
+#define TERRAIN_LAYER_COUNT 4
+#define TERRAIN_VIRTUAL_TEXTURE_LEVELS 4 // Needs to match Defs.h
+
+// Baked splat results around the camera, see TerrainVirtualTexture
+struct VirtualTexture {
+	sampler2DArray albedo; // One layer per clipmap level
+	sampler2DArray normal;
+	sampler2DArray materialInfo;
+	isampler2DArray pageTable; // World page currently held by each slot
+
+	ivec2 levelOrigins[TERRAIN_VIRTUAL_TEXTURE_LEVELS]; // First page of each level's window
+	int pagesPerSide;
+	int pageSize;
+	float texelWorldSize; // Of the finest level
+};
+
 in mat3 TBN;
 in vec2 TexCoords;
 
 uniform Material material;
+uniform VirtualTexture virtualTexture;
+uniform vec2 terrainSize;
 
 // Functions
+bool SampleVirtualTexture(vec2 localPosXZ, float pixelFootprint, out vec3 albedo, out vec3 normal, out vec3 materialInfo);
 vec3 UnpackNormal(vec3 textureNormal);
 
 void main() {
-	vec4 blendMapColour = texture(material.blendmap, TexCoords);
-	float backTextureWeight = 1 - (blendMapColour.r + blendMapColour.g + blendMapColour.b);
 	vec2 tiledCoords = TexCoords * material.tilingAmount;
 
-	vec3 backgroundTextureAlbedo = texture(material.texture_albedo1, tiledCoords).rgb * backTextureWeight;
-	vec3 rTextureAlbedo = texture(material.texture_albedo2, tiledCoords).rgb * blendMapColour.r;
-	vec3 gTextureAlbedo = texture(material.texture_albedo3, tiledCoords).rgb * blendMapColour.g;
-	vec3 bTextureAlbedo = texture(material.texture_albedo4, tiledCoords).rgb * blendMapColour.b;
-	vec3 albedo = backgroundTextureAlbedo + rTextureAlbedo + gTextureAlbedo + bTextureAlbedo;
-
-	vec3 backgroundTextureNormal = UnpackNormal(texture(material.texture_normal1, tiledCoords).rgb) * backTextureWeight;
-	vec3 rTextureNormal = UnpackNormal(texture(material.texture_normal2, tiledCoords).rgb) * blendMapColour.r;
-	vec3 gTextureNormal = UnpackNormal(texture(material.texture_normal3, tiledCoords).rgb) * blendMapColour.g;
-	vec3 bTextureNormal = UnpackNormal(texture(material.texture_normal4, tiledCoords).rgb) * blendMapColour.b;
-	vec3 normal = normalize(backgroundTextureNormal + rTextureNormal + gTextureNormal + bTextureNormal);
-
-	float backgroundTextureRoughness = texture(material.texture_roughness1, tiledCoords).r * backTextureWeight;
-	float rTextureRoughness = texture(material.texture_roughness2, tiledCoords).r * blendMapColour.r;
-	float gTextureRoughness = texture(material.texture_roughness3, tiledCoords).r * blendMapColour.g;
-	float bTextureRoughness = texture(material.texture_roughness4, tiledCoords).r * blendMapColour.b;
-	float roughness = max(max(backgroundTextureRoughness, rTextureRoughness), max(gTextureRoughness, bTextureRoughness));
-	roughness = max(roughness, 0.04);
-
-	float backgroundTextureMetallic = texture(material.texture_metallic1, tiledCoords).r * backTextureWeight;
-	float rTextureMetallic = texture(material.texture_metallic2, tiledCoords).r * blendMapColour.r;
-	float gTextureMetallic = texture(material.texture_metallic3, tiledCoords).r * blendMapColour.g;
-	float bTextureMetallic = texture(material.texture_metallic4, tiledCoords).r * blendMapColour.b;
-	float metallic = max(max(backgroundTextureMetallic, rTextureMetallic), max(gTextureMetallic, bTextureMetallic));
-
-	float backgroundTextureAO = texture(material.texture_AO1, tiledCoords).r * backTextureWeight;
-	float rTextureAO = texture(material.texture_AO2, tiledCoords).r * blendMapColour.r;
-	float gTextureAO = texture(material.texture_AO3, tiledCoords).r * blendMapColour.g;
-	float bTextureAO = texture(material.texture_AO4, tiledCoords).r * blendMapColour.b;
-	float ao = max(max(backgroundTextureAO, rTextureAO), max(gTextureAO, bTextureAO));
+	// Derivatives are computed up front since the branches below aren't uniform
+	vec2 localPosXZ = TexCoords * terrainSize;
+	float pixelFootprint = max(length(dFdx(localPosXZ)), length(dFdy(localPosXZ)));
+	vec2 tiledCoordsDx = dFdx(tiledCoords);
+	vec2 tiledCoordsDy = dFdy(tiledCoords);
+
+	vec3 albedo, normal, materialInfo;
+	if (!SampleVirtualTexture(localPosXZ, pixelFootprint, albedo, normal, materialInfo)) {
+		// Page isn't baked yet, splat the layers directly (layers with no weight are skipped)
+		albedo = vec3(0.0);
+		normal = vec3(0.0);
+		materialInfo = vec3(0.0);
+
+		vec4 blendMapColour = texture(material.blendmap, TexCoords);
+		vec4 layerWeights = vec4(1 - (blendMapColour.r + blendMapColour.g + blendMapColour.b), blendMapColour.rgb);
+
+		for (int layer = 0; layer < TERRAIN_LAYER_COUNT; ++layer) {
+			float layerWeight = layerWeights[layer];
+			if (layerWeight <= 0.0)
+				continue;
+
+			vec3 layerCoords = vec3(tiledCoords, layer);
+			albedo += textureGrad(material.albedoArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb * layerWeight;
+			normal += UnpackNormal(textureGrad(material.normalArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb) * layerWeight;
+			materialInfo = max(materialInfo, textureGrad(material.materialInfoArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb * layerWeight);
+		}
+		normal = normalize(normal);
+	}
+
+	float roughness = max(materialInfo.r, 0.04);
+	float metallic = materialInfo.g;
+	float ao = materialInfo.b;
 
 	// Normal mapping code. Opted out of tangent space normal mapping since I would have to convert all of my lights to tangent space
 	normal = normalize(TBN * UnpackNormal(normal));
@@ -120,6 +118,33 @@ void main() {
 	gb_MaterialInfo = vec4(metallic, roughness, ao, 1.0);
 }
 
+// Samples the finest clipmap level that is detailed enough for this pixel and has the page resident, returns false if none do
+bool SampleVirtualTexture(vec2 localPosXZ, float pixelFootprint, out vec3 albedo, out vec3 normal, out vec3 materialInfo) {
+	int startLevel = clamp(int(floor(log2(max(pixelFootprint / virtualTexture.texelWorldSize, 1.0)))), 0, TERRAIN_VIRTUAL_TEXTURE_LEVELS - 1);
+	float windowMargin = 1.0 / float(virtualTexture.pageSize); // One texel so filtering never reaches past the window
+
+	for (int level = startLevel; level < TERRAIN_VIRTUAL_TEXTURE_LEVELS; ++level) {
+		float pageWorldSize = virtualTexture.texelWorldSize * float(virtualTexture.pageSize) * exp2(float(level));
+		vec2 windowCoords = localPosXZ / pageWorldSize - vec2(virtualTexture.levelOrigins[level]);
+		if (any(lessThan(windowCoords, vec2(windowMargin))) || any(greaterThan(windowCoords, vec2(float(virtualTexture.pagesPerSide) - windowMargin))))
+			continue;
+
+		ivec2 page = ivec2(floor(localPosXZ / pageWorldSize));
+		ivec2 slot = ivec2(mod(vec2(page), float(virtualTexture.pagesPerSide)));
+		if (texelFetch(virtualTexture.pageTable, ivec3(slot, level), 0).xy != page)
+			continue;
+
+		// Levels are toroidally addressed, so world space maps straight onto repeating texture coordinates
+		vec3 clipmapCoords = vec3(localPosXZ / (pageWorldSize * float(virtualTexture.pagesPerSide)), level);
+		albedo = textureLod(virtualTexture.albedo, clipmapCoords, 0.0).rgb;
+		normal = normalize(textureLod(virtualTexture.normal, clipmapCoords, 0.0).rgb * 2.0 - 1.0);
+		materialInfo = textureLod(virtualTexture.materialInfo, clipmapCoords, 0.0).rgb;
+		return true;
+	}
+
+	return false;
+}
+
 // Unpacks the normal from the texture and returns the normal in tangent space
 vec3 UnpackNormal(vec3 textureNormal) {
 	return normalize(textureNormal * 2.0 - 1.0);
@@ -1,7 +1,9 @@
 #shader-type vertex
 #version 430 core
 
-layout (location = 0) in vec3 position;
+// Full precision meshes leave position.w at its default of 1. Compact meshes store positions normalized against the mesh bounds
+// with the bitangent's handedness in w, and store normals + tangents octahedral encoded in xy (no bitangent attribute)
+layout (location = 0) in vec4 position;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 texCoords;
 layout (location = 3) in vec3 tangent;
@@ -16,20 +18,43 @@ out vec3 ViewPosTangentSpace;
 uniform bool hasDisplacement;
 uniform vec3 viewPos;
 
+uniform bool compactVertexFormat;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
 uniform mat3 normalMatrix;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+vec3 OctahedralDecode(vec2 encoded) {
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
 void main() {
+	// Decode the mesh's vertex format
+	vec3 localPosition = position.xyz * positionScale + positionOffset;
+	vec3 localNormal = normal;
+	vec3 localTangent = tangent;
+	vec3 localBitangent = bitangent;
+	if (compactVertexFormat) {
+		localNormal = OctahedralDecode(normal.xy);
+		localTangent = OctahedralDecode(tangent.xy);
+		localBitangent = cross(localNormal, localTangent) * (position.w * 2.0 - 1.0);
+	}
+
 	// Use the normal matrix to maintain the orthogonal property of a vector when it is scaled non-uniformly
-	vec3 T = normalize(normalMatrix * tangent);
-	vec3 B = normalize(normalMatrix * bitangent);
-	vec3 N = normalize(normalMatrix * normal);
+	vec3 T = normalize(normalMatrix * localTangent);
+	vec3 B = normalize(normalMatrix * localBitangent);
+	vec3 N = normalize(normalMatrix * localNormal);
 	TBN = mat3(T, B, N);
 
 	TexCoords = texCoords;
-	FragPos = vec3(model * vec4(position, 1.0f));
+	FragPos = vec3(model * vec4(localPosition, 1.0f));
 	if (hasDisplacement) {
 		mat3 inverseTBN = transpose(TBN); // Calculate matrix to go from world -> tangent (orthogonal matrix's transpose = inverse)
 		FragPosTangentSpace = inverseTBN * FragPos;
@@ -55,6 +80,7 @@ struct Material {
 	sampler2D texture_displacement;
 };
 
+// Lights are read from shader storage, laid out std430 to match DirectionalLightData, PointLightData and SpotLightData
 struct DirLight {
 	vec3 direction;
 
@@ -64,7 +90,6 @@ struct DirLight {
 
 struct PointLight {
 	vec3 position;
-
 	float intensity;
 	vec3 lightColour;
 	float attenuationRadius;
@@ -72,19 +97,14 @@ struct PointLight {
 
 struct SpotLight {
 	vec3 position;
-	vec3 direction;
-
 	float intensity;
-	vec3 lightColour;
+	vec3 direction;
 	float attenuationRadius;
-
+	vec3 lightColour;
 	float cutOff;
 	float outerCutOff;
 };
 
-#define MAX_DIR_LIGHTS 5
-#define MAX_POINT_LIGHTS 5
-#define MAX_SPOT_LIGHTS 5
 const float PI = 3.14159265359;
 
 in mat3 TBN;
@@ -104,22 +124,33 @@ uniform sampler2D brdfLUT;
 
 // Lighting
 uniform sampler2D shadowmap;
-uniform ivec4 numDirPointSpotLights;
-uniform DirLight dirLights[MAX_DIR_LIGHTS];
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
+layout (std430, binding = 5) readonly buffer DirectionalLightBuffer { ivec4 numDirPointSpotLights; DirLight dirLights[]; };
+layout (std430, binding = 0) readonly buffer PointLightBuffer { PointLight pointLights[]; };
+layout (std430, binding = 1) readonly buffer SpotLightBuffer { SpotLight spotLights[]; };
+
+// Clustered lighting, each view space cluster lists the point and spot lights that reach it
+layout (std430, binding = 2) readonly buffer LightClusterBuffer { uvec2 lightClusters[]; }; // Index list offset, point light count | spot light count << 16
+layout (std430, binding = 3) readonly buffer LightIndexBuffer { uint lightIndices[]; };
+uniform ivec3 clusterGridSize;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterSliceScaleBias;
+
+// Each draw lists the point and spot lights that reach the object, objects reaching too many use the light clusters instead
+layout (std430, binding = 6) readonly buffer ObjectLightIndexBuffer { uint objectLightIndices[]; };
+uniform uvec2 objectLightList; // Index list offset, point light count | spot light count << 16, all bits set for clustered objects
 
 uniform bool hasDisplacement;
 uniform vec2 minMaxDisplacementSteps;
 uniform float parallaxStrength;
 uniform Material material;
 uniform vec3 viewPos;
+uniform mat4 view;
 uniform mat4 lightSpaceViewProjectionMatrix;
 
 // Light radiance calculations
 vec3 CalculateDirectionalLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity);
-vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity);
-vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity);
+vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity, uvec3 lightList);
+vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity, uvec3 lightList);
 
 // Cook-Torrance BRDF functions adopted by Epic for UE4
 float NormalDistributionGGX(vec3 normal, vec3 halfway, float roughness);
@@ -128,6 +159,8 @@ float GeometrySchlickGGX(float cosTheta, float roughness);
 vec3 FresnelSchlick(float cosTheta, vec3 baseReflectivity);
 
 // Other function prototypes
+uvec3 FindLightCluster(float viewDepth);
+uint LightListIndex(uint listIndex);
 vec3 UnpackNormal(vec3 textureNormal);
 float CalculateShadow(vec3 normal, vec3 fragToLight);
 vec2 ParallaxMapping(vec2 texCoords, vec3 viewDirTangentSpace);
@@ -160,10 +193,15 @@ void main() {
 	baseReflectivity = mix(baseReflectivity, albedo, metallic);
 
 	// Calculate per light radiance for all of the direct lighting
+	uvec3 lightList;
+	if (objectLightList.y == 0xFFFFFFFFu)
+		lightList = FindLightCluster(-(view * vec4(FragPos, 1.0)).z);
+	else
+		lightList = uvec3(objectLightList.x, objectLightList.y & 0xFFFFu, objectLightList.y >> 16u);
 	vec3 directLightIrradiance = vec3(0.0);
 	directLightIrradiance += CalculateDirectionalLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity);
-	directLightIrradiance += CalculatePointLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity);
-	directLightIrradiance += CalculateSpotLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity);
+	directLightIrradiance += CalculatePointLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity, lightList);
+	directLightIrradiance += CalculateSpotLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity, lightList);
 
 	// Calcualte ambient IBL for both diffuse and specular
 	vec3 ambient = vec3(0.05) * albedo * ao;
@@ -219,10 +257,11 @@ vec3 CalculateDirectionalLightRadiance(vec3 albedo, vec3 normal, float metallic,
 }
 
 
-vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity) {
+vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity, uvec3 lightList) {
 	vec3 pointLightIrradiance = vec3(0.0);
 
-	for (int i = 0; i < numDirPointSpotLights.y; ++i) {
+	for (uint j = 0u; j < lightList.y; ++j) {
+		uint i = LightListIndex(lightList.x + j);
 		vec3 fragToLight = normalize(pointLights[i].position - FragPos);
 		vec3 halfway = normalize(fragToView + fragToLight);
 		float fragToLightDistance = length(pointLights[i].position - FragPos);
@@ -261,10 +300,11 @@ vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float
 }
 
 
-vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity) {
+vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity, uvec3 lightList) {
 	vec3 spotLightIrradiance = vec3(0.0);
 
-	for (int i = 0; i < numDirPointSpotLights.z; ++i) {
+	for (uint j = 0u; j < lightList.z; ++j) {
+		uint i = LightListIndex(lightList.x + lightList.y + j);
 		vec3 fragToLight = normalize(spotLights[i].position - FragPos);
 		vec3 halfway = normalize(fragToView + fragToLight);
 		float fragToLightDistance = length(spotLights[i].position - FragPos);
@@ -347,8 +387,10 @@ vec3 FresnelSchlick(float cosTheta, vec3 baseReflectivity) {
 
 
 // Unpacks the normal from the texture and returns the normal in tangent space
+// Only x and y are read since cooked normal maps are two channel (BC5), z is always positive in tangent space so it can be reconstructed
 vec3 UnpackNormal(vec3 textureNormal) {
-	return normalize(textureNormal * 2.0 - 1.0);
+	vec2 normalXY = textureNormal.xy * 2.0 - 1.0;
+	return vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
 }
 
 
@@ -415,3 +457,17 @@ vec2 ParallaxMapping(vec2 texCoords, vec3 viewDirTangentSpace) {
 
 	return finalTexCoords;
 }
+
+// Returns the cluster's offset into the light index list, and its point and spot light counts
+uvec3 FindLightCluster(float viewDepth) {
+	int slice = clamp(int(log(viewDepth) * clusterSliceScaleBias.x + clusterSliceScaleBias.y), 0, clusterGridSize.z - 1);
+	ivec2 tile = min(ivec2(gl_FragCoord.xy / clusterTileSize), clusterGridSize.xy - 1);
+	uvec2 cluster = lightClusters[(slice * clusterGridSize.y + tile.y) * clusterGridSize.x + tile.x];
+	return uvec3(cluster.x, cluster.y & 0xFFFFu, cluster.y >> 16u);
+}
+
+
+// Lights come from the object's own list, or the light cluster's when the object has none. It is the same choice for the whole draw
+uint LightListIndex(uint listIndex) {
+	return objectLightList.y == 0xFFFFFFFFu ? lightIndices[listIndex] : objectLightIndices[listIndex];
+}
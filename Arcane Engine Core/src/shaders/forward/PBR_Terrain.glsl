@@ -37,35 +37,17 @@ void main() {
 
 // Does AMD support sampler2D in a struct?
 struct Material {
-	sampler2D texture_albedo1; // background texture
-	sampler2D texture_albedo2; // r texture
-	sampler2D texture_albedo3; // g texture
-	sampler2D texture_albedo4; // b texture
-
-	sampler2D texture_normal1; // background texture
-	sampler2D texture_normal2; // r texture
-	sampler2D texture_normal3; // g texture
-	sampler2D texture_normal4; // b texture
-
-	sampler2D texture_roughness1; // background texture
-	sampler2D texture_roughness2; // r texture
-	sampler2D texture_roughness3; // g texture
-	sampler2D texture_roughness4; // b texture
-
-	sampler2D texture_metallic1; // background texture
-	sampler2D texture_metallic2; // r texture
-	sampler2D texture_metallic3; // g texture
-	sampler2D texture_metallic4; // b texture
-
-	sampler2D texture_AO1; // background texture
-	sampler2D texture_AO2; // r texture
-	sampler2D texture_AO3; // g texture
-	sampler2D texture_AO4; // b texture
+	sampler2DArray albedoArray; // layer 0 is the background texture, layers 1-3 are driven by the blend map's rgb
+	sampler2DArray normalArray;
+	sampler2DArray materialInfoArray; // roughness (r), metallic (g), AO (b)
 
 	sampler2D blendmap;
 	float tilingAmount;
 };
 
+#define TERRAIN_LAYER_COUNT 4
+
+// Lights are read from shader storage, laid out std430 to match DirectionalLightData, PointLightData and SpotLightData
 struct DirLight {
 	vec3 direction;
 
@@ -75,7 +57,6 @@ struct DirLight {
 
 struct PointLight {
 	vec3 position;
-
 	float intensity;
 	vec3 lightColour;
 	float attenuationRadius;
@@ -83,19 +64,14 @@ struct PointLight {
 
 struct SpotLight {
 	vec3 position;
-	vec3 direction;
-
 	float intensity;
-	vec3 lightColour;
+	vec3 direction;
 	float attenuationRadius;
-
+	vec3 lightColour;
 	float cutOff;
 	float outerCutOff;
 };
 
-#define MAX_DIR_LIGHTS 5
-#define MAX_POINT_LIGHTS 5
-#define MAX_SPOT_LIGHTS 5
 const float PI = 3.14159265359;
 
 in mat3 TBN;
@@ -105,19 +81,26 @@ in vec3 FragPos;
 out vec4 color;
 
 uniform sampler2D shadowmap;
-uniform ivec4 numDirPointSpotLights;
-uniform DirLight dirLights[MAX_DIR_LIGHTS];
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
+layout (std430, binding = 5) readonly buffer DirectionalLightBuffer { ivec4 numDirPointSpotLights; DirLight dirLights[]; };
+layout (std430, binding = 0) readonly buffer PointLightBuffer { PointLight pointLights[]; };
+layout (std430, binding = 1) readonly buffer SpotLightBuffer { SpotLight spotLights[]; };
+
+// Clustered lighting, each view space cluster lists the point and spot lights that reach it
+layout (std430, binding = 2) readonly buffer LightClusterBuffer { uvec2 lightClusters[]; }; // Index list offset, point light count | spot light count << 16
+layout (std430, binding = 3) readonly buffer LightIndexBuffer { uint lightIndices[]; };
+uniform ivec3 clusterGridSize;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterSliceScaleBias;
 
 uniform Material material;
 uniform vec3 viewPos;
+uniform mat4 view;
 uniform mat4 lightSpaceViewProjectionMatrix;
 
 // Light radiance calculations
 vec3 CalculateDirectionalLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity);
-vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity);
-vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity);
+vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity, uvec3 lightCluster);
+vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity, uvec3 lightCluster);
 
 // Cook-Torrance BRDF functions adopted by Epic for UE4
 float NormalDistributionGGX(vec3 normal, vec3 halfway, float roughness);
@@ -126,44 +109,37 @@ float GeometrySchlickGGX(float cosTheta, float roughness);
 vec3 FresnelSchlick(float cosTheta, vec3 baseReflectivity);
 
 // Other function prototypes
+uvec3 FindLightCluster(float viewDepth);
 vec3 UnpackNormal(vec3 textureNormal);
 float CalculateShadow(vec3 normal, vec3 fragToLight);
 
 void main() {
 	vec4 blendMapColour = texture(material.blendmap, TexCoords);
-	float backTextureWeight = 1 - (blendMapColour.r + blendMapColour.g + blendMapColour.b);
+	vec4 layerWeights = vec4(1 - (blendMapColour.r + blendMapColour.g + blendMapColour.b), blendMapColour.rgb);
 	vec2 tiledCoords = TexCoords * material.tilingAmount;
 
-	vec3 backgroundTextureAlbedo = texture(material.texture_albedo1, tiledCoords).rgb * backTextureWeight;
-	vec3 rTextureAlbedo = texture(material.texture_albedo2, tiledCoords).rgb * blendMapColour.r;
-	vec3 gTextureAlbedo = texture(material.texture_albedo3, tiledCoords).rgb * blendMapColour.g;
-	vec3 bTextureAlbedo = texture(material.texture_albedo4, tiledCoords).rgb * blendMapColour.b;
-	vec3 albedo = backgroundTextureAlbedo + rTextureAlbedo + gTextureAlbedo + bTextureAlbedo;
-
-	vec3 backgroundTextureNormal = UnpackNormal(texture(material.texture_normal1, tiledCoords).rgb) * backTextureWeight;
-	vec3 rTextureNormal = UnpackNormal(texture(material.texture_normal2, tiledCoords).rgb) * blendMapColour.r;
-	vec3 gTextureNormal = UnpackNormal(texture(material.texture_normal3, tiledCoords).rgb) * blendMapColour.g;
-	vec3 bTextureNormal = UnpackNormal(texture(material.texture_normal4, tiledCoords).rgb) * blendMapColour.b;
-	vec3 normal = normalize(backgroundTextureNormal + rTextureNormal + gTextureNormal + bTextureNormal);
-
-	float backgroundTextureRoughness = texture(material.texture_roughness1, tiledCoords).r * backTextureWeight;
-	float rTextureRoughness = texture(material.texture_roughness2, tiledCoords).r * blendMapColour.r;
-	float gTextureRoughness = texture(material.texture_roughness3, tiledCoords).r * blendMapColour.g;
-	float bTextureRoughness = texture(material.texture_roughness4, tiledCoords).r * blendMapColour.b;
-	float roughness = max(max(backgroundTextureRoughness, rTextureRoughness), max(gTextureRoughness, bTextureRoughness));
-	roughness = max(roughness, 0.04); // Used for calculations since specular highlights will be too fine, and will cause flicker
-
-	float backgroundTextureMetallic = texture(material.texture_metallic1, tiledCoords).r * backTextureWeight;
-	float rTextureMetallic = texture(material.texture_metallic2, tiledCoords).r * blendMapColour.r;
-	float gTextureMetallic = texture(material.texture_metallic3, tiledCoords).r * blendMapColour.g;
-	float bTextureMetallic = texture(material.texture_metallic4, tiledCoords).r * blendMapColour.b;
-	float metallic = max(max(backgroundTextureMetallic, rTextureMetallic), max(gTextureMetallic, bTextureMetallic));
-
-	float backgroundTextureAO = texture(material.texture_AO1, tiledCoords).r * backTextureWeight;
-	float rTextureAO = texture(material.texture_AO2, tiledCoords).r * blendMapColour.r;
-	float gTextureAO = texture(material.texture_AO3, tiledCoords).r * blendMapColour.g;
-	float bTextureAO = texture(material.texture_AO4, tiledCoords).r * blendMapColour.b;
-	float ao = max(max(backgroundTextureAO, rTextureAO), max(gTextureAO, bTextureAO));
+	// Layers with no weight are skipped, gradients are computed up front since the branch isn't uniform
+	vec2 tiledCoordsDx = dFdx(tiledCoords);
+	vec2 tiledCoordsDy = dFdy(tiledCoords);
+
+	vec3 albedo = vec3(0.0);
+	vec3 normal = vec3(0.0);
+	vec3 materialInfo = vec3(0.0);
+	for (int layer = 0; layer < TERRAIN_LAYER_COUNT; ++layer) {
+		float layerWeight = layerWeights[layer];
+		if (layerWeight <= 0.0)
+			continue;
+
+		vec3 layerCoords = vec3(tiledCoords, layer);
+		albedo += textureGrad(material.albedoArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb * layerWeight;
+		normal += UnpackNormal(textureGrad(material.normalArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb) * layerWeight;
+		materialInfo = max(materialInfo, textureGrad(material.materialInfoArray, layerCoords, tiledCoordsDx, tiledCoordsDy).rgb * layerWeight);
+	}
+	normal = normalize(normal);
+
+	float roughness = max(materialInfo.r, 0.04); // Used for calculations since specular highlights will be too fine, and will cause flicker
+	float metallic = materialInfo.g;
+	float ao = materialInfo.b;
 
 	// Normal mapping code. Opted out of tangent space normal mapping since I would have to convert all of my lights to tangent space
 	normal = normalize(TBN * UnpackNormal(normal));
@@ -175,10 +151,11 @@ void main() {
 	baseReflectivity = mix(baseReflectivity, albedo, metallic);
 
 	// Calculate per light radiance for all of the direct lighting
+	uvec3 lightCluster = FindLightCluster(-(view * vec4(FragPos, 1.0)).z);
 	vec3 directLightIrradiance = vec3(0.0);
 	directLightIrradiance += CalculateDirectionalLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity);
-	directLightIrradiance += CalculatePointLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity);
-	directLightIrradiance += CalculateSpotLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity);
+	directLightIrradiance += CalculatePointLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity, lightCluster);
+	directLightIrradiance += CalculateSpotLightRadiance(albedo, normal, metallic, roughness, fragToView, baseReflectivity, lightCluster);
 
 	// Calculate ambient term
 	vec3 ambient = vec3(0.05) * albedo * ao;
@@ -222,10 +199,11 @@ vec3 CalculateDirectionalLightRadiance(vec3 albedo, vec3 normal, float metallic,
 }
 
 
-vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity) {
+vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity, uvec3 lightCluster) {
 	vec3 pointLightIrradiance = vec3(0.0);
 
-	for (int i = 0; i < numDirPointSpotLights.y; ++i) {
+	for (uint j = 0u; j < lightCluster.y; ++j) {
+		uint i = lightIndices[lightCluster.x + j];
 		vec3 fragToLight = normalize(pointLights[i].position - FragPos);
 		vec3 halfway = normalize(fragToView + fragToLight);
 		float fragToLightDistance = length(pointLights[i].position - FragPos);
@@ -264,10 +242,11 @@ vec3 CalculatePointLightRadiance(vec3 albedo, vec3 normal, float metallic, float
 }
 
 
-vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity) {
+vec3 CalculateSpotLightRadiance(vec3 albedo, vec3 normal, float metallic, float roughness, vec3 fragToView, vec3 baseReflectivity, uvec3 lightCluster) {
 	vec3 spotLightIrradiance = vec3(0.0);
 
-	for (int i = 0; i < numDirPointSpotLights.z; ++i) {
+	for (uint j = 0u; j < lightCluster.z; ++j) {
+		uint i = lightIndices[lightCluster.x + lightCluster.y + j];
 		vec3 fragToLight = normalize(spotLights[i].position - FragPos);
 		vec3 halfway = normalize(fragToView + fragToLight);
 		float fragToLightDistance = length(spotLights[i].position - FragPos);
@@ -380,3 +359,11 @@ float CalculateShadow(vec3 normal, vec3 fragToLight) {
 		shadow = 0.0;
 	return shadow;
 }
+
+// Returns the cluster's offset into the light index list, and its point and spot light counts
+uvec3 FindLightCluster(float viewDepth) {
+	int slice = clamp(int(log(viewDepth) * clusterSliceScaleBias.x + clusterSliceScaleBias.y), 0, clusterGridSize.z - 1);
+	ivec2 tile = min(ivec2(gl_FragCoord.xy / clusterTileSize), clusterGridSize.xy - 1);
+	uvec2 cluster = lightClusters[(slice * clusterGridSize.y + tile.y) * clusterGridSize.x + tile.x];
+	return uvec3(cluster.x, cluster.y & 0xFFFFu, cluster.y >> 16u);
+}
@@ -4,6 +4,8 @@
 #include <graphics/mesh/Model.h>
 #include <graphics/renderer/GLCache.h>
 #include <graphics/Shader.h>
+#include <terrain/TerrainTileStreamer.h>
+#include <terrain/TerrainVirtualTexture.h>
 #include <utils/loaders/TextureLoader.h>
 
 namespace arcane {
@@ -13,33 +15,29 @@ namespace arcane {
 		Terrain(glm::vec3 &worldPosition);
 		~Terrain();
 
+		// Streams in the terrain tiles needed around the camera
+		void onUpdate(const glm::vec3 &cameraPosition);
 		void Draw(Shader *shader, RenderPassType pass) const;
 
 		inline const glm::vec3& getPosition() const { return m_Position; }
-	private:
-		glm::vec3 calculateNormal(float worldPosX, float worldPosZ, unsigned char *heightMapData);
-
-		float sampleHeightfieldBilinear(float worldPosX, float worldPosZ, unsigned char *heightMapData);
-		float sampleHeightfieldNearest(float worldPosX, float worldPosZ, unsigned char *heightMapData);
-
-		float Terrain::clamp(float n, float lower, float upper);
+		inline const TerrainTileStreamer& getTileStreamer() const { return m_TileStreamer; }
 	private:
 		GLCache *m_GLCache;
 
 		// Tweakable Terrain Variables
 		float m_TextureTilingAmount;
-		float m_TerrainSizeXZ, m_TerrainSizeY;
-		unsigned int m_SideVertexCount;
-
-		// Non-Tweakable Terrain Varialbes
-		float m_SpaceBetweenVertices;
-		float m_TerrainToHeightfieldTextureConversion;
-		unsigned int m_HeightfieldTextureSize;
+		float m_SampleSpacing; // World units between level 0 heightmap samples
+		float m_TerrainSizeY;
 
 		glm::mat4 m_ModelMatrix;
 		glm::vec3 m_Position;
-		Mesh *m_Mesh;
-		std::array<Texture*, 21> m_Textures; // Represents all the textures supported by the terrain's texure splatting (rgba and the default value)
+		TerrainTileStreamer m_TileStreamer;
+
+		// Splat layers (background, r, g, b) are stored as layers of array textures, the blend map weights them
+		AssetHandle<Texture> m_AlbedoArray, m_NormalArray;
+		AssetHandle<Texture> m_MaterialInfoArray; // Roughness, metallic and AO packed into rgb
+		AssetHandle<Texture> m_BlendMap;
+		TerrainVirtualTexture m_VirtualTexture;
 	};
 
 }
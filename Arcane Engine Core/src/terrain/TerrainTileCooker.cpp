@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "TerrainTileCooker.h"
+
+#include <terrain/TerrainTileFormat.h>
+#include <utils/FileUtils.h>
+#include <utils/VirtualFileSystem.h>
+
+namespace arcane {
+
+	bool TerrainTileCooker::cookHeightmap(const std::string &heightmapPath, const std::string &outputPath, unsigned int tileSize) {
+		int mapWidth, mapHeight;
+		unsigned char *heightMapImage = VirtualFileSystem::loadImage(heightmapPath, &mapWidth, &mapHeight, 0, SOIL_LOAD_L);
+		if (!heightMapImage) {
+			Logger::getInstance().error("logged_files/terrain_creation.txt", "terrain cooking", "Couldn't load heightmap: " + heightmapPath);
+			return false;
+		}
+		if (mapWidth < 2 || mapHeight < 2 || tileSize == 0) {
+			Logger::getInstance().error("logged_files/terrain_creation.txt", "terrain cooking", "Heightmap or tile size is too small to be tiled: " + heightmapPath);
+			stbi_image_free(heightMapImage);
+			return false;
+		}
+
+		// Add levels until the top of the pyramid only needs a handful of tiles to cover the whole map
+		unsigned int mapQuadsX = mapWidth - 1, mapQuadsZ = mapHeight - 1;
+		unsigned int levelCount = 1;
+		while (true) {
+			unsigned int topTileCoverage = tileSize << (levelCount - 1);
+			unsigned int topTilesX = (mapQuadsX + topTileCoverage - 1) / topTileCoverage;
+			unsigned int topTilesZ = (mapQuadsZ + topTileCoverage - 1) / topTileCoverage;
+			if (std::max(topTilesX, topTilesZ) <= s_MaxTopLevelTilesPerSide)
+				break;
+			levelCount++;
+		}
+
+		// Pad level 0 (by clamping to the edge) so every level is covered by whole tiles
+		unsigned int topTileCoverage = tileSize << (levelCount - 1);
+		unsigned int topTilesX = (mapQuadsX + topTileCoverage - 1) / topTileCoverage;
+		unsigned int topTilesZ = (mapQuadsZ + topTileCoverage - 1) / topTileCoverage;
+		unsigned int sampleCountX = topTilesX * topTileCoverage + 1;
+		unsigned int sampleCountZ = topTilesZ * topTileCoverage + 1;
+
+		std::vector<std::vector<uint16_t>> levelSamples(levelCount);
+		levelSamples[0].resize((size_t)sampleCountX * sampleCountZ);
+		for (unsigned int z = 0; z < sampleCountZ; z++) {
+			unsigned int mapZ = std::min(z, (unsigned int)mapHeight - 1);
+			for (unsigned int x = 0; x < sampleCountX; x++) {
+				unsigned int mapX = std::min(x, (unsigned int)mapWidth - 1);
+				levelSamples[0][x + (size_t)z * sampleCountX] = (uint16_t)(heightMapImage[mapX + (size_t)mapZ * mapWidth] * 257);
+			}
+		}
+		stbi_image_free(heightMapImage);
+
+		for (unsigned int level = 1; level < levelCount; level++) {
+			downsampleLevel(levelSamples[level - 1], ((sampleCountX - 1) >> (level - 1)) + 1, ((sampleCountZ - 1) >> (level - 1)) + 1, levelSamples[level]);
+		}
+
+		// Header and level table
+		TerrainTileFileHeader header;
+		header.Magic = TERRAIN_TILE_FILE_MAGIC;
+		header.Version = TERRAIN_TILE_FILE_VERSION;
+		header.SampleCountX = sampleCountX;
+		header.SampleCountZ = sampleCountZ;
+		header.TileSize = tileSize;
+		header.LevelCount = levelCount;
+		header.SourceSize = 0;
+		header.SourceModifiedTime = 0;
+		VirtualFileSystem::getFileStamp(heightmapPath, header.SourceSize, header.SourceModifiedTime);
+
+		std::vector<TerrainTileLevelInfo> levels(levelCount);
+		uint64_t dataOffset = sizeof(TerrainTileFileHeader) + sizeof(TerrainTileLevelInfo) * levelCount;
+		for (unsigned int level = 0; level < levelCount; level++) {
+			levels[level].TileCountX = ((sampleCountX - 1) >> level) / tileSize;
+			levels[level].TileCountZ = ((sampleCountZ - 1) >> level) / tileSize;
+			levels[level].DataOffset = dataOffset;
+			dataOffset += (uint64_t)levels[level].TileCountX * levels[level].TileCountZ * getTerrainTileByteSize(tileSize);
+		}
+
+		std::ofstream output(outputPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!output) {
+			Logger::getInstance().error("logged_files/terrain_creation.txt", "terrain cooking", "Couldn't create tiled heightmap: " + outputPath);
+			return false;
+		}
+		output.write((const char*)&header, sizeof(header));
+		output.write((const char*)levels.data(), sizeof(TerrainTileLevelInfo) * levelCount);
+
+		// Tiles are written row by row per level, each one including its border samples
+		const int samplesPerSide = (int)getTerrainTileSamplesPerSide(tileSize);
+		std::vector<uint16_t> tileSamples((size_t)samplesPerSide * samplesPerSide);
+		for (unsigned int level = 0; level < levelCount; level++) {
+			int levelSampleCountX = (int)((sampleCountX - 1) >> level) + 1;
+			int levelSampleCountZ = (int)((sampleCountZ - 1) >> level) + 1;
+
+			const std::vector<uint16_t> &samples = levelSamples[level];
+
+			for (unsigned int tileZ = 0; tileZ < levels[level].TileCountZ; tileZ++) {
+				for (unsigned int tileX = 0; tileX < levels[level].TileCountX; tileX++) {
+					for (int sampleZ = 0; sampleZ < samplesPerSide; sampleZ++) {
+						int levelZ = glm::clamp((int)(tileZ * tileSize) + sampleZ - 1, 0, levelSampleCountZ - 1);
+						for (int sampleX = 0; sampleX < samplesPerSide; sampleX++) {
+							int levelX = glm::clamp((int)(tileX * tileSize) + sampleX - 1, 0, levelSampleCountX - 1);
+							tileSamples[sampleX + sampleZ * samplesPerSide] = samples[levelX + (size_t)levelZ * levelSampleCountX];
+						}
+					}
+
+					// Filtering smooths away the peaks and dips of the finer levels, the bounds still have to contain them
+					uint16_t tileBounds[2] = { std::numeric_limits<uint16_t>::max(), 0 };
+					unsigned int coverage = tileSize << level;
+					for (unsigned int z = tileZ * coverage; z <= (tileZ + 1) * coverage; z++) {
+						for (unsigned int x = tileX * coverage; x <= (tileX + 1) * coverage; x++) {
+							uint16_t height = levelSamples[0][x + (size_t)z * sampleCountX];
+							tileBounds[0] = std::min(tileBounds[0], height);
+							tileBounds[1] = std::max(tileBounds[1], height);
+						}
+					}
+
+					output.write((const char*)tileSamples.data(), tileSamples.size() * sizeof(uint16_t));
+					output.write((const char*)tileBounds, sizeof(tileBounds));
+				}
+			}
+		}
+
+		if (!output) {
+			Logger::getInstance().error("logged_files/terrain_creation.txt", "terrain cooking", "Failed writing tiled heightmap: " + outputPath);
+			return false;
+		}
+		Logger::getInstance().info("logged_files/terrain_creation.txt", "terrain cooking", "Cooked " + heightmapPath + " into " + std::to_string(levelCount) + " levels");
+		return true;
+	}
+
+	void TerrainTileCooker::downsampleLevel(const std::vector<uint16_t> &source, unsigned int sourceCountX, unsigned int sourceCountZ, std::vector<uint16_t> &destination) {
+		unsigned int countX = (sourceCountX - 1) / 2 + 1, countZ = (sourceCountZ - 1) / 2 + 1;
+		destination.resize((size_t)countX * countZ);
+
+		// Coarse samples sit on every other fine sample, so a 3x3 tent (a 2x2 box applied twice) keeps the filter centred on them.
+		// Clamped at the edges
+		static const unsigned int weights[3] = { 1, 2, 1 };
+		for (unsigned int z = 0; z < countZ; z++) {
+			for (unsigned int x = 0; x < countX; x++) {
+				unsigned int sum = 0;
+				for (int offsetZ = -1; offsetZ <= 1; offsetZ++) {
+					unsigned int sourceZ = (unsigned int)glm::clamp((int)z * 2 + offsetZ, 0, (int)sourceCountZ - 1);
+					for (int offsetX = -1; offsetX <= 1; offsetX++) {
+						unsigned int sourceX = (unsigned int)glm::clamp((int)x * 2 + offsetX, 0, (int)sourceCountX - 1);
+						sum += source[sourceX + (size_t)sourceZ * sourceCountX] * weights[offsetX + 1] * weights[offsetZ + 1];
+					}
+				}
+				destination[x + (size_t)z * countX] = (uint16_t)((sum + 8) / 16);
+			}
+		}
+	}
+
+	std::string TerrainTileCooker::loadOrCookHeightmap(const std::string &heightmapPath, unsigned int tileSize) {
+		uint64_t sourceSize = 0;
+		int64_t sourceModifiedTime = 0;
+		bool hasSource = VirtualFileSystem::getFileStamp(heightmapPath, sourceSize, sourceModifiedTime);
+
+		std::string cachePath = getCachePath(heightmapPath);
+		if (isCookedHeightmapCurrent(cachePath, hasSource, sourceSize, sourceModifiedTime, tileSize))
+			return cachePath;
+
+		if (!hasSource)
+			return std::string();
+		FileUtils::createDirectories(TERRAIN_CACHE_DIRECTORY);
+		if (!cookHeightmap(heightmapPath, cachePath, tileSize))
+			return std::string();
+		return cachePath;
+	}
+
+	bool TerrainTileCooker::isCookedHeightmapCurrent(const std::string &cachePath, bool checkSource, uint64_t sourceSize, int64_t sourceModifiedTime, unsigned int tileSize) {
+		// Only the header is needed, the streamer validates the rest when it maps the file
+		std::ifstream input(cachePath, std::ios::in | std::ios::binary);
+		if (!input)
+			return false;
+
+		TerrainTileFileHeader header;
+		if (!input.read((char*)&header, sizeof(header)))
+			return false;
+		if (header.Magic != TERRAIN_TILE_FILE_MAGIC || header.Version != TERRAIN_TILE_FILE_VERSION || header.TileSize != tileSize)
+			return false;
+		if (checkSource && (header.SourceSize != sourceSize || header.SourceModifiedTime != sourceModifiedTime))
+			return false;
+		return true;
+	}
+
+	std::string TerrainTileCooker::getCachePath(const std::string &heightmapPath) {
+		// Hashes the heightmap path, the header decides if the entry is still up to date
+		uint64_t hash = FileUtils::hashFNV1a(heightmapPath.data(), heightmapPath.size());
+
+		char hashString[17];
+		snprintf(hashString, sizeof(hashString), "%016llx", (unsigned long long)hash);
+		return std::string(TERRAIN_CACHE_DIRECTORY) + hashString + ".ath";
+	}
+
+}
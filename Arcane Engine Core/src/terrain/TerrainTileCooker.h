@@ -0,0 +1,23 @@
+#pragma once
+
+namespace arcane {
+
+	class TerrainTileCooker {
+	public:
+		// Cuts a heightmap image into a tiled pyramid (see TerrainTileFormat.h) that can be memory mapped and streamed
+		static bool cookHeightmap(const std::string &heightmapPath, const std::string &outputPath, unsigned int tileSize);
+
+		// Returns the path of an up to date tiled pyramid for the heightmap, cooking one into the cache if there isn't one or the heightmap
+		// changed since. Empty if it couldn't be cooked
+		static std::string loadOrCookHeightmap(const std::string &heightmapPath, unsigned int tileSize);
+	private:
+		static bool isCookedHeightmapCurrent(const std::string &cachePath, bool checkSource, uint64_t sourceSize, int64_t sourceModifiedTime, unsigned int tileSize);
+		static std::string getCachePath(const std::string &heightmapPath);
+
+		// Builds the next level of the pyramid, half the quads of the source along each side
+		static void downsampleLevel(const std::vector<uint16_t> &source, unsigned int sourceCountX, unsigned int sourceCountZ, std::vector<uint16_t> &destination);
+
+		static const unsigned int s_MaxTopLevelTilesPerSide = 4;
+	};
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+namespace arcane {
+
+	// Tiled heightmap pyramid (.ath) layout:
+	// [TerrainTileFileHeader][TerrainTileLevelInfo * LevelCount][level 0 tiles][level 1 tiles]...
+	// Level n is level n - 1 filtered down to half the resolution, so every level has the same tile size but covers 2^n times the area per tile.
+	// Each tile stores (TileSize + 3)^2 16-bit heights: its own (TileSize + 1)^2 samples plus a one sample border, so
+	// normals can be generated without reading neighbouring tiles. They are followed by the lowest and highest level 0 height under the tile
+	#define TERRAIN_TILE_FILE_MAGIC 0x48545441 // "ATTH"
+	#define TERRAIN_TILE_FILE_VERSION 3
+
+	struct TerrainTileFileHeader {
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t SampleCountX, SampleCountZ; // Level 0 resolution (padded so every level is covered by whole tiles)
+		uint32_t TileSize; // Quads along a tile's side
+		uint32_t LevelCount;
+		uint64_t SourceSize; // Stamp of the heightmap it was cooked from, a mismatch means it has to be re-cooked
+		int64_t SourceModifiedTime;
+	};
+
+	struct TerrainTileLevelInfo {
+		uint32_t TileCountX, TileCountZ;
+		uint64_t DataOffset; // Offset in bytes from the start of the file to the level's first tile
+	};
+
+	inline uint32_t getTerrainTileSamplesPerSide(uint32_t tileSize) { return tileSize + 3; }
+	inline size_t getTerrainTileByteSize(uint32_t tileSize) { return ((size_t)getTerrainTileSamplesPerSide(tileSize) * getTerrainTileSamplesPerSide(tileSize) + 2) * sizeof(uint16_t); }
+
+}
@@ -0,0 +1,430 @@
+#include "pch.h"
+#include "TerrainTileStreamer.h"
+
+#include <graphics/renderer/RenderStatistics.h>
+
+namespace arcane {
+
+	// Interleaved position, normal, uv, tangent and bitangent (same layout as FullPrecisionVertex so the terrain shaders are unchanged)
+	static const unsigned int s_TileVertexComponentCount = 14;
+
+	TerrainTileStreamer::TerrainTileStreamer()
+		: m_Levels(nullptr), m_SampleSpacing(1.0f), m_HeightScale(1.0f), m_TileVertexCount(0), m_TileIndexCount(0), m_TileVertexBufferSize(0),
+		m_MaxResidentTiles(0), m_SharedIBO(0), m_FrameIndex(0), m_ShutdownWorker(false)
+	{
+		memset(&m_Header, 0, sizeof(m_Header));
+	}
+
+	TerrainTileStreamer::~TerrainTileStreamer() {
+		if (m_WorkerThread.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(m_RequestMutex);
+				m_ShutdownWorker = true;
+			}
+			m_RequestCondition.notify_all();
+			m_WorkerThread.join();
+		}
+
+		for (auto &residentTile : m_ResidentTiles) {
+			releaseTile(residentTile.second);
+		}
+		if (m_SharedIBO) {
+			glDeleteBuffers(1, &m_SharedIBO);
+		}
+	}
+
+	bool TerrainTileStreamer::init(const std::string &tiledHeightmapPath, float sampleSpacing, float heightScale) {
+		if (!m_HeightmapFile.open(tiledHeightmapPath)) {
+			return false;
+		}
+
+		// Validate the header and level table before touching any tile data
+		if (m_HeightmapFile.getSize() < sizeof(TerrainTileFileHeader)) {
+			Logger::getInstance().error("logged_files/terrain_creation.txt", "terrain streaming", "Tiled heightmap is truncated: " + tiledHeightmapPath);
+			return false;
+		}
+		memcpy(&m_Header, m_HeightmapFile.getData(), sizeof(TerrainTileFileHeader));
+		if (m_Header.Magic != TERRAIN_TILE_FILE_MAGIC || m_Header.Version != TERRAIN_TILE_FILE_VERSION || m_Header.LevelCount == 0 || m_Header.TileSize == 0) {
+			Logger::getInstance().error("logged_files/terrain_creation.txt", "terrain streaming", "Tiled heightmap has an unsupported header: " + tiledHeightmapPath);
+			return false;
+		}
+
+		size_t levelTableEnd = sizeof(TerrainTileFileHeader) + sizeof(TerrainTileLevelInfo) * m_Header.LevelCount;
+		if (m_HeightmapFile.getSize() < levelTableEnd) {
+			Logger::getInstance().error("logged_files/terrain_creation.txt", "terrain streaming", "Tiled heightmap is truncated: " + tiledHeightmapPath);
+			return false;
+		}
+		m_Levels = (const TerrainTileLevelInfo*)(m_HeightmapFile.getData() + sizeof(TerrainTileFileHeader));
+
+		const TerrainTileLevelInfo &lastLevel = m_Levels[m_Header.LevelCount - 1];
+		uint64_t fileEnd = lastLevel.DataOffset + (uint64_t)lastLevel.TileCountX * lastLevel.TileCountZ * getTerrainTileByteSize(m_Header.TileSize);
+		if (m_HeightmapFile.getSize() < fileEnd) {
+			Logger::getInstance().error("logged_files/terrain_creation.txt", "terrain streaming", "Tiled heightmap is truncated: " + tiledHeightmapPath);
+			return false;
+		}
+
+		m_SampleSpacing = sampleSpacing;
+		m_HeightScale = heightScale;
+
+		// Tile topology: a (TileSize + 1)^2 vertex grid followed by a skirt along each edge to hide cracks between levels
+		const unsigned int tileSize = m_Header.TileSize;
+		const unsigned int sideVertexCount = tileSize + 1;
+		const unsigned int gridVertexCount = sideVertexCount * sideVertexCount;
+		m_TileVertexCount = gridVertexCount + 4 * sideVertexCount;
+		m_TileVertexBufferSize = m_TileVertexCount * s_TileVertexComponentCount * sizeof(float);
+
+		std::vector<unsigned int> indices;
+		indices.reserve(tileSize * tileSize * 6 + 4 * tileSize * 6);
+
+		// Grid indices (ccw winding order for consistency which will allow back face culling)
+		for (unsigned int z = 0; z < tileSize; z++) {
+			for (unsigned int x = 0; x < tileSize; x++) {
+				unsigned int indexTL = x + (z * sideVertexCount);
+				unsigned int indexTR = 1 + x + (z * sideVertexCount);
+				unsigned int indexBL = sideVertexCount + x + (z * sideVertexCount);
+				unsigned int indexBR = 1 + sideVertexCount + x + (z * sideVertexCount);
+
+				indices.push_back(indexTL);
+				indices.push_back(indexBR);
+				indices.push_back(indexTR);
+
+				indices.push_back(indexTL);
+				indices.push_back(indexBL);
+				indices.push_back(indexBR);
+			}
+		}
+
+		// Skirt indices, edges are walked so the skirts face outwards (north, south, west, east)
+		auto gridIndex = [sideVertexCount](unsigned int x, unsigned int z) { return x + z * sideVertexCount; };
+		auto skirtIndex = [gridVertexCount, sideVertexCount](unsigned int edge, unsigned int k) { return gridVertexCount + edge * sideVertexCount + k; };
+		auto addSkirtQuad = [&indices](unsigned int a, unsigned int b, unsigned int skirtA, unsigned int skirtB) {
+			indices.push_back(a);
+			indices.push_back(b);
+			indices.push_back(skirtA);
+
+			indices.push_back(b);
+			indices.push_back(skirtB);
+			indices.push_back(skirtA);
+		};
+		for (unsigned int k = 0; k < tileSize; k++) {
+			addSkirtQuad(gridIndex(k, 0), gridIndex(k + 1, 0), skirtIndex(0, k), skirtIndex(0, k + 1));
+			addSkirtQuad(gridIndex(k + 1, tileSize), gridIndex(k, tileSize), skirtIndex(1, k + 1), skirtIndex(1, k));
+			addSkirtQuad(gridIndex(0, k + 1), gridIndex(0, k), skirtIndex(2, k + 1), skirtIndex(2, k));
+			addSkirtQuad(gridIndex(tileSize, k), gridIndex(tileSize, k + 1), skirtIndex(3, k), skirtIndex(3, k + 1));
+		}
+		m_TileIndexCount = indices.size();
+
+		glGenBuffers(1, &m_SharedIBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SharedIBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		// The top level is loaded synchronously and pinned so there is always full coverage to fall back on
+		const unsigned int topLevel = m_Header.LevelCount - 1;
+		const TerrainTileLevelInfo &topLevelInfo = m_Levels[topLevel];
+		m_MaxResidentTiles = std::max((size_t)(TERRAIN_TILE_MEMORY_BUDGET / m_TileVertexBufferSize), (size_t)topLevelInfo.TileCountX * topLevelInfo.TileCountZ);
+		for (unsigned int tileZ = 0; tileZ < topLevelInfo.TileCountZ; tileZ++) {
+			for (unsigned int tileX = 0; tileX < topLevelInfo.TileCountX; tileX++) {
+				TerrainTileBuildResult result;
+				result.Request = { topLevel, tileX, tileZ, 0.0f };
+				buildTile(result.Request, result);
+				uploadTile(result, true);
+				m_DrawList.push_back(&m_ResidentTiles[getTileKey(topLevel, tileX, tileZ)]);
+			}
+		}
+
+		m_WorkerThread = std::thread(&TerrainTileStreamer::workerLoop, this);
+		return true;
+	}
+
+	void TerrainTileStreamer::update(const glm::vec3 &localViewerPosition) {
+		if (!m_Levels)
+			return;
+		m_FrameIndex++;
+
+		// Upload a fixed amount of finished tiles per frame so the upload cost stays flat no matter how fast the viewer moves
+		for (unsigned int i = 0; i < TERRAIN_TILE_UPLOADS_PER_FRAME; i++) {
+			TerrainTileBuildResult result;
+			{
+				std::lock_guard<std::mutex> lock(m_CompletedMutex);
+				if (m_CompletedTiles.empty())
+					break;
+				result = std::move(m_CompletedTiles.front());
+				m_CompletedTiles.pop_front();
+			}
+
+			m_PendingTiles.erase(getTileKey(result.Request.Level, result.Request.TileX, result.Request.TileZ));
+			if (makeRoomForTile()) {
+				uploadTile(result, false);
+			}
+		}
+
+		// Drop requests the worker hasn't started on, the selection below queues whatever is still needed in its new order
+		{
+			std::lock_guard<std::mutex> lock(m_RequestMutex);
+			for (const TerrainTileRequest &request : m_RequestQueue) {
+				m_PendingTiles.erase(getTileKey(request.Level, request.TileX, request.TileZ));
+			}
+			m_RequestQueue.clear();
+		}
+
+		// Only request as many tiles as can be made resident, otherwise finished tiles would just be thrown away
+		size_t evictableTileCount = 0;
+		for (const auto &residentTile : m_ResidentTiles) {
+			if (!residentTile.second.Pinned && residentTile.second.LastUsedFrame + 1 < m_FrameIndex)
+				evictableTileCount++;
+		}
+		size_t tileCapacity = m_MaxResidentTiles - m_ResidentTiles.size() + evictableTileCount;
+		size_t requestBudget = tileCapacity > m_PendingTiles.size() ? tileCapacity - m_PendingTiles.size() : 0;
+
+		// Walk the quadtree from the top level, refining wherever all children of a tile are resident
+		m_DrawList.clear();
+		std::vector<TerrainTileRequest> requests;
+		const unsigned int topLevel = m_Header.LevelCount - 1;
+		for (unsigned int tileZ = 0; tileZ < m_Levels[topLevel].TileCountZ; tileZ++) {
+			for (unsigned int tileX = 0; tileX < m_Levels[topLevel].TileCountX; tileX++) {
+				selectTile(m_ResidentTiles[getTileKey(topLevel, tileX, tileZ)], localViewerPosition, requests);
+			}
+		}
+
+		// Coarse tiles first so the terrain refines progressively, then closest first within a level
+		std::sort(requests.begin(), requests.end(), [](const TerrainTileRequest &a, const TerrainTileRequest &b) {
+			if (a.Level != b.Level)
+				return a.Level > b.Level;
+			return a.Priority < b.Priority;
+		});
+		if (requests.size() > requestBudget) {
+			requests.resize(requestBudget);
+		}
+
+		if (!requests.empty()) {
+			{
+				std::lock_guard<std::mutex> lock(m_RequestMutex);
+				for (const TerrainTileRequest &request : requests) {
+					m_PendingTiles.insert(getTileKey(request.Level, request.TileX, request.TileZ));
+					m_RequestQueue.push_back(request);
+				}
+			}
+			m_RequestCondition.notify_one();
+		}
+	}
+
+	void TerrainTileStreamer::draw() const {
+		for (const TerrainTile *tile : m_DrawList) {
+			glBindVertexArray(tile->VAO);
+			glDrawElements(GL_TRIANGLES, m_TileIndexCount, GL_UNSIGNED_INT, 0);
+			RenderStatistics::addDrawCall(m_TileIndexCount / 3);
+		}
+		glBindVertexArray(0);
+	}
+
+	void TerrainTileStreamer::workerLoop() {
+		while (true) {
+			TerrainTileRequest request;
+			{
+				std::unique_lock<std::mutex> lock(m_RequestMutex);
+				m_RequestCondition.wait(lock, [this]() { return m_ShutdownWorker || !m_RequestQueue.empty(); });
+				if (m_ShutdownWorker)
+					return;
+
+				request = m_RequestQueue.front();
+				m_RequestQueue.pop_front();
+			}
+
+			// Reading the tile samples faults the mapped pages in on this thread instead of the GL thread
+			TerrainTileBuildResult result;
+			result.Request = request;
+			buildTile(request, result);
+
+			std::lock_guard<std::mutex> lock(m_CompletedMutex);
+			m_CompletedTiles.push_back(std::move(result));
+		}
+	}
+
+	void TerrainTileStreamer::buildTile(const TerrainTileRequest &request, TerrainTileBuildResult &result) const {
+		const TerrainTileLevelInfo &levelInfo = m_Levels[request.Level];
+		const size_t tileIndex = (size_t)request.TileZ * levelInfo.TileCountX + request.TileX;
+		const uint16_t *samples = (const uint16_t*)(m_HeightmapFile.getData() + levelInfo.DataOffset + tileIndex * getTerrainTileByteSize(m_Header.TileSize));
+
+		const float vertexSpacing = m_SampleSpacing * (float)(1u << request.Level);
+		const glm::vec2 tileOrigin(request.TileX * m_Header.TileSize * vertexSpacing, request.TileZ * m_Header.TileSize * vertexSpacing);
+		buildTileVertices(samples, m_Header.TileSize, vertexSpacing, m_HeightScale, tileOrigin, glm::vec2(getTerrainSizeX(), getTerrainSizeZ()), result);
+
+		// Widen the bounds to the full resolution heights under the tile, which its filtered samples can undershoot
+		const size_t samplesPerTile = (size_t)getTerrainTileSamplesPerSide(m_Header.TileSize) * getTerrainTileSamplesPerSide(m_Header.TileSize);
+		result.MinHeight = std::min(result.MinHeight, (samples[samplesPerTile] / 65535.0f) * m_HeightScale);
+		result.MaxHeight = std::max(result.MaxHeight, (samples[samplesPerTile + 1] / 65535.0f) * m_HeightScale);
+	}
+
+	void TerrainTileStreamer::buildTileVertices(const uint16_t *samples, unsigned int tileSize, float vertexSpacing, float heightScale, const glm::vec2 &tileOrigin, const glm::vec2 &terrainSize, TerrainTileBuildResult &result) {
+		const int samplesPerSide = (int)getTerrainTileSamplesPerSide(tileSize);
+		const int sideVertexCount = (int)tileSize + 1;
+
+		// Sample coordinates are relative to the tile's first vertex, the border allows -1 and tileSize + 1
+		auto sampleHeight = [&](int x, int z) { return (samples[(x + 1) + (z + 1) * samplesPerSide] / 65535.0f) * heightScale; };
+
+		result.VertexData.resize((sideVertexCount * sideVertexCount + 4 * sideVertexCount) * s_TileVertexComponentCount);
+		result.MinHeight = heightScale;
+		result.MaxHeight = 0.0f;
+
+		float *vertex = &result.VertexData[0];
+		for (int z = 0; z < sideVertexCount; z++) {
+			for (int x = 0; x < sideVertexCount; x++) {
+				float height = sampleHeight(x, z);
+				result.MinHeight = std::min(result.MinHeight, height);
+				result.MaxHeight = std::max(result.MaxHeight, height);
+
+				glm::vec2 positionXZ = tileOrigin + glm::vec2(x * vertexSpacing, z * vertexSpacing);
+
+				// Central differences, the border samples make this seamless across tiles of the same level
+				float heightL = sampleHeight(x - 1, z);
+				float heightR = sampleHeight(x + 1, z);
+				float heightD = sampleHeight(x, z - 1);
+				float heightU = sampleHeight(x, z + 1);
+				glm::vec3 normal = glm::normalize(glm::vec3(heightL - heightR, 2.0f * vertexSpacing, heightD - heightU));
+
+				// UVs run along x and z, so the tangent follows the slope in x (Gram-Schmidt to keep it orthogonal to the normal)
+				glm::vec3 tangent = glm::normalize(glm::vec3(2.0f * vertexSpacing, heightR - heightL, 0.0f));
+				tangent = glm::normalize(tangent - glm::dot(tangent, normal) * normal);
+				glm::vec3 bitangent = glm::normalize(glm::cross(normal, tangent));
+
+				glm::vec2 uv = positionXZ / terrainSize;
+
+				*vertex++ = positionXZ.x; *vertex++ = height; *vertex++ = positionXZ.y;
+				*vertex++ = normal.x; *vertex++ = normal.y; *vertex++ = normal.z;
+				*vertex++ = uv.x; *vertex++ = uv.y;
+				*vertex++ = tangent.x; *vertex++ = tangent.y; *vertex++ = tangent.z;
+				*vertex++ = bitangent.x; *vertex++ = bitangent.y; *vertex++ = bitangent.z;
+			}
+		}
+
+		// Skirts copy the edge vertices and push them down far enough to cover the gap to a coarser neighbour
+		const float skirtDepth = (result.MaxHeight - result.MinHeight) * 0.5f + vertexSpacing;
+		auto writeSkirtVertex = [&](int gridX, int gridZ) {
+			const float *source = &result.VertexData[(gridX + gridZ * sideVertexCount) * s_TileVertexComponentCount];
+			memcpy(vertex, source, s_TileVertexComponentCount * sizeof(float));
+			vertex[1] -= skirtDepth;
+			vertex += s_TileVertexComponentCount;
+		};
+		const int lastVertex = sideVertexCount - 1;
+		for (int k = 0; k < sideVertexCount; k++) writeSkirtVertex(k, 0);
+		for (int k = 0; k < sideVertexCount; k++) writeSkirtVertex(k, lastVertex);
+		for (int k = 0; k < sideVertexCount; k++) writeSkirtVertex(0, k);
+		for (int k = 0; k < sideVertexCount; k++) writeSkirtVertex(lastVertex, k);
+		result.MinHeight -= skirtDepth;
+	}
+
+	void TerrainTileStreamer::uploadTile(TerrainTileBuildResult &result, bool pinned) {
+		TerrainTile tile;
+		tile.Level = result.Request.Level;
+		tile.TileX = result.Request.TileX;
+		tile.TileZ = result.Request.TileZ;
+		tile.MinHeight = result.MinHeight;
+		tile.MaxHeight = result.MaxHeight;
+		tile.LastUsedFrame = m_FrameIndex;
+		tile.Pinned = pinned;
+
+		glGenVertexArrays(1, &tile.VAO);
+		glGenBuffers(1, &tile.VBO);
+
+		glBindVertexArray(tile.VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, tile.VBO);
+		glBufferData(GL_ARRAY_BUFFER, m_TileVertexBufferSize, &result.VertexData[0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SharedIBO);
+
+		size_t stride = s_TileVertexComponentCount * sizeof(float);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
+		glEnableVertexAttribArray(4);
+		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)(11 * sizeof(float)));
+		glBindVertexArray(0);
+
+		m_ResidentTiles[getTileKey(tile.Level, tile.TileX, tile.TileZ)] = tile;
+	}
+
+	bool TerrainTileStreamer::makeRoomForTile() {
+		if (m_ResidentTiles.size() < m_MaxResidentTiles)
+			return true;
+
+		// Evict the least recently used tile that wasn't needed by the last selection
+		auto victim = m_ResidentTiles.end();
+		for (auto iter = m_ResidentTiles.begin(); iter != m_ResidentTiles.end(); iter++) {
+			const TerrainTile &tile = iter->second;
+			if (tile.Pinned || tile.LastUsedFrame + 1 >= m_FrameIndex)
+				continue;
+			if (victim == m_ResidentTiles.end() || tile.LastUsedFrame < victim->second.LastUsedFrame)
+				victim = iter;
+		}
+
+		if (victim == m_ResidentTiles.end())
+			return false;
+
+		releaseTile(victim->second);
+		m_ResidentTiles.erase(victim);
+		return true;
+	}
+
+	void TerrainTileStreamer::releaseTile(TerrainTile &tile) {
+		glDeleteVertexArrays(1, &tile.VAO);
+		glDeleteBuffers(1, &tile.VBO);
+		tile.VAO = tile.VBO = 0;
+	}
+
+	void TerrainTileStreamer::selectTile(TerrainTile &tile, const glm::vec3 &localViewerPosition, std::vector<TerrainTileRequest> &requests) {
+		tile.LastUsedFrame = m_FrameIndex;
+
+		if (tile.Level > 0) {
+			float distance = distanceToTile(tile.Level, tile.TileX, tile.TileZ, tile.MinHeight, tile.MaxHeight, localViewerPosition);
+			if (distance < getTileWorldSize(tile.Level) * TERRAIN_LOD_DISTANCE_FACTOR) {
+				std::array<TerrainTile*, 4> children;
+				bool childrenResident = true;
+
+				for (unsigned int i = 0; i < 4; i++) {
+					unsigned int childLevel = tile.Level - 1;
+					unsigned int childX = tile.TileX * 2 + (i & 1);
+					unsigned int childZ = tile.TileZ * 2 + (i >> 1);
+					uint64_t childKey = getTileKey(childLevel, childX, childZ);
+
+					auto iter = m_ResidentTiles.find(childKey);
+					if (iter == m_ResidentTiles.end()) {
+						children[i] = nullptr;
+						childrenResident = false;
+						if (m_PendingTiles.find(childKey) == m_PendingTiles.end()) {
+							requests.push_back({ childLevel, childX, childZ, distanceToTile(childLevel, childX, childZ, tile.MinHeight, tile.MaxHeight, localViewerPosition) });
+						}
+					}
+					else {
+						// Keep the children alive while they are waiting on their siblings
+						children[i] = &iter->second;
+						children[i]->LastUsedFrame = m_FrameIndex;
+					}
+				}
+
+				if (childrenResident) {
+					for (TerrainTile *child : children) {
+						selectTile(*child, localViewerPosition, requests);
+					}
+					return;
+				}
+			}
+		}
+
+		m_DrawList.push_back(&tile);
+	}
+
+	float TerrainTileStreamer::distanceToTile(unsigned int level, unsigned int tileX, unsigned int tileZ, float minHeight, float maxHeight, const glm::vec3 &localViewerPosition) const {
+		float tileWorldSize = getTileWorldSize(level);
+		glm::vec3 boundsMin(tileX * tileWorldSize, minHeight, tileZ * tileWorldSize);
+		glm::vec3 boundsMax(boundsMin.x + tileWorldSize, maxHeight, boundsMin.z + tileWorldSize);
+
+		glm::vec3 delta = glm::max(glm::max(boundsMin - localViewerPosition, localViewerPosition - boundsMax), glm::vec3(0.0f));
+		return glm::length(delta);
+	}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <terrain/TerrainTileFormat.h>
+#include <utils/MemoryMappedFile.h>
+
+namespace arcane {
+
+	struct TerrainTile {
+		unsigned int Level, TileX, TileZ;
+		unsigned int VAO, VBO;
+		float MinHeight, MaxHeight;
+		unsigned long long LastUsedFrame;
+		bool Pinned; // Top level tiles always stay resident so there is always something to draw
+	};
+
+	struct TerrainTileRequest {
+		unsigned int Level, TileX, TileZ;
+		float Priority; // Distance to the viewer, closer tiles of the same level are loaded first
+	};
+
+	struct TerrainTileBuildResult {
+		TerrainTileRequest Request;
+		std::vector<float> VertexData;
+		float MinHeight, MaxHeight;
+	};
+
+	// Streams chunks of a tiled heightmap pyramid around the viewer. Tile meshes are built on a worker thread from the memory
+	// mapped file and handed back to the GL thread, which uploads a fixed amount of them per frame and keeps the resident set
+	// within TERRAIN_TILE_MEMORY_BUDGET by evicting the least recently used tiles
+	class TerrainTileStreamer {
+	public:
+		TerrainTileStreamer();
+		~TerrainTileStreamer();
+
+		bool init(const std::string &tiledHeightmapPath, float sampleSpacing, float heightScale);
+
+		// Uploads finished tiles, selects the tiles to draw for the viewer (in the terrain's local space) and queues missing ones
+		void update(const glm::vec3 &localViewerPosition);
+		void draw() const;
+
+		inline float getTerrainSizeX() const { return (m_Header.SampleCountX - 1) * m_SampleSpacing; }
+		inline float getTerrainSizeZ() const { return (m_Header.SampleCountZ - 1) * m_SampleSpacing; }
+		inline size_t getResidentTileCount() const { return m_ResidentTiles.size(); }
+		inline size_t getResidentBytes() const { return m_ResidentTiles.size() * m_TileVertexBufferSize; }
+
+		// Builds a tile's vertices (grid then skirts) from its (tileSize + 3)^2 bordered height samples. Pure CPU work, it runs on the worker
+		static void buildTileVertices(const uint16_t *samples, unsigned int tileSize, float vertexSpacing, float heightScale, const glm::vec2 &tileOrigin, const glm::vec2 &terrainSize, TerrainTileBuildResult &result);
+	private:
+		void workerLoop();
+
+		void buildTile(const TerrainTileRequest &request, TerrainTileBuildResult &result) const;
+		void uploadTile(TerrainTileBuildResult &result, bool pinned);
+		bool makeRoomForTile();
+		void releaseTile(TerrainTile &tile);
+
+		void selectTile(TerrainTile &tile, const glm::vec3 &localViewerPosition, std::vector<TerrainTileRequest> &requests);
+		float distanceToTile(unsigned int level, unsigned int tileX, unsigned int tileZ, float minHeight, float maxHeight, const glm::vec3 &localViewerPosition) const;
+
+		inline uint64_t getTileKey(unsigned int level, unsigned int tileX, unsigned int tileZ) const { return ((uint64_t)level << 56) | ((uint64_t)tileZ << 28) | (uint64_t)tileX; }
+		inline float getTileWorldSize(unsigned int level) const { return m_Header.TileSize * m_SampleSpacing * (float)(1u << level); }
+	private:
+		MemoryMappedFile m_HeightmapFile;
+		TerrainTileFileHeader m_Header;
+		const TerrainTileLevelInfo *m_Levels;
+
+		float m_SampleSpacing, m_HeightScale;
+		unsigned int m_TileVertexCount, m_TileIndexCount;
+		size_t m_TileVertexBufferSize;
+		size_t m_MaxResidentTiles;
+		unsigned int m_SharedIBO; // Every tile shares the same grid + skirt topology
+
+		unsigned long long m_FrameIndex;
+		std::unordered_map<uint64_t, TerrainTile> m_ResidentTiles;
+		std::set<uint64_t> m_PendingTiles; // Queued or being built by the worker
+		std::vector<const TerrainTile*> m_DrawList;
+
+		// Worker thread state
+		std::thread m_WorkerThread;
+		std::mutex m_RequestMutex, m_CompletedMutex;
+		std::condition_variable m_RequestCondition;
+		std::deque<TerrainTileRequest> m_RequestQueue;
+		std::deque<TerrainTileBuildResult> m_CompletedTiles;
+		bool m_ShutdownWorker;
+	};
+
+}
@@ -0,0 +1,214 @@
+#include "pch.h"
+#include "TerrainVirtualTexture.h"
+
+#include <utils/loaders/ShaderLoader.h>
+
+namespace arcane {
+
+	// Marks a page table slot that holds no page
+	static const glm::ivec2 s_EmptyPageSlot(std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
+
+	TerrainVirtualTexture::TerrainVirtualTexture()
+		: m_AlbedoArray(nullptr), m_NormalArray(nullptr), m_MaterialInfoArray(nullptr), m_BlendMap(nullptr), m_TilingAmount(1.0f), m_TerrainSize(1.0f, 1.0f),
+		m_AlbedoClipmap(nullptr), m_NormalClipmap(nullptr), m_MaterialInfoClipmap(nullptr), m_PageTable(nullptr),
+		m_PagesPerSide(TERRAIN_VIRTUAL_TEXTURE_RESOLUTION / TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE)
+	{
+		m_GLCache = GLCache::getInstance();
+		m_BakeShader = ShaderLoader::loadShader("src/shaders/TerrainVirtualTexture_Bake.glsl");
+
+		m_LevelFramebuffers.fill(0);
+		m_LevelOrigins.fill(glm::ivec2(0, 0));
+		m_PageTableDirty.fill(false);
+	}
+
+	TerrainVirtualTexture::~TerrainVirtualTexture() {
+		for (unsigned int framebuffer : m_LevelFramebuffers) {
+			if (framebuffer)
+				glDeleteFramebuffers(1, &framebuffer);
+		}
+
+		delete m_AlbedoClipmap;
+		delete m_NormalClipmap;
+		delete m_MaterialInfoClipmap;
+		delete m_PageTable;
+	}
+
+	void TerrainVirtualTexture::init(Texture *albedoArray, Texture *normalArray, Texture *materialInfoArray, Texture *blendMap, float tilingAmount, const glm::vec2 &terrainSize) {
+		m_AlbedoArray = albedoArray;
+		m_NormalArray = normalArray;
+		m_MaterialInfoArray = materialInfoArray;
+		m_BlendMap = blendMap;
+		m_TilingAmount = tilingAmount;
+		m_TerrainSize = terrainSize;
+
+		// Clipmap levels are sampled at a fixed texel density so they don't need mips, the geometry pass picks a coarser level instead
+		TextureSettings clipmapSettings;
+		clipmapSettings.TextureMinificationFilterMode = GL_LINEAR;
+		clipmapSettings.TextureAnisotropyLevel = 1.0f;
+		clipmapSettings.HasMips = false;
+
+		clipmapSettings.TextureFormat = GL_SRGB8_ALPHA8;
+		m_AlbedoClipmap = new Texture(clipmapSettings);
+		m_AlbedoClipmap->generate2DArrayTexture(TERRAIN_VIRTUAL_TEXTURE_RESOLUTION, TERRAIN_VIRTUAL_TEXTURE_RESOLUTION, TERRAIN_VIRTUAL_TEXTURE_LEVELS, GL_RGBA);
+
+		clipmapSettings.TextureFormat = GL_RGBA8;
+		m_NormalClipmap = new Texture(clipmapSettings);
+		m_NormalClipmap->generate2DArrayTexture(TERRAIN_VIRTUAL_TEXTURE_RESOLUTION, TERRAIN_VIRTUAL_TEXTURE_RESOLUTION, TERRAIN_VIRTUAL_TEXTURE_LEVELS, GL_RGBA);
+		m_MaterialInfoClipmap = new Texture(clipmapSettings);
+		m_MaterialInfoClipmap->generate2DArrayTexture(TERRAIN_VIRTUAL_TEXTURE_RESOLUTION, TERRAIN_VIRTUAL_TEXTURE_RESOLUTION, TERRAIN_VIRTUAL_TEXTURE_LEVELS, GL_RGBA);
+
+		// Page table starts out empty so every page gets baked on demand
+		m_PageTableData.assign(TERRAIN_VIRTUAL_TEXTURE_LEVELS * m_PagesPerSide * m_PagesPerSide, s_EmptyPageSlot);
+
+		TextureSettings pageTableSettings;
+		pageTableSettings.TextureFormat = GL_RG32I;
+		pageTableSettings.TextureMinificationFilterMode = GL_NEAREST;
+		pageTableSettings.TextureMagnificationFilterMode = GL_NEAREST;
+		pageTableSettings.TextureAnisotropyLevel = 1.0f;
+		pageTableSettings.HasMips = false;
+		m_PageTable = new Texture(pageTableSettings);
+		m_PageTable->generate2DArrayTexture(m_PagesPerSide, m_PagesPerSide, TERRAIN_VIRTUAL_TEXTURE_LEVELS, GL_RG_INTEGER, GL_INT, &m_PageTableData[0]);
+
+		// One framebuffer per level, rendering into that level's layer of all three clipmaps
+		GLenum colourAttachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+		for (unsigned int level = 0; level < TERRAIN_VIRTUAL_TEXTURE_LEVELS; level++) {
+			glGenFramebuffers(1, &m_LevelFramebuffers[level]);
+			glBindFramebuffer(GL_FRAMEBUFFER, m_LevelFramebuffers[level]);
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_AlbedoClipmap->getTextureId(), 0, level);
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, m_NormalClipmap->getTextureId(), 0, level);
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, m_MaterialInfoClipmap->getTextureId(), 0, level);
+			glDrawBuffers(3, colourAttachments);
+
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+				Logger::getInstance().error("logged_files/error.txt", "Terrain Virtual Texture", "Could not create the framebuffer for clipmap level " + std::to_string(level));
+			}
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void TerrainVirtualTexture::update(const glm::vec3 &localViewerPosition) {
+		if (!m_PageTable)
+			return;
+
+		// Centre every level's window of pages on the viewer
+		glm::vec2 viewerXZ(localViewerPosition.x, localViewerPosition.z);
+		for (unsigned int level = 0; level < TERRAIN_VIRTUAL_TEXTURE_LEVELS; level++) {
+			m_LevelOrigins[level] = glm::ivec2(glm::floor(viewerXZ / getPageWorldSize(level))) - glm::ivec2(m_PagesPerSide / 2);
+		}
+
+		// Find the pages inside the windows whose slot holds something else (they scrolled into view or were invalidated)
+		struct PageBakeRequest {
+			unsigned int Level;
+			glm::ivec2 Page;
+			float DistanceToViewer;
+		};
+		std::vector<PageBakeRequest> requests;
+		for (unsigned int level = 0; level < TERRAIN_VIRTUAL_TEXTURE_LEVELS; level++) {
+			float pageWorldSize = getPageWorldSize(level);
+			for (int z = 0; z < m_PagesPerSide; z++) {
+				for (int x = 0; x < m_PagesPerSide; x++) {
+					glm::ivec2 page = m_LevelOrigins[level] + glm::ivec2(x, z);
+					glm::vec2 pageMin = glm::vec2(page) * pageWorldSize;
+					glm::vec2 pageMax = pageMin + pageWorldSize;
+
+					// Pages off the terrain are never sampled
+					if (pageMax.x <= 0.0f || pageMax.y <= 0.0f || pageMin.x >= m_TerrainSize.x || pageMin.y >= m_TerrainSize.y)
+						continue;
+					if (getPageTableEntry(level, getPageSlot(page)) == page)
+						continue;
+
+					requests.push_back({ level, page, glm::length((pageMin + pageMax) * 0.5f - viewerXZ) });
+				}
+			}
+		}
+		if (requests.empty())
+			return;
+
+		// Coarse levels first so the fallback coverage is there as soon as possible, then closest first within a level
+		std::sort(requests.begin(), requests.end(), [](const PageBakeRequest &a, const PageBakeRequest &b) {
+			if (a.Level != b.Level)
+				return a.Level > b.Level;
+			return a.DistanceToViewer < b.DistanceToViewer;
+		});
+		if (requests.size() > TERRAIN_VIRTUAL_TEXTURE_PAGES_PER_FRAME) {
+			requests.resize(TERRAIN_VIRTUAL_TEXTURE_PAGES_PER_FRAME);
+		}
+
+		// Bake state
+		m_GLCache->setDepthTest(false);
+		m_GLCache->setBlend(false);
+		m_GLCache->switchShader(m_BakeShader);
+		glEnable(GL_FRAMEBUFFER_SRGB); // The albedo clipmap is sRGB, so linear results need to be encoded on write
+
+		m_AlbedoArray->bind(0);
+		m_BakeShader->setUniform("material.albedoArray", 0);
+		m_NormalArray->bind(1);
+		m_BakeShader->setUniform("material.normalArray", 1);
+		m_MaterialInfoArray->bind(2);
+		m_BakeShader->setUniform("material.materialInfoArray", 2);
+		m_BlendMap->bind(3);
+		m_BakeShader->setUniform("material.blendmap", 3);
+		m_BakeShader->setUniform("material.tilingAmount", m_TilingAmount);
+		m_BakeShader->setUniform("terrainSize", m_TerrainSize);
+
+		for (const PageBakeRequest &request : requests) {
+			bakePage(request.Level, request.Page);
+		}
+
+		glDisable(GL_FRAMEBUFFER_SRGB);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		m_GLCache->setDepthTest(true);
+
+		// Publish the newly baked pages
+		m_PageTable->bind();
+		for (unsigned int level = 0; level < TERRAIN_VIRTUAL_TEXTURE_LEVELS; level++) {
+			if (!m_PageTableDirty[level])
+				continue;
+
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, level, m_PagesPerSide, m_PagesPerSide, 1, GL_RG_INTEGER, GL_INT, &m_PageTableData[level * m_PagesPerSide * m_PagesPerSide]);
+			m_PageTableDirty[level] = false;
+		}
+		m_PageTable->unbind();
+	}
+
+	void TerrainVirtualTexture::invalidate() {
+		std::fill(m_PageTableData.begin(), m_PageTableData.end(), s_EmptyPageSlot);
+		m_PageTableDirty.fill(true);
+	}
+
+	void TerrainVirtualTexture::bind(Shader *shader, int &currentTextureUnit) const {
+		m_AlbedoClipmap->bind(currentTextureUnit);
+		shader->setUniform("virtualTexture.albedo", currentTextureUnit++);
+		m_NormalClipmap->bind(currentTextureUnit);
+		shader->setUniform("virtualTexture.normal", currentTextureUnit++);
+		m_MaterialInfoClipmap->bind(currentTextureUnit);
+		shader->setUniform("virtualTexture.materialInfo", currentTextureUnit++);
+		m_PageTable->bind(currentTextureUnit);
+		shader->setUniform("virtualTexture.pageTable", currentTextureUnit++);
+
+		for (unsigned int level = 0; level < TERRAIN_VIRTUAL_TEXTURE_LEVELS; level++) {
+			shader->setUniform(("virtualTexture.levelOrigins[" + std::to_string(level) + "]").c_str(), m_LevelOrigins[level]);
+		}
+		shader->setUniform("virtualTexture.pagesPerSide", m_PagesPerSide);
+		shader->setUniform("virtualTexture.pageSize", TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE);
+		shader->setUniform("virtualTexture.texelWorldSize", TERRAIN_VIRTUAL_TEXTURE_TEXEL_SIZE);
+		shader->setUniform("terrainSize", m_TerrainSize);
+	}
+
+	void TerrainVirtualTexture::bakePage(unsigned int level, const glm::ivec2 &page) {
+		float pageWorldSize = getPageWorldSize(level);
+		glm::ivec2 slot = getPageSlot(page);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_LevelFramebuffers[level]);
+		glViewport(slot.x * TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE, slot.y * TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE, TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE, TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE);
+
+		m_BakeShader->setUniform("pageWorldOrigin", glm::vec2(page) * pageWorldSize);
+		m_BakeShader->setUniform("pageWorldSize", pageWorldSize);
+		m_BakeShader->setUniform("texelWorldSize", pageWorldSize / TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE);
+		m_PageQuad.Draw();
+
+		getPageTableEntry(level, slot) = page;
+		m_PageTableDirty[level] = true;
+	}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <graphics/Shader.h>
+#include <graphics/mesh/common/Quad.h>
+#include <graphics/renderer/GLCache.h>
+#include <graphics/texture/Texture.h>
+
+namespace arcane {
+
+	// Runtime virtual texture for the terrain's splatted material. The blended albedo, normal and material info are baked into
+	// clipmap levels centred on the viewer (level n covers 2^n times the area of level 0 at the same resolution). Each level is
+	// toroidally addressed in pages, so moving the viewer only re-bakes the pages that scrolled into view. A page table tells the
+	// geometry pass which world page currently lives in each slot, anything not resident falls back to splatting
+	class TerrainVirtualTexture {
+	public:
+		TerrainVirtualTexture();
+		~TerrainVirtualTexture();
+
+		void init(Texture *albedoArray, Texture *normalArray, Texture *materialInfoArray, Texture *blendMap, float tilingAmount, const glm::vec2 &terrainSize);
+
+		// Re-centres the clipmap on the viewer (in the terrain's local space) and bakes missing pages within the per frame budget
+		void update(const glm::vec3 &localViewerPosition);
+		void invalidate(); // Marks every page stale so it gets re-baked, needed if the splat textures change
+
+		void bind(Shader *shader, int &currentTextureUnit) const;
+	private:
+		void bakePage(unsigned int level, const glm::ivec2 &page);
+
+		inline float getPageWorldSize(unsigned int level) const { return TERRAIN_VIRTUAL_TEXTURE_PAGE_SIZE * TERRAIN_VIRTUAL_TEXTURE_TEXEL_SIZE * (float)(1u << level); }
+		inline glm::ivec2 getPageSlot(const glm::ivec2 &page) const { return glm::ivec2(((page.x % m_PagesPerSide) + m_PagesPerSide) % m_PagesPerSide, ((page.y % m_PagesPerSide) + m_PagesPerSide) % m_PagesPerSide); }
+		inline glm::ivec2& getPageTableEntry(unsigned int level, const glm::ivec2 &slot) { return m_PageTableData[level * m_PagesPerSide * m_PagesPerSide + slot.y * m_PagesPerSide + slot.x]; }
+	private:
+		GLCache *m_GLCache;
+		Shader *m_BakeShader;
+		Quad m_PageQuad;
+
+		// Splat sources
+		Texture *m_AlbedoArray, *m_NormalArray, *m_MaterialInfoArray, *m_BlendMap;
+		float m_TilingAmount;
+		glm::vec2 m_TerrainSize;
+
+		// Clipmap (one array layer per level)
+		Texture *m_AlbedoClipmap, *m_NormalClipmap, *m_MaterialInfoClipmap;
+		Texture *m_PageTable; // Stores the world page held by every slot of every level
+		std::array<unsigned int, TERRAIN_VIRTUAL_TEXTURE_LEVELS> m_LevelFramebuffers;
+		std::array<glm::ivec2, TERRAIN_VIRTUAL_TEXTURE_LEVELS> m_LevelOrigins; // First page of each level's window
+		std::array<bool, TERRAIN_VIRTUAL_TEXTURE_LEVELS> m_PageTableDirty;
+		std::vector<glm::ivec2> m_PageTableData;
+		int m_PagesPerSide;
+	};
+
+}
@@ -1,13 +1,13 @@
 #include "pch.h"
 #include "RuntimePane.h"
 
-namespace arcane {
+#include <graphics/renderer/GPUProfiler.h>
+#include <graphics/renderer/RenderStatistics.h>
+#include <utils/FrameStatistics.h>
 
-	float RuntimePane::s_ShadowmapTimer = 0.0f;
-	float RuntimePane::s_SsaoTimer = 0.0f;
-	float RuntimePane::s_FxaaTimer = 0.0f;
+namespace arcane {
 
-	RuntimePane::RuntimePane(glm::vec2 &panePosition) : Pane(std::string("Runtime Analytics"), panePosition), m_ValueOffset(0), m_MaxFrametime(0), m_Frametimes()
+	RuntimePane::RuntimePane(glm::vec2 &panePosition) : Pane(std::string("Runtime Analytics"), panePosition)
 	{
 	}
 
@@ -15,17 +15,49 @@ namespace arcane {
 		float frametime = 1000.0f / ImGui::GetIO().Framerate;
 		ImGui::Text("Frametime: %.3f ms (FPS %.1f)", frametime, ImGui::GetIO().Framerate);
 #if DEBUG_ENABLED
-		if (frametime > m_MaxFrametime) {
-			m_MaxFrametime = frametime;
+		FrameTimePercentiles frameTimes = FrameStatistics::getFrameTimes().getPercentiles();
+		const std::array<float, FRAME_STATISTICS_PLOT_FRAMES> &recentFrameTimes = FrameStatistics::getRecentFrameTimes();
+		ImGui::PlotLines("", &recentFrameTimes[0], recentFrameTimes.size(), FrameStatistics::getRecentFrameTimesOffset(), (const char*)0, 0.0f, (float)frameTimes.Max + 1.0f, ImVec2(255, 70));
+		ImGui::Text("p50 %.2f  p95 %.2f  p99 %.2f  p99.9 %.2f ms", frameTimes.P50, frameTimes.P95, frameTimes.P99, frameTimes.P999);
+		ImGui::Text("GPU Bound: %.0f%%  Stutters: %u (%llu total)", 100.0f * FrameStatistics::getGPUBoundFraction(), FrameStatistics::getWindowStutterCount(), (unsigned long long)FrameStatistics::getStutterCount());
+		if (ImGui::Button("Export CSV")) {
+			FrameStatistics::exportCSV();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Export JSON")) {
+			FrameStatistics::exportJSON();
+		}
+#endif
+
+#if GPU_PROFILER_ENABLED
+		// Latest GPU pass timings, with the p99 of each over the statistics window
+		ImGui::Text("GPU Frame: %.3f ms", GPUProfiler::getFrameTime());
+		const std::map<std::string, RollingHistogram> &passTimes = FrameStatistics::getPassTimes();
+		for (const GPUPassTiming &timing : GPUProfiler::getPassTimings()) {
+			auto passTime = passTimes.find(timing.Name);
+			double p99 = passTime != passTimes.end() ? passTime->second.getQuantile(0.99) : 0.0;
+			ImGui::Text("%*s%s: %.3f ms (p99 %.3f)", timing.Depth * 2, "", timing.Name, timing.Milliseconds, p99);
+		}
+#endif
+
+		const RenderCounters &counters = RenderStatistics::getCounters();
+		ImGui::Text("Draw Calls: %llu  Triangles: %llu", (unsigned long long)counters.DrawCalls, (unsigned long long)counters.Triangles);
+		ImGui::Text("Shader Switches: %llu  State Changes: %llu", (unsigned long long)counters.ShaderSwitches, (unsigned long long)counters.StateChanges);
+
+#if PROFILER_ENABLED
+		if (Profiler::isCapturing()) {
+			ImGui::Text("Capturing CPU profile...");
+		}
+		else if (ImGui::Button("Capture CPU Profile")) {
+			Profiler::requestCapture();
+		}
+		bool spikeCapture = Profiler::getSpikeCaptureEnabled();
+		if (ImGui::Checkbox("Capture Frame Spikes", &spikeCapture)) {
+			Profiler::setSpikeCaptureEnabled(spikeCapture);
+		}
+		if (!Profiler::getLastCapturePath().empty()) {
+			ImGui::Text("Last Capture: %s", Profiler::getLastCapturePath().c_str());
 		}
-		
-		m_ValueOffset = (m_ValueOffset + 1) % m_Frametimes.size();
-		m_Frametimes[m_ValueOffset] = frametime;
-		ImGui::PlotLines("", &m_Frametimes[0], m_Frametimes.size(), m_ValueOffset, (const char*)0, 0.0f, m_MaxFrametime + 1.0f, ImVec2(255, 70));
-
-		ImGui::Text("Shadowmap Generation: %.6f ms", 1000.0f * s_ShadowmapTimer);
-		ImGui::Text("SSAO Generation: %.6f ms", 1000.0f * s_SsaoTimer);
-		ImGui::Text("FXAA: %.6f ms", 1000.0f * s_FxaaTimer);
 #endif
 	}
 
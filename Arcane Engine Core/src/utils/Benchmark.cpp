@@ -0,0 +1,291 @@
+#include "pch.h"
+#include "Benchmark.h"
+
+#include <graphics/Window.h>
+#include <graphics/camera/CameraPath.h>
+#include <graphics/renderer/GPUProfiler.h>
+#include <graphics/renderer/MasterRenderer.h>
+#include <graphics/renderer/RenderStatistics.h>
+#include <graphics/texture/TextureStreamer.h>
+#include <scene/Scene3D.h>
+#include <utils/loaders/AssetManager.h>
+
+namespace arcane {
+
+	static void addTiming(std::vector<std::pair<std::string, double>> &timings, const char *name, double milliseconds) {
+		for (std::pair<std::string, double> &timing : timings) {
+			if (timing.first == name) {
+				timing.second += milliseconds;
+				return;
+			}
+		}
+		timings.push_back(std::make_pair(std::string(name), milliseconds));
+	}
+
+	static void writeEscaped(std::ostream &output, const std::string &text) {
+		for (char character : text) {
+			if (character == '"' || character == '\\')
+				output << '\\';
+			output << character;
+		}
+	}
+
+	// Exact percentiles, a benchmark keeps every sample so there is no need to estimate
+	static void writePercentiles(std::ostream &output, std::vector<double> values) {
+		std::sort(values.begin(), values.end());
+		auto percentile = [&values](double quantile) {
+			return values.empty() ? 0.0 : values[std::min(values.size() - 1, (size_t)std::ceil(quantile * values.size()) - (quantile > 0.0 ? 1 : 0))];
+		};
+
+		double sum = 0.0;
+		for (double value : values) {
+			sum += value;
+		}
+		output << "{\"samples\":" << values.size() << ",\"mean\":" << (values.empty() ? 0.0 : sum / values.size());
+		output << ",\"p50\":" << percentile(0.5) << ",\"p95\":" << percentile(0.95) << ",\"p99\":" << percentile(0.99) << ",\"p99.9\":" << percentile(0.999);
+		output << ",\"max\":" << (values.empty() ? 0.0 : values.back()) << "}";
+	}
+
+	bool Benchmark::isRequested(int argc, char **argv) {
+		for (int i = 1; i < argc; ++i) {
+			if (strcmp(argv[i], "--benchmark") == 0)
+				return true;
+		}
+		return false;
+	}
+
+	int Benchmark::run(int argc, char **argv) {
+		BenchmarkSettings settings;
+		if (!parseArguments(argc, argv, settings)) {
+			std::cout << "Usage: --benchmark [--scene name] [--camera-path file] [--frames n] [--warmup n] [--resolution WxH] [--output file]" << std::endl;
+			return 1;
+		}
+
+		CameraPath cameraPath;
+		if (!cameraPath.load(settings.CameraPathFile)) {
+			std::cout << "Couldn't load camera path: " << settings.CameraPathFile << std::endl;
+			return 1;
+		}
+
+		// Same startup as the interactive engine, minus the UI
+		Window window("Arcane Engine Benchmark", settings.Width, settings.Height, true);
+#if GPU_PROFILER_ENABLED
+		GPUProfiler::init();
+#endif
+		TextureLoader::initializeDefaultTextures();
+		std::vector<BenchmarkFrame> frames(settings.FrameCount);
+		{
+			Scene3D scene(&window, settings.SceneName);
+			MasterRenderer renderer(&scene);
+			AssetManager::finishAsyncLoads();
+			TextureLoader::finishAsyncLoads();
+			renderer.init();
+
+			// GPU timings are read back a few frames late, the callback files them under the frame they belong to
+			uint64_t firstGPUFrame = std::numeric_limits<uint64_t>::max();
+			GPUProfiler::setWaitForResults(true);
+			GPUProfiler::setResolveCallback([&frames, &firstGPUFrame](uint64_t frameIndex, double frameMilliseconds, const std::vector<GPUPassTiming> &passTimings) {
+				if (frameIndex < firstGPUFrame || frameIndex - firstGPUFrame >= frames.size())
+					return;
+
+				BenchmarkFrame &frame = frames[(size_t)(frameIndex - firstGPUFrame)];
+				frame.GPUMilliseconds = frameMilliseconds;
+				for (const GPUPassTiming &timing : passTimings) {
+					addTiming(frame.GPUPasses, timing.Name, timing.Milliseconds);
+				}
+			});
+
+			float pathStep = cameraPath.getDuration() / std::max(settings.FrameCount - 1, 1u);
+			std::vector<ProfilerEvent> zones;
+			for (unsigned int i = 0; i < settings.WarmupFrameCount + settings.FrameCount; ++i) {
+				bool measured = i >= settings.WarmupFrameCount;
+				unsigned int frameIndex = measured ? i - settings.WarmupFrameCount : 0;
+
+				uint64_t frameStart = Profiler::getTimestamp();
+#if GPU_PROFILER_ENABLED
+				GPUProfiler::beginFrame();
+				if (i == settings.WarmupFrameCount)
+					firstGPUFrame = GPUProfiler::getFrameIndex();
+#endif
+				RenderStatistics::reset();
+				cameraPath.apply(*scene.getCamera(), frameIndex * pathStep);
+
+				Window::bind();
+				Window::clear();
+				AssetManager::update();
+				TextureLoader::updateAsyncLoads();
+				scene.onUpdate(pathStep);
+				renderer.render();
+#if GPU_PROFILER_ENABLED
+				GPUProfiler::endFrame();
+#endif
+				uint64_t cpuEnd = Profiler::getTimestamp();
+				window.update();
+				uint64_t frameEnd = Profiler::getTimestamp();
+
+				if (!measured)
+					continue;
+
+				BenchmarkFrame &frame = frames[frameIndex];
+				frame.FrameMilliseconds = (frameEnd - frameStart) / 1000000.0;
+				frame.CPUMilliseconds = (cpuEnd - frameStart) / 1000000.0;
+				const RenderCounters &counters = RenderStatistics::getCounters();
+				frame.DrawCalls = counters.DrawCalls;
+				frame.Triangles = counters.Triangles;
+				frame.ShaderSwitches = counters.ShaderSwitches;
+				frame.StateChanges = counters.StateChanges;
+
+				Profiler::getThreadZones(frameStart, cpuEnd, zones);
+				for (const ProfilerEvent &zone : zones) {
+					addTiming(frame.CPUZones, zone.Name, (zone.End - zone.Start) / 1000000.0);
+				}
+			}
+
+			GPUProfiler::flush();
+			GPUProfiler::setResolveCallback(nullptr);
+			GPUProfiler::setWaitForResults(false);
+		}
+
+		bool written = writeResults(settings, frames);
+
+#if GPU_PROFILER_ENABLED
+		GPUProfiler::shutdown();
+#endif
+		TextureLoader::shutdownAsyncLoading();
+		AssetManager::shutdown();
+		TextureStreamer::shutdown();
+		return written ? 0 : 1;
+	}
+
+	bool Benchmark::parseArguments(int argc, char **argv, BenchmarkSettings &outSettings) {
+		for (int i = 1; i < argc; ++i) {
+			std::string argument = argv[i];
+			if (argument == "--benchmark")
+				continue;
+			if (i + 1 >= argc)
+				return false;
+
+			std::string value = argv[++i];
+			if (argument == "--scene") {
+				outSettings.SceneName = value;
+			}
+			else if (argument == "--camera-path") {
+				outSettings.CameraPathFile = value;
+			}
+			else if (argument == "--output") {
+				outSettings.OutputFile = value;
+			}
+			else if (argument == "--frames") {
+				int frames = atoi(value.c_str());
+				if (frames <= 0)
+					return false;
+				outSettings.FrameCount = (unsigned int)frames;
+			}
+			else if (argument == "--warmup") {
+				int frames = atoi(value.c_str());
+				if (frames < 0)
+					return false;
+				outSettings.WarmupFrameCount = (unsigned int)frames;
+			}
+			else if (argument == "--resolution") {
+				if (sscanf(value.c_str(), "%dx%d", &outSettings.Width, &outSettings.Height) != 2 || outSettings.Width <= 0 || outSettings.Height <= 0)
+					return false;
+			}
+			else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Benchmark::writeResults(const BenchmarkSettings &settings, const std::vector<BenchmarkFrame> &frames) {
+		std::ofstream output(settings.OutputFile, std::ios::out | std::ios::trunc);
+		if (!output) {
+			Logger::getInstance().error("logged_files/benchmark.txt", "benchmark", "Couldn't create results: " + settings.OutputFile);
+			return false;
+		}
+
+		const char *glRenderer = (const char*)glGetString(GL_RENDERER);
+		const char *glVersion = (const char*)glGetString(GL_VERSION);
+		output << "{\n\t\"scene\": \"";
+		writeEscaped(output, settings.SceneName);
+		output << "\",\n\t\"camera_path\": \"";
+		writeEscaped(output, settings.CameraPathFile);
+		output << "\",\n\t\"gl_renderer\": \"";
+		writeEscaped(output, glRenderer ? glRenderer : "");
+		output << "\",\n\t\"gl_version\": \"";
+		writeEscaped(output, glVersion ? glVersion : "");
+		output << "\",\n\t\"resolution\": [" << settings.Width << ", " << settings.Height << "],\n";
+		output << "\t\"warmup_frames\": " << settings.WarmupFrameCount << ",\n\t\"frame_count\": " << frames.size() << ",\n";
+
+		// Summary over every measured frame
+		std::vector<double> frameTimes, cpuTimes, gpuTimes;
+		std::map<std::string, std::vector<double>> cpuZoneTimes, gpuPassTimes;
+		for (const BenchmarkFrame &frame : frames) {
+			frameTimes.push_back(frame.FrameMilliseconds);
+			cpuTimes.push_back(frame.CPUMilliseconds);
+			gpuTimes.push_back(frame.GPUMilliseconds);
+			for (const std::pair<std::string, double> &zone : frame.CPUZones) {
+				cpuZoneTimes[zone.first].push_back(zone.second);
+			}
+			for (const std::pair<std::string, double> &pass : frame.GPUPasses) {
+				gpuPassTimes[pass.first].push_back(pass.second);
+			}
+		}
+		output << "\t\"summary\": {\n\t\t\"frame\": ";
+		writePercentiles(output, frameTimes);
+		output << ",\n\t\t\"cpu\": ";
+		writePercentiles(output, cpuTimes);
+		output << ",\n\t\t\"gpu\": ";
+		writePercentiles(output, gpuTimes);
+		output << ",\n\t\t\"cpu_zones\": {";
+		bool first = true;
+		for (const std::pair<const std::string, std::vector<double>> &zone : cpuZoneTimes) {
+			output << (first ? "\n\t\t\t\"" : ",\n\t\t\t\"");
+			writeEscaped(output, zone.first);
+			output << "\": ";
+			writePercentiles(output, zone.second);
+			first = false;
+		}
+		output << "\n\t\t},\n\t\t\"gpu_passes\": {";
+		first = true;
+		for (const std::pair<const std::string, std::vector<double>> &pass : gpuPassTimes) {
+			output << (first ? "\n\t\t\t\"" : ",\n\t\t\t\"");
+			writeEscaped(output, pass.first);
+			output << "\": ";
+			writePercentiles(output, pass.second);
+			first = false;
+		}
+		output << "\n\t\t}\n\t},\n";
+
+		// Every frame
+		output << "\t\"frames\": [";
+		for (size_t i = 0; i < frames.size(); ++i) {
+			const BenchmarkFrame &frame = frames[i];
+			output << (i == 0 ? "\n\t\t{" : ",\n\t\t{") << "\"frame\":" << i << ",\"frame_ms\":" << frame.FrameMilliseconds << ",\"cpu_ms\":" << frame.CPUMilliseconds << ",\"gpu_ms\":" << frame.GPUMilliseconds;
+			output << ",\"draw_calls\":" << frame.DrawCalls << ",\"triangles\":" << frame.Triangles << ",\"shader_switches\":" << frame.ShaderSwitches << ",\"state_changes\":" << frame.StateChanges;
+
+			output << ",\"cpu_zones\":{";
+			for (size_t j = 0; j < frame.CPUZones.size(); ++j) {
+				output << (j == 0 ? "\"" : ",\"");
+				writeEscaped(output, frame.CPUZones[j].first);
+				output << "\":" << frame.CPUZones[j].second;
+			}
+			output << "},\"gpu_passes\":{";
+			for (size_t j = 0; j < frame.GPUPasses.size(); ++j) {
+				output << (j == 0 ? "\"" : ",\"");
+				writeEscaped(output, frame.GPUPasses[j].first);
+				output << "\":" << frame.GPUPasses[j].second;
+			}
+			output << "}}";
+		}
+		output << "\n\t]\n}\n";
+
+		if (!output) {
+			Logger::getInstance().error("logged_files/benchmark.txt", "benchmark", "Couldn't write results: " + settings.OutputFile);
+			return false;
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace arcane {
+
+	struct BenchmarkSettings {
+		std::string SceneName = "default";
+		std::string CameraPathFile = BENCHMARK_DEFAULT_CAMERA_PATH;
+		std::string OutputFile = BENCHMARK_DEFAULT_OUTPUT_PATH;
+		unsigned int FrameCount = BENCHMARK_DEFAULT_FRAMES, WarmupFrameCount = BENCHMARK_WARMUP_FRAMES;
+		int Width = BENCHMARK_RESOLUTION_X, Height = BENCHMARK_RESOLUTION_Y;
+	};
+
+	struct BenchmarkFrame {
+		double FrameMilliseconds, CPUMilliseconds, GPUMilliseconds;
+		uint64_t DrawCalls, Triangles, ShaderSwitches, StateChanges;
+		std::vector<std::pair<std::string, double>> CPUZones; // Main thread profiler zones, summed by name
+		std::vector<std::pair<std::string, double>> GPUPasses;
+	};
+
+	// Renders a scene offscreen along a recorded camera path for a fixed number of frames, at a fixed resolution with v-sync off, and
+	// writes every frame's CPU/GPU timings and render counters to JSON. Run with:
+	//   --benchmark [--scene name] [--camera-path file] [--frames n] [--warmup n] [--resolution WxH] [--output file]
+	// The camera moves by frame rather than by time, so every run renders exactly the same frames
+	class Benchmark {
+	public:
+		static bool isRequested(int argc, char **argv);
+		static int run(int argc, char **argv); // Returns the process exit code
+	private:
+		static bool parseArguments(int argc, char **argv, BenchmarkSettings &outSettings);
+		static bool writeResults(const BenchmarkSettings &settings, const std::vector<BenchmarkFrame> &frames);
+	};
+
+}
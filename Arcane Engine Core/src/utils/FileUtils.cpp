@@ -1,16 +1,22 @@
 #include "pch.h"
 #include "FileUtils.h"
 
+#include <utils/VirtualFileSystem.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 namespace arcane {
 
 	std::string FileUtils::readFile(const std::string &filepath) {
-		std::ifstream ifs(filepath, std::ios::in, std::ios::binary);
+		VirtualFile file;
 		std::string result;
 
-		if (ifs) {
-			result = std::string((std::istreambuf_iterator<char>(ifs)),
-				(std::istreambuf_iterator<char>()));
-			ifs.close();
+		if (VirtualFileSystem::openFile(filepath, file)) {
+			result = std::string(reinterpret_cast<const char*>(file.getData()), file.getSize());
 		}
 		else {
 			Logger::getInstance().warning("logged_files/error.txt", "Could Not Read File", filepath);
@@ -19,4 +25,28 @@ namespace arcane {
 		return result;
 	}
 
+	void FileUtils::createDirectories(const std::string &path) {
+		for (size_t i = 0; i < path.size(); i++) {
+			if (path[i] != '/' && i + 1 != path.size())
+				continue;
+
+			std::string directory = path.substr(0, i + 1);
+#ifdef _WIN32
+			_mkdir(directory.c_str());
+#else
+			mkdir(directory.c_str(), 0755);
+#endif
+		}
+	}
+
+	uint64_t FileUtils::hashFNV1a(const void *data, size_t size, uint64_t basis) {
+		const unsigned char *bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = basis;
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
 }
@@ -5,6 +5,13 @@ namespace arcane {
 	class FileUtils {
 	public:
 		static std::string readFile(const std::string &filepath);
+
+		// Creates every directory along the path, ones that already exist are skipped
+		static void createDirectories(const std::string &path);
+
+		// 64 bit FNV-1a, pass a previous hash in as the basis to hash several pieces of data together
+		static const uint64_t FNV1aOffsetBasis = 14695981039346656037ull;
+		static uint64_t hashFNV1a(const void *data, size_t size, uint64_t basis = FNV1aOffsetBasis);
 	};
 
 } 
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "pch.h"
+#include "FrameStatistics.h"
+
+#include <graphics/renderer/GPUProfiler.h>
+#include <utils/FileUtils.h>
+
+namespace arcane {
+
+	constexpr double RollingHistogram::MinMilliseconds;
+
+	RollingHistogram::RollingHistogram() {
+		clear();
+	}
+
+	void RollingHistogram::addSample(double milliseconds) {
+		unsigned int bucket = getBucket(milliseconds);
+		if (m_SampleCount == FRAME_STATISTICS_WINDOW) {
+			--m_Buckets[m_Window[m_WindowHead]];
+		}
+		else {
+			++m_SampleCount;
+		}
+		m_Window[m_WindowHead] = (uint16_t)bucket;
+		++m_Buckets[bucket];
+		m_WindowHead = (m_WindowHead + 1) % FRAME_STATISTICS_WINDOW;
+	}
+
+	void RollingHistogram::clear() {
+		m_Buckets.fill(0);
+		m_WindowHead = 0;
+		m_SampleCount = 0;
+	}
+
+	double RollingHistogram::getQuantile(double quantile) const {
+		if (m_SampleCount == 0)
+			return 0.0;
+
+		unsigned int targetRank = std::max(1u, (unsigned int)std::ceil(quantile * m_SampleCount));
+		unsigned int rank = 0;
+		for (unsigned int bucket = 0; bucket < BucketCount; ++bucket) {
+			rank += m_Buckets[bucket];
+			if (rank >= targetRank) {
+				// Geometric middle of the bucket, the error is then at most half a bucket either way
+				return MinMilliseconds * std::pow(2.0, (bucket + 0.5) / BucketsPerOctave);
+			}
+		}
+		return getBucketLowerBound(BucketCount - 1);
+	}
+
+	FrameTimePercentiles RollingHistogram::getPercentiles() const {
+		FrameTimePercentiles percentiles;
+		percentiles.P50 = getQuantile(0.5);
+		percentiles.P95 = getQuantile(0.95);
+		percentiles.P99 = getQuantile(0.99);
+		percentiles.P999 = getQuantile(0.999);
+		percentiles.Max = 0.0;
+		percentiles.SampleCount = m_SampleCount;
+		for (unsigned int bucket = BucketCount; bucket-- > 0;) {
+			if (m_Buckets[bucket] > 0) {
+				percentiles.Max = getBucketLowerBound(bucket + 1);
+				break;
+			}
+		}
+		return percentiles;
+	}
+
+	unsigned int RollingHistogram::getBucket(double milliseconds) {
+		if (!(milliseconds > MinMilliseconds))
+			return 0;
+
+		double bucket = std::floor(std::log2(milliseconds / MinMilliseconds) * BucketsPerOctave);
+		return bucket < BucketCount ? (unsigned int)bucket : BucketCount - 1;
+	}
+
+	double RollingHistogram::getBucketLowerBound(unsigned int bucket) {
+		return bucket == 0 ? 0.0 : MinMilliseconds * std::pow(2.0, (double)bucket / BucketsPerOctave);
+	}
+
+	// Static declarations
+	RollingHistogram FrameStatistics::s_FrameTimes, FrameStatistics::s_CPUTimes, FrameStatistics::s_GPUTimes;
+	std::map<std::string, RollingHistogram> FrameStatistics::s_PassTimes;
+	std::array<uint8_t, FRAME_STATISTICS_WINDOW> FrameStatistics::s_FrameFlags;
+	unsigned int FrameStatistics::s_FrameFlagsHead = 0, FrameStatistics::s_WindowGPUBoundCount = 0, FrameStatistics::s_WindowStutterCount = 0;
+	uint64_t FrameStatistics::s_FrameCount = 0, FrameStatistics::s_StutterCount = 0, FrameStatistics::s_LastGPUFrame = std::numeric_limits<uint64_t>::max();
+	std::array<float, FRAME_STATISTICS_PLOT_FRAMES> FrameStatistics::s_RecentFrameTimes;
+	unsigned int FrameStatistics::s_RecentFrameTimesHead = 0;
+	double FrameStatistics::s_FrameStart = 0.0, FrameStatistics::s_LastCPUTime = 0.0;
+
+	void FrameStatistics::beginFrame() {
+		// The previous frame is only complete once this one starts, so that is when it is recorded
+		double now = glfwGetTime();
+		if (s_FrameStart > 0.0) {
+			recordFrame((now - s_FrameStart) * 1000.0, s_LastCPUTime);
+		}
+		s_FrameStart = now;
+	}
+
+	void FrameStatistics::endFrame() {
+		s_LastCPUTime = (glfwGetTime() - s_FrameStart) * 1000.0;
+	}
+
+	void FrameStatistics::reset() {
+		s_FrameTimes.clear();
+		s_CPUTimes.clear();
+		s_GPUTimes.clear();
+		s_PassTimes.clear();
+		s_FrameFlagsHead = 0;
+		s_WindowGPUBoundCount = 0;
+		s_WindowStutterCount = 0;
+		s_FrameCount = 0;
+		s_StutterCount = 0;
+		s_RecentFrameTimes.fill(0.0f);
+		s_RecentFrameTimesHead = 0;
+	}
+
+	float FrameStatistics::getGPUBoundFraction() {
+		unsigned int frameCount = (unsigned int)std::min<uint64_t>(s_FrameCount, FRAME_STATISTICS_WINDOW);
+		return frameCount > 0 ? (float)s_WindowGPUBoundCount / frameCount : 0.0f;
+	}
+
+	std::string FrameStatistics::exportCSV() {
+		std::string path = getExportPath(".csv");
+		std::ofstream output(path, std::ios::out | std::ios::trunc);
+		if (!output) {
+			Logger::getInstance().error("logged_files/profiler.txt", "frame statistics", "Couldn't create export: " + path);
+			return std::string();
+		}
+
+		auto writeSeries = [&output](const std::string &name, const RollingHistogram &histogram) {
+			FrameTimePercentiles percentiles = histogram.getPercentiles();
+			output << '"' << name << "\"," << percentiles.SampleCount << ',' << percentiles.P50 << ',' << percentiles.P95 << ',' << percentiles.P99 << ',' << percentiles.P999 << ',' << percentiles.Max << '\n';
+		};
+
+		output << "series,samples,p50_ms,p95_ms,p99_ms,p99.9_ms,max_ms\n";
+		writeSeries("frame", s_FrameTimes);
+		writeSeries("cpu", s_CPUTimes);
+		writeSeries("gpu", s_GPUTimes);
+		for (const std::pair<const std::string, RollingHistogram> &pass : s_PassTimes) {
+			writeSeries("pass:" + pass.first, pass.second);
+		}
+
+		if (!output) {
+			Logger::getInstance().error("logged_files/profiler.txt", "frame statistics", "Couldn't write export: " + path);
+			return std::string();
+		}
+		return path;
+	}
+
+	std::string FrameStatistics::exportJSON() {
+		std::string path = getExportPath(".json");
+		std::ofstream output(path, std::ios::out | std::ios::trunc);
+		if (!output) {
+			Logger::getInstance().error("logged_files/profiler.txt", "frame statistics", "Couldn't create export: " + path);
+			return std::string();
+		}
+
+		bool firstSeries = true;
+		auto writeSeries = [&output, &firstSeries](const std::string &name, const RollingHistogram &histogram) {
+			FrameTimePercentiles percentiles = histogram.getPercentiles();
+			output << (firstSeries ? "\n" : ",\n") << "\t\t{\"name\":\"" << name << "\",\"samples\":" << percentiles.SampleCount;
+			output << ",\"p50\":" << percentiles.P50 << ",\"p95\":" << percentiles.P95 << ",\"p99\":" << percentiles.P99 << ",\"p99.9\":" << percentiles.P999 << ",\"max\":" << percentiles.Max;
+
+			// Only the buckets with samples in them, as [lower bound, upper bound, count]
+			output << ",\"histogram\":[";
+			bool firstBucket = true;
+			for (unsigned int bucket = 0; bucket < RollingHistogram::BucketCount; ++bucket) {
+				if (histogram.getBucketSampleCount(bucket) == 0)
+					continue;
+
+				output << (firstBucket ? "" : ",") << '[' << RollingHistogram::getBucketLowerBound(bucket) << ',' << RollingHistogram::getBucketLowerBound(bucket + 1) << ',' << histogram.getBucketSampleCount(bucket) << ']';
+				firstBucket = false;
+			}
+			output << "]}";
+			firstSeries = false;
+		};
+
+		output << "{\n\t\"frames\": " << s_FrameCount << ",\n\t\"window\": " << FRAME_STATISTICS_WINDOW << ",\n";
+		output << "\t\"stutters\": " << s_StutterCount << ",\n\t\"window_stutters\": " << s_WindowStutterCount << ",\n";
+		output << "\t\"gpu_bound_fraction\": " << getGPUBoundFraction() << ",\n";
+		output << "\t\"series\": [";
+		writeSeries("frame", s_FrameTimes);
+		writeSeries("cpu", s_CPUTimes);
+		writeSeries("gpu", s_GPUTimes);
+		for (const std::pair<const std::string, RollingHistogram> &pass : s_PassTimes) {
+			writeSeries("pass:" + pass.first, pass.second);
+		}
+		output << "\n\t]\n}\n";
+
+		if (!output) {
+			Logger::getInstance().error("logged_files/profiler.txt", "frame statistics", "Couldn't write export: " + path);
+			return std::string();
+		}
+		return path;
+	}
+
+	void FrameStatistics::recordFrame(double frameMilliseconds, double cpuMilliseconds) {
+		// Stutters are judged against the median before the frame is added, a run of slow frames keeps counting until it is the norm
+		bool stutter = s_FrameTimes.getSampleCount() >= FRAME_STATISTICS_STUTTER_MIN_FRAMES && frameMilliseconds > s_FrameTimes.getQuantile(0.5) * FRAME_STATISTICS_STUTTER_FACTOR;
+		s_FrameTimes.addSample(frameMilliseconds);
+		s_CPUTimes.addSample(cpuMilliseconds);
+
+		// GPU timings arrive a few frames late, each resolved frame is added once. Classification uses the latest one there is
+		double gpuMilliseconds = 0.0;
+#if GPU_PROFILER_ENABLED
+		gpuMilliseconds = GPUProfiler::getFrameTime();
+		if (gpuMilliseconds > 0.0 && GPUProfiler::getResolvedFrameIndex() != s_LastGPUFrame) {
+			s_LastGPUFrame = GPUProfiler::getResolvedFrameIndex();
+			s_GPUTimes.addSample(gpuMilliseconds);
+
+			// A pass that ran more than once in the frame counts as one sample of its total
+			const std::vector<GPUPassTiming> &timings = GPUProfiler::getPassTimings();
+			for (size_t i = 0; i < timings.size(); ++i) {
+				bool counted = false;
+				for (size_t j = 0; j < i && !counted; ++j) {
+					counted = strcmp(timings[i].Name, timings[j].Name) == 0;
+				}
+				if (counted)
+					continue;
+
+				double passMilliseconds = timings[i].Milliseconds;
+				for (size_t j = i + 1; j < timings.size(); ++j) {
+					if (strcmp(timings[i].Name, timings[j].Name) == 0)
+						passMilliseconds += timings[j].Milliseconds;
+				}
+				s_PassTimes[timings[i].Name].addSample(passMilliseconds);
+			}
+		}
+#endif
+
+		uint8_t flags = 0;
+		if (gpuMilliseconds >= cpuMilliseconds)
+			flags |= FrameGPUBound;
+		if (stutter) {
+			flags |= FrameStutter;
+			++s_StutterCount;
+		}
+
+		if (s_FrameCount >= FRAME_STATISTICS_WINDOW) {
+			uint8_t oldFlags = s_FrameFlags[s_FrameFlagsHead];
+			s_WindowGPUBoundCount -= (oldFlags & FrameGPUBound) ? 1 : 0;
+			s_WindowStutterCount -= (oldFlags & FrameStutter) ? 1 : 0;
+		}
+		s_FrameFlags[s_FrameFlagsHead] = flags;
+		s_WindowGPUBoundCount += (flags & FrameGPUBound) ? 1 : 0;
+		s_WindowStutterCount += (flags & FrameStutter) ? 1 : 0;
+		s_FrameFlagsHead = (s_FrameFlagsHead + 1) % FRAME_STATISTICS_WINDOW;
+		++s_FrameCount;
+
+		s_RecentFrameTimes[s_RecentFrameTimesHead] = (float)frameMilliseconds;
+		s_RecentFrameTimesHead = (s_RecentFrameTimesHead + 1) % FRAME_STATISTICS_PLOT_FRAMES;
+	}
+
+	std::string FrameStatistics::getExportPath(const char *extension) {
+		FileUtils::createDirectories(FRAME_STATISTICS_EXPORT_DIRECTORY);
+		return std::string(FRAME_STATISTICS_EXPORT_DIRECTORY) + "frame_statistics_" + std::to_string(s_FrameCount) + extension;
+	}
+
+}
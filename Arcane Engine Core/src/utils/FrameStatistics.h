@@ -0,0 +1,86 @@
+#pragma once
+
+namespace arcane {
+
+	struct FrameTimePercentiles {
+		double P50, P95, P99, P999, Max; // Milliseconds
+		unsigned int SampleCount;
+	};
+
+	// Timings over the last FRAME_STATISTICS_WINDOW samples in log spaced buckets (32 per doubling, so quantiles are within about 1%).
+	// The window only keeps each sample's bucket, so memory stays fixed however long it runs
+	class RollingHistogram {
+	public:
+		static const unsigned int BucketsPerOctave = 32;
+		static const unsigned int BucketCount = BucketsPerOctave * 20; // 10us up to about 10s
+		static constexpr double MinMilliseconds = 0.01;
+
+		RollingHistogram();
+
+		void addSample(double milliseconds);
+		void clear();
+
+		double getQuantile(double quantile) const; // 0 without samples
+		FrameTimePercentiles getPercentiles() const;
+		inline unsigned int getSampleCount() const { return m_SampleCount; }
+		inline unsigned int getBucketSampleCount(unsigned int bucket) const { return m_Buckets[bucket]; }
+
+		static unsigned int getBucket(double milliseconds);
+		static double getBucketLowerBound(unsigned int bucket);
+	private:
+		std::array<uint32_t, BucketCount> m_Buckets;
+		std::array<uint16_t, FRAME_STATISTICS_WINDOW> m_Window; // Bucket of each sample, oldest is overwritten first
+		unsigned int m_WindowHead, m_SampleCount;
+	};
+
+	// Rolling frame time percentiles, whether frames are CPU or GPU bound, stutters and per pass GPU histograms. Tail latency is what
+	// matters here, so everything is reported as percentiles rather than averages
+	class FrameStatistics {
+	public:
+		// Bracket the main thread's work for the frame, endFrame goes right before the buffers are swapped
+		static void beginFrame();
+		static void endFrame();
+		static void reset();
+
+		inline static const RollingHistogram& getFrameTimes() { return s_FrameTimes; } // Start of one frame to the start of the next
+		inline static const RollingHistogram& getCPUTimes() { return s_CPUTimes; } // Main thread work, without waiting on the swap
+		inline static const RollingHistogram& getGPUTimes() { return s_GPUTimes; }
+		inline static const std::map<std::string, RollingHistogram>& getPassTimes() { return s_PassTimes; }
+
+		// Fractions of the frames in the window
+		static float getGPUBoundFraction();
+		inline static unsigned int getWindowStutterCount() { return s_WindowStutterCount; }
+		inline static uint64_t getStutterCount() { return s_StutterCount; }
+		inline static uint64_t getFrameCount() { return s_FrameCount; }
+
+		// The last FRAME_STATISTICS_PLOT_FRAMES frame times, starting at getRecentFrameTimesOffset, for plotting
+		inline static const std::array<float, FRAME_STATISTICS_PLOT_FRAMES>& getRecentFrameTimes() { return s_RecentFrameTimes; }
+		inline static unsigned int getRecentFrameTimesOffset() { return s_RecentFrameTimesHead; }
+
+		// CSV is the percentile summary of every series, JSON adds the bound classification, stutters and the histograms.
+		// Written to FRAME_STATISTICS_EXPORT_DIRECTORY, returns the path or an empty string on failure
+		static std::string exportCSV();
+		static std::string exportJSON();
+	private:
+		static void recordFrame(double frameMilliseconds, double cpuMilliseconds);
+		static std::string getExportPath(const char *extension);
+	private:
+		enum FrameFlags : uint8_t {
+			FrameGPUBound = 1 << 0,
+			FrameStutter = 1 << 1
+		};
+
+		static RollingHistogram s_FrameTimes, s_CPUTimes, s_GPUTimes;
+		static std::map<std::string, RollingHistogram> s_PassTimes;
+
+		static std::array<uint8_t, FRAME_STATISTICS_WINDOW> s_FrameFlags;
+		static unsigned int s_FrameFlagsHead, s_WindowGPUBoundCount, s_WindowStutterCount;
+		static uint64_t s_FrameCount, s_StutterCount, s_LastGPUFrame;
+
+		static std::array<float, FRAME_STATISTICS_PLOT_FRAMES> s_RecentFrameTimes;
+		static unsigned int s_RecentFrameTimesHead;
+
+		static double s_FrameStart, s_LastCPUTime;
+	};
+
+}
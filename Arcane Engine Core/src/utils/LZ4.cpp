@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "LZ4.h"
+
+namespace arcane {
+
+	static uint32_t read32(const unsigned char *data) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Writes a length that didn't fit in its token nibble as a run of 255s and a remainder
+	static unsigned char* writeLengthBytes(unsigned char *dst, size_t length) {
+		while (length >= 255) {
+			*dst++ = 255;
+			length -= 255;
+		}
+		*dst++ = (unsigned char)length;
+		return dst;
+	}
+
+	size_t LZ4::compress(const unsigned char *src, size_t srcSize, unsigned char *dst, size_t dstCapacity) {
+		unsigned char *op = dst;
+		unsigned char *opEnd = dst + dstCapacity;
+
+		// Emits the literals since the anchor followed by a match (matchLength 0 for the closing literal only sequence)
+		auto emitSequence = [&op, opEnd](const unsigned char *literals, size_t literalLength, size_t offset, size_t matchLength) -> bool {
+			size_t worstCase = 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+			if (worstCase > (size_t)(opEnd - op))
+				return false;
+
+			unsigned char *token = op++;
+			*token = (unsigned char)(std::min<size_t>(literalLength, 15) << 4);
+			if (literalLength >= 15) {
+				op = writeLengthBytes(op, literalLength - 15);
+			}
+			memcpy(op, literals, literalLength);
+			op += literalLength;
+
+			if (matchLength > 0) {
+				*op++ = (unsigned char)(offset & 0xff);
+				*op++ = (unsigned char)(offset >> 8);
+				size_t matchCode = matchLength - s_MinMatch;
+				*token |= (unsigned char)std::min<size_t>(matchCode, 15);
+				if (matchCode >= 15) {
+					op = writeLengthBytes(op, matchCode - 15);
+				}
+			}
+			return true;
+		};
+
+		size_t anchor = 0;
+		if (srcSize > s_MatchSearchLimit) {
+			// Most recent position of every hashed 4 byte sequence
+			std::vector<size_t> hashTable((size_t)1 << s_HashBits, std::numeric_limits<size_t>::max());
+			size_t matchSearchEnd = srcSize - s_MatchSearchLimit;
+			size_t matchEnd = srcSize - s_LastLiterals;
+
+			size_t position = 0;
+			while (position < matchSearchEnd) {
+				uint32_t sequence = read32(src + position);
+				uint32_t hash = (sequence * 2654435761u) >> (32 - s_HashBits);
+				size_t candidate = hashTable[hash];
+				hashTable[hash] = position;
+
+				if (candidate == std::numeric_limits<size_t>::max() || position - candidate > s_MaxOffset || read32(src + candidate) != sequence) {
+					position++;
+					continue;
+				}
+
+				size_t matchLength = s_MinMatch;
+				while (position + matchLength < matchEnd && src[candidate + matchLength] == src[position + matchLength]) {
+					matchLength++;
+				}
+
+				if (!emitSequence(src + anchor, position - anchor, position - candidate, matchLength))
+					return 0;
+				position += matchLength;
+				anchor = position;
+			}
+		}
+
+		if (!emitSequence(src + anchor, srcSize - anchor, 0, 0))
+			return 0;
+		return op - dst;
+	}
+
+	bool LZ4::decompress(const unsigned char *src, size_t srcSize, unsigned char *dst, size_t dstSize) {
+		size_t ip = 0, op = 0;
+
+		auto readLength = [src, srcSize, &ip](size_t &length) -> bool {
+			unsigned char byte;
+			do {
+				if (ip >= srcSize)
+					return false;
+				byte = src[ip++];
+				length += byte;
+			} while (byte == 255);
+			return true;
+		};
+
+		while (ip < srcSize) {
+			unsigned char token = src[ip++];
+
+			size_t literalLength = token >> 4;
+			if (literalLength == 15 && !readLength(literalLength))
+				return false;
+			if (literalLength > srcSize - ip || literalLength > dstSize - op)
+				return false;
+			memcpy(dst + op, src + ip, literalLength);
+			ip += literalLength;
+			op += literalLength;
+
+			// The closing sequence has no match
+			if (ip == srcSize)
+				break;
+
+			if (srcSize - ip < 2)
+				return false;
+			size_t offset = src[ip] | ((size_t)src[ip + 1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > op)
+				return false;
+
+			size_t matchLength = token & 15;
+			if (matchLength == 15 && !readLength(matchLength))
+				return false;
+			matchLength += s_MinMatch;
+			if (matchLength > dstSize - op)
+				return false;
+
+			// Byte by byte since a match can overlap the bytes it is producing
+			const unsigned char *match = dst + op - offset;
+			for (size_t i = 0; i < matchLength; i++) {
+				dst[op + i] = match[i];
+			}
+			op += matchLength;
+		}
+		return op == dstSize;
+	}
+
+}
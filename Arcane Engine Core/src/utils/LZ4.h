@@ -0,0 +1,21 @@
+#pragma once
+
+namespace arcane {
+
+	// LZ4 block format (no frame header), decompression speed is what matters so packing uses a simple greedy matcher
+	class LZ4 {
+	public:
+		// Returns the compressed size, or 0 if the result doesn't fit in dstCapacity
+		static size_t compress(const unsigned char *src, size_t srcSize, unsigned char *dst, size_t dstCapacity);
+
+		// dstSize has to be the exact decompressed size. Fails on malformed input instead of reading or writing out of bounds
+		static bool decompress(const unsigned char *src, size_t srcSize, unsigned char *dst, size_t dstSize);
+	private:
+		static const unsigned int s_HashBits = 12;
+		static const size_t s_MinMatch = 4;
+		static const size_t s_LastLiterals = 5; // The format requires the last 5 bytes to be literals
+		static const size_t s_MatchSearchLimit = 12; // and the last match to start at least 12 bytes before the end
+		static const size_t s_MaxOffset = 65535;
+	};
+
+}
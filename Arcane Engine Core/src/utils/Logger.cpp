@@ -23,21 +23,25 @@ namespace arcane {
 	}
 
 	void Logger::debug(const std::string &filePath, std::string &module, const std::string &message) {
+		std::lock_guard<std::recursive_mutex> lock(logMutex);
 		setOutputFile(filePath);
 		logMessage(DEBUG, module, message);
 	}
 
 	void Logger::info(const std::string &filePath, const std::string &module, const std::string &message) {
+		std::lock_guard<std::recursive_mutex> lock(logMutex);
 		setOutputFile(filePath);
 		logMessage(INFO, module, message);
 	}
 
 	void Logger::warning(const std::string &filePath, const std::string &module, const std::string &message) {
+		std::lock_guard<std::recursive_mutex> lock(logMutex);
 		setOutputFile(filePath);
 		logMessage(WARNING, module, message);
 	}
 
 	void Logger::error(const std::string &filePath, const std::string &module, const std::string &message) {
+		std::lock_guard<std::recursive_mutex> lock(logMutex);
 		setOutputFile(filePath);
 		logMessage(ERROR, module, message);
 	}
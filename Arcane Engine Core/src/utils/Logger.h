@@ -27,6 +27,9 @@ namespace arcane {
 
 		std::ofstream filestream;
 		std::string file; // Default value set to: "logged_files/log.txt"
+
+		// Loading workers log too, so picking the file and writing to it happen under one lock. Recursive since clearing a file can log
+		std::recursive_mutex logMutex;
 	};
 
 }
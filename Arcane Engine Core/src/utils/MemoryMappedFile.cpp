@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "MemoryMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace arcane {
+
+#ifdef _WIN32
+	MemoryMappedFile::MemoryMappedFile() : m_Data(nullptr), m_Size(0), m_FileHandle(INVALID_HANDLE_VALUE), m_MappingHandle(nullptr) {}
+#else
+	MemoryMappedFile::MemoryMappedFile() : m_Data(nullptr), m_Size(0), m_FileDescriptor(-1) {}
+#endif
+
+	MemoryMappedFile::~MemoryMappedFile() {
+		close();
+	}
+
+	bool MemoryMappedFile::open(const std::string &filepath) {
+		close();
+
+#ifdef _WIN32
+		m_FileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_FileHandle == INVALID_HANDLE_VALUE) {
+			Logger::getInstance().error("logged_files/error.txt", "Memory Mapped File", "Could not open file: " + filepath);
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(m_FileHandle, &fileSize) || fileSize.QuadPart == 0) {
+			Logger::getInstance().error("logged_files/error.txt", "Memory Mapped File", "Could not map empty file: " + filepath);
+			close();
+			return false;
+		}
+		m_Size = (size_t)fileSize.QuadPart;
+
+		m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_MappingHandle == nullptr) {
+			Logger::getInstance().error("logged_files/error.txt", "Memory Mapped File", "Could not create file mapping: " + filepath);
+			close();
+			return false;
+		}
+
+		m_Data = (const unsigned char*)MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+		m_FileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+		if (m_FileDescriptor == -1) {
+			Logger::getInstance().error("logged_files/error.txt", "Memory Mapped File", "Could not open file: " + filepath);
+			return false;
+		}
+
+		struct stat fileStats;
+		if (fstat(m_FileDescriptor, &fileStats) == -1 || fileStats.st_size == 0) {
+			Logger::getInstance().error("logged_files/error.txt", "Memory Mapped File", "Could not map empty file: " + filepath);
+			close();
+			return false;
+		}
+		m_Size = (size_t)fileStats.st_size;
+
+		void *mapping = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+		m_Data = (mapping == MAP_FAILED) ? nullptr : (const unsigned char*)mapping;
+#endif
+
+		if (m_Data == nullptr) {
+			Logger::getInstance().error("logged_files/error.txt", "Memory Mapped File", "Could not map view of file: " + filepath);
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void MemoryMappedFile::prefetch(size_t offset, size_t size) const {
+		if (!m_Data || offset >= m_Size)
+			return;
+		size = std::min(size, m_Size - offset);
+
+#ifdef _WIN32
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN8
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress = (void*)(m_Data + offset);
+		range.NumberOfBytes = size;
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+		// madvise wants a page aligned start
+		size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		size_t alignedOffset = offset - offset % pageSize;
+		madvise((void*)(m_Data + alignedOffset), size + (offset - alignedOffset), MADV_WILLNEED);
+#endif
+	}
+
+	void MemoryMappedFile::close() {
+#ifdef _WIN32
+		if (m_Data) {
+			UnmapViewOfFile(m_Data);
+		}
+		if (m_MappingHandle) {
+			CloseHandle(m_MappingHandle);
+			m_MappingHandle = nullptr;
+		}
+		if (m_FileHandle != INVALID_HANDLE_VALUE) {
+			CloseHandle(m_FileHandle);
+			m_FileHandle = INVALID_HANDLE_VALUE;
+		}
+#else
+		if (m_Data) {
+			munmap((void*)m_Data, m_Size);
+		}
+		if (m_FileDescriptor != -1) {
+			::close(m_FileDescriptor);
+			m_FileDescriptor = -1;
+		}
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+namespace arcane {
+
+	// Read-only view of a file that is paged in by the OS on access instead of being copied into memory up front
+	class MemoryMappedFile {
+	public:
+		MemoryMappedFile();
+		~MemoryMappedFile();
+
+		MemoryMappedFile(const MemoryMappedFile &file) = delete;
+		MemoryMappedFile& operator=(const MemoryMappedFile &file) = delete;
+
+		bool open(const std::string &filepath);
+		void close();
+
+		// Asks the OS to start reading a range in before it is touched, so faulting it in later doesn't stall on the disk. Only a hint
+		void prefetch(size_t offset, size_t size) const;
+
+		inline bool isOpen() const { return m_Data != nullptr; }
+		inline const unsigned char* getData() const { return m_Data; }
+		inline size_t getSize() const { return m_Size; }
+	private:
+		const unsigned char *m_Data;
+		size_t m_Size;
+
+#ifdef _WIN32
+		void *m_FileHandle, *m_MappingHandle;
+#else
+		int m_FileDescriptor;
+#endif
+	};
+
+}
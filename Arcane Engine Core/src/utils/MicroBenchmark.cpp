@@ -0,0 +1,481 @@
+#include "pch.h"
+#include "MicroBenchmark.h"
+
+#include <graphics/Shader.h>
+#include <graphics/ibl/ProbeManager.h>
+#include <graphics/lights/ObjectLightAssigner.h>
+#include <graphics/mesh/Mesh.h>
+#include <graphics/renderer/ModelRenderer.h>
+#include <graphics/renderer/renderpass/LightClusterPass.h>
+#include <scene/RenderableModel.h>
+#include <terrain/TerrainTileStreamer.h>
+#include <utils/FileUtils.h>
+
+namespace arcane {
+
+	// Static declarations
+	std::string MicroBenchmark::s_Filter;
+	std::vector<MicroBenchmarkResult> MicroBenchmark::s_Results;
+
+	// Results are folded into this so the compiler can't throw away work whose output is never read
+	static volatile float s_Sink;
+
+	static void appendBigEndian(std::vector<unsigned char> &output, uint32_t value) {
+		output.push_back((unsigned char)(value >> 24));
+		output.push_back((unsigned char)(value >> 16));
+		output.push_back((unsigned char)(value >> 8));
+		output.push_back((unsigned char)value);
+	}
+
+	static void appendPNGChunk(std::vector<unsigned char> &output, const char *type, const std::vector<unsigned char> &data) {
+		static uint32_t crcTable[256];
+		if (crcTable[1] == 0) {
+			for (uint32_t i = 0; i < 256; ++i) {
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; ++bit) {
+					crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+				}
+				crcTable[i] = crc;
+			}
+		}
+
+		appendBigEndian(output, (uint32_t)data.size());
+		size_t crcStart = output.size();
+		output.insert(output.end(), type, type + 4);
+		output.insert(output.end(), data.begin(), data.end());
+
+		uint32_t crc = 0xFFFFFFFFu;
+		for (size_t i = crcStart; i < output.size(); ++i) {
+			crc = crcTable[(crc ^ output[i]) & 0xFF] ^ (crc >> 8);
+		}
+		appendBigEndian(output, crc ^ 0xFFFFFFFFu);
+	}
+
+	// Encodes an RGBA image as a PNG with Sub filtered rows in a single fixed Huffman deflate block of literals, so decoding goes through
+	// the same inflate and unfilter paths as a real file
+	static std::vector<unsigned char> encodeSyntheticPNG(const std::vector<unsigned char> &pixels, unsigned int width, unsigned int height) {
+		std::vector<unsigned char> filtered;
+		filtered.reserve((size_t)(width * 4 + 1) * height);
+		for (unsigned int y = 0; y < height; ++y) {
+			const unsigned char *row = &pixels[(size_t)y * width * 4];
+			filtered.push_back(1);
+			for (unsigned int x = 0; x < width * 4; ++x) {
+				filtered.push_back((unsigned char)(row[x] - (x >= 4 ? row[x - 4] : 0)));
+			}
+		}
+
+		std::vector<unsigned char> zlib = { 0x78, 0x01 };
+		uint32_t bitBuffer = 0, bitCount = 0;
+		auto writeBits = [&](uint32_t bits, uint32_t count) {
+			bitBuffer |= bits << bitCount;
+			bitCount += count;
+			while (bitCount >= 8) {
+				zlib.push_back((unsigned char)bitBuffer);
+				bitBuffer >>= 8;
+				bitCount -= 8;
+			}
+		};
+		// Huffman codes are packed starting from their most significant bit
+		auto writeCode = [&](uint32_t code, uint32_t length) {
+			for (uint32_t bit = length; bit-- > 0;) {
+				writeBits((code >> bit) & 1, 1);
+			}
+		};
+		writeBits(1, 1); // Final block
+		writeBits(1, 2); // Fixed Huffman codes
+		for (unsigned char literal : filtered) {
+			if (literal < 144)
+				writeCode(0x30 + literal, 8);
+			else
+				writeCode(0x190 + literal - 144, 9);
+		}
+		writeCode(0, 7); // End of block
+		if (bitCount > 0)
+			writeBits(0, 8 - bitCount);
+
+		uint32_t adlerA = 1, adlerB = 0;
+		for (unsigned char byte : filtered) {
+			adlerA = (adlerA + byte) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+		}
+		appendBigEndian(zlib, (adlerB << 16) | adlerA);
+
+		std::vector<unsigned char> header;
+		appendBigEndian(header, width);
+		appendBigEndian(header, height);
+		header.push_back(8); // Bit depth
+		header.push_back(6); // RGBA
+		header.push_back(0); header.push_back(0); header.push_back(0); // Deflate, adaptive filtering, no interlacing
+
+		std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		appendPNGChunk(png, "IHDR", header);
+		appendPNGChunk(png, "IDAT", zlib);
+		appendPNGChunk(png, "IEND", std::vector<unsigned char>());
+		return png;
+	}
+
+	bool MicroBenchmark::isRequested(int argc, char **argv) {
+		for (int i = 1; i < argc; ++i) {
+			if (strcmp(argv[i], "--microbenchmark") == 0)
+				return true;
+		}
+		return false;
+	}
+
+	int MicroBenchmark::run(int argc, char **argv) {
+		std::string outputPath;
+		for (int i = 1; i < argc; ++i) {
+			std::string argument = argv[i];
+			if (argument == "--microbenchmark")
+				continue;
+
+			if (i + 1 < argc && argument == "--filter") {
+				s_Filter = argv[++i];
+			}
+			else if (i + 1 < argc && argument == "--output") {
+				outputPath = argv[++i];
+			}
+			else {
+				std::cout << "Usage: --microbenchmark [--filter text] [--output file.csv]" << std::endl;
+				return 1;
+			}
+		}
+
+		s_Results.clear();
+		benchmarkMeshInterleaving();
+		benchmarkTerrainTileBuild();
+		benchmarkTextureDecode();
+		benchmarkTransparentSort();
+		benchmarkModelMatrix();
+		benchmarkProbeSearch();
+		benchmarkLightCulling();
+		benchmarkObjectLightAssignment();
+		benchmarkShaderPreProcess();
+		benchmarkLogger();
+
+		if (!outputPath.empty() && !writeResults(outputPath))
+			return 1;
+		return 0;
+	}
+
+	void MicroBenchmark::benchmarkMeshInterleaving() {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		auto randomVec3 = [&]() { return glm::vec3(distribution(random), distribution(random), distribution(random)); };
+
+		// Below 65536 vertices meshes narrow their indices to 16 bits, the largest size covers the 32 bit path
+		const size_t vertexCounts[] = { 1024, 16384, 262144 };
+		for (size_t vertexCount : vertexCounts) {
+			std::vector<glm::vec3> positions(vertexCount), normals(vertexCount), tangents(vertexCount), bitangents(vertexCount);
+			std::vector<glm::vec2> uvs(vertexCount);
+			std::vector<unsigned int> indices(vertexCount * 3 / 2);
+			for (size_t i = 0; i < vertexCount; ++i) {
+				positions[i] = randomVec3(); normals[i] = randomVec3(); tangents[i] = randomVec3(); bitangents[i] = randomVec3();
+				uvs[i] = glm::vec2(distribution(random), distribution(random));
+			}
+			for (unsigned int &index : indices) {
+				index = random() % vertexCount;
+			}
+			bool shortIndices = vertexCount <= 65536;
+			size_t indexBytes = indices.size() * (shortIndices ? sizeof(unsigned short) : sizeof(unsigned int));
+
+			std::vector<unsigned short> shortIndexData(shortIndices ? indices.size() : 0);
+			std::vector<unsigned int> indexData(shortIndices ? 0 : indices.size());
+			auto writeIndices = [&](const Mesh &mesh) {
+				if (shortIndices)
+					mesh.writeIndices(&shortIndexData[0]);
+				else
+					mesh.writeIndices(&indexData[0]);
+			};
+
+			Mesh standardMesh(positions, uvs, normals, indices);
+			std::vector<StandardVertex> standardVertices(vertexCount);
+			measure("Mesh::LoadData interleave standard", vertexCount, (double)(vertexCount * sizeof(StandardVertex) + indexBytes), [&](uint64_t) {
+				standardMesh.writeVertices(&standardVertices[0]);
+				writeIndices(standardMesh);
+			});
+
+			Mesh fullPrecisionMesh(positions, uvs, normals, tangents, bitangents, indices);
+			std::vector<FullPrecisionVertex> fullPrecisionVertices(vertexCount);
+			measure("Mesh::LoadData interleave full", vertexCount, (double)(vertexCount * sizeof(FullPrecisionVertex) + indexBytes), [&](uint64_t) {
+				fullPrecisionMesh.writeVertices(&fullPrecisionVertices[0]);
+				writeIndices(fullPrecisionMesh);
+			});
+		}
+	}
+
+	void MicroBenchmark::benchmarkTerrainTileBuild() {
+		const unsigned int tileSizes[] = { 32, 64, 128 };
+		for (unsigned int tileSize : tileSizes) {
+			// Rolling hills, so the normals and skirts see realistic slopes
+			unsigned int samplesPerSide = getTerrainTileSamplesPerSide(tileSize);
+			std::vector<uint16_t> samples((size_t)samplesPerSide * samplesPerSide);
+			for (unsigned int z = 0; z < samplesPerSide; ++z) {
+				for (unsigned int x = 0; x < samplesPerSide; ++x) {
+					float height = 0.5f + 0.25f * std::sin(x * 0.15f) + 0.25f * std::cos(z * 0.11f);
+					samples[x + z * samplesPerSide] = (uint16_t)(height * 65535.0f);
+				}
+			}
+
+			TerrainTileBuildResult result;
+			TerrainTileStreamer::buildTileVertices(&samples[0], tileSize, 2.0f, 200.0f, glm::vec2(0.0f), glm::vec2(4096.0f), result);
+			double bytesPerOp = (double)(samples.size() * sizeof(uint16_t) + result.VertexData.size() * sizeof(float));
+			measure("Terrain tile build", tileSize, bytesPerOp, [&](uint64_t) {
+				TerrainTileStreamer::buildTileVertices(&samples[0], tileSize, 2.0f, 200.0f, glm::vec2(0.0f), glm::vec2(4096.0f), result);
+				s_Sink = result.MaxHeight;
+			});
+		}
+	}
+
+	void MicroBenchmark::benchmarkTextureDecode() {
+		std::mt19937 random(2);
+		const unsigned int resolutions[] = { 64, 256, 1024 };
+		for (unsigned int resolution : resolutions) {
+			// Smooth gradients with some noise, roughly how an albedo map filters
+			std::vector<unsigned char> pixels((size_t)resolution * resolution * 4);
+			for (unsigned int y = 0; y < resolution; ++y) {
+				for (unsigned int x = 0; x < resolution; ++x) {
+					unsigned char *pixel = &pixels[((size_t)y * resolution + x) * 4];
+					pixel[0] = (unsigned char)(x * 255 / resolution + random() % 8);
+					pixel[1] = (unsigned char)(y * 255 / resolution + random() % 8);
+					pixel[2] = (unsigned char)((x + y) * 127 / resolution + random() % 8);
+					pixel[3] = 255;
+				}
+			}
+			std::vector<unsigned char> png = encodeSyntheticPNG(pixels, resolution, resolution);
+
+			// Same decode the texture loader's workers run on a file's bytes, always to 4 channels
+			measure("TextureLoader decode png", resolution, (double)pixels.size(), [&](uint64_t) {
+				int width, height, numComponents;
+				unsigned char *data = stbi_load_from_memory(&png[0], (int)png.size(), &width, &height, &numComponents, 4);
+				if (data) {
+					s_Sink = data[0];
+					stbi_image_free(data);
+				}
+			});
+		}
+	}
+
+	void MicroBenchmark::benchmarkTransparentSort() {
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> distribution(-500.0f, 500.0f);
+		glm::vec3 one(1.0f), up(0.0f, 1.0f, 0.0f);
+
+		const size_t renderableCounts[] = { 16, 256, 4096 };
+		for (size_t renderableCount : renderableCounts) {
+			std::vector<std::unique_ptr<RenderableModel>> renderables;
+			std::deque<RenderableModel*> unsorted;
+			for (size_t i = 0; i < renderableCount; ++i) {
+				glm::vec3 position(distribution(random), distribution(random), distribution(random));
+				renderables.push_back(std::unique_ptr<RenderableModel>(new RenderableModel(position, one, up, 0.0f, nullptr, nullptr, false, true)));
+				unsorted.push_back(renderables.back().get());
+			}
+
+			// Each op sorts a fresh copy of the queue, like a frame's worth of submissions
+			std::deque<RenderableModel*> renderQueue;
+			glm::vec3 viewPosition(0.0f, 10.0f, 0.0f);
+			measure("ModelRenderer transparent sort", renderableCount, (double)(renderableCount * sizeof(RenderableModel*)), [&](uint64_t) {
+				renderQueue = unsorted;
+				ModelRenderer::sortBackToFront(renderQueue, viewPosition);
+				s_Sink = renderQueue.front()->getPosition().x;
+			});
+		}
+	}
+
+	void MicroBenchmark::benchmarkModelMatrix() {
+		std::mt19937 random(4);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+		// A batch of renderables larger than L1 so the transforms are streamed in like they would be during a flush
+		const size_t renderableCount = 1024;
+		std::vector<std::unique_ptr<RenderableModel>> roots, children;
+		for (size_t i = 0; i < renderableCount; ++i) {
+			glm::vec3 position(distribution(random) * 100.0f, distribution(random) * 100.0f, distribution(random) * 100.0f);
+			glm::vec3 scale(1.0f + distribution(random) * 0.5f);
+			glm::vec3 axis = glm::normalize(glm::vec3(distribution(random), distribution(random), distribution(random)) + glm::vec3(0.0f, 2.0f, 0.0f));
+			roots.push_back(std::unique_ptr<RenderableModel>(new RenderableModel(position, scale, axis, distribution(random) * 3.14f, nullptr, nullptr)));
+			children.push_back(std::unique_ptr<RenderableModel>(new RenderableModel(position, scale, axis, distribution(random) * 3.14f, nullptr, roots.back().get())));
+		}
+
+		measure("setupModelMatrix root", renderableCount, (double)sizeof(glm::mat4), [&](uint64_t i) {
+			s_Sink = ModelRenderer::calculateModelMatrix(roots[i % renderableCount].get())[3][0];
+		});
+		measure("setupModelMatrix child", renderableCount, (double)sizeof(glm::mat4), [&](uint64_t i) {
+			s_Sink = ModelRenderer::calculateModelMatrix(children[i % renderableCount].get())[3][0];
+		});
+		measure("setupModelMatrix child + normal matrix", renderableCount, (double)(sizeof(glm::mat4) + sizeof(glm::mat3)), [&](uint64_t i) {
+			glm::mat4 model = ModelRenderer::calculateModelMatrix(children[i % renderableCount].get());
+			s_Sink = ModelRenderer::calculateNormalMatrix(model)[2][2];
+		});
+	}
+
+	void MicroBenchmark::benchmarkProbeSearch() {
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> distribution(-500.0f, 500.0f);
+		glm::vec2 resolution(1.0f);
+
+		// Probes only allocate GL resources once generated, so they can be created here without a context
+		std::vector<glm::vec3> renderPositions(1024);
+		for (glm::vec3 &position : renderPositions) {
+			position = glm::vec3(distribution(random), distribution(random), distribution(random));
+		}
+		const size_t probeCounts[] = { 4, 64, 1024 };
+		for (size_t probeCount : probeCounts) {
+			std::vector<LightProbe*> probes;
+			for (size_t i = 0; i < probeCount; ++i) {
+				glm::vec3 position(distribution(random), distribution(random), distribution(random));
+				probes.push_back(new LightProbe(position, resolution));
+			}
+
+			measure("ProbeManager::bindProbes nearest", probeCount, (double)(probeCount * sizeof(glm::vec3)), [&](uint64_t i) {
+				s_Sink = ProbeManager::findClosestProbe(probes, renderPositions[i % renderPositions.size()])->getPosition().x;
+			});
+
+			for (LightProbe *probe : probes) {
+				delete probe;
+			}
+		}
+	}
+
+	void MicroBenchmark::benchmarkLightCulling() {
+		std::mt19937 random(6);
+		std::uniform_real_distribution<float> horizontal(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> depth(-400.0f, -1.0f);
+		std::uniform_real_distribution<float> radius(5.0f, 40.0f);
+
+		glm::mat4 projection = glm::perspective(glm::radians(80.0f), 16.0f / 9.0f, NEAR_PLANE, FAR_PLANE);
+		std::vector<LightClusterBounds> bounds;
+		LightClusterPass::calculateClusterBounds(projection, bounds);
+		LightClusterBins pointLightBins, spotLightBins;
+		std::vector<glm::uvec2> clusters(bounds.size());
+		std::vector<unsigned int> indices;
+
+		// Half point lights and half spot lights, spread through the front of the view frustum
+		const size_t lightCounts[] = { 64, 512, 4096 };
+		for (size_t lightCount : lightCounts) {
+			std::vector<glm::vec4> pointLightSpheres, spotLightSpheres;
+			for (size_t i = 0; i < lightCount; ++i) {
+				float x = horizontal(random);
+				float y = horizontal(random);
+				float z = depth(random);
+				float r = radius(random);
+				(i % 2 == 0 ? pointLightSpheres : spotLightSpheres).push_back(glm::vec4(x, y, z, r));
+			}
+
+			measure("LightClusterPass::cullLights", lightCount, (double)(lightCount * sizeof(glm::vec4) + bounds.size() * sizeof(glm::uvec2)), [&](uint64_t) {
+				LightClusterPass::binLights(projection, pointLightSpheres, pointLightBins);
+				LightClusterPass::binLights(projection, spotLightSpheres, spotLightBins);
+				LightClusterPass::cullLights(bounds, pointLightSpheres, pointLightBins, spotLightSpheres, spotLightBins, 0, bounds.size(), clusters, indices);
+				s_Sink = (float)indices.size();
+			});
+		}
+	}
+
+	void MicroBenchmark::benchmarkObjectLightAssignment() {
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> lightRadius(5.0f, 40.0f);
+		std::uniform_real_distribution<float> objectRadius(0.5f, 10.0f);
+		glm::vec3 colour(1.0f);
+
+		std::vector<glm::vec4> objectSpheres(1024);
+		for (glm::vec4 &sphere : objectSpheres) {
+			float x = position(random);
+			float y = position(random);
+			float z = position(random);
+			sphere = glm::vec4(x, y, z, objectRadius(random));
+		}
+
+		// Half point lights and half spot lights, spread through the same volume as the objects
+		const size_t lightCounts[] = { 64, 512, 4096 };
+		for (size_t lightCount : lightCounts) {
+			PointLightArrays pointLights;
+			SpotLightArrays spotLights;
+			for (size_t i = 0; i < lightCount; ++i) {
+				float x = position(random);
+				float y = position(random);
+				float z = position(random);
+				float r = lightRadius(random);
+				if (i % 2 == 0) {
+					pointLights.insert(false, 1.0f, colour);
+					pointLights.Positions.push_back(glm::vec3(x, y, z));
+					pointLights.AttenuationRadii.push_back(r);
+				}
+				else {
+					spotLights.insert(false, 1.0f, colour);
+					spotLights.Positions.push_back(glm::vec3(x, y, z));
+					spotLights.AttenuationRadii.push_back(r);
+				}
+			}
+
+			ObjectLightAssigner assigner;
+			std::vector<unsigned int> indices;
+			measure("ObjectLightAssigner::buildLightGrid", lightCount, (double)(lightCount * sizeof(glm::vec4)), [&](uint64_t) {
+				assigner.buildLightGrid(pointLights, spotLights, false);
+			});
+
+			// Lookups cycle through every object, so the average of what each one reads is what an op reads
+			size_t lookupBytes = 0;
+			for (const glm::vec4 &sphere : objectSpheres) {
+				lookupBytes += assigner.getLookupFootprint(sphere);
+			}
+			measure("ObjectLightAssigner::findLights", lightCount, (double)lookupBytes / objectSpheres.size(), [&](uint64_t i) {
+				if (i % objectSpheres.size() == 0)
+					indices.clear();
+				s_Sink = (float)assigner.findLights(objectSpheres[i % objectSpheres.size()], indices).y;
+			});
+		}
+	}
+
+	void MicroBenchmark::benchmarkShaderPreProcess() {
+		const size_t sourceSizes[] = { 1024, 16384, 262144 };
+		for (size_t sourceSize : sourceSizes) {
+			// Vertex and fragment stages of about the same length, padded out with typical GLSL lines
+			std::string source;
+			const char *stages[] = { "vertex", "fragment" };
+			for (const char *stage : stages) {
+				source += std::string("#shader-type ") + stage + "\n#version 430 core\n";
+				while (source.size() < sourceSize / 2 * (stage == stages[0] ? 1 : 2)) {
+					source += "\tvec3 fragToLight = normalize(lightPosition - data.FragPos); // Lighting\n";
+				}
+			}
+
+			measure("Shader::preProcessShaderBinary", sourceSize, (double)source.size(), [&](uint64_t) {
+				s_Sink = (float)Shader::preProcessShaderBinary(source).size();
+			});
+		}
+	}
+
+	void MicroBenchmark::benchmarkLogger() {
+		FileUtils::createDirectories("logged_files/");
+
+		// The logger echoes to the console, which is silenced so the terminal's speed doesn't decide the result
+		const size_t messageSizes[] = { 32, 256, 4096 };
+		for (size_t messageSize : messageSizes) {
+			std::string message(messageSize, 'x');
+			std::cout.setstate(std::ios::badbit);
+			measure("Logger throughput", messageSize, (double)messageSize, [&](uint64_t) {
+				Logger::getInstance().info("logged_files/microbenchmark.txt", "microbenchmark", message);
+			});
+			std::cout.clear();
+
+			// Every message is appended, so don't leave the file behind
+			std::remove("logged_files/microbenchmark.txt");
+		}
+	}
+
+	bool MicroBenchmark::writeResults(const std::string &path) {
+		std::ofstream output(path, std::ios::out | std::ios::trunc);
+		if (!output) {
+			Logger::getInstance().error("logged_files/microbenchmark.txt", "microbenchmark", "Couldn't create results: " + path);
+			return false;
+		}
+
+		output << "name,size,iterations,ns_per_op,bytes_per_op\n";
+		for (const MicroBenchmarkResult &result : s_Results) {
+			output << result.Name << ',' << result.Size << ',' << result.Iterations << ',' << result.NanosecondsPerOp << ',' << result.BytesPerOp << '\n';
+		}
+		return (bool)output;
+	}
+
+}
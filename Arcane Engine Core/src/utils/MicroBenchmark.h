@@ -0,0 +1,78 @@
+#pragma once
+
+namespace arcane {
+
+	struct MicroBenchmarkResult {
+		std::string Name;
+		size_t Size; // What the size means depends on the benchmark (vertices, texels along a side, renderables, bytes...)
+		uint64_t Iterations;
+		double NanosecondsPerOp;
+		double BytesPerOp; // Bytes an operation reads or writes, 0 where that isn't meaningful
+	};
+
+	// CPU micro-benchmarks of the engine's hot paths on synthetic inputs at several sizes. Runs before the window is created and never
+	// touches GL, so it works on machines without a GPU or display. Run with:
+	//   --microbenchmark [--filter text] [--output file.csv]
+	// or on its own without Visual Studio through the ArcaneMicroBenchmark target in CMakeLists.txt, which takes the same options
+	// Each benchmark repeats its operation for MICROBENCHMARK_MIN_TIME_MS, MICROBENCHMARK_REPETITIONS times, and keeps the fastest run
+	class MicroBenchmark {
+	public:
+		static bool isRequested(int argc, char **argv);
+		static int run(int argc, char **argv); // Returns the process exit code
+	private:
+		static void benchmarkMeshInterleaving();
+		static void benchmarkTerrainTileBuild();
+		static void benchmarkTextureDecode();
+		static void benchmarkTransparentSort();
+		static void benchmarkModelMatrix();
+		static void benchmarkProbeSearch();
+		static void benchmarkLightCulling();
+		static void benchmarkObjectLightAssignment();
+		static void benchmarkShaderPreProcess();
+		static void benchmarkLogger();
+
+		// Operation is called with the index of the iteration
+		template<typename Operation>
+		static void measure(const std::string &name, size_t size, double bytesPerOp, Operation operation);
+
+		static bool writeResults(const std::string &path);
+	private:
+		static std::string s_Filter;
+		static std::vector<MicroBenchmarkResult> s_Results;
+	};
+
+	template<typename Operation>
+	void MicroBenchmark::measure(const std::string &name, size_t size, double bytesPerOp, Operation operation) {
+		if (!s_Filter.empty() && name.find(s_Filter) == std::string::npos)
+			return;
+
+		// Warm the caches and any lazy initialization, then run in batches so the clock isn't read around every fast operation
+		operation(0);
+		const uint64_t minTime = (uint64_t)(MICROBENCHMARK_MIN_TIME_MS * 1000000.0);
+		uint64_t batch = 1;
+		MicroBenchmarkResult result = { name, size, 0, std::numeric_limits<double>::max(), bytesPerOp };
+		for (unsigned int repetition = 0; repetition < MICROBENCHMARK_REPETITIONS; ++repetition) {
+			uint64_t iterations = 0, elapsed = 0;
+			uint64_t start = Profiler::getTimestamp();
+			do {
+				for (uint64_t i = 0; i < batch; ++i) {
+					operation(iterations + i);
+				}
+				iterations += batch;
+				elapsed = Profiler::getTimestamp() - start;
+				if (elapsed < minTime / 100)
+					batch *= 2;
+			} while (elapsed < minTime);
+
+			double nanosecondsPerOp = (double)elapsed / iterations;
+			if (nanosecondsPerOp < result.NanosecondsPerOp) {
+				result.NanosecondsPerOp = nanosecondsPerOp;
+				result.Iterations = iterations;
+			}
+		}
+
+		printf("%-40s %10zu %12.1f ns/op %14.0f bytes/op %10.1f MB/s\n", name.c_str(), size, result.NanosecondsPerOp, bytesPerOp, bytesPerOp * 1000.0 / result.NanosecondsPerOp);
+		s_Results.push_back(result);
+	}
+
+}
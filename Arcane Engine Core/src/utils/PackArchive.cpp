@@ -0,0 +1,222 @@
+#include "pch.h"
+#include "PackArchive.h"
+
+#include <utils/FileUtils.h>
+#include <utils/LZ4.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace arcane {
+
+	static_assert(sizeof(PackHeader) % 16 == 0, "Pack header has to keep the entry data after it aligned");
+	static_assert(sizeof(PackEntry) % 8 == 0, "Pack entries have to stay aligned");
+
+	PackArchive::PackArchive() : m_Header(nullptr), m_Entries(nullptr), m_PathTable(nullptr) {}
+
+	bool PackArchive::open(const std::string &archivePath) {
+		m_Header = nullptr;
+		if (!m_File.open(archivePath))
+			return false;
+
+		if (!validate()) {
+			Logger::getInstance().error("logged_files/file_system.txt", "pack archive", "Archive is corrupt or from an older version: " + archivePath);
+			m_File.close();
+			return false;
+		}
+		m_Header = reinterpret_cast<const PackHeader*>(m_File.getData());
+		m_Entries = reinterpret_cast<const PackEntry*>(m_File.getData() + m_Header->IndexOffset);
+		m_PathTable = reinterpret_cast<const char*>(m_File.getData() + m_Header->PathTableOffset);
+
+		// Every lookup binary searches the index, so get it in before the first one
+		m_File.prefetch(m_Header->IndexOffset, (size_t)m_Header->EntryCount * sizeof(PackEntry));
+		m_File.prefetch(m_Header->PathTableOffset, m_Header->PathTableSize);
+#if VFS_READAHEAD_ARCHIVES
+		m_File.prefetch(0, m_File.getSize());
+#endif
+		return true;
+	}
+
+	const PackEntry* PackArchive::findEntry(const std::string &path) const {
+		if (!m_Header)
+			return nullptr;
+
+		std::string normalizedPath = normalizePath(path);
+		uint64_t hash = hashPath(normalizedPath);
+
+		const PackEntry *end = m_Entries + m_Header->EntryCount;
+		const PackEntry *entry = std::lower_bound(m_Entries, end, hash, [](const PackEntry &entry, uint64_t hash) {
+			return entry.PathHash < hash;
+		});
+		for (; entry != end && entry->PathHash == hash; ++entry) {
+			if (normalizedPath == m_PathTable + entry->PathOffset)
+				return entry;
+		}
+		return nullptr;
+	}
+
+	bool PackArchive::decompressEntry(const PackEntry &entry, unsigned char *outData) const {
+		if (entry.Flags & PackEntryLZ4)
+			return LZ4::decompress(getStoredData(entry), entry.StoredSize, outData, entry.Size);
+
+		memcpy(outData, getStoredData(entry), entry.Size);
+		return true;
+	}
+
+	bool PackArchive::buildArchive(const std::string &archivePath, const std::string &manifestPath) {
+		std::ifstream manifest(manifestPath);
+		if (!manifest) {
+			Logger::getInstance().error("logged_files/file_system.txt", "pack building", "Couldn't open manifest: " + manifestPath);
+			return false;
+		}
+
+		struct PendingEntry {
+			PackEntry Entry;
+			std::string Path;
+			std::vector<unsigned char> Data;
+		};
+		std::vector<PendingEntry> pendingEntries;
+		std::set<std::string> packedPaths;
+
+		std::string line;
+		while (std::getline(manifest, line)) {
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			std::string path = normalizePath(line);
+			if (!packedPaths.insert(path).second)
+				continue;
+
+			std::ifstream input(line, std::ios::in | std::ios::binary);
+			struct stat info;
+			if (!input || stat(line.c_str(), &info) != 0) {
+				Logger::getInstance().error("logged_files/file_system.txt", "pack building", "Couldn't read file listed in the manifest: " + line);
+				return false;
+			}
+			std::vector<unsigned char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+			PendingEntry pending;
+			memset(&pending.Entry, 0, sizeof(pending.Entry));
+			pending.Entry.PathHash = hashPath(path);
+			pending.Entry.Size = data.size();
+			pending.Entry.ModifiedTime = (int64_t)info.st_mtime;
+			pending.Path = path;
+
+			// Only keep the compressed version if it is worth the decompression
+			std::vector<unsigned char> compressed(data.size());
+			size_t compressedSize = LZ4::compress(data.data(), data.size(), compressed.data(), compressed.size());
+			if (compressedSize > 0 && compressedSize <= data.size() - (size_t)(data.size() * PACK_MIN_COMPRESSION_SAVING)) {
+				compressed.resize(compressedSize);
+				pending.Data = std::move(compressed);
+				pending.Entry.Flags |= PackEntryLZ4;
+			}
+			else {
+				pending.Data = std::move(data);
+			}
+			pending.Entry.StoredSize = pending.Data.size();
+			pendingEntries.push_back(std::move(pending));
+		}
+
+		// Sorted by hash for the binary search, ties by path so the archive is the same every time it is built
+		std::sort(pendingEntries.begin(), pendingEntries.end(), [](const PendingEntry &a, const PendingEntry &b) {
+			if (a.Entry.PathHash != b.Entry.PathHash)
+				return a.Entry.PathHash < b.Entry.PathHash;
+			return a.Path < b.Path;
+		});
+
+		std::ofstream output(archivePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!output) {
+			Logger::getInstance().error("logged_files/file_system.txt", "pack building", "Couldn't create archive: " + archivePath);
+			return false;
+		}
+
+		PackHeader header = {};
+		header.Magic = s_Magic;
+		header.Version = s_Version;
+		header.EntryCount = pendingEntries.size();
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		static const char s_Padding[16] = {};
+		uint64_t offset = sizeof(header);
+		std::vector<PackEntry> index;
+		std::string pathTable;
+		for (PendingEntry &pending : pendingEntries) {
+			pending.Entry.DataOffset = offset;
+			pending.Entry.PathOffset = pathTable.size();
+			pathTable += pending.Path;
+			pathTable += '\0';
+
+			output.write(reinterpret_cast<const char*>(pending.Data.data()), pending.Data.size());
+			offset += pending.Data.size();
+			size_t padding = (16 - offset % 16) % 16;
+			output.write(s_Padding, padding);
+			offset += padding;
+
+			index.push_back(pending.Entry);
+		}
+
+		header.IndexOffset = offset;
+		if (!index.empty()) {
+			output.write(reinterpret_cast<const char*>(&index[0]), index.size() * sizeof(PackEntry));
+		}
+		header.PathTableOffset = offset + index.size() * sizeof(PackEntry);
+		header.PathTableSize = pathTable.size();
+		output.write(pathTable.data(), pathTable.size());
+
+		output.seekp(0);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		if (!output) {
+			Logger::getInstance().error("logged_files/file_system.txt", "pack building", "Couldn't write archive: " + archivePath);
+			return false;
+		}
+		return true;
+	}
+
+	std::string PackArchive::normalizePath(const std::string &path) {
+		// Forward slashes only and no leading "./", so the same file is found however the loader spelled its path
+		std::string normalizedPath = path;
+		std::replace(normalizedPath.begin(), normalizedPath.end(), '\\', '/');
+		while (normalizedPath.compare(0, 2, "./") == 0) {
+			normalizedPath.erase(0, 2);
+		}
+		return normalizedPath;
+	}
+
+	uint64_t PackArchive::hashPath(const std::string &normalizedPath) {
+		return FileUtils::hashFNV1a(normalizedPath.data(), normalizedPath.size());
+	}
+
+	bool PackArchive::validate() const {
+		const unsigned char *data = m_File.getData();
+		size_t size = m_File.getSize();
+		if (size < sizeof(PackHeader))
+			return false;
+
+		const PackHeader &header = *reinterpret_cast<const PackHeader*>(data);
+		if (header.Magic != s_Magic || header.Version != s_Version)
+			return false;
+
+		// Every range has to be inside the file, so lookups never need to check
+		if (header.IndexOffset > size || header.IndexOffset % 8 != 0 || header.EntryCount > (size - header.IndexOffset) / sizeof(PackEntry))
+			return false;
+		if (header.PathTableOffset > size || header.PathTableSize > size - header.PathTableOffset)
+			return false;
+		if (header.PathTableSize > 0 && data[header.PathTableOffset + header.PathTableSize - 1] != '\0')
+			return false;
+
+		const PackEntry *entries = reinterpret_cast<const PackEntry*>(data + header.IndexOffset);
+		for (unsigned int i = 0; i < header.EntryCount; ++i) {
+			const PackEntry &entry = entries[i];
+			if (entry.DataOffset > size || entry.StoredSize > size - entry.DataOffset || entry.PathOffset >= header.PathTableSize)
+				return false;
+			if (!(entry.Flags & PackEntryLZ4) && entry.StoredSize != entry.Size)
+				return false;
+			if (i > 0 && entries[i - 1].PathHash > entry.PathHash)
+				return false;
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <utils/MemoryMappedFile.h>
+
+namespace arcane {
+
+	// A .apak file is this header, the entry data (16 byte aligned), the index sorted by path hash, then a table of the entries' paths
+	struct PackHeader {
+		uint32_t Magic, Version;
+		uint32_t EntryCount, PathTableSize;
+		uint64_t IndexOffset, PathTableOffset;
+	};
+
+	struct PackEntry {
+		uint64_t PathHash; // FNV-1a of the normalized path, what the index is sorted and searched by
+		uint64_t DataOffset; // From the start of the file
+		uint64_t StoredSize, Size; // StoredSize is the compressed size for LZ4 entries
+		int64_t ModifiedTime; // Of the packed file, so cookers can tell if their cached output is stale
+		uint32_t PathOffset; // Into the path table, the full path is compared so hash collisions can't return the wrong file
+		uint32_t Flags; // PackEntryFlags
+	};
+
+	enum PackEntryFlags {
+		PackEntryLZ4 = 1 << 0
+	};
+
+	// Read-only archive, mapped once so opening a packed file never goes back to the file system
+	class PackArchive {
+	public:
+		PackArchive();
+
+		bool open(const std::string &archivePath);
+
+		// nullptr if the archive doesn't contain the path
+		const PackEntry* findEntry(const std::string &path) const;
+		inline const unsigned char* getStoredData(const PackEntry &entry) const { return m_File.getData() + entry.DataOffset; }
+		bool decompressEntry(const PackEntry &entry, unsigned char *outData) const; // outData has to hold entry.Size bytes
+		inline void prefetchEntry(const PackEntry &entry) const { m_File.prefetch(entry.DataOffset, entry.StoredSize); }
+
+		// Packs the files listed in a manifest (one path per line, relative to the working directory like every other resource path).
+		// Files are LZ4 compressed when that saves at least PACK_MIN_COMPRESSION_SAVING of their size. Usable as an offline build step
+		static bool buildArchive(const std::string &archivePath, const std::string &manifestPath);
+
+		static std::string normalizePath(const std::string &path);
+		static uint64_t hashPath(const std::string &normalizedPath);
+	private:
+		bool validate() const;
+	private:
+		MemoryMappedFile m_File;
+		const PackHeader *m_Header;
+		const PackEntry *m_Entries;
+		const char *m_PathTable;
+
+		static const uint32_t s_Magic = 0x4b415041; // "APAK"
+		static const uint32_t s_Version = 1;
+	};
+
+}
@@ -0,0 +1,223 @@
+#include "pch.h"
+#include "Profiler.h"
+
+#include <utils/FileUtils.h>
+
+namespace arcane {
+
+	// Hands the thread's buffer back when the thread exits, so short lived workers don't each keep a buffer around
+	struct ProfilerThreadLease {
+		ProfilerThreadBuffer *Buffer = nullptr;
+
+		~ProfilerThreadLease() {
+			if (Buffer)
+				Profiler::releaseThreadBuffer(Buffer);
+		}
+	};
+
+	static thread_local ProfilerThreadLease t_ThreadLease;
+
+	// Static declarations
+	const std::chrono::steady_clock::time_point Profiler::s_Epoch = std::chrono::steady_clock::now();
+	std::mutex Profiler::s_RegistryMutex;
+	std::vector<std::unique_ptr<ProfilerThreadBuffer>> Profiler::s_ThreadBuffers;
+	uint64_t Profiler::s_FrameIndex = 0;
+	uint64_t Profiler::s_LastFrameEnd = 0;
+	std::deque<uint64_t> Profiler::s_FrameStarts;
+	unsigned int Profiler::s_CaptureFramesLeft = 0;
+	uint64_t Profiler::s_CaptureStart = 0;
+	uint64_t Profiler::s_SpikeCooldownEndFrame = 0;
+	bool Profiler::s_SpikeCaptureEnabled = true;
+	std::string Profiler::s_LastCapturePath;
+	std::future<void> Profiler::s_WriteJob;
+
+	void Profiler::recordZone(const char *name, uint64_t start, uint64_t end) {
+		ProfilerThreadBuffer *buffer = t_ThreadLease.Buffer;
+		if (!buffer) {
+			buffer = acquireThreadBuffer();
+			t_ThreadLease.Buffer = buffer;
+		}
+
+		// Single producer, the event is written before the count that publishes it
+		uint64_t writeCount = buffer->WriteCount.load(std::memory_order_relaxed);
+		ProfilerEvent &event = buffer->Events[writeCount % PROFILER_EVENTS_PER_THREAD];
+		event.Name = name;
+		event.Start = start;
+		event.End = end;
+		buffer->WriteCount.store(writeCount + 1, std::memory_order_release);
+	}
+
+	void Profiler::setThreadName(const std::string &name) {
+		ProfilerThreadBuffer *buffer = t_ThreadLease.Buffer;
+		if (!buffer) {
+			buffer = acquireThreadBuffer();
+			t_ThreadLease.Buffer = buffer;
+		}
+
+		std::lock_guard<std::mutex> lock(s_RegistryMutex);
+		buffer->ThreadName = name;
+	}
+
+	void Profiler::getThreadZones(uint64_t start, uint64_t end, std::vector<ProfilerEvent> &outEvents) {
+		outEvents.clear();
+		ProfilerThreadBuffer *buffer = t_ThreadLease.Buffer;
+		if (!buffer)
+			return;
+
+		// Only this thread writes the buffer, so it can be read directly
+		uint64_t writeCount = buffer->WriteCount.load(std::memory_order_relaxed);
+		uint64_t first = writeCount > PROFILER_EVENTS_PER_THREAD ? writeCount - PROFILER_EVENTS_PER_THREAD : 0;
+		for (uint64_t i = first; i < writeCount; ++i) {
+			const ProfilerEvent &event = buffer->Events[i % PROFILER_EVENTS_PER_THREAD];
+			if (event.End >= start && event.End <= end)
+				outEvents.push_back(event);
+		}
+	}
+
+	void Profiler::endFrame() {
+		if (s_WriteJob.valid() && s_WriteJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+			s_WriteJob.get();
+		}
+
+		uint64_t now = getTimestamp();
+		uint64_t frameStart = s_LastFrameEnd;
+		recordZone("Frame", frameStart, now);
+
+		s_FrameStarts.push_back(frameStart);
+		while (s_FrameStarts.size() > PROFILER_SPIKE_CONTEXT_FRAMES + 1) {
+			s_FrameStarts.pop_front();
+		}
+		s_LastFrameEnd = now;
+		++s_FrameIndex;
+
+		if (s_CaptureFramesLeft > 0) {
+			if (--s_CaptureFramesLeft == 0)
+				capture(s_CaptureStart, now, "requested");
+		}
+		else if (s_SpikeCaptureEnabled && s_FrameIndex >= s_SpikeCooldownEndFrame && (now - frameStart) / 1000000.0 > PROFILER_SPIKE_THRESHOLD_MS) {
+			capture(s_FrameStarts.front(), now, "spike");
+		}
+	}
+
+	void Profiler::requestCapture(unsigned int frameCount) {
+		if (frameCount == 0 || s_CaptureFramesLeft > 0)
+			return;
+
+		s_CaptureStart = s_LastFrameEnd;
+		s_CaptureFramesLeft = frameCount;
+	}
+
+	void Profiler::shutdown() {
+		if (s_WriteJob.valid()) {
+			s_WriteJob.get();
+		}
+	}
+
+	ProfilerThreadBuffer* Profiler::acquireThreadBuffer() {
+		std::lock_guard<std::mutex> lock(s_RegistryMutex);
+		for (std::unique_ptr<ProfilerThreadBuffer> &buffer : s_ThreadBuffers) {
+			if (!buffer->InUse) {
+				buffer->InUse = true;
+				buffer->ThreadName.clear();
+				return buffer.get();
+			}
+		}
+
+		std::unique_ptr<ProfilerThreadBuffer> buffer(new ProfilerThreadBuffer());
+		buffer->WriteCount.store(0, std::memory_order_relaxed);
+		buffer->ThreadIndex = (unsigned int)s_ThreadBuffers.size();
+		buffer->InUse = true;
+		s_ThreadBuffers.push_back(std::move(buffer));
+		return s_ThreadBuffers.back().get();
+	}
+
+	void Profiler::releaseThreadBuffer(ProfilerThreadBuffer *buffer) {
+		std::lock_guard<std::mutex> lock(s_RegistryMutex);
+		buffer->InUse = false;
+	}
+
+	void Profiler::capture(uint64_t start, uint64_t end, const char *reason) {
+		s_SpikeCooldownEndFrame = s_FrameIndex + PROFILER_SPIKE_COOLDOWN_FRAMES;
+
+		std::vector<std::vector<ProfilerEvent>> threadEvents;
+		std::vector<std::string> threadNames;
+		{
+			std::lock_guard<std::mutex> lock(s_RegistryMutex);
+			threadEvents.resize(s_ThreadBuffers.size());
+			threadNames.resize(s_ThreadBuffers.size());
+			for (const std::unique_ptr<ProfilerThreadBuffer> &buffer : s_ThreadBuffers) {
+				std::vector<ProfilerEvent> &events = threadEvents[buffer->ThreadIndex];
+				threadNames[buffer->ThreadIndex] = buffer->ThreadName.empty() ? "Thread " + std::to_string(buffer->ThreadIndex) : buffer->ThreadName;
+
+				uint64_t writeCount = buffer->WriteCount.load(std::memory_order_acquire);
+				uint64_t first = writeCount > PROFILER_EVENTS_PER_THREAD ? writeCount - PROFILER_EVENTS_PER_THREAD : 0;
+				std::vector<ProfilerEvent> copied;
+				copied.reserve((size_t)(writeCount - first));
+				for (uint64_t i = first; i < writeCount; ++i) {
+					copied.push_back(buffer->Events[i % PROFILER_EVENTS_PER_THREAD]);
+				}
+
+				// The owning thread kept writing while this copied, anything it could have overwritten since is dropped
+				std::atomic_thread_fence(std::memory_order_acquire);
+				uint64_t laterWriteCount = buffer->WriteCount.load(std::memory_order_relaxed);
+				uint64_t firstValid = laterWriteCount >= PROFILER_EVENTS_PER_THREAD ? laterWriteCount - PROFILER_EVENTS_PER_THREAD + 1 : 0;
+				for (uint64_t i = first; i < writeCount; ++i) {
+					const ProfilerEvent &event = copied[(size_t)(i - first)];
+					if (i >= firstValid && event.End >= start && event.Start <= end)
+						events.push_back(event);
+				}
+			}
+		}
+
+		if (s_WriteJob.valid()) {
+			s_WriteJob.get();
+		}
+
+		FileUtils::createDirectories(PROFILER_CAPTURE_DIRECTORY);
+		std::string path = std::string(PROFILER_CAPTURE_DIRECTORY) + "capture_frame" + std::to_string(s_FrameIndex) + "_" + reason + ".json";
+		s_LastCapturePath = path;
+		s_WriteJob = std::async(std::launch::async, [path, threadEvents, threadNames]() {
+			writeTrace(path, threadEvents, threadNames);
+		});
+	}
+
+	void Profiler::writeTrace(const std::string &path, const std::vector<std::vector<ProfilerEvent>> &threadEvents, const std::vector<std::string> &threadNames) {
+		std::ofstream output(path, std::ios::out | std::ios::trunc);
+		if (!output) {
+			Logger::getInstance().error("logged_files/profiler.txt", "profiler", "Couldn't write capture: " + path);
+			return;
+		}
+
+		auto writeEscaped = [&output](const char *text) {
+			for (; *text; ++text) {
+				if (*text == '"' || *text == '\\')
+					output << '\\';
+				output << *text;
+			}
+		};
+
+		// Chrome trace event format, timestamps are in microseconds
+		output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool firstEvent = true;
+		char timing[64];
+		for (size_t thread = 0; thread < threadEvents.size(); ++thread) {
+			output << (firstEvent ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":\"";
+			writeEscaped(threadNames[thread].c_str());
+			output << "\"}}";
+			firstEvent = false;
+
+			for (const ProfilerEvent &event : threadEvents[thread]) {
+				output << ",\n{\"name\":\"";
+				writeEscaped(event.Name);
+				snprintf(timing, sizeof(timing), "\",\"ts\":%.3f,\"dur\":%.3f", event.Start / 1000.0, (event.End - event.Start) / 1000.0);
+				output << timing << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread << "}";
+			}
+		}
+		output << "\n]}\n";
+
+		if (!output) {
+			Logger::getInstance().error("logged_files/profiler.txt", "profiler", "Couldn't write capture: " + path);
+		}
+	}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+namespace arcane {
+
+	struct ProfilerEvent {
+		const char *Name; // Not copied, zone names have to be string literals
+		uint64_t Start, End; // Nanoseconds since the profiler started
+	};
+
+	// Only ever written by the thread it belongs to. Captures read it without locking and drop whatever was overwritten while they were reading
+	struct ProfilerThreadBuffer {
+		std::array<ProfilerEvent, PROFILER_EVENTS_PER_THREAD> Events;
+		std::atomic<uint64_t> WriteCount;
+		unsigned int ThreadIndex;
+		std::string ThreadName; // Guarded by the profiler's registry mutex
+		bool InUse; // Buffers of threads that have exited are handed to the next new thread
+	};
+
+	// Scoped CPU zones recorded into per thread ring buffers, captured to Chrome trace JSON (chrome://tracing or ui.perfetto.dev).
+	// Captures are taken on request or automatically when a frame takes longer than PROFILER_SPIKE_THRESHOLD_MS
+	class Profiler {
+	public:
+		static inline uint64_t getTimestamp() {
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Epoch).count();
+		}
+
+		static void recordZone(const char *name, uint64_t start, uint64_t end);
+		static void setThreadName(const std::string &name);
+		// Zones the calling thread recorded that ended within [start, end], oldest first. Only as far back as its ring buffer goes
+		static void getThreadZones(uint64_t start, uint64_t end, std::vector<ProfilerEvent> &outEvents);
+
+		// Call on the main thread once a frame. The first frame counts from startup, so a spike capture of it covers loading as well
+		static void endFrame();
+
+		// Captures frameCount frames, starting with the current one
+		static void requestCapture(unsigned int frameCount = PROFILER_CAPTURE_FRAMES);
+		static void shutdown(); // Waits for a capture that is still being written
+
+		inline static bool isCapturing() { return s_CaptureFramesLeft > 0; }
+		inline static const std::string& getLastCapturePath() { return s_LastCapturePath; }
+		inline static void setSpikeCaptureEnabled(bool enabled) { s_SpikeCaptureEnabled = enabled; }
+		inline static bool getSpikeCaptureEnabled() { return s_SpikeCaptureEnabled; }
+	private:
+		static ProfilerThreadBuffer* acquireThreadBuffer();
+		static void releaseThreadBuffer(ProfilerThreadBuffer *buffer);
+		static void capture(uint64_t start, uint64_t end, const char *reason);
+		static void writeTrace(const std::string &path, const std::vector<std::vector<ProfilerEvent>> &threadEvents, const std::vector<std::string> &threadNames);
+
+		friend struct ProfilerThreadLease;
+	private:
+		static const std::chrono::steady_clock::time_point s_Epoch;
+
+		static std::mutex s_RegistryMutex;
+		static std::vector<std::unique_ptr<ProfilerThreadBuffer>> s_ThreadBuffers;
+
+		// Main thread only
+		static uint64_t s_FrameIndex;
+		static uint64_t s_LastFrameEnd;
+		static std::deque<uint64_t> s_FrameStarts; // The last PROFILER_SPIKE_CONTEXT_FRAMES frames, so a spike capture shows what led up to it
+		static unsigned int s_CaptureFramesLeft;
+		static uint64_t s_CaptureStart;
+		static uint64_t s_SpikeCooldownEndFrame;
+		static bool s_SpikeCaptureEnabled;
+		static std::string s_LastCapturePath;
+		static std::future<void> s_WriteJob; // Writing a capture happens off the main thread so it doesn't cause the next spike
+	};
+
+	class ProfilerZone {
+	public:
+		ProfilerZone(const char *name) : m_Name(name), m_Start(Profiler::getTimestamp()) {}
+		~ProfilerZone() { Profiler::recordZone(m_Name, m_Start, Profiler::getTimestamp()); }
+
+		ProfilerZone(const ProfilerZone &zone) = delete;
+		ProfilerZone& operator=(const ProfilerZone &zone) = delete;
+	private:
+		const char *m_Name;
+		uint64_t m_Start;
+	};
+
+}
+
+// Zones compile to nothing with PROFILER_ENABLED off
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+#if PROFILER_ENABLED
+#define PROFILE_ZONE(name) ::arcane::ProfilerZone PROFILER_CONCAT(profilerZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#define PROFILE_THREAD_NAME(name) ::arcane::Profiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#endif
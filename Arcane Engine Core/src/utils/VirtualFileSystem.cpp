@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "VirtualFileSystem.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace arcane {
+
+	// Static declarations
+	std::vector<std::unique_ptr<PackArchive>> VirtualFileSystem::s_Archives;
+
+	bool VirtualFileSystem::mountArchive(const std::string &archivePath) {
+		// Running from loose files is normal during development, so a missing archive isn't an error
+		struct stat info;
+		if (stat(archivePath.c_str(), &info) != 0)
+			return false;
+
+		std::unique_ptr<PackArchive> archive(new PackArchive());
+		if (!archive->open(archivePath))
+			return false;
+
+		s_Archives.insert(s_Archives.begin(), std::move(archive));
+		return true;
+	}
+
+	void VirtualFileSystem::unmountArchives() {
+		s_Archives.clear();
+	}
+
+	bool VirtualFileSystem::exists(const std::string &path) {
+		const PackArchive *archive;
+		if (findEntry(path, archive))
+			return true;
+
+		struct stat info;
+		return stat(path.c_str(), &info) == 0;
+	}
+
+	bool VirtualFileSystem::openFile(const std::string &path, VirtualFile &outFile) {
+		outFile.m_Buffer.clear();
+		outFile.m_Data = nullptr;
+		outFile.m_Size = 0;
+
+		const PackArchive *archive;
+		const PackEntry *entry = findEntry(path, archive);
+		if (entry) {
+			archive->prefetchEntry(*entry);
+
+			// Uncompressed entries are read straight out of the mapping
+			if (!(entry->Flags & PackEntryLZ4)) {
+				outFile.m_Data = archive->getStoredData(*entry);
+				outFile.m_Size = entry->Size;
+				return true;
+			}
+
+			outFile.m_Buffer.resize(entry->Size);
+			if (!archive->decompressEntry(*entry, outFile.m_Buffer.data())) {
+				Logger::getInstance().error("logged_files/file_system.txt", "virtual file system", "Couldn't decompress packed file: " + path);
+				outFile.m_Buffer.clear();
+				return false;
+			}
+			outFile.m_Data = outFile.m_Buffer.data();
+			outFile.m_Size = outFile.m_Buffer.size();
+			return true;
+		}
+
+		std::ifstream input(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!input)
+			return false;
+
+		outFile.m_Buffer.resize((size_t)input.tellg());
+		input.seekg(0);
+		input.read(reinterpret_cast<char*>(outFile.m_Buffer.data()), outFile.m_Buffer.size());
+		if (!input) {
+			outFile.m_Buffer.clear();
+			return false;
+		}
+		outFile.m_Data = outFile.m_Buffer.data();
+		outFile.m_Size = outFile.m_Buffer.size();
+		return true;
+	}
+
+	bool VirtualFileSystem::getFileStamp(const std::string &path, uint64_t &outSize, int64_t &outModifiedTime) {
+		const PackArchive *archive;
+		const PackEntry *entry = findEntry(path, archive);
+		if (entry) {
+			outSize = entry->Size;
+			outModifiedTime = entry->ModifiedTime;
+			return true;
+		}
+
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+			return false;
+
+		outSize = (uint64_t)info.st_size;
+		outModifiedTime = (int64_t)info.st_mtime;
+		return true;
+	}
+
+	unsigned char* VirtualFileSystem::loadImage(const std::string &path, int *width, int *height, int *numComponents, int requiredComponents) {
+		VirtualFile file;
+		if (!openFile(path, file) || file.getSize() > (size_t)std::numeric_limits<int>::max())
+			return nullptr;
+
+		return stbi_load_from_memory(file.getData(), (int)file.getSize(), width, height, numComponents, requiredComponents);
+	}
+
+	const PackEntry* VirtualFileSystem::findEntry(const std::string &path, const PackArchive *&outArchive) {
+		for (const std::unique_ptr<PackArchive> &archive : s_Archives) {
+			const PackEntry *entry = archive->findEntry(path);
+			if (entry) {
+				outArchive = archive.get();
+				return entry;
+			}
+		}
+		return nullptr;
+	}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <utils/PackArchive.h>
+
+namespace arcane {
+
+	// A file's contents, either pointing straight into a mounted archive or read into memory
+	class VirtualFile {
+	public:
+		VirtualFile() : m_Data(nullptr), m_Size(0) {}
+
+		VirtualFile(const VirtualFile &file) = delete;
+		VirtualFile& operator=(const VirtualFile &file) = delete;
+
+		inline const unsigned char* getData() const { return m_Data; }
+		inline size_t getSize() const { return m_Size; }
+	private:
+		friend class VirtualFileSystem;
+
+		const unsigned char *m_Data;
+		size_t m_Size;
+		std::vector<unsigned char> m_Buffer; // Owns the data unless it is an uncompressed archive entry
+	};
+
+	// Every loader reads resources through here. Mounted archives are searched first (most recently mounted first), then the loose files on disk
+	class VirtualFileSystem {
+	public:
+		// Mount before anything starts loading, reads from worker threads don't lock. Returns false if the archive is missing or invalid
+		static bool mountArchive(const std::string &archivePath);
+		static void unmountArchives();
+
+		static bool exists(const std::string &path);
+		static bool openFile(const std::string &path, VirtualFile &outFile);
+		// Size and modification time of the file, what cookers use to decide if their cached output is stale
+		static bool getFileStamp(const std::string &path, uint64_t &outSize, int64_t &outModifiedTime);
+
+		// stb_image decode of a file, free the result with stbi_image_free
+		static unsigned char* loadImage(const std::string &path, int *width, int *height, int *numComponents, int requiredComponents);
+	private:
+		static const PackEntry* findEntry(const std::string &path, const PackArchive *&outArchive);
+	private:
+		static std::vector<std::unique_ptr<PackArchive>> s_Archives;
+	};
+
+}
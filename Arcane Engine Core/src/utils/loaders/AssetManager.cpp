@@ -0,0 +1,228 @@
+#include "pch.h"
+#include "AssetManager.h"
+
+#include <graphics/mesh/Model.h>
+#include <graphics/texture/TextureStreamer.h>
+#include <utils/loaders/ModelCooker.h>
+#include <utils/loaders/TextureLoader.h>
+
+namespace arcane {
+
+	// Static declarations
+	std::mutex AssetManager::s_EntryMutex;
+	std::unordered_map<std::string, AssetEntry*> AssetManager::s_Entries;
+	std::deque<AssetEntry*> AssetManager::s_ReleasedEntries;
+	uint64_t AssetManager::s_FrameIndex = 0;
+	std::vector<PendingModelLoad> AssetManager::s_PendingModelLoads;
+
+	template<>
+	void AssetManager::destroyAsset<Texture>(void *asset) {
+		Texture *texture = static_cast<Texture*>(asset);
+		TextureStreamer::unregisterTexture(texture);
+		delete texture;
+	}
+
+	AssetHandle<Shader> AssetManager::loadShader(const std::string &path) {
+		return loadWith<Shader>("shader:" + path, [&path]() {
+			return new Shader(path);
+		});
+	}
+
+	AssetHandle<Texture> AssetManager::load2DTexture(const std::string &path, const TextureSettings &settings) {
+		return loadWith<Texture>(getTextureKey(path, settings), [&path, &settings]() {
+			return TextureLoader::create2DTexture(path, settings);
+		});
+	}
+
+	AssetHandle<Texture> AssetManager::load2DTextureAsync(const std::string &path, const TextureSettings &settings, const glm::vec4 &placeholderColour) {
+		// Shares the key with synchronous loads, whichever is requested first decides how the texture is loaded
+		bool created;
+		AssetHandle<Texture> handle(acquireEntry(getTextureKey(path, settings), created));
+		if (!created)
+			return handle;
+
+		handle.m_Entry->Asset = TextureLoader::createPlaceholderTexture(settings, placeholderColour);
+		handle.m_Entry->DestroyAsset = &AssetManager::destroyAsset<Texture>;
+		TextureLoader::request2DTextureDecode(handle, path, settings);
+		return handle;
+	}
+
+	AssetHandle<Model> AssetManager::loadModel(const std::string &path, bool keepCPUData) {
+		return loadWith<Model>(std::string(keepCPUData ? "model+cpu:" : "model:") + path, [&path, keepCPUData]() {
+			return new Model(path.c_str(), keepCPUData);
+		});
+	}
+
+	AssetHandle<Model> AssetManager::loadModelAsync(const std::string &path, bool keepCPUData) {
+		bool created;
+		AssetHandle<Model> handle(acquireEntry(std::string(keepCPUData ? "model+cpu:" : "model:") + path, created));
+		if (!created)
+			return handle;
+
+		handle.m_Entry->Asset = new Model();
+		handle.m_Entry->DestroyAsset = &AssetManager::destroyAsset<Model>;
+
+		// Mapping the cooked model (or importing and cooking the source) only touches the CPU, so it runs on its own thread
+		PendingModelLoad load;
+		load.Target = handle;
+		load.KeepCPUData = keepCPUData;
+		load.Cooked = std::make_shared<CookedModel>();
+		std::shared_ptr<CookedModel> cooked = load.Cooked;
+		load.Cooking = std::async(std::launch::async, [path, cooked]() {
+			return ModelCooker::loadOrCookModel(path, *cooked);
+		});
+		s_PendingModelLoads.push_back(std::move(load));
+		return handle;
+	}
+
+	std::string AssetManager::getTextureKey(const std::string &path, const TextureSettings &settings) {
+		// Every setting that changes the texture that gets created, so the same image loaded two different ways is cached twice
+		char settingsKey[256];
+		snprintf(settingsKey, sizeof(settingsKey), "|%x|%d%d|%x|%x|%d|%g,%g,%g,%g|%x|%x|%g|%d|%d",
+			settings.TextureFormat, settings.IsSRGB, settings.IsNormalMap, settings.TextureWrapSMode, settings.TextureWrapTMode, settings.HasBorder,
+			settings.BorderColour.r, settings.BorderColour.g, settings.BorderColour.b, settings.BorderColour.a,
+			settings.TextureMinificationFilterMode, settings.TextureMagnificationFilterMode, settings.TextureAnisotropyLevel, settings.HasMips, settings.MipBias);
+		return "texture:" + path + settingsKey;
+	}
+
+	void AssetManager::update() {
+		PROFILE_FUNCTION();
+		uploadCookedModels(ASSET_MODEL_UPLOADS_PER_FRAME);
+
+		// Destroy whatever was released long enough ago and hasn't been requested again since
+		std::vector<AssetEntry*> destroyedEntries;
+		{
+			std::lock_guard<std::mutex> lock(s_EntryMutex);
+			s_FrameIndex++;
+			while (!s_ReleasedEntries.empty() && s_ReleasedEntries.front()->ReleaseFrame + ASSET_DESTRUCTION_DELAY_FRAMES <= s_FrameIndex) {
+				AssetEntry *entry = s_ReleasedEntries.front();
+				s_ReleasedEntries.pop_front();
+				entry->QueuedForRelease = false;
+				if (entry->RefCount == 0) {
+					s_Entries.erase(entry->Key);
+					destroyedEntries.push_back(entry);
+				}
+			}
+		}
+
+		// Outside of the lock, destroying a model releases its textures
+		for (AssetEntry *entry : destroyedEntries) {
+			if (entry->Asset) {
+				entry->DestroyAsset(entry->Asset);
+			}
+			delete entry;
+		}
+	}
+
+	void AssetManager::finishAsyncLoads() {
+		PROFILE_FUNCTION();
+		while (!s_PendingModelLoads.empty()) {
+			uploadCookedModels(std::numeric_limits<unsigned int>::max());
+			if (!s_PendingModelLoads.empty()) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void AssetManager::shutdown() {
+		// Let the workers finish with their cooked models, then throw the results away
+		for (PendingModelLoad &load : s_PendingModelLoads) {
+			load.Cooking.wait();
+			completeLoad(load.Target.m_Entry);
+		}
+		s_PendingModelLoads.clear();
+
+		// Assets that are still referenced are left to the OS
+		std::vector<AssetEntry*> destroyedEntries;
+		{
+			std::lock_guard<std::mutex> lock(s_EntryMutex);
+			for (AssetEntry *entry : s_ReleasedEntries) {
+				entry->QueuedForRelease = false;
+				if (entry->RefCount == 0) {
+					s_Entries.erase(entry->Key);
+					destroyedEntries.push_back(entry);
+				}
+			}
+			s_ReleasedEntries.clear();
+		}
+		for (AssetEntry *entry : destroyedEntries) {
+			if (entry->Asset) {
+				entry->DestroyAsset(entry->Asset);
+			}
+			delete entry;
+		}
+	}
+
+	AssetEntry* AssetManager::acquireEntry(const std::string &key, bool &outCreated) {
+		std::lock_guard<std::mutex> lock(s_EntryMutex);
+
+		// The full key is compared, so two different paths can never share an asset
+		auto iter = s_Entries.find(key);
+		if (iter != s_Entries.end()) {
+			outCreated = false;
+			++iter->second->RefCount;
+			return iter->second;
+		}
+
+		AssetEntry *entry = new AssetEntry();
+		entry->Key = key;
+		entry->Asset = nullptr;
+		entry->DestroyAsset = nullptr;
+		entry->RefCount = 1;
+		entry->Loaded = entry->LoadedPromise.get_future().share();
+		entry->IsLoaded = false;
+		entry->QueuedForRelease = false;
+		entry->ReleaseFrame = 0;
+		s_Entries.insert(std::pair<std::string, AssetEntry*>(key, entry));
+
+		outCreated = true;
+		return entry;
+	}
+
+	void AssetManager::discardEntry(AssetEntry *entry) {
+		{
+			std::lock_guard<std::mutex> lock(s_EntryMutex);
+			s_Entries.erase(entry->Key);
+		}
+		delete entry;
+	}
+
+	void AssetManager::releaseEntry(AssetEntry *entry) {
+		std::lock_guard<std::mutex> lock(s_EntryMutex);
+
+		// The entry could have been requested again between the count reaching zero and taking the lock
+		if (entry->RefCount == 0 && !entry->QueuedForRelease) {
+			entry->QueuedForRelease = true;
+			entry->ReleaseFrame = s_FrameIndex;
+			s_ReleasedEntries.push_back(entry);
+		}
+	}
+
+	void AssetManager::completeLoad(AssetEntry *entry) {
+		if (!entry || entry->IsLoaded)
+			return;
+
+		entry->IsLoaded = true;
+		entry->LoadedPromise.set_value();
+	}
+
+	void AssetManager::uploadCookedModels(unsigned int maxUploads) {
+		unsigned int uploads = 0;
+		auto iter = s_PendingModelLoads.begin();
+		while (iter != s_PendingModelLoads.end() && uploads < maxUploads) {
+			if (iter->Cooking.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				iter++;
+				continue;
+			}
+
+			// A model that failed to load stays empty, the cooker has already logged why
+			if (iter->Cooking.get()) {
+				iter->Target->loadCooked(*iter->Cooked, iter->KeepCPUData);
+			}
+			completeLoad(iter->Target.m_Entry);
+			iter = s_PendingModelLoads.erase(iter);
+			uploads++;
+		}
+	}
+
+}
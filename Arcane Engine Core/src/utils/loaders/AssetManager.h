@@ -0,0 +1,140 @@
+#pragma once
+
+#include <graphics/Shader.h>
+#include <graphics/texture/Texture.h>
+
+namespace arcane {
+
+	class Model;
+	class CookedModel;
+
+	// Shared state behind every handle to a cached asset. The asset is created and destroyed on the GL thread, the reference count can change on any thread
+	struct AssetEntry {
+		std::string Key; // The path plus anything else that changes the loaded result (settings, CPU data)
+		void *Asset;
+		void (*DestroyAsset)(void *asset);
+		std::atomic<unsigned int> RefCount;
+
+		std::promise<void> LoadedPromise;
+		std::shared_future<void> Loaded; // Ready once the asset is fully loaded, straight away for synchronous loads
+		bool IsLoaded; // GL thread only
+
+		// Guarded by the manager's mutex
+		bool QueuedForRelease;
+		uint64_t ReleaseFrame;
+	};
+
+	// Reference counted handle to a cached asset. Once the last handle is gone the asset is destroyed a few frames later, unless it is requested again first
+	template<typename T>
+	class AssetHandle {
+	public:
+		AssetHandle() : m_Entry(nullptr) {}
+		AssetHandle(const AssetHandle &handle) : m_Entry(handle.m_Entry) { if (m_Entry) ++m_Entry->RefCount; }
+		AssetHandle(AssetHandle &&handle) noexcept : m_Entry(handle.m_Entry) { handle.m_Entry = nullptr; }
+		~AssetHandle() { reset(); }
+
+		AssetHandle& operator=(AssetHandle handle) noexcept {
+			std::swap(m_Entry, handle.m_Entry);
+			return *this;
+		}
+
+		void reset();
+
+		inline T* get() const { return m_Entry ? static_cast<T*>(m_Entry->Asset) : nullptr; }
+		inline T* operator->() const { return get(); }
+		inline explicit operator bool() const { return get() != nullptr; }
+
+		// Until the future is ready an asynchronously loaded asset is a placeholder (an empty model or a 1x1 texture)
+		inline std::shared_future<void> getLoadedFuture() const { return m_Entry ? m_Entry->Loaded : std::shared_future<void>(); }
+		inline bool isLoaded() const { return m_Entry && m_Entry->Loaded.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+	private:
+		friend class AssetManager;
+		explicit AssetHandle(AssetEntry *entry) : m_Entry(entry) {} // Adopts a reference the manager already took
+
+		AssetEntry *m_Entry;
+	};
+
+	struct PendingModelLoad {
+		AssetHandle<Model> Target;
+		bool KeepCPUData;
+		std::shared_ptr<CookedModel> Cooked;
+		std::future<bool> Cooking; // Reading (and cooking if needed) on a worker, the upload waits for the GL thread
+	};
+
+	class AssetManager {
+	public:
+		// Requesting an asset whose key is already cached (even if it is still loading) returns another handle to it. Request assets from the GL thread
+		static AssetHandle<Shader> loadShader(const std::string &path);
+		static AssetHandle<Texture> load2DTexture(const std::string &path, const TextureSettings &settings = TextureSettings());
+		// Returns a 1x1 placeholder straight away, the file is decoded by the TextureLoader's workers and swapped in by TextureLoader::updateAsyncLoads
+		static AssetHandle<Texture> load2DTextureAsync(const std::string &path, const TextureSettings &settings = TextureSettings(), const glm::vec4 &placeholderColour = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+		static AssetHandle<Model> loadModel(const std::string &path, bool keepCPUData = false);
+		// Returns an empty model straight away, it is read (and cooked if needed) on a worker thread and its meshes are uploaded by update
+		static AssetHandle<Model> loadModelAsync(const std::string &path, bool keepCPUData = false);
+
+		// Caches an asset built by the caller, create() only runs if nothing with the same key is cached. Returns an empty handle if it fails
+		template<typename T, typename Creator>
+		static AssetHandle<T> loadWith(const std::string &key, Creator create);
+
+		template<typename T>
+		static void markLoaded(const AssetHandle<T> &handle) { completeLoad(handle.m_Entry); }
+
+		static std::string getTextureKey(const std::string &path, const TextureSettings &settings);
+
+		static void update(); // Call on the GL thread once a frame
+		static void finishAsyncLoads(); // Blocks until every requested model has been uploaded
+		static void shutdown();
+
+		inline static size_t getCachedAssetCount() { std::lock_guard<std::mutex> lock(s_EntryMutex); return s_Entries.size(); }
+	private:
+		template<typename T> friend class AssetHandle;
+
+		// Returns the cached entry for the key with a reference taken for the caller, outCreated is set if the entry is new and still needs its asset
+		static AssetEntry* acquireEntry(const std::string &key, bool &outCreated);
+		static void discardEntry(AssetEntry *entry); // For entries whose asset failed to be created
+		static void releaseEntry(AssetEntry *entry); // The last handle to the entry is gone
+		static void completeLoad(AssetEntry *entry);
+		static void uploadCookedModels(unsigned int maxUploads);
+
+		template<typename T>
+		static void destroyAsset(void *asset) { delete static_cast<T*>(asset); }
+	private:
+		static std::mutex s_EntryMutex;
+		static std::unordered_map<std::string, AssetEntry*> s_Entries;
+		static std::deque<AssetEntry*> s_ReleasedEntries; // In release order, so the oldest are at the front
+		static uint64_t s_FrameIndex;
+
+		static std::vector<PendingModelLoad> s_PendingModelLoads; // GL thread only
+	};
+
+	// Streamed textures have to be unregistered before they go
+	template<> void AssetManager::destroyAsset<Texture>(void *asset);
+
+	template<typename T>
+	void AssetHandle<T>::reset() {
+		if (m_Entry && --m_Entry->RefCount == 0) {
+			AssetManager::releaseEntry(m_Entry);
+		}
+		m_Entry = nullptr;
+	}
+
+	template<typename T, typename Creator>
+	AssetHandle<T> AssetManager::loadWith(const std::string &key, Creator create) {
+		bool created;
+		AssetHandle<T> handle(acquireEntry(key, created));
+		if (!created)
+			return handle;
+
+		T *asset = create();
+		if (!asset) {
+			discardEntry(handle.m_Entry);
+			handle.m_Entry = nullptr;
+			return handle;
+		}
+		handle.m_Entry->Asset = asset;
+		handle.m_Entry->DestroyAsset = &AssetManager::destroyAsset<T>;
+		completeLoad(handle.m_Entry);
+		return handle;
+	}
+
+}
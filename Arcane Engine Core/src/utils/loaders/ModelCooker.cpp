@@ -0,0 +1,431 @@
+#include "pch.h"
+#include "ModelCooker.h"
+
+#include <graphics/mesh/MeshOptimizer.h>
+#include <graphics/mesh/VertexLayout.h>
+#include <utils/FileUtils.h>
+#include <utils/VirtualFileSystem.h>
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+namespace arcane {
+
+	static_assert(sizeof(CookedModelHeader) % 16 == 0, "Cooked model header has to keep the records after it aligned");
+	static_assert(sizeof(CookedMeshRecord) % 8 == 0, "Cooked mesh records have to stay aligned");
+
+	static size_t alignBlobOffset(size_t offset) {
+		return (offset + 15) & ~(size_t)15;
+	}
+
+	// Copied out rather than dereferenced, a corrupt entry's offsets aren't guaranteed to be aligned
+	template<typename IndexType>
+	static bool indicesInRange(const unsigned char *indexData, uint32_t indexCount, uint32_t vertexCount) {
+		for (uint32_t i = 0; i < indexCount; ++i) {
+			IndexType index;
+			memcpy(&index, indexData + (size_t)i * sizeof(IndexType), sizeof(IndexType));
+			if (index >= vertexCount)
+				return false;
+		}
+		return true;
+	}
+
+	// Read-only stream over a file from the virtual file system
+	class VirtualIOStream : public Assimp::IOStream {
+	public:
+		VirtualIOStream() : m_Position(0) {}
+
+		size_t Read(void *buffer, size_t size, size_t count) override {
+			if (size == 0)
+				return 0;
+
+			size_t readCount = std::min(count, (m_File.getSize() - m_Position) / size);
+			memcpy(buffer, m_File.getData() + m_Position, readCount * size);
+			m_Position += readCount * size;
+			return readCount;
+		}
+		size_t Write(const void *buffer, size_t size, size_t count) override { return 0; }
+
+		aiReturn Seek(size_t offset, aiOrigin origin) override {
+			size_t base = origin == aiOrigin_SET ? 0 : (origin == aiOrigin_CUR ? m_Position : m_File.getSize());
+			if (base + offset > m_File.getSize())
+				return aiReturn_FAILURE;
+
+			m_Position = base + offset;
+			return aiReturn_SUCCESS;
+		}
+		size_t Tell() const override { return m_Position; }
+		size_t FileSize() const override { return m_File.getSize(); }
+		void Flush() override {}
+
+		inline VirtualFile& getFile() { return m_File; }
+	private:
+		VirtualFile m_File;
+		size_t m_Position;
+	};
+
+	// Routes Assimp's reads, the model and anything it references (like .mtl files), through the virtual file system
+	class VirtualIOSystem : public Assimp::IOSystem {
+	public:
+		bool Exists(const char *path) const override { return VirtualFileSystem::exists(path); }
+		char getOsSeparator() const override { return '/'; }
+
+		Assimp::IOStream* Open(const char *path, const char *mode) override {
+			if (strchr(mode, 'w') || strchr(mode, 'a'))
+				return nullptr;
+
+			VirtualIOStream *stream = new VirtualIOStream();
+			if (!VirtualFileSystem::openFile(path, stream->getFile())) {
+				delete stream;
+				return nullptr;
+			}
+			return stream;
+		}
+		void Close(Assimp::IOStream *stream) override { delete stream; }
+	};
+
+	// A mesh converted by one of the cooking workers, before it is placed in the output
+	struct CookedMeshData {
+		CookedMeshRecord Record; // Data offsets and texture path offsets are filled in once the mesh is placed
+		std::vector<unsigned char> VertexData, IndexData;
+		std::string TexturePaths[CookedTextureSlotCount];
+	};
+
+	// Reads a vertex out of the importer, attributes the mesh doesn't have are zeroed
+	static void readVertex(const aiMesh *mesh, unsigned int i, FullPrecisionVertex &vertex) {
+		vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+		vertex.Normal = mesh->mNormals ? glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z) : glm::vec3(0.0f);
+
+		// A vertex can contain up to 8 different texture coordinates. We are just going to use one set of TexCoords per vertex so grab the first one
+		vertex.UV = mesh->mTextureCoords[0] ? glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y) : glm::vec2(0.0f);
+
+		if (mesh->mTangents && mesh->mBitangents) {
+			vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+			vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+		}
+		else {
+			vertex.Tangent = vertex.Bitangent = glm::vec3(0.0f);
+		}
+	}
+
+	// Converts one mesh to its cooked blobs. Runs on the cooking workers, so it only reads the scene and writes to outMesh
+	static void cookMesh(const aiScene *scene, const aiMesh *mesh, CookedVertexFormat vertexFormat, const glm::vec3 &modelBoundsMin, const glm::vec3 &boundsExtent,
+		const std::string &directory, CookedMeshData &outMesh) {
+		CookedMeshRecord &record = outMesh.Record;
+		memset(&record, 0, sizeof(record));
+
+		// Loop through every face (triangle thanks to aiProcess_Triangulate) and stores its indices in our meshes indices. This will ensure they are in the right order.
+		// Point and line primitives survive triangulation but can't be drawn as triangles, so they are skipped
+		std::vector<unsigned int> indices;
+		indices.reserve(mesh->mNumFaces * 3);
+		for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+			const aiFace &face = mesh->mFaces[i];
+			if (face.mNumIndices == 3) {
+				indices.insert(indices.end(), face.mIndices, face.mIndices + 3);
+			}
+		}
+
+		// Reorder the triangles for the vertex cache then overdraw, and the vertices for fetch locality
+		unsigned int vertexCount = mesh->mNumVertices;
+		std::vector<unsigned int> remap;
+#if MESH_OPTIMIZATION_ENABLED
+		static_assert(sizeof(aiVector3D) == sizeof(glm::vec3), "Assimp has to be built with single precision positions");
+		std::vector<unsigned int> clusters = MeshOptimizer::optimizeVertexCache(indices, mesh->mNumVertices);
+		MeshOptimizer::optimizeOverdraw(indices, clusters, reinterpret_cast<const glm::vec3*>(mesh->mVertices), mesh->mNumVertices);
+		vertexCount = MeshOptimizer::optimizeVertexFetch(indices, mesh->mNumVertices, remap);
+#else
+		remap.resize(mesh->mNumVertices);
+		for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+			remap[i] = i;
+		}
+#endif
+
+		// Vertices are encoded in place at their remapped position
+		size_t vertexSize = vertexFormat == CookedCompactVertices ? sizeof(CompactVertex) : sizeof(FullPrecisionVertex);
+		record.VertexCount = vertexCount;
+		outMesh.VertexData.assign(vertexCount * vertexSize, 0);
+
+		glm::vec3 boundsMin(std::numeric_limits<float>::max()), boundsMax(std::numeric_limits<float>::lowest());
+		float boundingRadius = 0.0f;
+		FullPrecisionVertex vertex;
+		for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+			if (remap[i] == ~0u)
+				continue;
+
+			readVertex(mesh, i, vertex);
+			unsigned char *destination = &outMesh.VertexData[remap[i] * vertexSize];
+			if (vertexFormat == CookedCompactVertices) {
+				CompactVertex compactVertex = CompactVertex::encode(vertex.Position, vertex.Normal, vertex.UV, vertex.Tangent, vertex.Bitangent, modelBoundsMin, boundsExtent);
+				memcpy(destination, &compactVertex, sizeof(compactVertex));
+			}
+			else {
+				memcpy(destination, &vertex, sizeof(vertex));
+			}
+
+			boundsMin = glm::min(boundsMin, vertex.Position);
+			boundsMax = glm::max(boundsMax, vertex.Position);
+			boundingRadius = std::max(boundingRadius, glm::length(vertex.Position));
+		}
+		if (vertexCount == 0) {
+			boundsMin = boundsMax = glm::vec3(0.0f);
+		}
+		memcpy(record.PositionScale, &boundsExtent[0], sizeof(record.PositionScale));
+		memcpy(record.PositionOffset, &modelBoundsMin[0], sizeof(record.PositionOffset));
+		memcpy(record.BoundsMin, &boundsMin[0], sizeof(record.BoundsMin));
+		memcpy(record.BoundsMax, &boundsMax[0], sizeof(record.BoundsMax));
+		record.BoundingRadius = boundingRadius;
+
+		// 16 bit indices whenever the vertices allow it
+		record.IndexCount = indices.size();
+		record.IndexSize = vertexCount <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+		outMesh.IndexData.resize(indices.size() * record.IndexSize);
+		if (record.IndexSize == sizeof(uint16_t)) {
+			uint16_t *destination = reinterpret_cast<uint16_t*>(outMesh.IndexData.data());
+			std::copy(indices.begin(), indices.end(), destination);
+		}
+		else if (!indices.empty()) {
+			memcpy(outMesh.IndexData.data(), &indices[0], indices.size() * sizeof(uint32_t));
+		}
+
+		// Material references, assumption made: material stuff is located in the same directory as the model object
+		static const aiTextureType s_SlotTypes[CookedTextureSlotCount] = { aiTextureType_DIFFUSE, aiTextureType_NORMALS, aiTextureType_AMBIENT, aiTextureType_DISPLACEMENT };
+		const aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+		for (unsigned int slot = 0; slot < CookedTextureSlotCount; ++slot) {
+			if (material->GetTextureCount(s_SlotTypes[slot]) == 0)
+				continue;
+
+			// Log material constraints are being violated (1 texture per type for the standard shader)
+			if (material->GetTextureCount(s_SlotTypes[slot]) > 1)
+				Logger::getInstance().error("logged_files/material_creation.txt", "Mesh Loading", "Mesh's default material contains more than 1 texture for the same type, which currently isn't supported by the standard shader");
+
+			aiString str;
+			material->GetTexture(s_SlotTypes[slot], 0, &str); // Grab only the first texture (standard shader only supports one texture of each type, it doesn't know how you want to do special blending)
+			outMesh.TexturePaths[slot] = directory + "/" + std::string(str.C_Str());
+		}
+	}
+
+	std::string CookedModel::getTexturePath(unsigned int mesh, CookedTextureSlot slot) const {
+		uint32_t offset = getMesh(mesh).TexturePaths[slot];
+		if (offset == ~0u)
+			return std::string();
+
+		return std::string(reinterpret_cast<const char*>(m_Data + getHeader().StringTableOffset + offset));
+	}
+
+	bool ModelCooker::loadOrCookModel(const std::string &sourcePath, CookedModel &outCooked) {
+		PROFILE_FUNCTION();
+		// Without the source around the cooked model is trusted as is, so builds can ship just the cache
+		uint64_t sourceSize = 0;
+		int64_t sourceModifiedTime = 0;
+		bool hasSource = getSourceStamp(sourcePath, sourceSize, sourceModifiedTime);
+
+		std::string cachePath = getCachePath(sourcePath);
+#if MODEL_COOKING_ENABLED
+		// A missing entry is the normal first run, only an entry that exists but can't be mapped is worth an error
+		if (VirtualFileSystem::exists(cachePath) && outCooked.m_File.open(cachePath)) {
+			if (validateCookedModel(outCooked.m_File.getData(), outCooked.m_File.getSize(), hasSource, sourceSize, sourceModifiedTime)) {
+				outCooked.m_Data = outCooked.m_File.getData();
+				outCooked.m_Size = outCooked.m_File.getSize();
+				return true;
+			}
+			outCooked.m_File.close();
+		}
+#endif
+
+		if (!hasSource || !cookModel(sourcePath, outCooked.m_Buffer))
+			return false;
+		outCooked.m_Data = outCooked.m_Buffer.data();
+		outCooked.m_Size = outCooked.m_Buffer.size();
+
+#if MODEL_COOKING_ENABLED
+		FileUtils::createDirectories(MODEL_CACHE_DIRECTORY);
+		std::ofstream output(cachePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		output.write(reinterpret_cast<const char*>(outCooked.m_Buffer.data()), outCooked.m_Buffer.size());
+		if (!output) {
+			Logger::getInstance().warning("logged_files/model_loading.txt", "model cooking", "Couldn't write cooked model to the cache: " + cachePath);
+		}
+#endif
+		return true;
+	}
+
+	bool ModelCooker::cookModel(const std::string &sourcePath, std::vector<unsigned char> &outData) {
+		PROFILE_FUNCTION();
+		Assimp::Importer import;
+		import.SetIOHandler(new VirtualIOSystem()); // Owned by the importer
+		const aiScene *scene = import.ReadFile(sourcePath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+			Logger::getInstance().error("logged_files/model_loading.txt", "model initialization", import.GetErrorString());
+			return false;
+		}
+
+		std::string directory = sourcePath.substr(0, sourcePath.find_last_of('/'));
+
+		CookedModelHeader header = {};
+		header.Magic = s_Magic;
+		header.Version = s_CookerVersion;
+		getSourceStamp(sourcePath, header.SourceSize, header.SourceModifiedTime);
+		header.VertexFormat = MESH_COMPACT_VERTEX_FORMAT ? CookedCompactVertices : CookedFullPrecisionVertices;
+		header.Optimized = MESH_OPTIMIZATION_ENABLED;
+
+		// Compact meshes are all quantized against the bounds of the whole model so they share the same grid and their seams stay closed
+		glm::vec3 modelBoundsMin(std::numeric_limits<float>::max()), modelBoundsMax(std::numeric_limits<float>::lowest());
+		float modelBoundingRadius = 0.0f;
+		for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
+			const aiMesh *mesh = scene->mMeshes[i];
+			for (unsigned int j = 0; j < mesh->mNumVertices; ++j) {
+				glm::vec3 position(mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z);
+				modelBoundsMin = glm::min(modelBoundsMin, position);
+				modelBoundsMax = glm::max(modelBoundsMax, position);
+				modelBoundingRadius = std::max(modelBoundingRadius, glm::length(position));
+			}
+		}
+		if (scene->mNumMeshes == 0) {
+			modelBoundsMin = modelBoundsMax = glm::vec3(0.0f);
+		}
+		memcpy(header.BoundsMin, &modelBoundsMin[0], sizeof(header.BoundsMin));
+		memcpy(header.BoundsMax, &modelBoundsMax[0], sizeof(header.BoundsMax));
+		header.BoundingRadius = modelBoundingRadius;
+
+		// Flat axes would divide by zero, give them a nominal extent instead
+		glm::vec3 boundsExtent = modelBoundsMax - modelBoundsMin;
+		for (int axis = 0; axis < 3; ++axis) {
+			if (boundsExtent[axis] <= 0.0f)
+				boundsExtent[axis] = 1.0f;
+		}
+
+		std::vector<const aiMesh*> meshes;
+		collectMeshes(scene->mRootNode, scene, meshes);
+		header.MeshCount = meshes.size();
+
+		// Meshes are converted independently, so they fan out across workers that each grab the next unclaimed mesh. The scene is only read
+		// from here on, and the calling thread works through the queue too instead of just waiting on the others
+		std::vector<CookedMeshData> cookedMeshes(meshes.size());
+		std::atomic<unsigned int> nextMesh(0);
+		auto cookMeshes = [&]() {
+			PROFILE_ZONE("Cook Meshes");
+			for (unsigned int m = nextMesh++; m < meshes.size(); m = nextMesh++) {
+				cookMesh(scene, meshes[m], (CookedVertexFormat)header.VertexFormat, modelBoundsMin, boundsExtent, directory, cookedMeshes[m]);
+			}
+		};
+		unsigned int workerCount = std::min<unsigned int>(std::max(std::thread::hardware_concurrency(), 1u), MODEL_COOKING_MAX_WORKERS);
+		workerCount = std::min<unsigned int>(workerCount, meshes.size());
+		std::vector<std::future<void>> workers;
+		for (unsigned int i = 1; i < workerCount; ++i) {
+			workers.push_back(std::async(std::launch::async, cookMeshes));
+		}
+		cookMeshes();
+		for (std::future<void> &worker : workers) {
+			worker.get();
+		}
+
+		// Lay the converted meshes out in their original order, the blobs are written straight into the output after the header and records
+		std::vector<CookedMeshRecord> records(meshes.size());
+		outData.assign(alignBlobOffset(sizeof(CookedModelHeader) + records.size() * sizeof(CookedMeshRecord)), 0);
+		std::string stringTable;
+		for (unsigned int m = 0; m < meshes.size(); ++m) {
+			CookedMeshData &cookedMesh = cookedMeshes[m];
+			CookedMeshRecord &record = records[m];
+			record = cookedMesh.Record;
+
+			record.VertexDataOffset = outData.size();
+			outData.insert(outData.end(), cookedMesh.VertexData.begin(), cookedMesh.VertexData.end());
+			outData.resize(alignBlobOffset(outData.size()), 0);
+			record.IndexDataOffset = outData.size();
+			outData.insert(outData.end(), cookedMesh.IndexData.begin(), cookedMesh.IndexData.end());
+			outData.resize(alignBlobOffset(outData.size()), 0);
+
+			for (unsigned int slot = 0; slot < CookedTextureSlotCount; ++slot) {
+				record.TexturePaths[slot] = ~0u;
+				if (cookedMesh.TexturePaths[slot].empty())
+					continue;
+
+				record.TexturePaths[slot] = stringTable.size();
+				stringTable += cookedMesh.TexturePaths[slot];
+				stringTable += '\0';
+			}
+		}
+
+		header.StringTableOffset = outData.size();
+		header.StringTableSize = stringTable.size();
+		outData.insert(outData.end(), stringTable.begin(), stringTable.end());
+
+		memcpy(&outData[0], &header, sizeof(header));
+		if (!records.empty()) {
+			memcpy(&outData[sizeof(header)], &records[0], records.size() * sizeof(CookedMeshRecord));
+		}
+		return true;
+	}
+
+	void ModelCooker::collectMeshes(const aiNode *node, const aiScene *scene, std::vector<const aiMesh*> &outMeshes) {
+		// Process all of the node's meshes (if any)
+		for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
+			// Each node has an array of mesh indices, use these indices to get the meshes from the scene
+			outMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+		}
+		// Process all of the node's children
+		for (unsigned int i = 0; i < node->mNumChildren; ++i) {
+			collectMeshes(node->mChildren[i], scene, outMeshes);
+		}
+	}
+
+	bool ModelCooker::validateCookedModel(const unsigned char *data, size_t size, bool checkSource, uint64_t sourceSize, int64_t sourceModifiedTime) {
+		if (size < sizeof(CookedModelHeader))
+			return false;
+
+		const CookedModelHeader &header = *reinterpret_cast<const CookedModelHeader*>(data);
+		if (header.Magic != s_Magic || header.Version != s_CookerVersion)
+			return false;
+		if (checkSource && (header.SourceSize != sourceSize || header.SourceModifiedTime != sourceModifiedTime))
+			return false;
+		if (header.VertexFormat != (MESH_COMPACT_VERTEX_FORMAT ? CookedCompactVertices : CookedFullPrecisionVertices) || header.Optimized != MESH_OPTIMIZATION_ENABLED)
+			return false;
+
+		// Every range has to be inside the file, a truncated or corrupt cache entry is re-cooked rather than read out of bounds
+		if (header.MeshCount > (size - sizeof(CookedModelHeader)) / sizeof(CookedMeshRecord))
+			return false;
+		if (header.StringTableOffset > size || header.StringTableSize > size - header.StringTableOffset)
+			return false;
+		if (header.StringTableSize > 0 && data[header.StringTableOffset + header.StringTableSize - 1] != '\0')
+			return false;
+
+		size_t vertexSize = header.VertexFormat == CookedCompactVertices ? sizeof(CompactVertex) : sizeof(FullPrecisionVertex);
+		const CookedMeshRecord *records = reinterpret_cast<const CookedMeshRecord*>(data + sizeof(CookedModelHeader));
+		for (unsigned int i = 0; i < header.MeshCount; ++i) {
+			const CookedMeshRecord &record = records[i];
+			if (record.IndexSize != sizeof(uint16_t) && record.IndexSize != sizeof(uint32_t))
+				return false;
+			if (record.VertexDataOffset > size || (uint64_t)record.VertexCount * vertexSize > size - record.VertexDataOffset)
+				return false;
+			if (record.IndexDataOffset > size || (uint64_t)record.IndexCount * record.IndexSize > size - record.IndexDataOffset)
+				return false;
+			// An index past the mesh's vertices would have the GPU read outside the vertex buffer
+			const unsigned char *indexData = data + record.IndexDataOffset;
+			bool indicesValid = record.IndexSize == sizeof(uint16_t) ? indicesInRange<uint16_t>(indexData, record.IndexCount, record.VertexCount) : indicesInRange<uint32_t>(indexData, record.IndexCount, record.VertexCount);
+			if (!indicesValid)
+				return false;
+			for (unsigned int slot = 0; slot < CookedTextureSlotCount; ++slot) {
+				if (record.TexturePaths[slot] != ~0u && record.TexturePaths[slot] >= header.StringTableSize)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool ModelCooker::getSourceStamp(const std::string &sourcePath, uint64_t &outSize, int64_t &outModifiedTime) {
+		return VirtualFileSystem::getFileStamp(sourcePath, outSize, outModifiedTime);
+	}
+
+	std::string ModelCooker::getCachePath(const std::string &sourcePath) {
+		// Hashes the source path, the header decides if the entry is still up to date
+		uint64_t hash = FileUtils::hashFNV1a(sourcePath.data(), sourcePath.size());
+
+		char hashString[17];
+		snprintf(hashString, sizeof(hashString), "%016llx", (unsigned long long)hash);
+		return std::string(MODEL_CACHE_DIRECTORY) + hashString + ".amesh";
+	}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <utils/MemoryMappedFile.h>
+
+struct aiMesh;
+struct aiScene;
+struct aiNode;
+
+namespace arcane {
+
+	enum CookedTextureSlot {
+		CookedAlbedoTexture, CookedNormalTexture, CookedAmbientOcclusionTexture, CookedDisplacementTexture,
+		CookedTextureSlotCount
+	};
+
+	enum CookedVertexFormat {
+		CookedFullPrecisionVertices, // FullPrecisionVertex
+		CookedCompactVertices // CompactVertex
+	};
+
+	// A .amesh file is this header, the mesh records, the vertex and index blobs, then a string table. Blobs are 16 byte aligned and
+	// already in the layout the GPU reads, so loading is a straight copy from the mapped file into the buffers
+	struct CookedModelHeader {
+		uint32_t Magic, Version;
+		uint64_t SourceSize;
+		int64_t SourceModifiedTime; // Together with the size, decides if the source changed since it was cooked
+		uint32_t VertexFormat; // CookedVertexFormat
+		uint32_t Optimized; // Went through the MeshOptimizer passes
+		uint32_t MeshCount, StringTableSize;
+		uint64_t StringTableOffset; // Texture paths, null terminated
+		float BoundsMin[3], BoundsMax[3], BoundingRadius;
+		uint32_t Padding;
+	};
+
+	struct CookedMeshRecord {
+		uint64_t VertexDataOffset, IndexDataOffset; // From the start of the file
+		uint32_t VertexCount, IndexCount, IndexSize; // IndexSize is 2 or 4 bytes
+		float PositionScale[3], PositionOffset[3]; // Dequantization for compact vertices
+		float BoundsMin[3], BoundsMax[3], BoundingRadius;
+		uint32_t TexturePaths[CookedTextureSlotCount]; // Offsets into the string table, ~0u if the mesh has no texture of that type
+	};
+
+	// View over a cooked model, either mapped from the cache or held in memory if it was just cooked and couldn't be cached
+	class CookedModel {
+	public:
+		CookedModel() : m_Data(nullptr), m_Size(0) {}
+
+		inline const CookedModelHeader& getHeader() const { return *reinterpret_cast<const CookedModelHeader*>(m_Data); }
+		inline const CookedMeshRecord& getMesh(unsigned int i) const { return reinterpret_cast<const CookedMeshRecord*>(m_Data + sizeof(CookedModelHeader))[i]; }
+		inline const unsigned char* getVertexData(unsigned int i) const { return m_Data + getMesh(i).VertexDataOffset; }
+		inline const unsigned char* getIndexData(unsigned int i) const { return m_Data + getMesh(i).IndexDataOffset; }
+		std::string getTexturePath(unsigned int mesh, CookedTextureSlot slot) const;
+	private:
+		friend class ModelCooker;
+
+		MemoryMappedFile m_File;
+		std::vector<unsigned char> m_Buffer;
+		const unsigned char *m_Data;
+		size_t m_Size;
+	};
+
+	class ModelCooker {
+	public:
+		// Maps the cooked version of a model from the cache, importing and cooking the source first if it changed since it was last cooked.
+		// With MODEL_COOKING_ENABLED off the model is cooked in memory every time and the cache is left alone
+		static bool loadOrCookModel(const std::string &sourcePath, CookedModel &outCooked);
+
+		// Imports a model with Assimp and lays it out as a .amesh file in outData, converting its meshes on up to MODEL_COOKING_MAX_WORKERS threads.
+		// Usable as an offline cook step
+		static bool cookModel(const std::string &sourcePath, std::vector<unsigned char> &outData);
+	private:
+		static std::string getCachePath(const std::string &sourcePath);
+		static bool getSourceStamp(const std::string &sourcePath, uint64_t &outSize, int64_t &outModifiedTime);
+		static bool validateCookedModel(const unsigned char *data, size_t size, bool checkSource, uint64_t sourceSize, int64_t sourceModifiedTime);
+
+		static void collectMeshes(const aiNode *node, const aiScene *scene, std::vector<const aiMesh*> &outMeshes);
+
+		static const uint32_t s_Magic = 0x48534d41; // "AMSH"
+		static const uint32_t s_CookerVersion = 1; // Bump when the cooked layout or the mesh processing changes so stale cache entries get re-cooked
+	};
+
+}
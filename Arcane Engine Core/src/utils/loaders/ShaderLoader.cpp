@@ -4,23 +4,20 @@
 namespace arcane {
 
 	// Static declarations
-	std::unordered_map<std::size_t, Shader*> ShaderLoader::s_ShaderCache;
-	std::hash<std::string> ShaderLoader::s_Hasher;
+	std::unordered_map<std::string, AssetHandle<Shader>> ShaderLoader::s_ShaderCache;
 
 	Shader* ShaderLoader::loadShader(const std::string &path) {
-		std::size_t hash = s_Hasher(path);
-
-		// Check the cache
-		auto iter = s_ShaderCache.find(hash);
+		// Check the cache, keyed by the full path so two shaders can never collide
+		auto iter = s_ShaderCache.find(path);
 		if (iter != s_ShaderCache.end()) {
-			return iter->second;
+			return iter->second.get();
 		}
 
 		// Load the shader
-		Shader *shader = new Shader(path);
+		AssetHandle<Shader> shader = AssetManager::loadShader(path);
 
-		s_ShaderCache.insert(std::pair<std::size_t, Shader*>(hash, shader));
-		return s_ShaderCache[hash];
+		s_ShaderCache.insert(std::pair<std::string, AssetHandle<Shader>>(path, shader));
+		return shader.get();
 	}
 
 }
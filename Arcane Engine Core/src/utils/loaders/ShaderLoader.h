@@ -1,15 +1,16 @@
 #pragma once
 
 #include <graphics/Shader.h>
+#include <utils/loaders/AssetManager.h>
 
 namespace arcane {
 
 	class ShaderLoader {
 	public:
+		// Shaders are handed out as raw pointers, so they stay referenced until shutdown
 		static Shader* loadShader(const std::string &path);
 	private:
-		static std::unordered_map<std::size_t, Shader*> s_ShaderCache;
-		static std::hash<std::string> s_Hasher;
+		static std::unordered_map<std::string, AssetHandle<Shader>> s_ShaderCache;
 	};
 
 }
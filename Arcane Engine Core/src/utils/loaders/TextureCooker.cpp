@@ -0,0 +1,401 @@
+#include "pch.h"
+#include "TextureCooker.h"
+
+#include <utils/FileUtils.h>
+#include <utils/VirtualFileSystem.h>
+
+namespace arcane {
+
+	// DDS container with the DX10 extension header, so the file records the exact BC format (including sRGB)
+	struct DDSPixelFormat {
+		uint32_t Size, Flags, FourCC, RGBBitCount, RBitMask, GBitMask, BBitMask, ABitMask;
+	};
+
+	struct DDSHeader {
+		uint32_t Size, Flags, Height, Width, PitchOrLinearSize, Depth, MipMapCount, Reserved1[11];
+		DDSPixelFormat PixelFormat;
+		uint32_t Caps, Caps2, Caps3, Caps4, Reserved2;
+	};
+
+	struct DDSHeaderDX10 {
+		uint32_t DXGIFormat, ResourceDimension, MiscFlag, ArraySize, MiscFlags2;
+	};
+
+	static const uint32_t s_DDSMagic = 0x20534444; // "DDS "
+	static const uint32_t s_DDSFourCCDX10 = 0x30315844; // "DX10"
+	static const unsigned int s_DDSSourceSizeSlot = 0, s_DDSSourceModifiedTimeSlot = 2; // The source stamp is kept in the reserved header words, so the cache stays a plain DDS file
+
+	enum DXGIFormat {
+		DXGI_BC1_UNORM = 71, DXGI_BC1_UNORM_SRGB = 72,
+		DXGI_BC3_UNORM = 77, DXGI_BC3_UNORM_SRGB = 78,
+		DXGI_BC4_UNORM = 80,
+		DXGI_BC5_UNORM = 83
+	};
+
+	static float srgbToLinear(float value) {
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static float linearToSRGB(float value) {
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	static unsigned char unitToByte(float value) {
+		return (unsigned char)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	bool TextureCooker::loadOrCookTexture(const std::string &sourcePath, const TextureSettings &settings, CookedTexture &outCooked) {
+		// Without the source around the cooked texture is trusted as is, so builds can ship just the cache
+		uint64_t sourceSize = 0;
+		int64_t sourceModifiedTime = 0;
+		bool hasSource = VirtualFileSystem::getFileStamp(sourcePath, sourceSize, sourceModifiedTime);
+
+		std::string cachePath = getCachePath(sourcePath, settings);
+		outCooked.CachePath = cachePath;
+		outCooked.CacheDataOffset = sizeof(s_DDSMagic) + sizeof(DDSHeader) + sizeof(DDSHeaderDX10);
+		if (readCookedTexture(cachePath, hasSource, sourceSize, sourceModifiedTime, outCooked))
+			return true;
+
+		if (!hasSource || !cookTexture(sourcePath, settings, outCooked))
+			return false;
+
+		FileUtils::createDirectories(TEXTURE_CACHE_DIRECTORY);
+		if (!writeCookedTexture(cachePath, outCooked, settings.IsSRGB, sourceSize, sourceModifiedTime)) {
+			Logger::getInstance().warning("logged_files/texture_loading.txt", "texture cooking", "Couldn't write cooked texture to the cache: " + cachePath);
+			outCooked.CachePath.clear();
+		}
+		return true;
+	}
+
+	bool TextureCooker::cookTexture(const std::string &sourcePath, const TextureSettings &settings, CookedTexture &outCooked) {
+		PROFILE_FUNCTION();
+		int width, height, numComponents;
+		unsigned char *image = VirtualFileSystem::loadImage(sourcePath, &width, &height, &numComponents, 4);
+		if (!image) {
+			Logger::getInstance().error("logged_files/texture_loading.txt", "texture cooking", "Couldn't load texture: " + sourcePath);
+			return false;
+		}
+
+		// Pick the cheapest format that keeps the channels the image actually uses
+		bool hasAlpha = false;
+		if (numComponents == 2 || numComponents == 4) {
+			for (size_t i = 0; i < (size_t)width * height && !hasAlpha; i++) {
+				hasAlpha = image[i * 4 + 3] != 255;
+			}
+		}
+
+		if (settings.IsNormalMap)
+			outCooked.CompressedFormat = GL_COMPRESSED_RG_RGTC2;
+		else if (numComponents == 1)
+			outCooked.CompressedFormat = GL_COMPRESSED_RED_RGTC1;
+		else if (hasAlpha)
+			outCooked.CompressedFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		else
+			outCooked.CompressedFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+		outCooked.Width = width;
+		outCooked.Height = height;
+		outCooked.MipCount = settings.HasMips ? (unsigned int)std::floor(std::log2((float)std::max(width, height))) + 1 : 1;
+		outCooked.FirstMip = 0;
+		outCooked.Data.clear();
+
+		// Mips are filtered in linear space so sRGB textures don't darken as they get smaller
+		std::vector<glm::vec4> mip((size_t)width * height);
+		for (size_t i = 0; i < mip.size(); i++) {
+			glm::vec4 texel = glm::vec4(image[i * 4], image[i * 4 + 1], image[i * 4 + 2], image[i * 4 + 3]) / 255.0f;
+			if (settings.IsNormalMap) {
+				texel = glm::vec4(glm::vec3(texel) * 2.0f - 1.0f, texel.a);
+			}
+			else if (settings.IsSRGB) {
+				texel = glm::vec4(srgbToLinear(texel.r), srgbToLinear(texel.g), srgbToLinear(texel.b), texel.a);
+			}
+			mip[i] = texel;
+		}
+		stbi_image_free(image);
+
+		std::vector<glm::vec4> nextMip;
+		unsigned int mipWidth = width, mipHeight = height;
+		for (unsigned int level = 0; level < outCooked.MipCount; level++) {
+			compressMip(mip, mipWidth, mipHeight, settings, outCooked.CompressedFormat, outCooked.Data);
+
+			if (level + 1 < outCooked.MipCount) {
+				downsampleMip(mip, mipWidth, mipHeight, nextMip, settings.IsNormalMap);
+				mip.swap(nextMip);
+				mipWidth = std::max(mipWidth / 2, 1u);
+				mipHeight = std::max(mipHeight / 2, 1u);
+			}
+		}
+
+		return true;
+	}
+
+	size_t TextureCooker::getMipDataOffset(GLenum compressedFormat, unsigned int width, unsigned int height, unsigned int mip) {
+		size_t offset = 0;
+		for (unsigned int level = 0; level < mip; level++) {
+			offset += Texture::getCompressedImageSize(compressedFormat, std::max(width >> level, 1u), std::max(height >> level, 1u));
+		}
+		return offset;
+	}
+
+	std::string TextureCooker::getCachePath(const std::string &sourcePath, const TextureSettings &settings) {
+		// Hashes the source path and every setting that changes the cooked output, the stamp in the header decides if the entry is still up to date
+		unsigned char settingBytes[] = { (unsigned char)settings.IsSRGB, (unsigned char)settings.IsNormalMap, (unsigned char)settings.HasMips, (unsigned char)s_CookerVersion };
+		uint64_t hash = FileUtils::hashFNV1a(sourcePath.data(), sourcePath.size());
+		hash = FileUtils::hashFNV1a(settingBytes, sizeof(settingBytes), hash);
+
+		char hashString[17];
+		snprintf(hashString, sizeof(hashString), "%016llx", (unsigned long long)hash);
+		return std::string(TEXTURE_CACHE_DIRECTORY) + hashString + ".dds";
+	}
+
+	bool TextureCooker::readCookedTexture(const std::string &cachePath, bool hasSource, uint64_t sourceSize, int64_t sourceModifiedTime, CookedTexture &outCooked) {
+		std::ifstream input(cachePath, std::ios::in | std::ios::binary);
+		if (!input)
+			return false;
+
+		uint32_t magic;
+		DDSHeader header;
+		DDSHeaderDX10 headerDX10;
+		input.read((char*)&magic, sizeof(magic));
+		input.read((char*)&header, sizeof(header));
+		input.read((char*)&headerDX10, sizeof(headerDX10));
+		if (!input || magic != s_DDSMagic || header.Size != sizeof(DDSHeader) || header.PixelFormat.FourCC != s_DDSFourCCDX10)
+			return false;
+
+		// The source changed since it was cooked
+		if (hasSource) {
+			uint64_t cookedSourceSize;
+			int64_t cookedSourceModifiedTime;
+			memcpy(&cookedSourceSize, &header.Reserved1[s_DDSSourceSizeSlot], sizeof(cookedSourceSize));
+			memcpy(&cookedSourceModifiedTime, &header.Reserved1[s_DDSSourceModifiedTimeSlot], sizeof(cookedSourceModifiedTime));
+			if (cookedSourceSize != sourceSize || cookedSourceModifiedTime != sourceModifiedTime)
+				return false;
+		}
+
+		switch (headerDX10.DXGIFormat) {
+		case DXGI_BC1_UNORM: case DXGI_BC1_UNORM_SRGB: outCooked.CompressedFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+		case DXGI_BC3_UNORM: case DXGI_BC3_UNORM_SRGB: outCooked.CompressedFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+		case DXGI_BC4_UNORM: outCooked.CompressedFormat = GL_COMPRESSED_RED_RGTC1; break;
+		case DXGI_BC5_UNORM: outCooked.CompressedFormat = GL_COMPRESSED_RG_RGTC2; break;
+		default: return false;
+		}
+		outCooked.Width = header.Width;
+		outCooked.Height = header.Height;
+		outCooked.MipCount = std::max(header.MipMapCount, 1u);
+
+		size_t dataSize = getMipDataOffset(outCooked.CompressedFormat, outCooked.Width, outCooked.Height, outCooked.MipCount);
+		outCooked.FirstMip = 0;
+		outCooked.Data.resize(dataSize);
+		input.read((char*)outCooked.Data.data(), dataSize);
+		return (bool)input;
+	}
+
+	bool TextureCooker::writeCookedTexture(const std::string &cachePath, const CookedTexture &cooked, bool isSRGB, uint64_t sourceSize, int64_t sourceModifiedTime) {
+		std::ofstream output(cachePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!output)
+			return false;
+
+		DDSHeader header = {};
+		header.Size = sizeof(DDSHeader);
+		header.Flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // Caps, height, width, pixel format, mip count, linear size
+		header.Height = cooked.Height;
+		header.Width = cooked.Width;
+		header.PitchOrLinearSize = Texture::getCompressedImageSize(cooked.CompressedFormat, cooked.Width, cooked.Height);
+		header.MipMapCount = cooked.MipCount;
+		header.PixelFormat.Size = sizeof(DDSPixelFormat);
+		header.PixelFormat.Flags = 0x4; // FourCC
+		header.PixelFormat.FourCC = s_DDSFourCCDX10;
+		header.Caps = 0x1000 | (cooked.MipCount > 1 ? 0x8 | 0x400000 : 0); // Texture, complex + mipmap
+		memcpy(&header.Reserved1[s_DDSSourceSizeSlot], &sourceSize, sizeof(sourceSize));
+		memcpy(&header.Reserved1[s_DDSSourceModifiedTimeSlot], &sourceModifiedTime, sizeof(sourceModifiedTime));
+
+		DDSHeaderDX10 headerDX10 = {};
+		headerDX10.ResourceDimension = 3; // Texture2D
+		headerDX10.ArraySize = 1;
+		switch (cooked.CompressedFormat) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: headerDX10.DXGIFormat = isSRGB ? DXGI_BC1_UNORM_SRGB : DXGI_BC1_UNORM; break;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: headerDX10.DXGIFormat = isSRGB ? DXGI_BC3_UNORM_SRGB : DXGI_BC3_UNORM; break;
+		case GL_COMPRESSED_RED_RGTC1: headerDX10.DXGIFormat = DXGI_BC4_UNORM; break;
+		case GL_COMPRESSED_RG_RGTC2: headerDX10.DXGIFormat = DXGI_BC5_UNORM; break;
+		}
+
+		output.write((const char*)&s_DDSMagic, sizeof(s_DDSMagic));
+		output.write((const char*)&header, sizeof(header));
+		output.write((const char*)&headerDX10, sizeof(headerDX10));
+		output.write((const char*)cooked.Data.data(), cooked.Data.size());
+		return (bool)output;
+	}
+
+	void TextureCooker::downsampleMip(const std::vector<glm::vec4> &source, unsigned int sourceWidth, unsigned int sourceHeight, std::vector<glm::vec4> &destination, bool isNormalMap) {
+		unsigned int width = std::max(sourceWidth / 2, 1u), height = std::max(sourceHeight / 2, 1u);
+		destination.resize((size_t)width * height);
+
+		// 2x2 box filter, clamped so odd sized mips still fold their last row/column in
+		for (unsigned int y = 0; y < height; y++) {
+			unsigned int y0 = std::min(y * 2, sourceHeight - 1), y1 = std::min(y * 2 + 1, sourceHeight - 1);
+			for (unsigned int x = 0; x < width; x++) {
+				unsigned int x0 = std::min(x * 2, sourceWidth - 1), x1 = std::min(x * 2 + 1, sourceWidth - 1);
+				glm::vec4 texel = (source[x0 + (size_t)y0 * sourceWidth] + source[x1 + (size_t)y0 * sourceWidth] + source[x0 + (size_t)y1 * sourceWidth] + source[x1 + (size_t)y1 * sourceWidth]) * 0.25f;
+
+				// Averaging shortens normals, which would flatten the lighting on distant surfaces
+				if (isNormalMap) {
+					glm::vec3 normal = glm::vec3(texel);
+					float length = glm::length(normal);
+					texel = glm::vec4(length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f), texel.a);
+				}
+				destination[x + (size_t)y * width] = texel;
+			}
+		}
+	}
+
+	void TextureCooker::compressMip(const std::vector<glm::vec4> &mip, unsigned int width, unsigned int height, const TextureSettings &settings, GLenum compressedFormat, std::vector<unsigned char> &output) {
+		// Back to 8 bits in the space the texture will be sampled from
+		std::vector<unsigned char> texels((size_t)width * height * 4);
+		for (size_t i = 0; i < mip.size(); i++) {
+			glm::vec4 texel = mip[i];
+			if (settings.IsNormalMap) {
+				texel = glm::vec4(glm::vec3(texel) * 0.5f + 0.5f, texel.a);
+			}
+			else if (settings.IsSRGB) {
+				texel = glm::vec4(linearToSRGB(texel.r), linearToSRGB(texel.g), linearToSRGB(texel.b), texel.a);
+			}
+			texels[i * 4] = unitToByte(texel.r);
+			texels[i * 4 + 1] = unitToByte(texel.g);
+			texels[i * 4 + 2] = unitToByte(texel.b);
+			texels[i * 4 + 3] = unitToByte(texel.a);
+		}
+
+		size_t outputOffset = output.size();
+		output.resize(outputOffset + Texture::getCompressedImageSize(compressedFormat, width, height));
+
+		unsigned char blockTexels[16 * 4];
+		for (unsigned int blockY = 0; blockY < height; blockY += 4) {
+			for (unsigned int blockX = 0; blockX < width; blockX += 4) {
+				// Blocks hanging off the edge of the mip repeat the edge texels
+				for (unsigned int y = 0; y < 4; y++) {
+					unsigned int texelY = std::min(blockY + y, height - 1);
+					for (unsigned int x = 0; x < 4; x++) {
+						unsigned int texelX = std::min(blockX + x, width - 1);
+						memcpy(&blockTexels[(x + y * 4) * 4], &texels[(texelX + (size_t)texelY * width) * 4], 4);
+					}
+				}
+
+				unsigned char *block = &output[outputOffset];
+				switch (compressedFormat) {
+				case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+					encodeBC1Block(blockTexels, block);
+					outputOffset += 8;
+					break;
+				case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+					encodeBC4Block(blockTexels, 3, block);
+					encodeBC1Block(blockTexels, block + 8);
+					outputOffset += 16;
+					break;
+				case GL_COMPRESSED_RED_RGTC1:
+					encodeBC4Block(blockTexels, 0, block);
+					outputOffset += 8;
+					break;
+				case GL_COMPRESSED_RG_RGTC2:
+					encodeBC4Block(blockTexels, 0, block);
+					encodeBC4Block(blockTexels, 1, block + 8);
+					outputOffset += 16;
+					break;
+				}
+			}
+		}
+	}
+
+	void TextureCooker::encodeBC1Block(const unsigned char *blockTexels, unsigned char *output) {
+		// Endpoints come from the colour bounding box, inset slightly so the interpolated colours land closer to the texels
+		glm::ivec3 minColour(255), maxColour(0);
+		for (unsigned int i = 0; i < 16; i++) {
+			glm::ivec3 colour(blockTexels[i * 4], blockTexels[i * 4 + 1], blockTexels[i * 4 + 2]);
+			minColour = glm::min(minColour, colour);
+			maxColour = glm::max(maxColour, colour);
+		}
+		glm::ivec3 inset = (maxColour - minColour) / 16;
+		minColour = glm::clamp(minColour + inset, 0, 255);
+		maxColour = glm::clamp(maxColour - inset, 0, 255);
+
+		auto packColour565 = [](const glm::ivec3 &colour) {
+			return (uint16_t)(((colour.r >> 3) << 11) | ((colour.g >> 2) << 5) | (colour.b >> 3));
+		};
+		auto unpackColour565 = [](uint16_t colour) {
+			int r = (colour >> 11) & 31, g = (colour >> 5) & 63, b = colour & 31;
+			return glm::ivec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+		};
+
+		// colour0 > colour1 selects the four colour mode, which BC3 relies on as well
+		uint16_t colour0 = packColour565(maxColour), colour1 = packColour565(minColour);
+		if (colour0 < colour1)
+			std::swap(colour0, colour1);
+
+		uint32_t indices = 0;
+		if (colour0 != colour1) {
+			glm::ivec3 palette[4];
+			palette[0] = unpackColour565(colour0);
+			palette[1] = unpackColour565(colour1);
+			palette[2] = (palette[0] * 2 + palette[1]) / 3;
+			palette[3] = (palette[0] + palette[1] * 2) / 3;
+
+			for (unsigned int i = 0; i < 16; i++) {
+				glm::ivec3 colour(blockTexels[i * 4], blockTexels[i * 4 + 1], blockTexels[i * 4 + 2]);
+				uint32_t bestIndex = 0;
+				int bestDistance = INT_MAX;
+				for (uint32_t paletteIndex = 0; paletteIndex < 4; paletteIndex++) {
+					glm::ivec3 difference = colour - palette[paletteIndex];
+					int distance = difference.r * difference.r + difference.g * difference.g + difference.b * difference.b;
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						bestIndex = paletteIndex;
+					}
+				}
+				indices |= bestIndex << (i * 2);
+			}
+		}
+
+		memcpy(output, &colour0, 2);
+		memcpy(output + 2, &colour1, 2);
+		memcpy(output + 4, &indices, 4);
+	}
+
+	void TextureCooker::encodeBC4Block(const unsigned char *blockTexels, unsigned int channel, unsigned char *output) {
+		int minValue = 255, maxValue = 0;
+		for (unsigned int i = 0; i < 16; i++) {
+			minValue = std::min(minValue, (int)blockTexels[i * 4 + channel]);
+			maxValue = std::max(maxValue, (int)blockTexels[i * 4 + channel]);
+		}
+
+		// endpoint0 > endpoint1 selects the eight value mode (6 interpolated values between the endpoints)
+		uint64_t indices = 0;
+		if (maxValue != minValue) {
+			int palette[8];
+			palette[0] = maxValue;
+			palette[1] = minValue;
+			for (int i = 1; i < 7; i++) {
+				palette[i + 1] = ((7 - i) * maxValue + i * minValue) / 7;
+			}
+
+			for (unsigned int i = 0; i < 16; i++) {
+				int value = blockTexels[i * 4 + channel];
+				uint64_t bestIndex = 0;
+				int bestDistance = INT_MAX;
+				for (uint64_t paletteIndex = 0; paletteIndex < 8; paletteIndex++) {
+					int distance = std::abs(value - palette[paletteIndex]);
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						bestIndex = paletteIndex;
+					}
+				}
+				indices |= bestIndex << (i * 3);
+			}
+		}
+
+		output[0] = (unsigned char)maxValue;
+		output[1] = (unsigned char)minValue;
+		for (unsigned int i = 0; i < 6; i++) {
+			output[2 + i] = (unsigned char)(indices >> (i * 8));
+		}
+	}
+
+}
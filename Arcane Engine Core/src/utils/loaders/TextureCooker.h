@@ -0,0 +1,44 @@
+#pragma once
+
+#include <graphics/texture/Texture.h>
+
+namespace arcane {
+
+	struct CookedTexture {
+		GLenum CompressedFormat; // Linear format, the texture settings decide if it is sampled as sRGB
+		unsigned int Width, Height;
+		unsigned int MipCount;
+		unsigned int FirstMip; // Largest mip held in Data, mips above it were left on disk to be streamed in
+		std::vector<unsigned char> Data; // Blocks for every mip from FirstMip down, largest mip first and tightly packed
+
+		std::string CachePath; // Cooked file the texture can stream its mips from, empty if it couldn't be cached
+		size_t CacheDataOffset; // Where the blocks of the first mip start in the cooked file
+	};
+
+	class TextureCooker {
+	public:
+		// Fills outCooked from the cache, cooking the source image into the cache first if it (or the settings) changed since it was last cooked. Only the source's size and modification time are checked on a hit
+		static bool loadOrCookTexture(const std::string &sourcePath, const TextureSettings &settings, CookedTexture &outCooked);
+
+		// Compresses an image to BC1 (opaque colour), BC3 (colour + alpha), BC4 (single channel) or BC5 (normal maps) with a full mip chain
+		static bool cookTexture(const std::string &sourcePath, const TextureSettings &settings, CookedTexture &outCooked);
+
+		// Byte offset of a mip's blocks from the start of a tightly packed mip chain
+		static size_t getMipDataOffset(GLenum compressedFormat, unsigned int width, unsigned int height, unsigned int mip);
+	private:
+		static std::string getCachePath(const std::string &sourcePath, const TextureSettings &settings);
+		static bool readCookedTexture(const std::string &cachePath, bool hasSource, uint64_t sourceSize, int64_t sourceModifiedTime, CookedTexture &outCooked);
+		static bool writeCookedTexture(const std::string &cachePath, const CookedTexture &cooked, bool isSRGB, uint64_t sourceSize, int64_t sourceModifiedTime);
+
+		// Mip filtering (done on linear values, normals get renormalized)
+		static void downsampleMip(const std::vector<glm::vec4> &source, unsigned int sourceWidth, unsigned int sourceHeight, std::vector<glm::vec4> &destination, bool isNormalMap);
+		static void compressMip(const std::vector<glm::vec4> &mip, unsigned int width, unsigned int height, const TextureSettings &settings, GLenum compressedFormat, std::vector<unsigned char> &output);
+
+		// Block encoders, each takes a 4x4 block of RGBA8 texels
+		static void encodeBC1Block(const unsigned char *blockTexels, unsigned char *output);
+		static void encodeBC4Block(const unsigned char *blockTexels, unsigned int channel, unsigned char *output);
+	private:
+		static const uint32_t s_CookerVersion = 1; // Bump when the encoders change so stale cache entries get re-cooked
+	};
+
+}
@@ -1,24 +1,43 @@
 #include "pch.h"
 #include "TextureLoader.h"
 
+#include <graphics/texture/TextureStreamer.h>
+#include <utils/VirtualFileSystem.h>
+
 namespace arcane {
 
 	// Static declarations
-	std::unordered_map<std::string, Texture*> TextureLoader::m_TextureCache;
 	Texture *TextureLoader::s_DefaultAlbedo;
 	Texture *TextureLoader::s_DefaultNormal;
 	Texture *TextureLoader::s_WhiteTexture; Texture *TextureLoader::s_BlackTexture;
+	std::vector<std::thread> TextureLoader::s_DecodeWorkers;
+	std::mutex TextureLoader::s_JobMutex, TextureLoader::s_DecodedMutex;
+	std::condition_variable TextureLoader::s_JobCondition;
+	std::deque<AsyncTextureJob> TextureLoader::s_PendingJobs;
+	std::deque<DecodedTexture> TextureLoader::s_DecodedTextures;
+	bool TextureLoader::s_ShutdownWorkers = false;
+	unsigned int TextureLoader::s_OutstandingAsyncLoads = 0;
+	unsigned int TextureLoader::s_StagingBuffer = 0;
+	unsigned char *TextureLoader::s_StagingBufferData = nullptr;
+	std::array<GLsync, TEXTURE_STAGING_SLOT_COUNT> TextureLoader::s_StagingFences;
+	unsigned int TextureLoader::s_NextStagingSlot = 0;
+
+	AssetHandle<Texture> TextureLoader::load2DTexture(std::string &path, TextureSettings *settings) {
+		return AssetManager::load2DTexture(path, settings != nullptr ? *settings : TextureSettings());
+	}
 
-	Texture* TextureLoader::load2DTexture(std::string &path, TextureSettings *settings) {
-		// Check the cache
-		auto iter = m_TextureCache.find(path);
-		if (iter != m_TextureCache.end()) {
-			return iter->second;
+	Texture* TextureLoader::create2DTexture(const std::string &path, const TextureSettings &settings) {
+#if TEXTURE_COOKING_ENABLED
+		// Prefer the block compressed version of the texture
+		Texture *cookedTexture = loadCooked2DTexture(path, settings);
+		if (cookedTexture) {
+			return cookedTexture;
 		}
+#endif
 
 		// Load the texture
 		int width, height, numComponents;
-		unsigned char *data = stbi_load(path.c_str(), &width, &height, &numComponents, 0);
+		unsigned char *data = VirtualFileSystem::loadImage(path, &width, &height, &numComponents, 0);
 		if (!data) {
 			Logger::getInstance().error("logged_files/texture_loading.txt", "texture load fail - path:", path);
 			stbi_image_free(data);
@@ -32,6 +51,321 @@ namespace arcane {
 		case 4: dataFormat = GL_RGBA; break;
 		}
 
+		Texture *texture = new Texture(settings);
+		texture->generate2DTexture(width, height, dataFormat, GL_UNSIGNED_BYTE, data);
+		stbi_image_free(data);
+
+		return texture;
+	}
+
+	Texture* TextureLoader::loadCooked2DTexture(const std::string &path, const TextureSettings &settings) {
+		// An explicitly requested format is respected, so those textures aren't compressed
+		if (settings.TextureFormat != GL_NONE)
+			return nullptr;
+
+		CookedTexture cooked;
+		if (!TextureCooker::loadOrCookTexture(path, settings, cooked))
+			return nullptr;
+
+#if TEXTURE_STREAMING_ENABLED
+		// Only the small mips are uploaded, the streamer brings in the rest once the texture is seen up close
+		TextureStreamer::trimToResidentTail(cooked);
+#endif
+
+		Texture *texture = new Texture(settings);
+		texture->generateCompressed2DTexture(cooked.Width, cooked.Height, cooked.CompressedFormat, cooked.MipCount, cooked.Data.data(), cooked.FirstMip);
+		if (cooked.FirstMip > 0) {
+			TextureStreamer::registerTexture(texture, cooked);
+		}
+		return texture;
+	}
+
+	AssetHandle<Texture> TextureLoader::load2DTextureAsync(std::string &path, TextureSettings *settings, const glm::vec4 &placeholderColour) {
+		// Textures that are still loading are cached too, so they are only requested once
+		return AssetManager::load2DTextureAsync(path, settings != nullptr ? *settings : TextureSettings(), placeholderColour);
+	}
+
+	Texture* TextureLoader::createPlaceholderTexture(const TextureSettings &settings, const glm::vec4 &placeholderColour) {
+		unsigned char placeholderPixel[4];
+		for (unsigned int i = 0; i < 4; i++) {
+			placeholderPixel[i] = (unsigned char)(glm::clamp(placeholderColour[i], 0.0f, 1.0f) * 255.0f);
+		}
+
+		Texture *texture = new Texture(settings);
+		texture->generate2DTexture(1, 1, GL_RGBA, GL_UNSIGNED_BYTE, placeholderPixel);
+		return texture;
+	}
+
+	void TextureLoader::request2DTextureDecode(const AssetHandle<Texture> &target, const std::string &path, const TextureSettings &settings) {
+		if (s_DecodeWorkers.empty()) {
+			initializeStagingBuffer();
+			s_ShutdownWorkers = false;
+			for (unsigned int i = 0; i < TEXTURE_LOADING_WORKER_COUNT; i++) {
+				s_DecodeWorkers.push_back(std::thread(&TextureLoader::decodeWorkerLoop));
+			}
+		}
+
+		AsyncTextureJob job;
+		job.Path = path;
+		job.Settings = settings;
+		job.Target = target;
+
+		s_OutstandingAsyncLoads++;
+		{
+			std::lock_guard<std::mutex> lock(s_JobMutex);
+			s_PendingJobs.push_back(std::move(job));
+		}
+		s_JobCondition.notify_one();
+	}
+
+	void TextureLoader::updateAsyncLoads(double budgetMilliseconds) {
+		PROFILE_FUNCTION();
+		double startTime = glfwGetTime();
+
+		// Always finalize at least one texture so loading makes progress even with a tiny budget
+		do {
+			int stagingSlot = acquireStagingSlot();
+
+			DecodedTexture decoded;
+			{
+				std::lock_guard<std::mutex> lock(s_DecodedMutex);
+				if (s_DecodedTextures.empty())
+					return;
+
+				// Wait for the GPU to release a staging slot unless this texture can't be staged anyway
+				if (stagingSlot < 0 && s_StagingBufferData && getUploadSize(s_DecodedTextures.front()) <= TEXTURE_STAGING_SLOT_SIZE)
+					return;
+
+				decoded = std::move(s_DecodedTextures.front());
+				s_DecodedTextures.pop_front();
+			}
+
+			finalizeDecodedTexture(decoded, stagingSlot);
+		} while ((glfwGetTime() - startTime) * 1000.0 < budgetMilliseconds);
+	}
+
+	void TextureLoader::finishAsyncLoads() {
+		PROFILE_FUNCTION();
+		while (s_OutstandingAsyncLoads > 0) {
+			updateAsyncLoads(std::numeric_limits<double>::max());
+			if (s_OutstandingAsyncLoads > 0) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void TextureLoader::shutdownAsyncLoading() {
+		{
+			std::lock_guard<std::mutex> lock(s_JobMutex);
+			s_ShutdownWorkers = true;
+			s_PendingJobs.clear();
+		}
+		s_JobCondition.notify_all();
+		for (std::thread &worker : s_DecodeWorkers) {
+			worker.join();
+		}
+		s_DecodeWorkers.clear();
+
+		for (DecodedTexture &decoded : s_DecodedTextures) {
+			stbi_image_free(decoded.Pixels);
+		}
+		s_DecodedTextures.clear();
+		s_OutstandingAsyncLoads = 0;
+
+		for (GLsync &fence : s_StagingFences) {
+			if (fence) {
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+		if (s_StagingBuffer) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_StagingBuffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &s_StagingBuffer);
+			s_StagingBuffer = 0;
+			s_StagingBufferData = nullptr;
+		}
+	}
+
+	size_t TextureLoader::getUploadSize(const DecodedTexture &decoded) {
+		return decoded.IsCooked ? decoded.Cooked.Data.size() : (size_t)decoded.Width * decoded.Height * 4;
+	}
+
+	void TextureLoader::decodeWorkerLoop() {
+		PROFILE_THREAD_NAME("Texture Decode Worker");
+		while (true) {
+			AsyncTextureJob job;
+			{
+				std::unique_lock<std::mutex> lock(s_JobMutex);
+				s_JobCondition.wait(lock, []() { return s_ShutdownWorkers || !s_PendingJobs.empty(); });
+				if (s_ShutdownWorkers)
+					return;
+
+				job = std::move(s_PendingJobs.front());
+				s_PendingJobs.pop_front();
+			}
+
+			PROFILE_ZONE("Decode Texture");
+			DecodedTexture decoded;
+			decoded.Job = job;
+			decoded.Pixels = nullptr;
+			decoded.IsCooked = false;
+#if TEXTURE_COOKING_ENABLED
+			if (job.Settings.TextureFormat == GL_NONE) {
+				decoded.IsCooked = TextureCooker::loadOrCookTexture(job.Path, job.Settings, decoded.Cooked);
+#if TEXTURE_STREAMING_ENABLED
+				if (decoded.IsCooked) {
+					TextureStreamer::trimToResidentTail(decoded.Cooked);
+				}
+#endif
+			}
+#endif
+
+			// Always decode to 4 channels so every texture fits the same staging layout
+			if (!decoded.IsCooked) {
+				int numComponents;
+				decoded.Pixels = VirtualFileSystem::loadImage(job.Path, &decoded.Width, &decoded.Height, &numComponents, 4);
+				decoded.DataFormat = GL_RGBA;
+			}
+
+			std::lock_guard<std::mutex> lock(s_DecodedMutex);
+			s_DecodedTextures.push_back(std::move(decoded));
+		}
+	}
+
+	void TextureLoader::initializeStagingBuffer() {
+		s_StagingFences.fill(nullptr);
+
+		// Persistent mapping needs ARB_buffer_storage, without it textures are uploaded from client memory
+		if (!GLEW_ARB_buffer_storage)
+			return;
+
+		GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLsizeiptr stagingBufferSize = (GLsizeiptr)TEXTURE_STAGING_SLOT_SIZE * TEXTURE_STAGING_SLOT_COUNT;
+		glGenBuffers(1, &s_StagingBuffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_StagingBuffer);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, stagingBufferSize, nullptr, mapFlags);
+		s_StagingBufferData = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, stagingBufferSize, mapFlags);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (!s_StagingBufferData) {
+			Logger::getInstance().warning("logged_files/texture_loading.txt", "async texture loading", "Couldn't map the texture staging buffer, falling back to client memory uploads");
+			glDeleteBuffers(1, &s_StagingBuffer);
+			s_StagingBuffer = 0;
+		}
+	}
+
+	int TextureLoader::acquireStagingSlot() {
+		if (!s_StagingBufferData)
+			return -1;
+
+		// Slots are used round robin, the next one is free once the GPU has finished reading the last upload from it
+		GLsync &fence = s_StagingFences[s_NextStagingSlot];
+		if (fence) {
+			// Flushing makes sure the fence reaches the GPU, otherwise polling it may never see it signal
+			GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if (waitResult == GL_TIMEOUT_EXPIRED || waitResult == GL_WAIT_FAILED)
+				return -1;
+
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+		return (int)s_NextStagingSlot;
+	}
+
+	void TextureLoader::finalizeDecodedTexture(DecodedTexture &decoded, int stagingSlot) {
+		s_OutstandingAsyncLoads--;
+
+		// A texture that failed to load keeps its placeholder
+		AssetManager::markLoaded(decoded.Job.Target);
+		if (!decoded.IsCooked && !decoded.Pixels) {
+			Logger::getInstance().error("logged_files/texture_loading.txt", "texture load fail - path:", decoded.Job.Path);
+			return;
+		}
+
+		// Restore the requested settings, generating the placeholder resolved them for its own format
+		Texture *texture = decoded.Job.Target.get();
+		texture->setTextureSettings(decoded.Job.Settings);
+
+		auto generateTexture = [&decoded, texture](const void *data, bool sourcedFromPixelBuffer) {
+			if (decoded.IsCooked)
+				texture->generateCompressed2DTexture(decoded.Cooked.Width, decoded.Cooked.Height, decoded.Cooked.CompressedFormat, decoded.Cooked.MipCount, data, decoded.Cooked.FirstMip);
+			else
+				texture->generate2DTexture(decoded.Width, decoded.Height, decoded.DataFormat, GL_UNSIGNED_BYTE, data, sourcedFromPixelBuffer);
+		};
+		const unsigned char *uploadData = decoded.IsCooked ? decoded.Cooked.Data.data() : decoded.Pixels;
+		size_t uploadSize = getUploadSize(decoded);
+
+		if (stagingSlot >= 0 && uploadSize <= TEXTURE_STAGING_SLOT_SIZE) {
+			// The copy into the mapped slot is all the CPU work left, the driver sources the upload from the buffer
+			size_t slotOffset = (size_t)stagingSlot * TEXTURE_STAGING_SLOT_SIZE;
+			memcpy(s_StagingBufferData + slotOffset, uploadData, uploadSize);
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_StagingBuffer);
+			generateTexture((const void*)slotOffset, true);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			s_StagingFences[stagingSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush();
+			s_NextStagingSlot = (s_NextStagingSlot + 1) % TEXTURE_STAGING_SLOT_COUNT;
+		}
+		else {
+			generateTexture(uploadData, false);
+		}
+
+		if (decoded.IsCooked && decoded.Cooked.FirstMip > 0) {
+			TextureStreamer::registerTexture(texture, decoded.Cooked);
+		}
+		stbi_image_free(decoded.Pixels);
+	}
+
+	AssetHandle<Texture> TextureLoader::load2DArrayTexture(const std::vector<std::string> &layerPaths, TextureSettings *settings) {
+		std::string cacheKey;
+		for (const std::string &path : layerPaths) {
+			cacheKey += path + ';';
+		}
+		return AssetManager::loadWith<Texture>(AssetManager::getTextureKey(cacheKey, settings != nullptr ? *settings : TextureSettings()), [&]() {
+			return create2DArrayTexture(layerPaths, settings);
+		});
+	}
+
+	Texture* TextureLoader::create2DArrayTexture(const std::vector<std::string> &layerPaths, TextureSettings *settings) {
+		// Load every layer into one buffer, the first layer decides the resolution and component count
+		int layerWidth = 0, layerHeight = 0, numComponents = 0;
+		std::vector<unsigned char> layerData;
+		for (unsigned int i = 0; i < layerPaths.size(); i++) {
+			int width, height, fileComponents;
+			unsigned char *data = VirtualFileSystem::loadImage(layerPaths[i], &width, &height, &fileComponents, numComponents);
+			if (!data) {
+				Logger::getInstance().error("logged_files/texture_loading.txt", "texture array load fail - path:", layerPaths[i]);
+				return nullptr;
+			}
+
+			if (i == 0) {
+				layerWidth = width;
+				layerHeight = height;
+				numComponents = fileComponents;
+				layerData.resize((size_t)layerWidth * layerHeight * numComponents * layerPaths.size());
+			}
+			else if (width != layerWidth || height != layerHeight) {
+				Logger::getInstance().error("logged_files/texture_loading.txt", "texture array load fail - layer resolution mismatch:", layerPaths[i]);
+				stbi_image_free(data);
+				return nullptr;
+			}
+
+			size_t layerSize = (size_t)layerWidth * layerHeight * numComponents;
+			memcpy(&layerData[layerSize * i], data, layerSize);
+			stbi_image_free(data);
+		}
+
+		GLenum dataFormat;
+		switch (numComponents) {
+		case 1: dataFormat = GL_RED;  break;
+		case 3: dataFormat = GL_RGB;  break;
+		case 4: dataFormat = GL_RGBA; break;
+		}
+
 		Texture *texture = nullptr;
 		if (settings != nullptr) {
 			texture = new Texture(*settings);
@@ -40,48 +374,113 @@ namespace arcane {
 			texture = new Texture();
 		}
 
-		texture->generate2DTexture(width, height, dataFormat, GL_UNSIGNED_BYTE, data);
+		texture->generate2DArrayTexture(layerWidth, layerHeight, layerPaths.size(), dataFormat, GL_UNSIGNED_BYTE, &layerData[0]);
+		return texture;
+	}
 
-		m_TextureCache.insert(std::pair<std::string, Texture*>(path, texture));
-		stbi_image_free(data);
+	AssetHandle<Texture> TextureLoader::loadPacked2DArrayTexture(const std::vector<std::array<std::string, 3>> &layerChannelPaths, TextureSettings *settings) {
+		std::string cacheKey;
+		for (const std::array<std::string, 3> &channelPaths : layerChannelPaths) {
+			cacheKey += channelPaths[0] + '|' + channelPaths[1] + '|' + channelPaths[2] + ';';
+		}
+		return AssetManager::loadWith<Texture>(AssetManager::getTextureKey(cacheKey, settings != nullptr ? *settings : TextureSettings()), [&]() {
+			return createPacked2DArrayTexture(layerChannelPaths, settings);
+		});
+	}
+
+	Texture* TextureLoader::createPacked2DArrayTexture(const std::vector<std::array<std::string, 3>> &layerChannelPaths, TextureSettings *settings) {
+		// Interleave the greyscale images of each layer into rgb
+		int layerWidth = 0, layerHeight = 0;
+		std::vector<unsigned char> layerData;
+		for (unsigned int layer = 0; layer < layerChannelPaths.size(); layer++) {
+			for (unsigned int channel = 0; channel < 3; channel++) {
+				const std::string &path = layerChannelPaths[layer][channel];
+				int width, height, fileComponents;
+				unsigned char *data = VirtualFileSystem::loadImage(path, &width, &height, &fileComponents, SOIL_LOAD_L);
+				if (!data) {
+					Logger::getInstance().error("logged_files/texture_loading.txt", "packed texture array load fail - path:", path);
+					return nullptr;
+				}
+
+				if (layer == 0 && channel == 0) {
+					layerWidth = width;
+					layerHeight = height;
+					layerData.resize((size_t)layerWidth * layerHeight * 3 * layerChannelPaths.size());
+				}
+				else if (width != layerWidth || height != layerHeight) {
+					Logger::getInstance().error("logged_files/texture_loading.txt", "packed texture array load fail - layer resolution mismatch:", path);
+					stbi_image_free(data);
+					return nullptr;
+				}
+
+				size_t pixelCount = (size_t)layerWidth * layerHeight;
+				unsigned char *destination = &layerData[pixelCount * 3 * layer + channel];
+				for (size_t pixel = 0; pixel < pixelCount; pixel++) {
+					destination[pixel * 3] = data[pixel];
+				}
+				stbi_image_free(data);
+			}
+		}
 
-		return m_TextureCache[path];
+		Texture *texture = nullptr;
+		if (settings != nullptr) {
+			texture = new Texture(*settings);
+		}
+		else {
+			texture = new Texture();
+		}
+
+		texture->generate2DArrayTexture(layerWidth, layerHeight, layerChannelPaths.size(), GL_RGB, GL_UNSIGNED_BYTE, &layerData[0]);
+		return texture;
 	}
 
 	Cubemap* TextureLoader::loadCubemapTexture(const std::string &right, const std::string &left, const std::string &top, const std::string &bottom, const std::string &back, const std::string &front, CubemapSettings *settings) {
+		PROFILE_FUNCTION();
 		Cubemap *cubemap = new Cubemap();
 		if (settings != nullptr)
 			cubemap->setCubemapSettings(*settings);
 
 		std::vector<std::string> faces = { right, left, top, bottom, back, front };
 
+		// Decode the faces in parallel, only the uploads need to happen on the GL thread
+		struct DecodedFace { int Width, Height, NumComponents; unsigned char *Data; };
+		std::array<std::future<DecodedFace>, 6> decodedFaces;
+		for (unsigned int i = 0; i < 6; ++i) {
+			decodedFaces[i] = std::async(std::launch::async, [](const std::string &path) {
+				PROFILE_ZONE("Decode Cubemap Face");
+				DecodedFace face;
+				face.Data = VirtualFileSystem::loadImage(path, &face.Width, &face.Height, &face.NumComponents, 0);
+				return face;
+			}, faces[i]);
+		}
+
 		// Load the textures for the cubemap
-		int width, height, numComponents;
+		bool failed = false;
 		for (unsigned int i = 0; i < 6; ++i) {
-			unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &numComponents, 0);
+			DecodedFace face = decodedFaces[i].get();
 
-			if (data) {
+			if (face.Data && !failed) {
 				GLenum dataFormat;
-				switch (numComponents) {
+				switch (face.NumComponents) {
 				case 1: dataFormat = GL_RED;  break;
 				case 3: dataFormat = GL_RGB;  break;
 				case 4: dataFormat = GL_RGBA; break;
 				}
 
-				cubemap->generateCubemapFace(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, width, height, dataFormat, data);
-				stbi_image_free(data);
+				cubemap->generateCubemapFace(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, face.Width, face.Height, dataFormat, face.Data);
 			}
-			else {
+			else if (!failed) {
 				Logger::getInstance().error("logged_files/error.txt", "Cubemap initialization", "Couldn't load cubemap using 6 filepaths. Filepath error: " + faces[i]);
-				stbi_image_free(data);
-				return cubemap;
+				failed = true;
 			}
+			stbi_image_free(face.Data); // Every face has to be collected so none of the decodes are left running
 		}
 		
 		return cubemap;
 	}
 
 	void TextureLoader::initializeDefaultTextures() {
+		PROFILE_FUNCTION();
 		// Setup texture and minimal filtering because they are 1x1 textures so they require none
 		TextureSettings srgbTextureSettings;
 		srgbTextureSettings.IsSRGB = true;
@@ -91,7 +490,9 @@ namespace arcane {
 		s_DefaultAlbedo->setAnisotropicFilteringMode(1.0f);
 		s_DefaultAlbedo->setTextureMinFilter(GL_NEAREST);
 		s_DefaultAlbedo->setTextureMagFilter(GL_NEAREST);
-		s_DefaultNormal = load2DTexture(std::string("res/textures/default/defaultNormal.png"));
+		TextureSettings normalTextureSettings;
+		normalTextureSettings.IsNormalMap = true;
+		s_DefaultNormal = load2DTexture(std::string("res/textures/default/defaultNormal.png"), &normalTextureSettings);
 		s_DefaultNormal->bind();
 		s_DefaultNormal->setAnisotropicFilteringMode(1.0f);
 		s_DefaultNormal->setTextureMinFilter(GL_NEAREST);
@@ -2,15 +2,47 @@
 
 #include <graphics/texture/Cubemap.h>
 #include <graphics/texture/Texture.h>
+#include <utils/loaders/AssetManager.h>
+#include <utils/loaders/TextureCooker.h>
 
 namespace arcane {
 
+	struct AsyncTextureJob {
+		std::string Path;
+		AssetHandle<Texture> Target; // Keeps the texture alive until the decoded image is swapped in
+		TextureSettings Settings;
+	};
+
+	struct DecodedTexture {
+		AsyncTextureJob Job;
+		int Width, Height;
+		GLenum DataFormat;
+		unsigned char *Pixels; // Owned by stb_image, nullptr if decoding failed
+
+		bool IsCooked; // If set, Cooked holds the texture instead of Pixels
+		CookedTexture Cooked;
+	};
+
 	class TextureLoader {
 	public:
 		static void initializeDefaultTextures();
 
+		// Cached through the AssetManager, keep the handle for as long as the texture is used
 		// TODO: HDR loading
-		static Texture* load2DTexture(std::string &path, TextureSettings *settings = nullptr);
+		static AssetHandle<Texture> load2DTexture(std::string &path, TextureSettings *settings = nullptr);
+		static AssetHandle<Texture> load2DArrayTexture(const std::vector<std::string> &layerPaths, TextureSettings *settings = nullptr); // All layers need to share the same resolution
+		static AssetHandle<Texture> loadPacked2DArrayTexture(const std::vector<std::array<std::string, 3>> &layerChannelPaths, TextureSettings *settings = nullptr); // Packs three greyscale images into the rgb channels of each layer
+		// Returns a 1x1 placeholder straight away, the file is decoded on a worker thread and swapped in by updateAsyncLoads
+		static AssetHandle<Texture> load2DTextureAsync(std::string &path, TextureSettings *settings = nullptr, const glm::vec4 &placeholderColour = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+		static void updateAsyncLoads(double budgetMilliseconds = TEXTURE_UPLOAD_BUDGET_MS); // Call on the GL thread once a frame
+		static void finishAsyncLoads(); // Blocks until every requested texture has been swapped in
+		static void shutdownAsyncLoading();
+
+		// Uncached building blocks for the AssetManager
+		static Texture* create2DTexture(const std::string &path, const TextureSettings &settings);
+		static Texture* createPlaceholderTexture(const TextureSettings &settings, const glm::vec4 &placeholderColour);
+		static void request2DTextureDecode(const AssetHandle<Texture> &target, const std::string &path, const TextureSettings &settings); // Target holds the placeholder until then
+
 		static Cubemap* loadCubemapTexture(const std::string &right, const std::string &left, const std::string &top, const std::string &bottom, const std::string &back, const std::string &front, CubemapSettings *settings = nullptr);
 
 		inline static Texture* getWhiteTexture() { return s_WhiteTexture; }
@@ -25,7 +57,30 @@ namespace arcane {
 		inline static Texture* getFullRoughness() { return s_WhiteTexture; }
 		inline static Texture* getNoRoughness() { return s_BlackTexture; }
 	private:
-		static std::unordered_map<std::string, Texture*> m_TextureCache;
+		static Texture* loadCooked2DTexture(const std::string &path, const TextureSettings &settings);
+		static Texture* create2DArrayTexture(const std::vector<std::string> &layerPaths, TextureSettings *settings);
+		static Texture* createPacked2DArrayTexture(const std::vector<std::array<std::string, 3>> &layerChannelPaths, TextureSettings *settings);
+		static size_t getUploadSize(const DecodedTexture &decoded);
+
+		static void decodeWorkerLoop();
+		static void initializeStagingBuffer();
+		static int acquireStagingSlot();
+		static void finalizeDecodedTexture(DecodedTexture &decoded, int stagingSlot);
+	private:
+		// Async loading
+		static std::vector<std::thread> s_DecodeWorkers;
+		static std::mutex s_JobMutex, s_DecodedMutex;
+		static std::condition_variable s_JobCondition;
+		static std::deque<AsyncTextureJob> s_PendingJobs;
+		static std::deque<DecodedTexture> s_DecodedTextures;
+		static bool s_ShutdownWorkers;
+		static unsigned int s_OutstandingAsyncLoads; // Requested but not swapped in yet, only touched by the GL thread
+
+		// Persistently mapped pixel unpack buffer, split into slots that are fenced until the GPU has consumed them
+		static unsigned int s_StagingBuffer;
+		static unsigned char *s_StagingBufferData;
+		static std::array<GLsync, TEXTURE_STAGING_SLOT_COUNT> s_StagingFences;
+		static unsigned int s_NextStagingSlot;
 		
 		// Default Textures
 		static Texture *s_DefaultAlbedo;